@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef ANIMATION_FRAMES_H
+#define ANIMATION_FRAMES_H
+
+#include "oledAnimation.h"
+
+// The art of the animation frames, see oledAnimation.h for the tiles. Kept
+// apart from the handlers so the host tests check every frame compileSprite()
+// makes against the renderer it replaced.
+
+constexpr char fanArt[][SPRITE_CELLS + 1] = {
+    "........"
+    "........"
+    ".L....R."
+    "..L..R.."
+    "...XX..."
+    "...XX..."
+    "..R..L.."
+    ".R....L.",
+
+    "........"
+    "........"
+    "...Vv..."
+    "...Vv..."
+    ".HHXXHH."
+    ".hhXXhh."
+    "...Vv..."
+    "...Vv..."
+};
+
+constexpr char voltageArt[][SPRITE_CELLS + 1] = {
+    "........"
+    "........"
+    "........"
+    "........"
+    "........"
+    "........"
+    "........"
+    "........",
+
+    "........"
+    "........"
+    "........"
+    "........"
+    "........"
+    "........"
+    "GGGGGGGG"
+    "GGGGGGGG",
+
+    "........"
+    "........"
+    "........"
+    "........"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG",
+
+    "........"
+    "........"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG",
+
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+    "GGGGGGGG"
+};
+
+constexpr char currentArt[][SPRITE_CELLS + 1] = {
+    "........"
+    "........"
+    "........"
+    "........"
+    "........"
+    "........"
+    "........"
+    "........",
+
+    "gg......"
+    "gg......"
+    "gg......"
+    "gg......"
+    "gg......"
+    "gg......"
+    "gg......"
+    "gg......",
+
+    "gggg...."
+    "gggg...."
+    "gggg...."
+    "gggg...."
+    "gggg...."
+    "gggg...."
+    "gggg...."
+    "gggg....",
+
+    "gggggg.."
+    "gggggg.."
+    "gggggg.."
+    "gggggg.."
+    "gggggg.."
+    "gggggg.."
+    "gggggg.."
+    "gggggg..",
+
+    "gggggggg"
+    "gggggggg"
+    "gggggggg"
+    "gggggggg"
+    "gggggggg"
+    "gggggggg"
+    "gggggggg"
+    "gggggggg"
+};
+
+constexpr char dieArt[][SPRITE_CELLS + 1] = {
+    "1TTTTTT2"
+    "<......>"
+    "<......>"
+    "<..!@..>"
+    "<..#$..>"
+    "<......>"
+    "<......>"
+    "3bbbbbb4",
+
+    "1TTTTTT2"
+    "<!@....>"
+    "<#$....>"
+    "<......>"
+    "<......>"
+    "<....!@>"
+    "<....#$>"
+    "3bbbbbb4",
+
+    "1TTTTTT2"
+    "<!@....>"
+    "<#$....>"
+    "<..!@..>"
+    "<..#$..>"
+    "<....!@>"
+    "<....#$>"
+    "3bbbbbb4",
+
+    "1TTTTTT2"
+    "<!@..!@>"
+    "<#$..#$>"
+    "<......>"
+    "<......>"
+    "<!@..!@>"
+    "<#$..#$>"
+    "3bbbbbb4",
+
+    "1TTTTTT2"
+    "<!@..!@>"
+    "<#$..#$>"
+    "<..!@..>"
+    "<..#$..>"
+    "<!@..!@>"
+    "<#$..#$>"
+    "3bbbbbb4",
+
+    "1TTTTTT2"
+    "<!@..!@>"
+    "<#$..#$>"
+    "<!@..!@>"
+    "<#$..#$>"
+    "<!@..!@>"
+    "<#$..#$>"
+    "3bbbbbb4"
+};
+
+#define FAN_FRAME_COUNT (sizeof(fanArt) / sizeof(fanArt[0]))
+#define VOLTAGE_FRAME_COUNT (sizeof(voltageArt) / sizeof(voltageArt[0]))
+#define CURRENT_FRAME_COUNT (sizeof(currentArt) / sizeof(currentArt[0]))
+#define DIE_FRAME_COUNT (sizeof(dieArt) / sizeof(dieArt[0]))
+
+#endif /* ANIMATION_FRAMES_H */
@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef CALLBACK_TABLE_H
+#define CALLBACK_TABLE_H
+
+#include "globals.h"
+
+typedef int (*hubMethodCallback)(const char *, size_t, char **response, size_t* resp_size);
+
+typedef struct CALLBACK_LOOKUP_TAG {
+    char* name;
+    uint32_t hash; // case-insensitive hash of name
+    hubMethodCallback callback;
+} CALLBACK_LOOKUP;
+
+// open addressing table of indexes into a callback list, -1 marks an empty bucket
+#define CALLBACK_TABLE_SIZE (MAX_CALLBACK_COUNT * 2)
+
+// Registered methods or desired properties by name, case-insensitive. A zero
+// initialized table is empty, the buckets are set up by the first add.
+typedef struct CALLBACK_TABLE_TAG {
+    int count;
+    CALLBACK_LOOKUP list[MAX_CALLBACK_COUNT];
+    int8_t buckets[CALLBACK_TABLE_SIZE];
+} CALLBACK_TABLE;
+
+// case-insensitive FNV-1a over the first length characters of name
+uint32_t callbackNameHash(const char *name, unsigned length);
+
+// false when the table is full or the name can't be copied
+bool callbackTableAdd(CALLBACK_TABLE *table, const char *name, hubMethodCallback callback);
+
+// name doesn't need to be null terminated, nothing is allocated
+CALLBACK_LOOKUP *callbackTableFind(CALLBACK_TABLE *table, const char *name, unsigned nameLength);
+
+#endif /* CALLBACK_TABLE_H */
@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include "globals.h"
+
+#define CBOR_CONTENT_TYPE "application/cbor"
+
+// Writes CBOR (RFC 7049) into a caller supplied buffer, the binary
+// counterpart of JsonWriter. Keys are text strings so the payload stays
+// self describing. Floats go out as half precision when that is exact and
+// single precision otherwise. Once the buffer is full every further write
+// is dropped and hasOverflow() reports true.
+class CborWriter
+{
+    uint8_t * buffer;
+    unsigned capacity;
+    unsigned length;
+    bool overflow;
+
+    void appendRaw(const void * data, unsigned dataLength);
+    void appendHead(uint8_t majorType, uint32_t value);
+
+public:
+    CborWriter(uint8_t * buffer_, unsigned capacity_): buffer(buffer_), capacity(capacity_),
+                                                       length(0), overflow(false)
+    {
+        assert(buffer != NULL && capacity != 0);
+    }
+
+    // an indefinite length map, members don't have to be counted up front
+    void beginMap();
+    void endMap();
+
+    // map key, the value follows as the next item; keyLength excludes the null terminator
+    void appendKey(const char * key, unsigned keyLength);
+
+    // the next count items are the elements of the array
+    void beginArray(unsigned count);
+
+    template <unsigned N>
+    void appendFloat(const char (&key)[N], float value) {
+        appendFloat(key, N - 1, value);
+    }
+
+    template <unsigned N>
+    void appendInt(const char (&key)[N], int value) {
+        appendInt(key, N - 1, value);
+    }
+
+    void appendFloat(const char * key, unsigned keyLength, float value) {
+        appendKey(key, keyLength);
+        appendFloatValue(value);
+    }
+
+    void appendInt(const char * key, unsigned keyLength, int value) {
+        appendKey(key, keyLength);
+        appendIntValue(value);
+    }
+
+    void appendFloatValue(float value);
+    void appendIntValue(int value);
+
+    const uint8_t * getBuffer() { return buffer; }
+
+    unsigned getLength() { return length; }
+
+    bool hasOverflow() { return overflow; }
+};
+
+#endif /* CBOR_WRITER_H */
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include "telemetrySampler.h"
+#include "utility.h"
+
+// a field is sent at least this often (ms) even when it doesn't change
+#define DEADBAND_DEFAULT_HEARTBEAT (5 * 60 * 1000)
+
+typedef struct DEADBAND_FIELD_TAG {
+    int32_t absolute; // change needed to send, scaled like the field's samples, 0 - unused
+    float relative;   // change as a fraction of the last sent value, 0 - unused
+    int32_t lastSent;
+    unsigned long lastSentTime;
+    bool hasSent;
+    int32_t pendingValue; // in the payload being sent, taken as last sent on commit
+    bool pending;
+    unsigned long suppressedCount;
+} DEADBAND_FIELD;
+
+// change-only telemetry, fields that moved less than their threshold are left out
+void deadbandInit(bool enabled);
+bool isDeadbandEnabled();
+
+// true when the last value, or the interval's min or max, moved past a threshold
+// from the last sent value, or the heartbeat expired. always true when disabled.
+// the field then waits for deadbandCommit() to take the new value
+bool deadbandShouldSend(int field, const FIELD_AGGREGATE &values, unsigned long now);
+
+// the payload went out, its fields count as sent. without a commit, or after
+// deadbandDiscard(), the next payload is compared with what was sent before
+void deadbandCommit(unsigned long now);
+void deadbandDiscard();
+
+// applies {"enabled":true,"heartbeat":300,"temp":0.5,"tempRel":0.01,...}, heartbeat in seconds
+bool deadbandConfigure(JSObject *config);
+
+unsigned long getDeadbandSuppressedCount(int field);
+unsigned long getDeadbandSuppressedTotal();
+
+#endif /* DEADBAND_H */
@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef DISPLAY_MODEL_H
+#define DISPLAY_MODEL_H
+
+#include "globals.h"
+
+#define DISPLAY_LINE_COUNT 4
+// flushes closer together than this (ms) are skipped, kept below the period
+// of the display task so a task run a little late isn't skipped as well
+#define DISPLAY_MIN_REFRESH_INTERVAL 200
+
+// Text pages for the OLED. Pages are rendered into the model, the flush only
+// sends lines that differ from what is on the screen, padded to the full
+// width so no clean is needed between pages.
+void displayModelInit(unsigned long minRefreshInterval);
+
+// lines are separated by \r\n like for Screen.print, missing lines are blank
+void displayModelSetText(const char *text);
+void displayModelSetLine(int line, const char *text);
+
+// for code drawing on the screen directly, the next flush redraws every line
+void displayModelClear();
+
+// returns the number of lines sent
+unsigned displayModelFlush(unsigned long now);
+
+// ms until a flush skipped by the refresh cap can be run again, 0 when none was skipped
+unsigned long displayModelFlushDelay(unsigned long now);
+
+unsigned long getDisplayLinesDrawn();
+unsigned long getDisplayLinesUnchanged(); // lines a full redraw would have sent
+unsigned long getDisplayFlushesSkipped(); // refresh cap
+unsigned long getDisplayBusTime();        // us spent in Screen calls
+
+#endif /* DISPLAY_MODEL_H */
@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef FIXED_FFT_H
+#define FIXED_FFT_H
+
+#include "globals.h"
+
+#define FFT_SIZE 256 // real input samples, a power of two
+#define FFT_BINS (FFT_SIZE / 2 + 1)
+
+// builds the twiddle and Hann window tables
+void fftInit();
+
+// Hann window applied in place to Q15 samples
+void fftApplyWindow(int16_t *samples);
+
+// Power spectrum of FFT_SIZE real Q15 samples, bins 0 to FFT_SIZE / 2.
+// Each bin is |X[k]|^2 with X scaled by 1/FFT_SIZE, so the input can use
+// the full Q15 range without overflowing. A FFT_SIZE / 2 point complex FFT
+// does the work; it uses the Cortex-M4 DSP instructions when available.
+void fftRealPower(const int16_t *samples, uint32_t *power);
+
+#endif /* FIXED_FFT_H */
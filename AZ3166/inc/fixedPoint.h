@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include "globals.h"
+
+// sensor values travel as scaled integers, e.g. 2481 with 2 decimals is 24.81
+#define FIXED_MAX_DECIMALS 9
+
+// "-2147483648" plus a decimal point, padding zeros and the terminator
+#define FIXED_FORMAT_SIZE (STRING_BUFFER_16 + FIXED_MAX_DECIMALS)
+
+extern const uint32_t fixedScales[FIXED_MAX_DECIMALS + 1]; // 10^decimals
+
+// nearest scaled integer, single precision only
+int32_t toFixed(float value, unsigned decimals);
+
+float fixedToFloat(int32_t value, unsigned decimals);
+
+// same value at another number of decimals, rounded half away from zero
+int32_t rescaleFixed(int32_t value, unsigned decimals, unsigned newDecimals);
+
+// Writes value with exactly precision decimals, rounding half away from zero
+// when digits are dropped. buffer needs FIXED_FORMAT_SIZE bytes, returns the
+// length without the null terminator.
+unsigned formatFixed(int32_t value, unsigned decimals, unsigned precision, char *buffer);
+
+// floor of the square root
+uint32_t integerSqrt(uint64_t value);
+
+// digits of value padded with zeros to minDigits, returns the length
+unsigned formatUnsigned(uint32_t value, unsigned minDigits, char *buffer);
+
+#endif /* FIXED_POINT_H */
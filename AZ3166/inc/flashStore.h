@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef FLASH_STORE_H
+#define FLASH_STORE_H
+
+#include "globals.h"
+
+// Flash region holding the offline telemetry queue, the last three 128 KB
+// sectors of the STM32F412. It has to stay clear of the sketch image, which
+// FlashIapStore::init() checks against the image end from the linker.
+#define TELEMETRY_STORE_ADDRESS     0x080A0000
+#define TELEMETRY_STORE_SECTOR_SIZE 0x20000
+#define TELEMETRY_STORE_SECTORS     3
+
+// Erasable storage split into equally sized sectors. Addresses are relative
+// to the start of the store. Like NOR flash, erased bytes read 0xFF and
+// programming can only clear bits.
+class FlashStore
+{
+public:
+    virtual ~FlashStore() { }
+
+    virtual bool init() = 0;
+    virtual bool read(uint32_t address, void *buffer, uint32_t size) = 0;
+    virtual bool program(uint32_t address, const void *buffer, uint32_t size) = 0;
+    virtual bool erase(unsigned sector) = 0;
+
+    virtual uint32_t getSectorSize() = 0;
+    virtual unsigned getSectorCount() = 0;
+};
+
+#ifdef FLASH_STORE_FILE
+
+#include <stdio.h>
+
+// host stand-in backed by a file, lets the queue be exercised off the device
+class FileFlashStore : public FlashStore
+{
+    const char *path;
+    FILE *file;
+    uint32_t sectorSize;
+    unsigned sectorCount;
+
+public:
+    FileFlashStore(const char *path_, uint32_t sectorSize_, unsigned sectorCount_):
+        path(path_), file(NULL), sectorSize(sectorSize_), sectorCount(sectorCount_) { }
+
+    ~FileFlashStore();
+
+    bool init();
+    bool read(uint32_t address, void *buffer, uint32_t size);
+    bool program(uint32_t address, const void *buffer, uint32_t size);
+    bool erase(unsigned sector);
+
+    uint32_t getSectorSize() { return sectorSize; }
+    unsigned getSectorCount() { return sectorCount; }
+};
+
+#else
+
+#include <mbed.h>
+
+// internal flash through mbed's FlashIAP
+class FlashIapStore : public FlashStore
+{
+    FlashIAP flash;
+    uint32_t startAddress;
+    uint32_t sectorSize;
+    unsigned sectorCount;
+
+public:
+    FlashIapStore(uint32_t startAddress_, uint32_t sectorSize_, unsigned sectorCount_):
+        startAddress(startAddress_), sectorSize(sectorSize_), sectorCount(sectorCount_) { }
+
+    bool init();
+    bool read(uint32_t address, void *buffer, uint32_t size);
+    bool program(uint32_t address, const void *buffer, uint32_t size);
+    bool erase(unsigned sector);
+
+    uint32_t getSectorSize() { return sectorSize; }
+    unsigned getSectorCount() { return sectorCount; }
+};
+
+#endif // FLASH_STORE_FILE
+
+#endif /* FLASH_STORE_H */
@@ -36,6 +36,8 @@ struct Globals
 
 // IOT HUB
 #define MAX_CALLBACK_COUNT 32
+#define IOTHUB_MESSAGE_MAX_SIZE STRING_BUFFER_4096 // IoT Hub meters messages in 4 KB units
+#define IOTHUB_BATCH_MAX_SIZE   (IOTHUB_MESSAGE_MAX_SIZE - STRING_BUFFER_128) // room for message properties
 
 // DEVICE SPECIFIC
 #define AZ3166_DISPLAY_MAX_COLUMN 16
@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef HTS221_H
+#define HTS221_H
+
+#include "globals.h"
+
+// a reading younger than this (ms) is shared instead of starting a conversion
+#define HTS221_CACHE_PERIOD 250
+// longest wait (ms) for a one shot conversion
+#define HTS221_READY_TIMEOUT 50
+
+// humidity in 1/100 %RH and temperature in 1/100 C, see sensors.h
+typedef struct HTS221_READING_TAG {
+    int32_t humidity;
+    int32_t temperature;
+    unsigned long sampleTime;
+    bool valid;
+} HTS221_READING;
+
+// Drives the HTS221 in one shot mode. A conversion is triggered, data ready
+// polled and both outputs read in a single burst; the calibration is read
+// once at init and applied in integer math.
+bool hts221Init();
+
+// the cached reading when it is recent enough, otherwise a new conversion
+const HTS221_READING *hts221Read(unsigned long now);
+
+unsigned long getHts221AcquisitionCount();
+
+#endif /* HTS221_H */
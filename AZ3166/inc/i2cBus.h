@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include "globals.h"
+
+class DevI2C;
+
+// the sensors on the shared D14/D15 bus
+typedef enum {
+    I2C_DEVICE_LSM6DSL,
+    I2C_DEVICE_HTS221,
+    I2C_DEVICE_LPS22HB,
+    I2C_DEVICE_LIS2MDL,
+    I2C_DEVICE_COUNT
+} I2cDevice;
+
+#define I2C_QUEUE_SIZE 8
+#define I2C_BURST_MAX 32 // bytes, queued reads are merged up to this length
+#define I2C_BURST_PARTS 4
+
+typedef struct I2C_DEVICE_STATS_TAG {
+    unsigned long transactions;
+    unsigned long bytes;
+    unsigned long busTime; // us
+    unsigned long errors;
+} I2C_DEVICE_STATS;
+
+// called once the queued read finished, data is only valid when ok
+typedef void (*i2cCallback)(bool ok, void *context);
+
+void i2cBusInit(DevI2C *i2c);
+
+// blocking register access, waits for a running asynchronous transfer first
+bool i2cRead(I2cDevice device, uint8_t reg, uint8_t *data, uint16_t length);
+bool i2cWrite(I2cDevice device, uint8_t reg, uint8_t value);
+
+// a read of adjacent registers of a queued one joins it as a single burst,
+// false when the queue is full
+bool i2cQueueRead(I2cDevice device, uint8_t reg, uint8_t *data, uint16_t length,
+                  i2cCallback callback = NULL, void *context = NULL);
+
+// with DEVICE_I2C_ASYNCH the queue is worked off in the background, every call
+// completes finished transfers and starts the next. otherwise the queue runs now
+void i2cBusRun();
+
+// runs the queue until it is empty
+void i2cBusFlush();
+
+// accounts transfers made by a vendor driver, start is the micros() before them
+void i2cAccount(I2cDevice device, unsigned long start, unsigned transactions, unsigned bytes, bool ok);
+
+const char * getI2cDeviceName(I2cDevice device);
+const I2C_DEVICE_STATS * getI2cDeviceStats(I2cDevice device);
+unsigned long getI2cMergedCount(); // queued reads that shared a burst
+
+#endif /* I2C_BUS_H */
@@ -4,20 +4,39 @@
 #ifndef IOT_HUB_CLIENT_H
 #define IOT_HUB_CLIENT_H
 
-typedef int (*hubMethodCallback)(const char *, size_t, char **response, size_t* resp_size);
+// DoWork cadence while messages are in flight or cloud traffic was seen
+// within HUB_PUMP_ACTIVE_PERIOD, and once the connection is idle
+#define HUB_PUMP_BUSY_INTERVAL 10
+#define HUB_PUMP_IDLE_INTERVAL 100
+#define HUB_PUMP_ACTIVE_PERIOD 1000
 
-#include <AzureIotHub.h>
+// telemetry messages waiting for a send confirmation
+#define DEFAULT_MAX_IN_FLIGHT 4
+
+// preallocated message slots, bounds the in flight window
+#define MESSAGE_POOL_SIZE DEFAULT_MAX_IN_FLIGHT
 
-typedef struct CALLBACK_LOOKUP_TAG {
-    char* name;
-    hubMethodCallback callback;
-} CALLBACK_LOOKUP;
+#include <AzureIotHub.h>
+#include "reportedPropertyWriter.h"
+#include "telemetryQueue.h"
+#include "callbackTable.h"
 
 typedef struct EVENT_INSTANCE_TAG {
     IOTHUB_MESSAGE_HANDLE messageHandle;
     int messageTrackingId; // For tracking the messages within the user callback.
+    unsigned long submitTime; // millis() when handed to the SDK
+    uint32_t replayId; // id in the offline queue, 0 for live telemetry
 } EVENT_INSTANCE;
 
+// a message pool slot, the payload itself is only kept by the SDK's message
+typedef struct MESSAGE_SLOT_TAG {
+    EVENT_INSTANCE instance;
+    bool inUse;
+    MessageFormat format;
+    time_t sampleTime;
+    unsigned sampleMillis;
+} MESSAGE_SLOT;
+
 class IoTHubClient
 {
     bool traceOn;
@@ -30,6 +49,28 @@ class IoTHubClient
     char displayHubName[AZ3166_DISPLAY_MAX_COLUMN + 1];
     IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle;
 
+    // telemetry batching, samples are packed into one JSON array message
+    unsigned long batchWindow; // 0 - batching disabled
+    unsigned long batchStartTime;
+    unsigned batchLength;
+    unsigned batchSampleCount;
+    char batchBuffer[IOTHUB_BATCH_MAX_SIZE + 1];
+
+    unsigned long lastWorkTime;
+    unsigned long previousWorkTime;
+    unsigned long lastActivityTime;
+
+    int inFlightCount;
+    int maxInFlight;
+
+    ReportedPropertyWriter reportedWriter;
+
+    // telemetry that couldn't be sent waits in flash, NULL disables it
+    TelemetryQueue *offlineQueue;
+    bool hubConnected;
+    bool replayInFlight;
+    unsigned long lastReplayTime;
+
     void checkConnection() {
         if (needsReconnect) {
             // simple reconnection of the client in the event of a disconnect
@@ -44,18 +85,34 @@ class IoTHubClient
     void hubClientYield(void) {
         checkConnection();
 
+        previousWorkTime = lastWorkTime;
+        lastWorkTime = millis();
         IoTHubClient_LL_DoWork(iotHubClientHandle);
-        ThreadAPI_Sleep(1 /* waitTime */);
     }
 
     void initIotHubClient();
     void closeIotHubClient();
 
+    bool sendMessage(const char *payload, unsigned length, MessageFormat format = MESSAGE_FORMAT_JSON,
+                     const QUEUED_MESSAGE *queued = NULL);
+    bool storeOffline(const char *payload, unsigned length, MessageFormat format, time_t sampleTime,
+                      unsigned sampleMillis);
+    bool submitTelemetry(const char *payload, unsigned length, MessageFormat format);
+    void replayOfflineTelemetry();
+    void flushReportedProperties();
+    bool appendToBatch(const char *payload);
+
 public:
     IoTHubClient(bool traceOn_): traceOn(traceOn_), hasError(false),
                                  needsReconnect(false), displayCharPos(0),
                                  waitCount(3), needsCopying(true),
-                                 iotHubClientHandle(NULL)
+                                 iotHubClientHandle(NULL), batchWindow(0),
+                                 batchStartTime(0), batchLength(0),
+                                 batchSampleCount(0), lastWorkTime(0),
+                                 previousWorkTime(0), lastActivityTime(0),
+                                 inFlightCount(0), maxInFlight(DEFAULT_MAX_IN_FLIGHT),
+                                 offlineQueue(NULL), hubConnected(false),
+                                 replayInFlight(false), lastReplayTime(0)
     {
         memset(deviceId, 0, IOT_CENTRAL_MAX_LEN);
         memset(hubName,  0, IOT_CENTRAL_MAX_LEN);
@@ -71,8 +128,59 @@ public:
         return !hasError;
     }
 
+    // services the hub connection, returns the ms until it should run again
+    unsigned long pump();
+
+    // cloud traffic was seen, keep pumping at the busy cadence for a while
+    void markActivity() { lastActivityTime = millis(); }
+
+    // upper bound of how long data received in the running DoWork waited to be read
+    unsigned long getReceiveLatency() { return millis() - previousWorkTime; }
+
+    // telemetry sends fail fast once this many messages await confirmation
+    void setMaxInFlight(int window) { maxInFlight = min(window, MESSAGE_POOL_SIZE); }
+
+    // true while the in flight window is full, callers should slow down
+    bool isBackpressured() { return inFlightCount >= maxInFlight; }
+
+    int getInFlightCount() { return inFlightCount; }
+
+    // called from the send confirmation callback
+    void messageConfirmed(EVENT_INSTANCE *eventInstance, IOTHUB_CLIENT_CONFIRMATION_RESULT result);
+
+    // failed telemetry is queued and replayed once the hub is reachable again
+    void setOfflineQueue(TelemetryQueue *queue) { offlineQueue = queue; }
+    bool hasOfflineQueue() { return offlineQueue != NULL; }
+
+    // queues telemetry for replay without trying to send it first
+    bool storeTelemetry(const char *payload, unsigned length, MessageFormat format);
+    void setConnected(bool connected) { hubConnected = connected; }
+
     bool sendTelemetry(const char *payload);
-    bool sendReportedProperty(const char *payload);
+
+    // binary payloads bypass batching, which only joins JSON samples. true once
+    // the message is sent, batched or kept in the offline queue
+    bool sendTelemetry(const char *payload, unsigned length, MessageFormat format);
+
+    // window (ms) a batch of telemetry samples may stay open, 0 disables batching
+    void setBatchWindow(unsigned long window) { batchWindow = window; }
+    bool flushTelemetryBatch(); // the batch stays open until it is sent or queued
+    void checkTelemetryBatch(); // flush when the batch window expired
+
+    // reported properties are coalesced per key and sent as one patch from pump()
+    bool setReportedProperty(const char *name, const char *json) {
+        return setReportedProperty(name, strlen(name), json, strlen(json));
+    }
+    bool setReportedProperty(const char *name, unsigned nameLength, const char *json, unsigned jsonLength) {
+        return reportedWriter.set(name, nameLength, json, jsonLength);
+    }
+    void setReportedFlushInterval(unsigned long interval) { reportedWriter.setFlushInterval(interval); }
+    void requestReportedFlush() { reportedWriter.requestFlush(); }
+
+    // called from the reported state confirmation callback
+    void reportedPropertiesConfirmed(int patchId, int statusCode) {
+        reportedWriter.patchConfirmed(patchId, statusCode, millis());
+    }
 
     bool registerMethod(const char *methodName, hubMethodCallback callback);
     bool registerDesiredProperty(const char *propertyName, hubMethodCallback callback);
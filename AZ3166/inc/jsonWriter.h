@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include "globals.h"
+
+// JSON_KEY("temp") expands to "\"temp\":" so every key prefix is a single
+// string literal whose length is known at compile time
+#define JSON_KEY(name) "\"" name "\":"
+
+// Writes JSON into a caller supplied buffer without touching the heap.
+// Once the buffer is full every further write is dropped and hasOverflow()
+// reports true, the buffer always stays null terminated.
+class JsonWriter
+{
+    char * buffer;
+    unsigned capacity;
+    unsigned length;
+    bool hasMember;
+    bool overflow;
+
+    void appendRaw(const char * text, unsigned textLength);
+
+    void appendSeparator() {
+        if (hasMember) {
+            appendRaw(",", 1);
+        }
+        hasMember = true;
+    }
+
+public:
+    JsonWriter(char * buffer_, unsigned capacity_): buffer(buffer_),
+                                                    capacity(capacity_), length(0),
+                                                    hasMember(false), overflow(false)
+    {
+        assert(buffer != NULL && capacity != 0);
+        buffer[0] = char(0);
+    }
+
+    void beginObject() {
+        appendRaw("{", 1);
+        hasMember = false;
+    }
+
+    // nested object under a key that is only known at runtime, e.g. a twin property name
+    void beginObject(const char * name, unsigned nameLength) {
+        appendSeparator();
+        appendRaw("\"", 1);
+        appendRaw(name, nameLength);
+        appendRaw("\":{", 3);
+        hasMember = false;
+    }
+
+    void endObject() {
+        appendRaw("}", 1);
+        hasMember = true; // a closed object is a member of its parent
+    }
+
+    template <unsigned N>
+    void appendFloat(const char (&key)[N], float value) {
+        appendFloat(key, N - 1, value);
+    }
+
+    template <unsigned N>
+    void appendInt(const char (&key)[N], int value) {
+        appendInt(key, N - 1, value);
+    }
+
+    template <unsigned N>
+    void appendString(const char (&key)[N], const char * text) {
+        appendSeparator();
+        appendRaw(key, N - 1);
+        appendRaw("\"", 1);
+        appendRaw(text, strlen(text)); // not escaped, text must be plain
+        appendRaw("\"", 1);
+    }
+
+    // value is already valid JSON text, e.g. a span copied out of another document
+    template <unsigned N>
+    void appendJson(const char (&key)[N], const char * json, unsigned jsonLength) {
+        appendSeparator();
+        appendRaw(key, N - 1);
+        appendRaw(json, jsonLength);
+    }
+
+    // key is a JSON_KEY prefix, keyLength excludes the null terminator
+    void appendFloat(const char * key, unsigned keyLength, float value) {
+        appendSeparator();
+        appendRaw(key, keyLength);
+        appendFloatValue(value);
+    }
+
+    void appendInt(const char * key, unsigned keyLength, int value) {
+        appendSeparator();
+        appendRaw(key, keyLength);
+        appendIntValue(value);
+    }
+
+    // scaled integer written with precision decimals, see fixedPoint.h
+    void appendFixed(const char * key, unsigned keyLength, int32_t value,
+                     unsigned decimals, unsigned precision) {
+        appendSeparator();
+        appendRaw(key, keyLength);
+        appendFixedValue(value, decimals, precision);
+    }
+
+    // same text as Arduino's String(float) i.e. two decimal places
+    void appendFloatValue(float value);
+    void appendIntValue(int value);
+    void appendFixedValue(int32_t value, unsigned decimals, unsigned precision);
+
+    const char * getBuffer() { return buffer; }
+
+    unsigned getLength() { return length; }
+
+    bool hasOverflow() { return overflow; }
+};
+
+#endif /* JSON_WRITER_H */
@@ -0,0 +1,23 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef LED_INDICATOR_H
+#define LED_INDICATOR_H
+
+typedef enum {
+    LED_EVENT_SEND,             // Azure LED, short flash
+    LED_EVENT_ERROR,            // user LED, short flash
+    LED_EVENT_WIFI_CONNECTED,   // WiFi LED, steady on
+    LED_EVENT_WIFI_DISCONNECTED,// WiFi LED, slow blink
+    LED_EVENT_DEVICE_STATE      // RGB LED blinks the new device state color then holds it
+} LedEvent;
+
+void ledIndicatorInit();
+
+// start the blink pattern for the event, returns immediately
+void ledIndicatorSignal(LedEvent event);
+
+// advance the running patterns, call from the main loop
+void ledIndicatorTick();
+
+#endif /* LED_INDICATOR_H */
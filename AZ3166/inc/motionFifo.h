@@ -0,0 +1,54 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef MOTION_FIFO_H
+#define MOTION_FIFO_H
+
+#include "globals.h"
+
+class LSM6DSLSensor;
+
+#define MOTION_RING_SIZE 256    // samples, a power of two
+#define MOTION_MAX_READERS 4
+#define MOTION_BURST_SAMPLES 16 // samples fetched per i2c read
+
+// FIFO_CTRL5 ODR_FIFO codes, the sensors run at the same rate
+typedef enum {
+    MOTION_ODR_12_5HZ = 1, MOTION_ODR_26HZ, MOTION_ODR_52HZ,
+    MOTION_ODR_104HZ, MOTION_ODR_208HZ, MOTION_ODR_416HZ
+} MotionOdr;
+
+// raw LSM6DSL output, see motionToUnits()
+typedef struct MOTION_SAMPLE_TAG {
+    int16_t gyro[3];
+    int16_t accel[3];
+} MOTION_SAMPLE;
+
+// Runs the LSM6DSL FIFO in continuous mode with gyroscope and accelerometer
+// at odr. motionFifoDrain() moves complete samples into a ring buffer once
+// watermark samples are waiting. Every reader has its own cursor; a reader
+// that falls more than MOTION_RING_SIZE behind loses the oldest samples.
+bool motionFifoInit(LSM6DSLSensor *sensor, MotionOdr odr, unsigned watermark);
+bool isMotionFifoEnabled();
+
+// reads the FIFO when it reached the watermark or force is set, returns the samples added
+unsigned motionFifoDrain(bool force);
+
+// a reader starts at the next sample written, -1 when all readers are taken
+int motionAddReader();
+
+// copies up to maxSamples unread samples, oldest first
+unsigned motionRead(int reader, MOTION_SAMPLE *samples, unsigned maxSamples);
+
+// accelerometer in mg, gyroscope in mdps
+void motionToUnits(const MOTION_SAMPLE *sample, int32_t *accel, int32_t *gyro);
+
+int32_t getMotionAccelSensitivity(); // ug per LSB
+uint32_t getMotionOdrMilliHz();
+
+unsigned long getMotionSampleCount();
+unsigned long getMotionFifoOverrunCount();  // the sensor FIFO filled before it was drained
+unsigned long getMotionDroppedWordCount();  // words discarded to realign on a sample
+unsigned long getMotionReaderOverrunCount(int reader); // samples the reader missed
+
+#endif /* MOTION_FIFO_H */
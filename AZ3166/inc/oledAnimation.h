@@ -1,12 +1,97 @@
 // Copyright (c) Microsoft. All rights reserved.
-// Licensed under the MIT license. 
+// Licensed under the MIT license.
 
-#ifndef OLED_ANIMATION
+#ifndef OLED_ANIMATION_H
 #define OLED_ANIMATION_H
 
-void animationInit(char **frames, int maxFrames, int width, int moveLimit, int frameDelay, bool center);
+// Frames are drawn as ASCII art of 8x8 pixel tiles, 8 columns by 8 rows:
+//   B block, G block with gap, g block with vertical gap, X cross,
+//   L R diagonals, H h horizontal lines, V v vertical lines, O circle,
+//   T b < > borders, 1 2 3 4 corners, ! @ # $ circle quarters, . clear
+// compileSprite() turns the art into the bitmap Screen.draw() takes at
+// build time, so a frame is drawn straight from flash.
+#define SPRITE_WIDTH 64 // pixels
+#define SPRITE_COLUMNS (SPRITE_WIDTH / 8)
+#define SPRITE_ROWS 8
+#define SPRITE_CELLS (SPRITE_COLUMNS * SPRITE_ROWS)
+#define SPRITE_PAD 3 // blank columns left of the art, the right pad is 8 - SPRITE_PAD
+#define SPRITE_STRIDE (SPRITE_WIDTH + 8) // bitmap bytes per 8 pixel row
+#define SPRITE_SIZE (SPRITE_STRIDE * SPRITE_ROWS)
+
+typedef struct SPRITE_TAG {
+    unsigned char bitmap[SPRITE_SIZE];
+} Sprite;
+
+// tile i is drawn for spriteTileChars[i], unknown characters stay clear
+constexpr char spriteTileChars[] = ".BGgXRLHhVvOTb<>1234!@#$";
+constexpr unsigned char spriteTiles[][8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // . clear
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, // B block
+    {0x7E, 0x7E, 0x7E, 0x7E, 0x7E, 0x7E, 0x7E, 0x7E}, // G block with gap
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00}, // g block with vertical gap
+    {0x81, 0x42, 0x24, 0x18, 0x18, 0x24, 0x42, 0x81}, // X cross
+    {0xC0, 0xE0, 0x70, 0x38, 0x1C, 0x0E, 0x07, 0x03}, // R diagonal right to left
+    {0x03, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xC0}, // L diagonal left to right
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80}, // H horizontal top
+    {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01}, // h horizontal bottom
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // V vertical left
+    {0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // v vertical right
+    {0x18, 0x7E, 0x7E, 0xFF, 0xFF, 0x7E, 0x7E, 0x18}, // O circle
+    {0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03}, // T border top
+    {0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0}, // b border bottom
+    {0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // < border left
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF}, // > border right
+    {0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03}, // 1 corner left top
+    {0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0xFF, 0xFF}, // 2 corner right top
+    {0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0}, // 3 corner left bottom
+    {0xC0, 0x00, 0xC0, 0xC0, 0xC0, 0xC0, 0xFF, 0xFF}, // 4 corner right bottom
+    {0x00, 0xF0, 0xF8, 0xFC, 0xFC, 0xFE, 0xFE, 0xFE}, // ! circle left top
+    {0xFE, 0xFE, 0xFE, 0xFC, 0xFC, 0xF8, 0xF0, 0x00}, // @ circle right top
+    {0x00, 0x0F, 0x1F, 0x3F, 0x3F, 0x7F, 0x7F, 0x7F}, // # circle left bottom
+    {0x7F, 0x7F, 0x7F, 0x3F, 0x3F, 0x1F, 0x0F, 0x00}  // $ circle right bottom
+};
+
+constexpr unsigned spriteTile(char cell, unsigned tile = 0) {
+    return spriteTileChars[tile] == 0 ? 0 :
+           spriteTileChars[tile] == cell ? tile : spriteTile(cell, tile + 1);
+}
+
+// byte i of the bitmap, pixel column i % SPRITE_STRIDE of tile row i / SPRITE_STRIDE
+constexpr unsigned char spriteByte(const char *art, unsigned i) {
+    return i % SPRITE_STRIDE < SPRITE_PAD || i % SPRITE_STRIDE >= SPRITE_PAD + SPRITE_WIDTH ? 0 :
+           spriteTiles[spriteTile(art[i / SPRITE_STRIDE * SPRITE_COLUMNS + (i % SPRITE_STRIDE - SPRITE_PAD) / 8])]
+                      [(i % SPRITE_STRIDE - SPRITE_PAD) % 8];
+}
+
+// 0 .. N-1 as a parameter pack, split in halves to keep the template depth low
+template <unsigned... I> struct SpriteIndices { };
+
+template <class A, class B> struct SpriteJoin;
+template <unsigned... A, unsigned... B>
+struct SpriteJoin<SpriteIndices<A...>, SpriteIndices<B...> > {
+    typedef SpriteIndices<A..., (sizeof...(A) + B)...> type;
+};
+
+template <unsigned N> struct SpriteRange {
+    typedef typename SpriteJoin<typename SpriteRange<N / 2>::type,
+                                typename SpriteRange<N - N / 2>::type>::type type;
+};
+template <> struct SpriteRange<0> { typedef SpriteIndices<> type; };
+template <> struct SpriteRange<1> { typedef SpriteIndices<0> type; };
+
+template <unsigned... I>
+constexpr Sprite compileSprite(const char *art, SpriteIndices<I...>) {
+    return Sprite { { spriteByte(art, I)... } };
+}
+
+// art is the rows concatenated, exactly SPRITE_CELLS characters
+constexpr Sprite compileSprite(const char (&art)[SPRITE_CELLS + 1]) {
+    return compileSprite(art, SpriteRange<SPRITE_SIZE>::type());
+}
+
+void animationInit(const Sprite **frames, int maxFrames, int moveLimit, int frameDelay, bool center);
 void clearScreen();
 void renderNextFrame();
 void animationEnd();
 
-#endif /* OLED_ANIMATION_H */
\ No newline at end of file
+#endif /* OLED_ANIMATION_H */
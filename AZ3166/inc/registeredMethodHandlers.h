@@ -10,6 +10,7 @@ int fanSpeedDesiredChange(const char *message, size_t size, char **response, siz
 int voltageDesiredChange(const char *message, size_t size, char **response, size_t* resp_size);
 int currentDesiredChange(const char *message, size_t size, char **response, size_t* resp_size);
 int irOnDesiredChange(const char *message, size_t size, char **response, size_t* resp_size);
+int deadbandDesiredChange(const char *message, size_t size, char **response, size_t* resp_size);
 
     
 #endif /* REGISTERED_METHOD_HANDLERS_H */
\ No newline at end of file
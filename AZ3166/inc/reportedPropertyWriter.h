@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef REPORTED_PROPERTY_WRITER_H
+#define REPORTED_PROPERTY_WRITER_H
+
+#include "globals.h"
+
+// keys pending or in flight at once, sent keys give up their entry
+#define REPORTED_MAX_KEYS 8
+#define REPORTED_NAME_MAX_SIZE STRING_BUFFER_32
+#define REPORTED_VALUE_MAX_SIZE STRING_BUFFER_512
+#define REPORTED_PATCH_MAX_SIZE STRING_BUFFER_1024
+
+// flush early once this many bytes of keys and values are pending
+#define REPORTED_FLUSH_SIZE (REPORTED_PATCH_MAX_SIZE / 2)
+
+// a patch that isn't confirmed in time is treated as failed and retried
+#define REPORTED_CONFIRM_TIMEOUT 30000
+#define REPORTED_RETRY_DELAY 1000
+#define REPORTED_MAX_RETRIES 5
+
+typedef struct REPORTED_ENTRY_TAG {
+    char name[REPORTED_NAME_MAX_SIZE];
+    char value[REPORTED_VALUE_MAX_SIZE]; // JSON text, always the latest value
+    unsigned nameLength;
+    unsigned valueLength;
+    bool dirty;    // latest value hasn't been sent yet
+    bool inFlight; // part of the patch awaiting confirmation
+} REPORTED_ENTRY;
+
+// Accumulates reported properties so a burst of updates becomes one twin
+// PATCH. Only the latest value of every key is kept, pending keys are sent
+// once the flush interval expired or enough bytes are pending. One patch is
+// in flight at a time and a failed patch is sent again with its keys' latest
+// values.
+class ReportedPropertyWriter
+{
+    REPORTED_ENTRY entries[REPORTED_MAX_KEYS];
+    unsigned entryCount;
+    unsigned pendingBytes;
+    unsigned long firstPendingTime;
+    unsigned long flushInterval;
+    bool flushRequested;
+
+    bool awaitingConfirmation;
+    int patchId;
+    unsigned long sentTime;
+    unsigned long retryTime;
+    unsigned retryCount;
+
+    REPORTED_ENTRY * findEntry(const char *name, unsigned nameLength);
+
+public:
+    ReportedPropertyWriter(): entryCount(0), pendingBytes(0), firstPendingTime(0),
+                              flushInterval(0), flushRequested(false),
+                              awaitingConfirmation(false), patchId(0), sentTime(0),
+                              retryTime(0), retryCount(0) { }
+
+    // 0 sends pending keys on the next flush check
+    void setFlushInterval(unsigned long interval) { flushInterval = interval; }
+
+    // json is the property value, e.g. 3 or {"value":3}, false when it doesn't fit
+    bool set(const char *name, unsigned nameLength, const char *json, unsigned jsonLength);
+
+    // send at the next flush check regardless of the interval, e.g. twin acknowledgements
+    void requestFlush() { flushRequested = true; }
+
+    bool isFlushDue(unsigned long now);
+
+    // writes the pending keys as one patch and marks them in flight, returns its length
+    unsigned buildPatch(char *buffer, unsigned bufferSize, unsigned long now);
+
+    int getPatchId() { return patchId; }
+
+    // statusCode < 0 means the patch couldn't be handed to the SDK
+    void patchConfirmed(int id, int statusCode, unsigned long now);
+
+    bool hasPending() { return pendingBytes > 0 || awaitingConfirmation; }
+};
+
+#endif /* REPORTED_PROPERTY_WRITER_H */
@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "globals.h"
+
+#define SCHEDULER_MAX_TASKS 16
+
+typedef void (*schedulerCallback)();
+
+typedef struct SCHEDULER_TASK_TAG {
+    const char *name;
+    schedulerCallback callback;
+    unsigned long period;       // ms
+    uint32_t nextDeadline;      // absolute ms on the 32 bit millis() clock, advanced by period after each run
+    unsigned long runCount;
+    unsigned long skippedCount; // periods missed because the task ran late
+    unsigned long totalRunTime; // us
+    unsigned long maxRunTime;   // us
+    unsigned long maxLateness;  // ms past the deadline when the task ran
+} SCHEDULER_TASK;
+
+// cooperative scheduler, tasks are kept in a min-heap ordered by deadline
+void schedulerInit();
+
+// returns the task id or -1 when the task table is full
+int schedulerAddTask(const char *name, unsigned long period, schedulerCallback callback,
+                     unsigned long now);
+
+// move the next deadline of a task to now + delay, e.g. for debouncing
+void schedulerRunIn(int taskId, unsigned long delay, unsigned long now);
+void schedulerSetPeriod(int taskId, unsigned long period);
+
+// run every task whose deadline is at or before now
+void schedulerRun(unsigned long now);
+
+const SCHEDULER_TASK * schedulerGetTask(int taskId);
+int schedulerGetTaskCount();
+void schedulerPrintStats();
+
+#endif /* SCHEDULER_H */
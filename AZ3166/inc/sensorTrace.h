@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef SENSOR_TRACE_H
+#define SENSOR_TRACE_H
+
+#include "globals.h"
+
+// A trace is a header followed by records, little endian as on the device.
+// The recorder prints them over Serial as hex lines starting with
+// SENSOR_TRACE_PREFIX; a trace file is made from a captured log with
+//   grep '^#T' log.txt | cut -c3- | xxd -r -p > sensors.trace
+#define SENSOR_TRACE_MAGIC 0x54535a41 // "AZST"
+#define SENSOR_TRACE_VERSION 1
+#define SENSOR_TRACE_PREFIX "#T"
+
+typedef struct SENSOR_TRACE_HEADER_TAG {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+} SENSOR_TRACE_HEADER;
+
+// every sensor read once, in the units of sensors.h
+typedef struct SENSOR_TRACE_RECORD_TAG {
+    uint32_t time; // ms since the trace started
+    int32_t humidity;
+    int32_t temperature;
+    int32_t pressure;
+    int32_t magnetometer[3];
+    int32_t accelerometer[3];
+    int32_t gyroscope[3];
+} SENSOR_TRACE_RECORD;
+
+// recorder, prints the header then one record per capture
+void sensorTraceStart(unsigned long now);
+void sensorTraceCapture(unsigned long now);
+
+#ifdef SENSOR_TRACE_REPLAY
+
+// With SENSOR_TRACE_REPLAY defined sensorTrace.cpp implements sensors.h from a
+// trace file so the sampling and telemetry code runs on a Linux host. Build it
+// in place of sensors.cpp and the drivers (hts221, motionFifo, i2cBus).
+
+#ifndef SENSOR_TRACE_PATH
+#define SENSOR_TRACE_PATH "sensors.trace"
+#endif
+
+// trace ms per real ms, 0 - the trace time only moves with sensorReplaySeek
+#ifndef SENSOR_TRACE_SPEED
+#define SENSOR_TRACE_SPEED 1
+#endif
+
+// initSensors() opens SENSOR_TRACE_PATH at SENSOR_TRACE_SPEED, the trace loops at its end
+bool sensorReplayOpen(const char *path, unsigned speed);
+void sensorReplayClose();
+void sensorReplaySeek(uint32_t time);
+
+// the last record at or before the trace time, NULL when no trace is open
+const SENSOR_TRACE_RECORD *sensorReplayCurrent();
+unsigned getSensorReplayRecordCount();
+
+#endif // SENSOR_TRACE_REPLAY
+
+#endif /* SENSOR_TRACE_H */
@@ -4,14 +4,25 @@
 #ifndef SENSORS_H
 #define SENSORS_H
 
+#include "motionFifo.h"
+#include "fixedPoint.h"
+
 void initSensors();
 
+// environmental readings are scaled integers, see fixedPoint.h
+#define HUMIDITY_DECIMALS 2     // 1/100 %RH
+#define TEMPERATURE_DECIMALS 2  // 1/100 C
+#define PRESSURE_DECIMALS 3     // 1/1000 hPa
+
+// a failed read reports 0xFFFF in the unit of the sensor
+#define SENSOR_READ_ERROR(decimals) (0xFFFF * (int32_t)fixedScales[decimals])
+
 // HTS221
-float readHumidity();
-float readTemperature();
+int32_t readHumidity();
+int32_t readTemperature();
 
 // LPS22HB
-float readPressure();
+int32_t readPressure();
 
 // LIS2MDL
 void readMagnetometer(int *axes);
@@ -19,7 +30,21 @@ void readMagnetometer(int *axes);
 // LSM6DSL
 void readAccelerometer(int *axes);
 void readGyroscope(int *axes);
+
+// either may be NULL, both come from a single burst read
+void readMotion(int *accel, int *gyro);
+
+// true once two wake up interrupts came within a second and at least 150 ms
+// apart, reads no registers
 bool checkForShake();
+// wake ups so far can't be part of a later shake
+void discardShakes();
+unsigned long getShakeInterruptCount();
+unsigned long getShakeWakeUpCount(); // interrupts that weren't part of the previous jolt
+unsigned long getShakeCount();
+
+// streams every accelerometer and gyroscope sample through the FIFO, see motionFifo.h
+bool enableMotionFifo(MotionOdr odr, unsigned watermark);
 
 // RGB LED
 void setLedColor(uint8_t red, uint8_t green, uint8_t blue);
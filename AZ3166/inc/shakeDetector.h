@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef SHAKE_DETECTOR_H
+#define SHAKE_DETECTOR_H
+
+#include "globals.h"
+
+// a shake is a second wake up interrupt within SHAKE_WINDOW ms of the first,
+// interrupts closer than SHAKE_MIN_SPACING ms to the last counted one are the
+// same jolt
+#define SHAKE_WINDOW 1000
+#define SHAKE_MIN_SPACING 150
+
+// Turns accelerometer wake up interrupts into shakes. The interrupt handler
+// only counts, the shakes are found when the counts are polled. A zero
+// initialized detector has seen nothing.
+typedef struct SHAKE_DETECTOR_TAG {
+    // written by the interrupt handler only
+    volatile unsigned long interruptCount;
+    volatile unsigned long wakeUpCount; // interrupts at least SHAKE_MIN_SPACING apart
+    unsigned long lastWakeUpTime;
+
+    unsigned long handledCount;
+    unsigned long windowCount; // wake ups before the open window
+    unsigned long windowStart;
+    unsigned long shakeCount;
+} SHAKE_DETECTOR;
+
+// from the interrupt handler
+void shakeDetectorWakeUp(SHAKE_DETECTOR *detector, unsigned long now);
+
+// true once per shake since the last call
+bool shakeDetectorCheck(SHAKE_DETECTOR *detector, unsigned long now);
+
+// forgets the wake ups so far, they can't be part of a later shake
+void shakeDetectorDiscard(SHAKE_DETECTOR *detector);
+
+#endif /* SHAKE_DETECTOR_H */
@@ -10,10 +10,42 @@ void incrementReportedCount();
 void incrementErrorCount();
 void incrementTelemetryCount();
 void incrementDesiredCount();
+void incrementBatchCount(int sampleCount);
+void recordTwinLatency(unsigned long latency);
+void recordTwinDeliveryLatency(long latency);
+void recordConfirmLatency(unsigned long latency);
+void incrementBackpressureCount();
+void incrementPoolExhaustedCount();
+void incrementReportedCoalescedCount();
+void incrementReportedPatchCount();
+void incrementReportedRetryCount();
+void incrementOfflineStoredCount();
+void incrementOfflineReplayedCount();
+void incrementOfflineDroppedCount();
+void recordTelemetryEncoding(unsigned payloadSize, unsigned long encodeTime);
 
 int getReportedCount();
 int getErrorCount();
 int getTelemetryCount();
 int getDesiredCount();
+int getBatchCount();
+int getBatchedSampleCount();
+int getMessagesSavedPerHour();
+unsigned long getTwinLatencyAverage();
+unsigned long getTwinLatencyMax();
+unsigned long getTwinDeliveryLatencyAverage();
+unsigned long getTwinDeliveryLatencyMax();
+unsigned long getTwinDeliveryCount();
+int getBackpressureCount();
+int getPoolExhaustedCount();
+int getReportedCoalescedCount();
+int getReportedPatchCount();
+int getReportedRetryCount();
+int getOfflineStoredCount();
+int getOfflineReplayedCount();
+int getOfflineDroppedCount();
+unsigned getTelemetrySizeAverage();
+unsigned long getTelemetryEncodeTimeAverage();
+void printConfirmLatencyHistogram();
 
 #endif /* STATS_H */
\ No newline at end of file
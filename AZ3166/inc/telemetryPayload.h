@@ -0,0 +1,18 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef TELEMETRY_PAYLOAD_H
+#define TELEMETRY_PAYLOAD_H
+
+#include "globals.h"
+#include "telemetryQueue.h"
+
+// Summarizes the samples taken since the last call and encodes them, plus the
+// vibration summary, as one JSON or CBOR telemetry message. Without aggregate
+// only the last value of each field is sent. fieldCount is set to the number
+// of fields that made it past the deadband, which takes them as sent only on
+// deadbandCommit(). Returns the payload length, 0 when it didn't fit.
+unsigned buildTelemetryPayload(char *payload, unsigned payloadSize, MessageFormat format,
+                               bool aggregate, unsigned *fieldCount);
+
+#endif /* TELEMETRY_PAYLOAD_H */
@@ -0,0 +1,94 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef TELEMETRY_QUEUE_H
+#define TELEMETRY_QUEUE_H
+
+#include <time.h>
+#include "globals.h"
+#include "flashStore.h"
+
+#define TELEMETRY_QUEUE_MAX_SECTORS 8
+
+// replay pacing, a queued message every interval while the in flight window
+// keeps TELEMETRY_REPLAY_RESERVE slots free for live telemetry
+#define TELEMETRY_REPLAY_INTERVAL 250
+#define TELEMETRY_REPLAY_RESERVE 1
+
+// payload encoding, sets the content type of the message sent to the hub
+typedef enum { MESSAGE_FORMAT_JSON, MESSAGE_FORMAT_CBOR } MessageFormat;
+
+typedef struct QUEUED_MESSAGE_TAG {
+    uint32_t messageId;
+    MessageFormat format;
+    time_t sampleTime;      // utc seconds
+    unsigned sampleMillis;
+    unsigned level;         // downsampling passes the message survived
+    unsigned length;
+} QUEUED_MESSAGE;
+
+// Store and forward queue for telemetry that couldn't be sent. Records are
+// appended to flash sectors in order and replayed oldest first. One sector
+// is always kept erased; once no other sector is free and the write sector
+// is half full, the two oldest are merged into it keeping every other record,
+// so old data gets sparser instead of new data being dropped.
+// A sector erase takes 1-2 s on the STM32F412, so push(), pop() and peek()
+// only program. Sectors they are done with are retired, maintain() erases
+// them and does the merging, one sector at a time from a low priority task.
+class TelemetryQueue
+{
+    FlashStore &flash;
+    uint32_t sectorSize;
+    unsigned sectorCount;
+    uint32_t sectorSequence[TELEMETRY_QUEUE_MAX_SECTORS]; // replay order, SECTOR_FREE when erased
+
+    int writeSector;
+    uint32_t writeOffset;
+    int readSector; // oldest unconsumed record, -1 when the queue is empty
+    uint32_t readOffset;
+
+    uint32_t nextSequence;
+    uint32_t nextMessageId;
+    unsigned count;
+    unsigned downsampledCount;
+    bool ready;
+
+    int findSector(bool oldest, int after);
+    int findFreeSector();
+    int findRetiredSector();
+    unsigned getFreeSectorCount();
+    bool eraseSector(int sector);
+    bool retireSector(int sector);
+    bool openSector();
+    bool downsample();
+    bool scanSector(int sector, uint32_t *endOffset, uint32_t *maxMessageId);
+    bool findUnconsumed(int sector, uint32_t from, uint32_t *offset);
+    void advanceRead(int sector, uint32_t from);
+
+public:
+    TelemetryQueue(FlashStore &flash_): flash(flash_), sectorSize(0), sectorCount(0),
+                                        writeSector(-1), writeOffset(0), readSector(-1),
+                                        readOffset(0), nextSequence(1), nextMessageId(1),
+                                        count(0), downsampledCount(0), ready(false) { }
+
+    // recovers the queue left in flash by a previous run
+    bool init();
+
+    bool push(const char *payload, unsigned length, MessageFormat format, time_t sampleTime,
+              unsigned sampleMillis);
+
+    // oldest message, the payload is null terminated; when the payload doesn't
+    // fit it returns false with message still filled in, so it can be popped
+    bool peek(QUEUED_MESSAGE *message, char *payload, unsigned payloadSize);
+
+    // drop the oldest message once the hub confirmed it, ignored if messageId isn't the oldest
+    bool pop(uint32_t messageId);
+
+    // erases one retired sector or merges two full ones, true when it did either
+    bool maintain();
+
+    unsigned getCount() { return count; }
+    unsigned getDownsampledCount() { return downsampledCount; }
+};
+
+#endif /* TELEMETRY_QUEUE_H */
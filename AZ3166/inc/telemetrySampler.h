@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef TELEMETRY_SAMPLER_H
+#define TELEMETRY_SAMPLER_H
+
+#include "globals.h"
+
+#define SAMPLER_BUFFER_SIZE 32
+
+// order of the fields in the telemetry payload
+typedef enum {
+    HUMIDITY_FIELD, TEMP_FIELD, PRESSURE_FIELD,
+    MAG_X_FIELD, MAG_Y_FIELD, MAG_Z_FIELD,
+    ACCEL_X_FIELD, ACCEL_Y_FIELD, ACCEL_Z_FIELD,
+    GYRO_X_FIELD, GYRO_Y_FIELD, GYRO_Z_FIELD,
+    TELEMETRY_FIELD_COUNT
+} TelemetryField;
+
+typedef enum { FIELD_LAST, FIELD_MIN, FIELD_MAX, FIELD_MEAN, FIELD_KEY_COUNT } FieldKey;
+
+typedef struct TELEMETRY_FIELD_INFO_TAG {
+    const char *name;
+    const char *keys[FIELD_KEY_COUNT]; // JSON_KEY prefixes, see TELEMETRY_FIELD
+    uint8_t keyLengths[FIELD_KEY_COUNT];
+    uint8_t sensorMask; // *_CHECKED bit selecting the field
+    uint8_t decimals;   // samples are integers scaled by 10^decimals
+    uint8_t precision;  // decimals sent for last, min and max
+    uint8_t meanPrecision;
+} TELEMETRY_FIELD_INFO;
+
+typedef struct TELEMETRY_SAMPLE_TAG {
+    unsigned long sampleTime;
+    int32_t values[TELEMETRY_FIELD_COUNT];
+} TELEMETRY_SAMPLE;
+
+// scaled like the samples, except the mean which has getMeanDecimals()
+typedef struct FIELD_AGGREGATE_TAG {
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+    int32_t last;
+} FIELD_AGGREGATE;
+
+extern const TELEMETRY_FIELD_INFO telemetryFields[TELEMETRY_FIELD_COUNT];
+
+// the mean keeps enough decimals for its precision
+static inline unsigned getMeanDecimals(int field) {
+    const TELEMETRY_FIELD_INFO &info = telemetryFields[field];
+    return info.meanPrecision > info.decimals ? info.meanPrecision : info.decimals;
+}
+
+// decimals and sent precision of one aggregate value
+static inline unsigned getFieldDecimals(int field, FieldKey key) {
+    return key == FIELD_MEAN ? getMeanDecimals(field) : telemetryFields[field].decimals;
+}
+
+static inline unsigned getFieldPrecision(int field, FieldKey key) {
+    return key == FIELD_MEAN ? telemetryFields[field].meanPrecision : telemetryFields[field].precision;
+}
+
+void samplerInit(uint8_t telemetryState);
+
+// read the selected sensors into the ring buffer
+void samplerTakeSample();
+
+// summarize the buffered samples and empty the buffer, returns the sample count
+unsigned samplerAggregate(FIELD_AGGREGATE *aggregates);
+
+bool isFieldSelected(int field);
+unsigned getSamplerOverwriteCount();
+unsigned long getSamplerMotionMissedCount(); // FIFO samples lost before the sampler read them
+
+#endif /* TELEMETRY_SAMPLER_H */
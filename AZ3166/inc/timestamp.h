@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <time.h>
+
+// "2017-10-01T18:18:36.123Z"
+#define ISO8601_TIMESTAMP_LENGTH 24
+
+// ties millis() to the start of the current RTC second, called right after
+// the RTC was set so the milliseconds count from the true second boundary
+void anchorCurrentTime();
+
+// true once anchorCurrentTime() was called, the RTC is on utc
+bool isTimeSynced();
+
+// current utc time, milliseconds on the same clock as formatIsoTimestamp
+void getCurrentTime(time_t *seconds, unsigned *milliseconds);
+
+// current utc time as ISO-8601 with milliseconds, returns the length written
+unsigned formatIsoTimestamp(char *buffer, unsigned bufferSize);
+
+// ISO-8601 for a given utc time, no caching
+unsigned formatIsoTimestampAt(time_t seconds, unsigned milliseconds, char *buffer, unsigned bufferSize);
+
+// "2017-10-01T18:18:36.1234567Z" as the hub writes it, any number of fraction
+// digits, none included; false when it isn't such a timestamp
+bool parseIsoTimestamp(const char *text, unsigned length, time_t *seconds, unsigned *milliseconds);
+
+#endif /* TIMESTAMP_H */
@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef TWIN_PARSER_H
+#define TWIN_PARSER_H
+
+#include "globals.h"
+
+#define TWIN_MAX_PROPERTIES MAX_CALLBACK_COUNT
+
+// points into the twin payload, nothing is copied
+typedef struct TWIN_SPAN_TAG {
+    const char *start;
+    unsigned length;
+} TWIN_SPAN;
+
+typedef struct TWIN_PROPERTY_TAG {
+    TWIN_SPAN name;
+    TWIN_SPAN desired;                // raw JSON of the desired entry
+    TWIN_SPAN desiredValue;           // its "value" member, or the entry itself when it is a scalar
+    TWIN_SPAN reportedValue;          // "value" member of the reported entry
+    TWIN_SPAN reportedDesiredVersion; // "desiredVersion" member of the reported entry
+    bool inDesired;
+    bool inReported;
+} TWIN_PROPERTY;
+
+typedef struct TWIN_DOCUMENT_TAG {
+    TWIN_PROPERTY properties[TWIN_MAX_PROPERTIES];
+    unsigned propertyCount;
+    unsigned droppedCount; // properties that didn't fit in the table
+    TWIN_SPAN desiredVersion;
+    TWIN_SPAN reportedVersion;
+    TWIN_SPAN desiredLastUpdated; // "$lastUpdated" of the desired $metadata, without the quotes
+} TWIN_DOCUMENT;
+
+// single pass over a twin payload. a full twin has "desired" and "reported" sections,
+// a partial update is the desired section itself. Of $metadata only the $lastUpdated
+// of the desired section is kept, other $ members but $version are skipped
+bool twinParse(const char *payload, unsigned size, bool partial, TWIN_DOCUMENT *document);
+
+static inline bool twinSpanEquals(const TWIN_SPAN &a, const TWIN_SPAN &b) {
+    return a.length == b.length && a.length != 0 && memcmp(a.start, b.start, a.length) == 0;
+}
+
+// copy the span as a null terminated string, false when it doesn't fit
+bool twinSpanCopy(const TWIN_SPAN &span, char *buffer, unsigned bufferSize);
+
+#endif /* TWIN_PARSER_H */
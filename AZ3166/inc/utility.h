@@ -127,6 +127,11 @@ public:
         return text;
     }
 
+    // -1 when the member is missing or isn't a boolean
+    int getBooleanByName(const char * name) {
+        return json_object_get_boolean(object, name);
+    }
+
     double getNumberByName(const char * name) {
         // API returns 0.0 on fail hence it doesn't actually have a good
         // fail discovery strategy
@@ -136,5 +141,6 @@ public:
 
 unsigned urldecode(const char * url, unsigned length, AutoString * outURL);
 bool SyncTimeToNTP();
+char * dtostrf(double number, signed char width, unsigned char prec, char *s);
 
 #endif /* INC_UTILITY_H */
\ No newline at end of file
@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef VIBRATION_H
+#define VIBRATION_H
+
+#include "globals.h"
+
+#define VIBRATION_BAND_COUNT 4
+#define VIBRATION_DECIMALS 2 // rms in 1/100 mg, frequency in 1/100 Hz
+
+// averaged over the windows analyzed since the previous summary
+typedef struct VIBRATION_SUMMARY_TAG {
+    int32_t rms;                            // of the three axes together
+    int32_t peakFrequency;                  // strongest bin of any axis and window
+    int32_t bands[VIBRATION_BAND_COUNT];    // rms per frequency band
+    unsigned windowCount;
+} VIBRATION_SUMMARY;
+
+// Vibration spectrum of the accelerometer. Samples come from the motion FIFO,
+// every FFT_SIZE of them the mean is removed from each axis, a Hann window
+// applied and the power spectrum summed into the bands.
+bool vibrationInit();
+bool isVibrationEnabled();
+
+// analyzes every complete window read from the FIFO ring
+void vibrationProcess();
+
+// false when no window completed since the last summary
+bool vibrationTakeSummary(VIBRATION_SUMMARY *summary);
+
+unsigned long getVibrationWindowCount();
+unsigned long getVibrationMissedCount();     // FIFO samples lost before they were read
+unsigned long getVibrationAnalysisTimeMax(); // us for the three axes of a window
+
+#endif /* VIBRATION_H */
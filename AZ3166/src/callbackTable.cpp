@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/callbackTable.h"
+
+static inline char toUpperAscii(char c) {
+    return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+}
+
+uint32_t callbackNameHash(const char *name, unsigned length) {
+    uint32_t hash = 2166136261U;
+    for (unsigned i = 0; i < length; i++) {
+        hash ^= (uint8_t)toUpperAscii(name[i]);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+bool callbackTableAdd(CALLBACK_TABLE *table, const char *name, hubMethodCallback callback) {
+    if (table->count >= MAX_CALLBACK_COUNT) {
+        return false;
+    }
+
+    if (table->count == 0) {
+        memset(table->buckets, -1, CALLBACK_TABLE_SIZE);
+    }
+
+    const uint32_t nameLength = strlen(name);
+    CALLBACK_LOOKUP *entry = &table->list[table->count];
+    entry->name = (char*) malloc(nameLength + 1);
+    if (entry->name == NULL) {
+        LOG_ERROR("registering the callback failed (OUT OF MEMORY)");
+        return false;
+    }
+    memcpy(entry->name, name, nameLength);
+    entry->name[nameLength] = char(0);
+    strupr(entry->name);
+    entry->hash = callbackNameHash(name, nameLength);
+    entry->callback = callback;
+
+    unsigned bucket = entry->hash % CALLBACK_TABLE_SIZE;
+    while (table->buckets[bucket] != -1) {
+        bucket = (bucket + 1) % CALLBACK_TABLE_SIZE;
+    }
+    table->buckets[bucket] = (int8_t)table->count;
+    table->count++;
+
+    return true;
+}
+
+CALLBACK_LOOKUP *callbackTableFind(CALLBACK_TABLE *table, const char *name, unsigned nameLength) {
+    if (table->count == 0 || name == NULL) {
+        return NULL;
+    }
+
+    const uint32_t hash = callbackNameHash(name, nameLength);
+    unsigned bucket = hash % CALLBACK_TABLE_SIZE;
+    while (table->buckets[bucket] != -1) {
+        CALLBACK_LOOKUP *entry = &table->list[table->buckets[bucket]];
+        if (entry->hash == hash && strncasecmp(entry->name, name, nameLength) == 0 &&
+            entry->name[nameLength] == char(0)) {
+            return entry;
+        }
+        bucket = (bucket + 1) % CALLBACK_TABLE_SIZE;
+    }
+
+    return NULL;
+}
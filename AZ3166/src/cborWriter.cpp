@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/cborWriter.h"
+
+#define CBOR_UNSIGNED 0
+#define CBOR_NEGATIVE 1
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+
+#define CBOR_MAP_INDEFINITE 0xBF
+#define CBOR_BREAK 0xFF
+#define CBOR_HALF 0xF9
+#define CBOR_SINGLE 0xFA
+
+// half precision bits when value converts without loss, -1 otherwise
+static int32_t toExactHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int exponent = (int)((bits >> 23) & 0xFF);
+    const uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0 && mantissa == 0) {
+        return sign; // +-0
+    }
+    if (exponent == 0xFF) {
+        return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0); // inf, nan
+    }
+
+    // normal half values only, 5 exponent and 10 mantissa bits
+    const int halfExponent = exponent - 127 + 15;
+    if (halfExponent < 1 || halfExponent > 30 || (mantissa & 0x1FFF) != 0) {
+        return -1;
+    }
+    return sign | (halfExponent << 10) | (mantissa >> 13);
+}
+
+void CborWriter::appendRaw(const void * data, unsigned dataLength) {
+    if (overflow) return;
+
+    if (length + dataLength > capacity) {
+        overflow = true;
+        return;
+    }
+
+    memcpy(buffer + length, data, dataLength);
+    length += dataLength;
+}
+
+// major type and argument in the shortest form, multi byte values are big endian
+void CborWriter::appendHead(uint8_t majorType, uint32_t value) {
+    uint8_t head[5];
+    unsigned headLength;
+
+    if (value < 24) {
+        head[0] = (majorType << 5) | value;
+        headLength = 1;
+    } else if (value <= 0xFF) {
+        head[0] = (majorType << 5) | 24;
+        head[1] = value;
+        headLength = 2;
+    } else if (value <= 0xFFFF) {
+        head[0] = (majorType << 5) | 25;
+        head[1] = value >> 8;
+        head[2] = value;
+        headLength = 3;
+    } else {
+        head[0] = (majorType << 5) | 26;
+        head[1] = value >> 24;
+        head[2] = value >> 16;
+        head[3] = value >> 8;
+        head[4] = value;
+        headLength = 5;
+    }
+
+    appendRaw(head, headLength);
+}
+
+void CborWriter::appendKey(const char * key, unsigned keyLength) {
+    appendHead(CBOR_TEXT, keyLength);
+    appendRaw(key, keyLength);
+}
+
+void CborWriter::beginMap() {
+    const uint8_t head = CBOR_MAP_INDEFINITE;
+    appendRaw(&head, 1);
+}
+
+void CborWriter::endMap() {
+    const uint8_t head = CBOR_BREAK;
+    appendRaw(&head, 1);
+}
+
+void CborWriter::beginArray(unsigned count) {
+    appendHead(CBOR_ARRAY, count);
+}
+
+void CborWriter::appendFloatValue(float value) {
+    uint8_t number[5];
+    const int32_t half = toExactHalf(value);
+    if (half >= 0) {
+        number[0] = CBOR_HALF;
+        number[1] = half >> 8;
+        number[2] = half;
+        appendRaw(number, 3);
+        return;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    number[0] = CBOR_SINGLE;
+    number[1] = bits >> 24;
+    number[2] = bits >> 16;
+    number[3] = bits >> 8;
+    number[4] = bits;
+    appendRaw(number, 5);
+}
+
+void CborWriter::appendIntValue(int value) {
+    // negative n is encoded as -1 - n
+    if (value < 0) {
+        appendHead(CBOR_NEGATIVE, (uint32_t)(-1 - value));
+    } else {
+        appendHead(CBOR_UNSIGNED, (uint32_t)value);
+    }
+}
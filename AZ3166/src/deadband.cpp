@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/deadband.h"
+#include "../inc/fixedPoint.h"
+
+// absolute thresholds in the unit of each field
+static const float defaultThresholds[TELEMETRY_FIELD_COUNT] = {
+    0.5f,                   // humidity %
+    0.2f,                   // temperature C
+    0.1f,                   // pressure hPa
+    5.0f, 5.0f, 5.0f,       // magnetometer mgauss
+    20.0f, 20.0f, 20.0f,    // accelerometer mg
+    100.0f, 100.0f, 100.0f  // gyroscope mdps
+};
+
+static DEADBAND_FIELD fields[TELEMETRY_FIELD_COUNT];
+static unsigned long heartbeat = DEADBAND_DEFAULT_HEARTBEAT;
+static bool deadbandEnabled = false;
+
+void deadbandInit(bool enabled) {
+    memset(fields, 0, sizeof(fields));
+    for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+        fields[field].absolute = toFixed(defaultThresholds[field], telemetryFields[field].decimals);
+    }
+    heartbeat = DEADBAND_DEFAULT_HEARTBEAT;
+    deadbandEnabled = enabled;
+}
+
+bool isDeadbandEnabled() {
+    return deadbandEnabled;
+}
+
+static bool hasChanged(const DEADBAND_FIELD *state, int32_t value) {
+    const int32_t change = value > state->lastSent ? value - state->lastSent : state->lastSent - value;
+    const bool useAbsolute = state->absolute > 0;
+    const bool useRelative = state->relative > 0;
+
+    if (!useAbsolute && !useRelative) {
+        return change != 0;
+    }
+    return (useAbsolute && change > state->absolute) ||
+           (useRelative && change > state->relative * abs(state->lastSent));
+}
+
+bool deadbandShouldSend(int field, const FIELD_AGGREGATE &values, unsigned long now) {
+    DEADBAND_FIELD *state = &fields[field];
+
+    // a spike that settled again before the send still shows in min or max
+    if (deadbandEnabled && state->hasSent && now - state->lastSentTime < heartbeat &&
+        !hasChanged(state, values.last) && !hasChanged(state, values.min) && !hasChanged(state, values.max)) {
+        state->pending = false;
+        state->suppressedCount++;
+        return false;
+    }
+
+    state->pendingValue = values.last;
+    state->pending = true;
+    return true;
+}
+
+void deadbandCommit(unsigned long now) {
+    for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+        DEADBAND_FIELD *state = &fields[field];
+        if (state->pending) {
+            state->lastSent = state->pendingValue;
+            state->lastSentTime = now;
+            state->hasSent = true;
+            state->pending = false;
+        }
+    }
+}
+
+void deadbandDiscard() {
+    for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+        fields[field].pending = false;
+    }
+}
+
+bool deadbandConfigure(JSObject *config) {
+    char relativeName[STRING_BUFFER_32];
+
+    if (config->hasProperty("heartbeat")) {
+        const double seconds = config->getNumberByName("heartbeat");
+        if (seconds <= 0) {
+            LOG_ERROR("'heartbeat' has to be a positive number of seconds");
+            return false;
+        }
+        heartbeat = (unsigned long)(seconds * 1000);
+    }
+
+    for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+        const char *name = telemetryFields[field].name;
+        snprintf(relativeName, sizeof(relativeName), "%sRel", name);
+
+        if (config->hasProperty(name)) {
+            fields[field].absolute = toFixed(max(0.0, config->getNumberByName(name)),
+                                             telemetryFields[field].decimals);
+        }
+        if (config->hasProperty(relativeName)) {
+            fields[field].relative = max(0.0, config->getNumberByName(relativeName));
+        }
+    }
+
+    const int enabled = config->getBooleanByName("enabled");
+    if (enabled != -1) {
+        deadbandEnabled = enabled == 1;
+    }
+
+    return true;
+}
+
+unsigned long getDeadbandSuppressedCount(int field) {
+    return fields[field].suppressedCount;
+}
+
+unsigned long getDeadbandSuppressedTotal() {
+    unsigned long total = 0;
+    for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+        total += fields[field].suppressedCount;
+    }
+    return total;
+}
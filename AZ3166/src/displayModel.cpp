@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/displayModel.h"
+
+#include "OledDisplay.h"
+
+typedef char DisplayLine[AZ3166_DISPLAY_MAX_COLUMN + 1];
+
+static DisplayLine pending[DISPLAY_LINE_COUNT];
+static DisplayLine drawn[DISPLAY_LINE_COUNT];
+static bool drawnValid = false; // false after the screen was changed behind the model
+static unsigned long minRefresh = DISPLAY_MIN_REFRESH_INTERVAL;
+static unsigned long lastFlushTime = 0;
+static bool hasFlushed = false;
+static bool flushSkipped = false;
+
+static unsigned long linesDrawn = 0;
+static unsigned long linesUnchanged = 0;
+static unsigned long flushesSkipped = 0;
+static unsigned long busTime = 0;
+
+// copies up to the column count and pads with spaces
+static void setLine(int line, const char *text, unsigned length) {
+    length = min(length, (unsigned)AZ3166_DISPLAY_MAX_COLUMN);
+    memcpy(pending[line], text, length);
+    memset(pending[line] + length, ' ', AZ3166_DISPLAY_MAX_COLUMN - length);
+    pending[line][AZ3166_DISPLAY_MAX_COLUMN] = 0;
+}
+
+void displayModelInit(unsigned long minRefreshInterval) {
+    minRefresh = minRefreshInterval;
+    for (int line = 0; line < DISPLAY_LINE_COUNT; line++) {
+        setLine(line, "", 0);
+    }
+    drawnValid = false;
+    hasFlushed = false;
+    flushSkipped = false;
+}
+
+void displayModelSetLine(int line, const char *text) {
+    assert(line >= 0 && line < DISPLAY_LINE_COUNT);
+    setLine(line, text, strlen(text));
+}
+
+void displayModelSetText(const char *text) {
+    for (int line = 0; line < DISPLAY_LINE_COUNT; line++) {
+        const char *end = strstr(text, "\r\n");
+        const unsigned length = end != NULL ? end - text : strlen(text);
+        setLine(line, text, length);
+        text += end != NULL ? length + 2 : length;
+    }
+}
+
+void displayModelClear() {
+    const unsigned long start = micros();
+    Screen.clean();
+    busTime += micros() - start;
+    drawnValid = false;
+}
+
+unsigned displayModelFlush(unsigned long now) {
+    if (hasFlushed && now - lastFlushTime < minRefresh) {
+        flushesSkipped++;
+        flushSkipped = true;
+        return 0;
+    }
+    lastFlushTime = now;
+    hasFlushed = true;
+    flushSkipped = false;
+
+    unsigned count = 0;
+    const unsigned long start = micros();
+    for (int line = 0; line < DISPLAY_LINE_COUNT; line++) {
+        if (drawnValid && memcmp(drawn[line], pending[line], AZ3166_DISPLAY_MAX_COLUMN) == 0) {
+            linesUnchanged++;
+            continue;
+        }
+        Screen.print(line, pending[line]);
+        memcpy(drawn[line], pending[line], sizeof(DisplayLine));
+        count++;
+    }
+    busTime += micros() - start;
+
+    drawnValid = true;
+    linesDrawn += count;
+    return count;
+}
+
+unsigned long displayModelFlushDelay(unsigned long now) {
+    if (!flushSkipped) return 0;
+    const unsigned long elapsed = now - lastFlushTime;
+    return elapsed < minRefresh ? minRefresh - elapsed : 1;
+}
+
+unsigned long getDisplayLinesDrawn() {
+    return linesDrawn;
+}
+
+unsigned long getDisplayLinesUnchanged() {
+    return linesUnchanged;
+}
+
+unsigned long getDisplayFlushesSkipped() {
+    return flushesSkipped;
+}
+
+unsigned long getDisplayBusTime() {
+    return busTime;
+}
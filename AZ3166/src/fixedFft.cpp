@@ -0,0 +1,153 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/fixedFft.h"
+#include <math.h>
+
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+#include "cmsis.h"
+#define FFT_USE_DSP
+#endif
+
+#define HALF_SIZE (FFT_SIZE / 2)
+
+// complex Q15 values packed as the real part in the low and the imaginary
+// part in the high half word, the operand layout of the M4 dual 16 bit ops
+typedef uint32_t complex16;
+
+static complex16 twiddles[HALF_SIZE]; // e^(-2 pi i k / FFT_SIZE)
+static int16_t hannWindow[FFT_SIZE];
+static complex16 buffer[HALF_SIZE];
+static uint8_t bitReversed[HALF_SIZE];
+
+static inline complex16 pack(int32_t re, int32_t im) {
+    return (uint16_t)re | ((uint32_t)(uint16_t)im << 16);
+}
+
+static inline int16_t real(complex16 value) {
+    return (int16_t)(value & 0xFFFF);
+}
+
+static inline int16_t imag(complex16 value) {
+    return (int16_t)(value >> 16);
+}
+
+static inline complex16 conjugate(complex16 value) {
+    return pack(real(value), -imag(value));
+}
+
+#ifdef FFT_USE_DSP
+
+static inline complex16 multiply(complex16 a, complex16 w) {
+    // CMSIS declares the results unsigned
+    return pack((int32_t)__SMUSD(a, w) >> 15, (int32_t)__SMUADX(a, w) >> 15);
+}
+
+static inline complex16 halvingAdd(complex16 a, complex16 b) {
+    return __SHADD16(a, b);
+}
+
+static inline complex16 halvingSubtract(complex16 a, complex16 b) {
+    return __SHSUB16(a, b);
+}
+
+#else
+
+static inline complex16 multiply(complex16 a, complex16 w) {
+    return pack((real(a) * real(w) - imag(a) * imag(w)) >> 15,
+                (real(a) * imag(w) + imag(a) * real(w)) >> 15);
+}
+
+static inline complex16 halvingAdd(complex16 a, complex16 b) {
+    return pack((real(a) + real(b)) >> 1, (imag(a) + imag(b)) >> 1);
+}
+
+static inline complex16 halvingSubtract(complex16 a, complex16 b) {
+    return pack((real(a) - real(b)) >> 1, (imag(a) - imag(b)) >> 1);
+}
+
+#endif // FFT_USE_DSP
+
+// symmetric range, -32768 twiddles could overflow the dual multiply accumulate
+static inline int16_t toQ15(float value) {
+    const int32_t scaled = (int32_t)floorf(value * 32768.0f + 0.5f);
+    return (int16_t)(scaled > 32767 ? 32767 : scaled < -32767 ? -32767 : scaled);
+}
+
+void fftInit() {
+    const float pi = 3.14159265358979f;
+
+    for (int k = 0; k < HALF_SIZE; k++) {
+        const float angle = 2 * pi * k / FFT_SIZE;
+        twiddles[k] = pack(toQ15(cosf(angle)), toQ15(-sinf(angle)));
+    }
+
+    for (int n = 0; n < FFT_SIZE; n++) {
+        hannWindow[n] = toQ15(0.5f - 0.5f * cosf(2 * pi * n / FFT_SIZE));
+    }
+
+    int bits = 0;
+    while ((1 << bits) < HALF_SIZE) bits++;
+    for (int i = 0; i < HALF_SIZE; i++) {
+        int reversed = 0;
+        for (int bit = 0; bit < bits; bit++) {
+            reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+        }
+        bitReversed[i] = reversed;
+    }
+}
+
+void fftApplyWindow(int16_t *samples) {
+    for (int n = 0; n < FFT_SIZE; n++) {
+        samples[n] = (int16_t)((samples[n] * hannWindow[n]) >> 15);
+    }
+}
+
+// radix 2 decimation in time, every stage halves so the result is DFT / HALF_SIZE
+static void complexFft() {
+    for (int size = 2; size <= HALF_SIZE; size <<= 1) {
+        const int half = size / 2;
+        const int step = FFT_SIZE / size; // twiddles of the half size transform are every other one
+        for (int start = 0; start < HALF_SIZE; start += size) {
+            for (int j = 0; j < half; j++) {
+                complex16 *a = &buffer[start + j];
+                complex16 *b = &buffer[start + j + half];
+                const complex16 t = multiply(*b, twiddles[j * step]);
+                const complex16 top = *a;
+                *a = halvingAdd(top, t);
+                *b = halvingSubtract(top, t);
+            }
+        }
+    }
+}
+
+static inline uint32_t magnitudeSquared(int32_t re, int32_t im) {
+    return (uint32_t)(re * re) + (uint32_t)(im * im);
+}
+
+void fftRealPower(const int16_t *samples, uint32_t *power) {
+    // even samples as the real, odd samples as the imaginary parts
+    for (int n = 0; n < HALF_SIZE; n++) {
+        buffer[bitReversed[n]] = pack(samples[2 * n], samples[2 * n + 1]);
+    }
+
+    complexFft();
+
+    // split into the spectrum of the real input:
+    // X[k] = (Z[k] + Z*[N/2-k]) / 2 - i W^k (Z[k] - Z*[N/2-k]) / 2, halved once more
+    const complex16 z0 = buffer[0];
+    power[0] = magnitudeSquared((real(z0) + imag(z0)) >> 1, 0);
+    power[HALF_SIZE] = magnitudeSquared((real(z0) - imag(z0)) >> 1, 0);
+
+    for (int k = 1; k < HALF_SIZE; k++) {
+        const complex16 mirrored = conjugate(buffer[HALF_SIZE - k]);
+        const complex16 even = halvingAdd(buffer[k], mirrored);
+        const complex16 odd = halvingSubtract(buffer[k], mirrored);
+
+        // -i W^k, W^k = (c, -s) becomes (-s, -c)
+        const complex16 w = twiddles[k];
+        const complex16 x = halvingAdd(even, multiply(odd, pack(imag(w), -real(w))));
+        power[k] = magnitudeSquared(real(x), imag(x));
+    }
+}
@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/fixedPoint.h"
+
+const uint32_t fixedScales[FIXED_MAX_DECIMALS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// two digits per lookup halves the number of divisions
+static const char digitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// half away from zero, magnitude is the absolute value
+static inline uint32_t divideRounded(uint32_t magnitude, uint32_t divisor) {
+    return magnitude / divisor + (magnitude % divisor >= divisor / 2 ? 1 : 0);
+}
+
+int32_t toFixed(float value, unsigned decimals) {
+    assert(decimals <= FIXED_MAX_DECIMALS);
+    const float scaled = value * (float)fixedScales[decimals];
+    return (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+float fixedToFloat(int32_t value, unsigned decimals) {
+    assert(decimals <= FIXED_MAX_DECIMALS);
+    return (float)value / (float)fixedScales[decimals];
+}
+
+int32_t rescaleFixed(int32_t value, unsigned decimals, unsigned newDecimals) {
+    assert(decimals <= FIXED_MAX_DECIMALS && newDecimals <= FIXED_MAX_DECIMALS);
+    if (newDecimals >= decimals) {
+        return value * (int32_t)fixedScales[newDecimals - decimals];
+    }
+
+    const uint32_t magnitude = divideRounded(value < 0 ? 0U - (uint32_t)value : (uint32_t)value,
+                                             fixedScales[decimals - newDecimals]);
+    return value < 0 ? -(int32_t)magnitude : (int32_t)magnitude;
+}
+
+uint32_t integerSqrt(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) bit >>= 2;
+
+    // one result bit per step, no division
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+unsigned formatUnsigned(uint32_t value, unsigned minDigits, char *buffer) {
+    // digits are written from the end straight into buffer
+    unsigned length = 1;
+    while (length <= FIXED_MAX_DECIMALS && value >= fixedScales[length]) {
+        length++;
+    }
+    if (length < minDigits) {
+        length = minDigits;
+    }
+
+    char *digit = buffer + length;
+    while (value >= 100) {
+        const unsigned pair = (value % 100) * 2;
+        value /= 100;
+        *--digit = digitPairs[pair + 1];
+        *--digit = digitPairs[pair];
+    }
+    if (value >= 10) {
+        *--digit = digitPairs[value * 2 + 1];
+        *--digit = digitPairs[value * 2];
+    } else {
+        *--digit = '0' + value;
+    }
+
+    while (digit > buffer) {
+        *--digit = '0';
+    }
+    return length;
+}
+
+unsigned formatFixed(int32_t value, unsigned decimals, unsigned precision, char *buffer) {
+    assert(decimals <= FIXED_MAX_DECIMALS && precision <= FIXED_MAX_DECIMALS);
+
+    uint32_t magnitude = value < 0 ? 0U - (uint32_t)value : (uint32_t)value;
+    if (precision < decimals) {
+        magnitude = divideRounded(magnitude, fixedScales[decimals - precision]);
+        decimals = precision;
+    }
+
+    char *out = buffer;
+    if (value < 0 && magnitude != 0) {
+        *out++ = '-'; // no "-0.00" once rounded to zero
+    }
+
+    out += formatUnsigned(magnitude / fixedScales[decimals], 1, out);
+    if (precision > 0) {
+        *out++ = '.';
+        if (decimals > 0) {
+            out += formatUnsigned(magnitude % fixedScales[decimals], decimals, out);
+        }
+        memset(out, '0', precision - decimals);
+        out += precision - decimals;
+    }
+
+    *out = char(0);
+    return (unsigned)(out - buffer);
+}
@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/flashStore.h"
+
+#ifdef FLASH_STORE_FILE
+
+FileFlashStore::~FileFlashStore() {
+    if (file != NULL) {
+        fclose(file);
+    }
+}
+
+bool FileFlashStore::init() {
+    file = fopen(path, "r+b");
+    if (file != NULL) {
+        return true;
+    }
+
+    // a new file starts out fully erased
+    file = fopen(path, "w+b");
+    if (file == NULL) {
+        LOG_ERROR("Unable to create the flash file");
+        return false;
+    }
+
+    for (unsigned sector = 0; sector < sectorCount; sector++) {
+        if (!erase(sector)) return false;
+    }
+    return true;
+}
+
+bool FileFlashStore::read(uint32_t address, void *buffer, uint32_t size) {
+    return address + size <= sectorSize * sectorCount &&
+           fseek(file, address, SEEK_SET) == 0 &&
+           fread(buffer, 1, size, file) == size;
+}
+
+bool FileFlashStore::program(uint32_t address, const void *buffer, uint32_t size) {
+    uint8_t current[STRING_BUFFER_128];
+    const uint8_t *data = (const uint8_t *)buffer;
+
+    // bits only go from 1 to 0, the same as on the device
+    while (size > 0) {
+        const uint32_t chunk = min(size, (uint32_t)sizeof(current));
+        if (!read(address, current, chunk)) return false;
+
+        for (uint32_t i = 0; i < chunk; i++) {
+            current[i] &= data[i];
+        }
+
+        if (fseek(file, address, SEEK_SET) != 0 || fwrite(current, 1, chunk, file) != chunk) {
+            return false;
+        }
+        address += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+
+    return fflush(file) == 0;
+}
+
+bool FileFlashStore::erase(unsigned sector) {
+    uint8_t erased[STRING_BUFFER_128];
+    memset(erased, 0xFF, sizeof(erased));
+
+    if (sector >= sectorCount || fseek(file, sector * sectorSize, SEEK_SET) != 0) {
+        return false;
+    }
+
+    for (uint32_t written = 0; written < sectorSize; written += sizeof(erased)) {
+        const uint32_t chunk = min(sectorSize - written, (uint32_t)sizeof(erased));
+        if (fwrite(erased, 1, chunk, file) != chunk) return false;
+    }
+
+    return fflush(file) == 0;
+}
+
+#else
+
+// end of the code and, stored right after it, the initial values of .data,
+// from the mbed GCC_ARM linker script
+extern "C" uint32_t __etext;
+extern "C" uint32_t __data_start__;
+extern "C" uint32_t __data_end__;
+
+bool FlashIapStore::init() {
+    if (flash.init() != 0) {
+        LOG_ERROR("FlashIAP init failed");
+        return false;
+    }
+
+    // nothing reserves the store in the linker script, a sketch grown into it
+    // would be erased by the queue
+    const uint32_t imageEnd = (uintptr_t)&__etext + ((uintptr_t)&__data_end__ - (uintptr_t)&__data_start__);
+    if (startAddress < imageEnd) {
+        Serial.printf("Telemetry store at 0x%08lx overlaps the sketch image ending at 0x%08lx\r\n",
+            (unsigned long)startAddress, (unsigned long)imageEnd);
+        return false;
+    }
+
+    if (startAddress + sectorCount * sectorSize > flash.get_flash_start() + flash.get_flash_size()) {
+        LOG_ERROR("Telemetry store extends past the end of the flash");
+        return false;
+    }
+
+    if (flash.get_sector_size(startAddress) != sectorSize) {
+        LOG_ERROR("Telemetry store sector size doesn't match the flash layout");
+        return false;
+    }
+
+    return true;
+}
+
+bool FlashIapStore::read(uint32_t address, void *buffer, uint32_t size) {
+    return flash.read(buffer, startAddress + address, size) == 0;
+}
+
+bool FlashIapStore::program(uint32_t address, const void *buffer, uint32_t size) {
+    return flash.program(buffer, startAddress + address, size) == 0;
+}
+
+bool FlashIapStore::erase(unsigned sector) {
+    return sector < sectorCount &&
+           flash.erase(startAddress + sector * sectorSize, sectorSize) == 0;
+}
+
+#endif // FLASH_STORE_FILE
@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/hts221.h"
+#include "../inc/i2cBus.h"
+
+#define HTS221_WHO_AM_I 0x0F
+#define HTS221_WHO_AM_I_VALUE 0xBC
+#define HTS221_CTRL_REG1 0x20
+#define HTS221_CTRL_REG2 0x21
+#define HTS221_STATUS_REG 0x27
+#define HTS221_HUMIDITY_OUT_L 0x28
+#define HTS221_CALIBRATION_REG 0x30
+
+#define CTRL_REG1_POWER_ON 0x80
+#define CTRL_REG1_BDU 0x04       // outputs only change once both bytes were read
+#define CTRL_REG2_ONE_SHOT 0x01
+#define STATUS_DATA_READY 0x03   // humidity and temperature available
+
+// linear interpolation points from the 16 calibration registers
+typedef struct HTS221_CALIBRATION_TAG {
+    int32_t h0RhX2, h1RhX2;
+    int32_t h0Out, h1Out;
+    int32_t t0DegCX8, t1DegCX8;
+    int32_t t0Out, t1Out;
+} HTS221_CALIBRATION;
+
+static bool initialized = false;
+static HTS221_CALIBRATION calibration;
+static HTS221_READING reading;
+static bool attempted = false;
+static unsigned long acquisitionCount = 0;
+
+static bool readRegisters(uint8_t reg, uint8_t *data, uint16_t length) {
+    return i2cRead(I2C_DEVICE_HTS221, reg, data, length);
+}
+
+static bool writeRegister(uint8_t reg, uint8_t value) {
+    return i2cWrite(I2C_DEVICE_HTS221, reg, value);
+}
+
+static inline int16_t toInt16(const uint8_t *data) {
+    return (int16_t)(data[0] | (data[1] << 8));
+}
+
+bool hts221Init() {
+    initialized = false;
+    memset(&reading, 0, sizeof(reading));
+    attempted = false;
+
+    uint8_t id = 0;
+    if (!readRegisters(HTS221_WHO_AM_I, &id, 1) || id != HTS221_WHO_AM_I_VALUE) {
+        LOG_ERROR("HTS221 not found");
+        return false;
+    }
+
+    uint8_t data[16];
+    if (!readRegisters(HTS221_CALIBRATION_REG, data, sizeof(data))) {
+        LOG_ERROR("Reading the HTS221 calibration failed");
+        return false;
+    }
+
+    calibration.h0RhX2 = data[0];
+    calibration.h1RhX2 = data[1];
+    calibration.t0DegCX8 = data[2] | ((data[5] & 0x03) << 8);
+    calibration.t1DegCX8 = data[3] | ((data[5] & 0x0C) << 6);
+    calibration.h0Out = toInt16(data + 6);
+    calibration.h1Out = toInt16(data + 10);
+    calibration.t0Out = toInt16(data + 12);
+    calibration.t1Out = toInt16(data + 14);
+
+    if (calibration.h1Out == calibration.h0Out || calibration.t1Out == calibration.t0Out) {
+        LOG_ERROR("Invalid HTS221 calibration");
+        return false;
+    }
+
+    // powered with no output data rate, conversions only run when triggered
+    initialized = writeRegister(HTS221_CTRL_REG1, CTRL_REG1_POWER_ON | CTRL_REG1_BDU);
+    return initialized;
+}
+
+static bool acquire() {
+    if (!initialized || !writeRegister(HTS221_CTRL_REG2, CTRL_REG2_ONE_SHOT)) {
+        return false;
+    }
+
+    uint8_t status = 0;
+    const unsigned long start = millis();
+    while (!readRegisters(HTS221_STATUS_REG, &status, 1) ||
+           (status & STATUS_DATA_READY) != STATUS_DATA_READY) {
+        if (millis() - start > HTS221_READY_TIMEOUT) {
+            LOG_ERROR("HTS221 conversion timed out");
+            return false;
+        }
+        delay(1);
+    }
+
+    // humidity and temperature outputs are adjacent, one burst reads both
+    uint8_t data[4];
+    if (!readRegisters(HTS221_HUMIDITY_OUT_L, data, sizeof(data))) {
+        return false;
+    }
+
+    const HTS221_CALIBRATION &cal = calibration;
+    int64_t humidity = (int64_t)(toInt16(data) - cal.h0Out) * (cal.h1RhX2 - cal.h0RhX2) * 50 /
+                       (cal.h1Out - cal.h0Out) + cal.h0RhX2 * 50;
+    const int64_t temperature = ((int64_t)(toInt16(data + 2) - cal.t0Out) * (cal.t1DegCX8 - cal.t0DegCX8) * 100 /
+                                 (cal.t1Out - cal.t0Out) + cal.t0DegCX8 * 100) / 8;
+
+    // the sensor can extrapolate past its range
+    if (humidity < 0) humidity = 0;
+    if (humidity > 10000) humidity = 10000;
+
+    reading.humidity = (int32_t)humidity;
+    reading.temperature = (int32_t)temperature;
+    acquisitionCount++;
+    return true;
+}
+
+const HTS221_READING *hts221Read(unsigned long now) {
+    // a failed conversion is not retried before the cache period either
+    if (!attempted || now - reading.sampleTime >= HTS221_CACHE_PERIOD) {
+        attempted = true;
+        reading.valid = acquire();
+        reading.sampleTime = now;
+    }
+    return &reading;
+}
+
+unsigned long getHts221AcquisitionCount() {
+    return acquisitionCount;
+}
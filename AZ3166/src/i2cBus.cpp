@@ -0,0 +1,265 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/i2cBus.h"
+
+#include "DevI2C.h"
+
+typedef struct I2C_DEVICE_INFO_TAG {
+    const char *name;
+    uint8_t address;
+    uint8_t autoIncrement; // register address bit needed for multi byte access
+} I2C_DEVICE_INFO;
+
+static const I2C_DEVICE_INFO devices[I2C_DEVICE_COUNT] = {
+    { "lsm6dsl", 0xD6, 0x00 },
+    { "hts221",  0xBE, 0x80 },
+    { "lps22hb", 0xBA, 0x00 },
+    { "lis2mdl", 0x3C, 0x00 }
+};
+
+// one queued read, a slice of the burst it was merged into
+typedef struct I2C_PART_TAG {
+    uint8_t *data;
+    uint16_t length;
+    uint16_t offset;
+    i2cCallback callback;
+    void *context;
+} I2C_PART;
+
+typedef struct I2C_BURST_TAG {
+    I2cDevice device;
+    uint8_t reg;
+    uint16_t length;
+    unsigned partCount;
+    I2C_PART parts[I2C_BURST_PARTS];
+    uint8_t buffer[I2C_BURST_MAX];
+} I2C_BURST;
+
+static DevI2C *bus = NULL;
+static I2C_BURST queue[I2C_QUEUE_SIZE];
+static unsigned queueHead = 0; // oldest burst, the running one while a transfer is active
+static unsigned queueCount = 0;
+static I2C_DEVICE_STATS stats[I2C_DEVICE_COUNT];
+static unsigned long mergedCount = 0;
+
+#if DEVICE_I2C_ASYNCH
+static bool active = false;
+static volatile bool transferDone = false;
+static volatile int transferEvent = 0;
+static volatile unsigned long transferTime = 0;
+static unsigned long transferStart = 0;
+static char subAddress;
+#endif
+
+void i2cBusInit(DevI2C *i2c) {
+    bus = i2c;
+    queueHead = 0;
+    queueCount = 0;
+    memset(stats, 0, sizeof(stats));
+    mergedCount = 0;
+}
+
+static uint8_t registerAddress(I2cDevice device, uint8_t reg, uint16_t length) {
+    return length > 1 ? reg | devices[device].autoIncrement : reg;
+}
+
+static void account(I2cDevice device, unsigned long duration, unsigned transactions, unsigned bytes, bool ok) {
+    I2C_DEVICE_STATS *deviceStats = &stats[device];
+    deviceStats->transactions += transactions;
+    deviceStats->bytes += bytes;
+    deviceStats->busTime += duration;
+    if (!ok) {
+        deviceStats->errors++;
+    }
+}
+
+void i2cAccount(I2cDevice device, unsigned long start, unsigned transactions, unsigned bytes, bool ok) {
+    account(device, micros() - start, transactions, bytes, ok);
+}
+
+// removes the oldest burst, its parts are handed out after so callbacks may queue again
+static void completeBurst(bool ok) {
+    I2C_BURST *burst = &queue[queueHead];
+    I2C_PART parts[I2C_BURST_PARTS];
+    const unsigned partCount = burst->partCount;
+
+    for (unsigned i = 0; i < partCount; i++) {
+        parts[i] = burst->parts[i];
+        if (ok) {
+            memcpy(parts[i].data, burst->buffer + parts[i].offset, parts[i].length);
+        }
+    }
+    queueHead = (queueHead + 1) % I2C_QUEUE_SIZE;
+    queueCount--;
+
+    for (unsigned i = 0; i < partCount; i++) {
+        if (parts[i].callback != NULL) {
+            parts[i].callback(ok, parts[i].context);
+        }
+    }
+}
+
+#if DEVICE_I2C_ASYNCH
+
+static void transferCallback(int event) {
+    transferTime = micros() - transferStart;
+    transferEvent = event;
+    transferDone = true;
+}
+
+static void finishTransfer() {
+    if (!active || !transferDone) {
+        return;
+    }
+    active = false;
+
+    const I2C_BURST *burst = &queue[queueHead];
+    const bool ok = (transferEvent & I2C_EVENT_ALL) == I2C_EVENT_TRANSFER_COMPLETE;
+    account(burst->device, transferTime, 1, burst->length, ok);
+    completeBurst(ok);
+}
+
+static void startTransfer() {
+    while (!active && queueCount > 0) {
+        const I2C_BURST *burst = &queue[queueHead];
+        subAddress = (char)registerAddress(burst->device, burst->reg, burst->length);
+        transferDone = false;
+        transferStart = micros();
+        active = bus->transfer(devices[burst->device].address, &subAddress, 1, (char *)burst->buffer,
+                               burst->length, event_callback_t(transferCallback), I2C_EVENT_ALL) == 0;
+        if (!active) {
+            account(burst->device, 0, 1, 0, false);
+            completeBurst(false);
+        }
+    }
+}
+
+static void waitForTransfer() {
+    while (active) {
+        finishTransfer();
+    }
+}
+
+void i2cBusRun() {
+    finishTransfer();
+    startTransfer();
+}
+
+#else
+
+static void waitForTransfer() {
+}
+
+void i2cBusRun() {
+    while (queueCount > 0) {
+        I2C_BURST *burst = &queue[queueHead];
+        const unsigned long start = micros();
+        const bool ok = bus->i2c_read(burst->buffer, devices[burst->device].address,
+                                      registerAddress(burst->device, burst->reg, burst->length),
+                                      burst->length) == 0;
+        i2cAccount(burst->device, start, 1, burst->length, ok);
+        completeBurst(ok);
+    }
+}
+
+#endif
+
+void i2cBusFlush() {
+    while (queueCount > 0) {
+        i2cBusRun();
+    }
+}
+
+bool i2cRead(I2cDevice device, uint8_t reg, uint8_t *data, uint16_t length) {
+    waitForTransfer();
+
+    const unsigned long start = micros();
+    const bool ok = bus->i2c_read(data, devices[device].address,
+                                  registerAddress(device, reg, length), length) == 0;
+    i2cAccount(device, start, 1, length, ok);
+    return ok;
+}
+
+bool i2cWrite(I2cDevice device, uint8_t reg, uint8_t value) {
+    waitForTransfer();
+
+    const unsigned long start = micros();
+    const bool ok = bus->i2c_write(&value, devices[device].address, reg, 1) == 0;
+    i2cAccount(device, start, 1, 1, ok);
+    return ok;
+}
+
+static void addPart(I2C_BURST *burst, uint16_t offset, uint8_t *data, uint16_t length,
+                    i2cCallback callback, void *context) {
+    I2C_PART *part = &burst->parts[burst->partCount++];
+    part->data = data;
+    part->length = length;
+    part->offset = offset;
+    part->callback = callback;
+    part->context = context;
+}
+
+bool i2cQueueRead(I2cDevice device, uint8_t reg, uint8_t *data, uint16_t length,
+                  i2cCallback callback, void *context) {
+    if (length == 0 || length > I2C_BURST_MAX) {
+        return false;
+    }
+
+#if DEVICE_I2C_ASYNCH
+    const unsigned first = active ? 1 : 0; // the running transfer can't grow
+#else
+    const unsigned first = 0;
+#endif
+    for (unsigned i = first; i < queueCount; i++) {
+        I2C_BURST *burst = &queue[(queueHead + i) % I2C_QUEUE_SIZE];
+        if (burst->device != device || burst->partCount == I2C_BURST_PARTS ||
+            burst->length + length > I2C_BURST_MAX) {
+            continue;
+        }
+
+        if (reg == burst->reg + burst->length) {
+            addPart(burst, burst->length, data, length, callback, context);
+            burst->length += length;
+            mergedCount++;
+            return true;
+        }
+        if (reg + length == burst->reg) {
+            for (unsigned p = 0; p < burst->partCount; p++) {
+                burst->parts[p].offset += length;
+            }
+            addPart(burst, 0, data, length, callback, context);
+            burst->reg = reg;
+            burst->length += length;
+            mergedCount++;
+            return true;
+        }
+    }
+
+    if (queueCount == I2C_QUEUE_SIZE) {
+        return false;
+    }
+
+    I2C_BURST *burst = &queue[(queueHead + queueCount) % I2C_QUEUE_SIZE];
+    burst->device = device;
+    burst->reg = reg;
+    burst->length = 0;
+    burst->partCount = 0;
+    addPart(burst, 0, data, length, callback, context);
+    burst->length = length;
+    queueCount++;
+    return true;
+}
+
+const char * getI2cDeviceName(I2cDevice device) {
+    return devices[device].name;
+}
+
+const I2C_DEVICE_STATS * getI2cDeviceStats(I2cDevice device) {
+    return &stats[device];
+}
+
+unsigned long getI2cMergedCount() {
+    return mergedCount;
+}
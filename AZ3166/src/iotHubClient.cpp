@@ -10,6 +10,12 @@
 
 #include "../inc/stats.h"
 #include "../inc/wifi.h"
+#include "../inc/ledIndicator.h"
+#include "../inc/timestamp.h"
+#include "../inc/twinParser.h"
+#include "../inc/jsonWriter.h"
+#include "../inc/cborWriter.h"
+#include "../inc/displayModel.h"
 
 // forward declarations
 static IOTHUBMESSAGE_DISPOSITION_RESULT receiveMessageCallback(IOTHUB_MESSAGE_HANDLE message, void *userContextCallback);
@@ -19,14 +25,39 @@ static void connectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result, IOT
 static void sendConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *userContextCallback);
 static void deviceTwinConfirmationCallback(int status_code, void* userContextCallback);
 
-static int methodCallbackCount = 0;
-static int desiredCallbackCount = 0;
-static CALLBACK_LOOKUP methodCallbackList[MAX_CALLBACK_COUNT];
-static CALLBACK_LOOKUP desiredCallbackList[MAX_CALLBACK_COUNT];
+static CALLBACK_TABLE methodCallbacks;
+static CALLBACK_TABLE desiredCallbacks;
 
 static int statusContext = 0;
 static int trackingId = 0;
 
+static MESSAGE_SLOT messagePool[MESSAGE_POOL_SIZE];
+static int nextMessageSlot = 0;
+
+// hands out free slots round-robin, NULL when every slot is in flight
+static MESSAGE_SLOT * acquireMessageSlot() {
+    for (int i = 0; i < MESSAGE_POOL_SIZE; i++) {
+        MESSAGE_SLOT *slot = &messagePool[(nextMessageSlot + i) % MESSAGE_POOL_SIZE];
+        if (!slot->inUse) {
+            nextMessageSlot = (nextMessageSlot + i + 1) % MESSAGE_POOL_SIZE;
+            slot->inUse = true;
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+static void releaseMessageSlot(EVENT_INSTANCE *eventInstance) {
+    // instance is the first member of its slot
+    MESSAGE_SLOT *slot = reinterpret_cast<MESSAGE_SLOT*>(eventInstance);
+    assert(slot >= messagePool && slot < messagePool + MESSAGE_POOL_SIZE);
+
+    IoTHubMessage_Destroy(eventInstance->messageHandle);
+    eventInstance->messageHandle = NULL;
+    slot->inUse = false;
+}
+
 void IoTHubClient::initIotHubClient() {
     char connectionString[AZ_IOT_HUB_MAX_LEN] = {0};
     readConnectionString(connectionString, AZ_IOT_HUB_MAX_LEN);
@@ -109,29 +140,175 @@ void IoTHubClient::initIotHubClient() {
     }
 }
 
+unsigned long IoTHubClient::pump() {
+    flushReportedProperties();
+    replayOfflineTelemetry();
+    hubClientYield();
+
+    IOTHUB_CLIENT_STATUS sendStatus;
+    const bool sending = IoTHubClient_LL_GetSendStatus(iotHubClientHandle, &sendStatus)
+                         == IOTHUB_CLIENT_OK && sendStatus == IOTHUB_CLIENT_SEND_STATUS_BUSY;
+
+    if (sending || millis() - lastActivityTime < HUB_PUMP_ACTIVE_PERIOD) {
+        return HUB_PUMP_BUSY_INTERVAL;
+    }
+
+    return HUB_PUMP_IDLE_INTERVAL;
+}
+
 bool IoTHubClient::sendTelemetry(const char *payload) {
+    return sendTelemetry(payload, strlen(payload), MESSAGE_FORMAT_JSON);
+}
+
+bool IoTHubClient::sendTelemetry(const char *payload, unsigned length, MessageFormat format) {
+    if (batchWindow == 0 || format != MESSAGE_FORMAT_JSON) {
+        return submitTelemetry(payload, length, format);
+    }
+
+    bool result = appendToBatch(payload);
+    checkTelemetryBatch();
+
+    // keep the hub connection serviced while samples are being batched
+    hubClientYield();
+
+    return result;
+}
+
+bool IoTHubClient::storeOffline(const char *payload, unsigned length, MessageFormat format, time_t sampleTime,
+                                unsigned sampleMillis) {
+    // it could never be replayed
+    if (length > IOTHUB_BATCH_MAX_SIZE) {
+        LOG_ERROR("Message is too large to keep for replay");
+        return false;
+    }
+
+    if (offlineQueue == NULL || !offlineQueue->push(payload, length, format, sampleTime, sampleMillis)) {
+        return false;
+    }
+
+    incrementOfflineStoredCount();
+    Serial.printf("Telemetry kept for replay, %u messages queued\r\n", offlineQueue->getCount());
+    return true;
+}
+
+bool IoTHubClient::storeTelemetry(const char *payload, unsigned length, MessageFormat format) {
+    time_t sampleTime;
+    unsigned sampleMillis;
+    getCurrentTime(&sampleTime, &sampleMillis);
+    return storeOffline(payload, length, format, sampleTime, sampleMillis);
+}
+
+// live telemetry the SDK doesn't take is kept for replay, false only when
+// the message is lost
+bool IoTHubClient::submitTelemetry(const char *payload, unsigned length, MessageFormat format) {
+    // the connection dropped, keep the message rather than losing it
+    if (needsReconnect && storeTelemetry(payload, length, format)) {
+        checkConnection();
+        return true;
+    }
+
+    return sendMessage(payload, length, format) || storeTelemetry(payload, length, format);
+}
+
+// one queued message at a time, paced and only while live telemetry has room
+void IoTHubClient::replayOfflineTelemetry() {
+    static char payload[IOTHUB_BATCH_MAX_SIZE + 1];
+
+    if (offlineQueue == NULL || !hubConnected || needsReconnect || replayInFlight ||
+        offlineQueue->getCount() == 0 || inFlightCount + TELEMETRY_REPLAY_RESERVE >= maxInFlight ||
+        millis() - lastReplayTime < TELEMETRY_REPLAY_INTERVAL) {
+        return;
+    }
+
+    QUEUED_MESSAGE queued;
+    queued.length = 0;
+    if (!offlineQueue->peek(&queued, payload, sizeof(payload))) {
+        // a record that can never be sent would hold up everything behind it
+        if (queued.length > IOTHUB_BATCH_MAX_SIZE && offlineQueue->pop(queued.messageId)) {
+            LOG_ERROR("Queued message is too large to replay, dropped");
+            incrementOfflineDroppedCount();
+        }
+        return;
+    }
+
+    lastReplayTime = millis();
+    replayInFlight = sendMessage(payload, queued.length, queued.format, &queued);
+}
+
+bool IoTHubClient::sendMessage(const char *payload, unsigned length, MessageFormat format,
+                               const QUEUED_MESSAGE *queued) {
+    time_t sampleTime;
+    unsigned sampleMillis;
+    if (queued != NULL) {
+        sampleTime = queued->sampleTime;
+        sampleMillis = queued->sampleMillis;
+    } else {
+        getCurrentTime(&sampleTime, &sampleMillis);
+    }
+
     checkConnection();
 
+    if (isBackpressured()) {
+        Serial.printf("ERROR: %d messages are waiting for confirmation\r\n", inFlightCount);
+        incrementBackpressureCount();
+        return false;
+    }
+
+    if (length > IOTHUB_BATCH_MAX_SIZE) {
+        LOG_ERROR("Message exceeds the message size");
+        return false;
+    }
+
+    MESSAGE_SLOT *slot = acquireMessageSlot();
+    if (slot == NULL) {
+        LOG_ERROR("Message pool exhausted");
+        incrementPoolExhaustedCount();
+        return false;
+    }
+
+    slot->format = format;
+    slot->sampleTime = sampleTime;
+    slot->sampleMillis = sampleMillis;
+
     IOTHUB_CLIENT_RESULT hubResult = IOTHUB_CLIENT_RESULT::IOTHUB_CLIENT_OK;
-    EVENT_INSTANCE *currentMessage = (EVENT_INSTANCE*) malloc(sizeof(EVENT_INSTANCE));
+    EVENT_INSTANCE *currentMessage = &slot->instance;
     currentMessage->messageHandle =
-        IoTHubMessage_CreateFromByteArray((const unsigned char*)payload, strlen(payload));
+        IoTHubMessage_CreateFromByteArray((const unsigned char*)payload, length);
 
     if (currentMessage->messageHandle == NULL) {
         Serial.println("ERROR: iotHubMessageHandle is NULL!");
-        free(currentMessage);
+        releaseMessageSlot(currentMessage);
         return false;
     }
     currentMessage->messageTrackingId = trackingId++;
+    currentMessage->submitTime = millis();
+    currentMessage->replayId = queued != NULL ? queued->messageId : 0;
+
+    // lets the hub route on the body and consumers pick the decoder
+    const bool isCbor = format == MESSAGE_FORMAT_CBOR;
+    if (IoTHubMessage_SetContentTypeSystemProperty(currentMessage->messageHandle,
+            isCbor ? CBOR_CONTENT_TYPE : "application/json") != IOTHUB_MESSAGE_OK ||
+        (!isCbor && IoTHubMessage_SetContentEncodingSystemProperty(currentMessage->messageHandle,
+            "utf-8") != IOTHUB_MESSAGE_OK)) {
+        Serial.println("ERROR: Setting the message content type failed");
+    }
 
     MAP_HANDLE propMap = IoTHubMessage_Properties(currentMessage->messageHandle);
 
     // add a timestamp to the message - illustrated for the use in batching
-    time_t now_utc = time(NULL); // utc time
-    char timeBuffer[STRING_BUFFER_128] = {0};
-    unsigned outputLength = snprintf(timeBuffer, STRING_BUFFER_128, "%s", ctime(&now_utc));
-    assert(outputLength && outputLength < STRING_BUFFER_128 && timeBuffer[outputLength - 1] == '\n');
-    timeBuffer[outputLength - 1] = char(0); // replace `\n` with `\0`
+    // replayed messages carry the time they were sampled and their queue id
+    char timeBuffer[STRING_BUFFER_32] = {0};
+    if (queued != NULL) {
+        formatIsoTimestampAt(sampleTime, sampleMillis, timeBuffer, STRING_BUFFER_32);
+
+        char messageId[STRING_BUFFER_16];
+        snprintf(messageId, sizeof(messageId), "%lu", (unsigned long)queued->messageId);
+        if (IoTHubMessage_SetMessageId(currentMessage->messageHandle, messageId) != IOTHUB_MESSAGE_OK) {
+            Serial.println("ERROR: Setting the message id failed");
+        }
+    } else {
+        formatIsoTimestamp(timeBuffer, STRING_BUFFER_32);
+    }
     if (Map_AddOrUpdate(propMap, "timestamp", timeBuffer) != MAP_OK)
     {
         Serial.println("ERROR: Adding message property failed");
@@ -144,13 +321,14 @@ bool IoTHubClient::sendTelemetry(const char *payload) {
     if (hubResult != IOTHUB_CLIENT_OK) {
         Serial.printf("ERROR: IoTHubClient_LL_SendEventAsync..........FAILED hubResult is (%d)!\r\n", hubResult);
         incrementErrorCount();
-        IoTHubMessage_Destroy(currentMessage->messageHandle);
-        free(currentMessage);
+        releaseMessageSlot(currentMessage);
         return false;
     }
 
     // keep happy messages small (serial monitor is failing for latter errors)
     Serial.println("IoTHubClient_LL_SendEventAsync [CHECK]");
+    inFlightCount++;
+    markActivity();
 
     // yield to process any work to/from the hub
     hubClientYield();
@@ -158,52 +336,144 @@ bool IoTHubClient::sendTelemetry(const char *payload) {
     return true;
 }
 
-bool IoTHubClient::sendReportedProperty(const char *payload) {
+// batch layout: [{"timestamp":"<time>",<sample members>},...]
+bool IoTHubClient::appendToBatch(const char *payload) {
+    const unsigned payloadLength = strlen(payload);
+    if (payloadLength < 2 || payload[0] != '{') {
+        LOG_ERROR("Telemetry sample is not a JSON object");
+        return false;
+    }
+
+    char timeBuffer[STRING_BUFFER_32] = {0};
+    formatIsoTimestamp(timeBuffer, STRING_BUFFER_32);
+
+    char prefix[STRING_BUFFER_128] = {0};
+    const bool isEmpty = payload[1] == '}';
+    const unsigned prefixLength = snprintf(prefix, STRING_BUFFER_128, "{\"timestamp\":\"%s\"%s",
+                                           timeBuffer, isEmpty ? "" : ",");
+    const unsigned sampleLength = prefixLength + payloadLength - 1; // payload without its '{'
+
+    // the leading '[' or ',' plus the closing ']' have to fit as well
+    // sample would cross the 4 KB boundary, a batch nothing took stays as it is
+    if (batchSampleCount > 0 && batchLength + 1 + sampleLength + 1 > IOTHUB_BATCH_MAX_SIZE &&
+        !flushTelemetryBatch()) {
+        LOG_ERROR("Telemetry batch is full and can't be sent");
+        return false;
+    }
+
+    if (1 + sampleLength + 1 > IOTHUB_BATCH_MAX_SIZE) {
+        LOG_ERROR("Telemetry sample doesn't fit into a single message");
+        incrementErrorCount();
+        return false;
+    }
+
+    if (batchSampleCount == 0) {
+        batchBuffer[0] = '[';
+        batchLength = 1;
+        batchStartTime = millis();
+    } else {
+        batchBuffer[batchLength++] = ',';
+    }
+
+    memcpy(batchBuffer + batchLength, prefix, prefixLength);
+    batchLength += prefixLength;
+    memcpy(batchBuffer + batchLength, payload + 1, payloadLength - 1);
+    batchLength += payloadLength - 1;
+    batchBuffer[batchLength] = char(0);
+    batchSampleCount++;
+
+    return true;
+}
+
+bool IoTHubClient::flushTelemetryBatch() {
+    if (batchSampleCount == 0) {
+        return true;
+    }
+
+    // closed for the send only, samples can still be added if it fails
+    batchBuffer[batchLength] = ']';
+    batchBuffer[batchLength + 1] = char(0);
+
+    if (!submitTelemetry(batchBuffer, batchLength + 1, MESSAGE_FORMAT_JSON)) {
+        batchBuffer[batchLength] = char(0);
+        return false;
+    }
+
+    incrementBatchCount(batchSampleCount);
+    Serial.printf("Batch of %u samples sent, %d messages saved per hour\r\n",
+        batchSampleCount, getMessagesSavedPerHour());
+
+    batchLength = 0;
+    batchSampleCount = 0;
+
+    return true;
+}
+
+void IoTHubClient::checkTelemetryBatch() {
+    if (batchSampleCount > 0 && millis() - batchStartTime >= batchWindow) {
+        flushTelemetryBatch();
+    }
+}
+
+void IoTHubClient::flushReportedProperties() {
+    static char patch[REPORTED_PATCH_MAX_SIZE];
+
+    const unsigned long now = millis();
+    if (!reportedWriter.isFlushDue(now)) {
+        return;
+    }
+
     checkConnection();
 
-    bool retValue = true;
+    const unsigned length = reportedWriter.buildPatch(patch, sizeof(patch), now);
+    if (length == 0) {
+        return;
+    }
 
+    const int patchId = reportedWriter.getPatchId();
     IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendReportedState(iotHubClientHandle,
-        (const unsigned char*)payload, strlen(payload), deviceTwinConfirmationCallback, NULL);
+        (const unsigned char*)patch, length, deviceTwinConfirmationCallback, (void*)(intptr_t)patchId);
 
     if (result != IOTHUB_CLIENT_OK) {
         LogError("Failure sending reported property!!!");
-        retValue = false;
+        reportedWriter.patchConfirmed(patchId, -1, now);
+    } else {
+        Serial.printf("Reported property patch sent: %s\r\n", patch);
+        markActivity();
     }
-
-    return retValue;
 }
 
 // register callbacks for direct and cloud to device messages
 bool IoTHubClient::registerMethod(const char *methodName, hubMethodCallback callback) {
-    if (methodCallbackCount < MAX_CALLBACK_COUNT) {
-        const uint32_t methodNameLength = strlen(methodName);
-        methodCallbackList[methodCallbackCount].name = (char*) malloc(methodNameLength + 1);
-        strncpy(methodCallbackList[methodCallbackCount].name, methodName, methodNameLength);
-        methodCallbackList[methodCallbackCount].name[methodNameLength] = char(0);
-        strupr(methodCallbackList[methodCallbackCount].name);
-        methodCallbackList[methodCallbackCount].callback = callback;
-        methodCallbackCount++;
-        return true;
-    }
-
-    return false;
+    return callbackTableAdd(&methodCallbacks, methodName, callback);
 }
 
 // register callbacks for desired properties
 bool IoTHubClient::registerDesiredProperty(const char *propertyName, hubMethodCallback callback) {
-    if (desiredCallbackCount < MAX_CALLBACK_COUNT) {
-        const uint32_t propertyNameLength = strlen(propertyName);
-        desiredCallbackList[desiredCallbackCount].name = (char*) malloc(propertyNameLength + 1);
-        strncpy(desiredCallbackList[desiredCallbackCount].name, (char*)propertyName, propertyNameLength);
-        desiredCallbackList[desiredCallbackCount].name[propertyNameLength] = char(0);
-        strupr(desiredCallbackList[desiredCallbackCount].name);
-        desiredCallbackList[desiredCallbackCount].callback = callback;
-        desiredCallbackCount++;
-        return true;
-    }
+    return callbackTableAdd(&desiredCallbacks, propertyName, callback);
+}
 
-    return false;
+void IoTHubClient::messageConfirmed(EVENT_INSTANCE *eventInstance, IOTHUB_CLIENT_CONFIRMATION_RESULT result) {
+    assert(inFlightCount > 0);
+    inFlightCount--;
+    recordConfirmLatency(millis() - eventInstance->submitTime);
+    markActivity();
+
+    if (eventInstance->replayId != 0) {
+        // a failed replay stays at the head of the queue and is sent again
+        replayInFlight = false;
+        if (result == IOTHUB_CLIENT_CONFIRMATION_OK && offlineQueue->pop(eventInstance->replayId)) {
+            incrementOfflineReplayedCount();
+        }
+    } else if (result != IOTHUB_CLIENT_CONFIRMATION_OK) {
+        // the SDK's copy of the payload lives until the slot is released
+        MESSAGE_SLOT *slot = reinterpret_cast<MESSAGE_SLOT*>(eventInstance);
+        const unsigned char *payload;
+        size_t length;
+        if (IoTHubMessage_GetByteArray(eventInstance->messageHandle, &payload, &length) == IOTHUB_MESSAGE_OK) {
+            storeOffline((const char *)payload, length, slot->format, slot->sampleTime, slot->sampleMillis);
+        }
+    }
 }
 
 void IoTHubClient::closeIotHubClient()
@@ -218,6 +488,8 @@ static IOTHUBMESSAGE_DISPOSITION_RESULT receiveMessageCallback
     const char *buffer;
     size_t size;
 
+    Globals::iothubClient->markActivity();
+
     // get message content
     if (IoTHubMessage_GetByteArray(message, (const unsigned char **)&buffer, &size) != IOTHUB_MESSAGE_OK) {
         (void)Serial.printf("unable to retrieve the message data\r\n");
@@ -236,29 +508,25 @@ static IOTHUBMESSAGE_DISPOSITION_RESULT receiveMessageCallback
     // }
 
     JSObject json(buffer);
-    String methodName = json.getStringByName("methodName");
-    if (methodName.length() == 0) {
+    const char *methodName = json.getStringByName("methodName");
+    if (methodName == NULL || methodName[0] == char(0)) {
         LOG_ERROR("Object doesn't have a member 'methodName'");
         return IOTHUBMESSAGE_REJECTED;
     }
-    methodName.toUpperCase();
 
     char *methodResponse;
     size_t responseSize;
 
     // lookup if the method has been registered to a function
-    for(int i = 0; i < methodCallbackCount; i++) {
-        if (methodName == methodCallbackList[i].name) {
-            const char* params = json.getStringByName("payload");
-            if (params == NULL) {
-                LOG_ERROR("Object doesn't have a member 'payload'");
-                return IOTHUBMESSAGE_REJECTED;
-            }
-
-            methodCallbackList[i].callback(params, strlen(params),
-                &methodResponse, &responseSize);
-            break;
+    CALLBACK_LOOKUP *method = callbackTableFind(&methodCallbacks, methodName, strlen(methodName));
+    if (method != NULL) {
+        const char* params = json.getStringByName("payload");
+        if (params == NULL) {
+            LOG_ERROR("Object doesn't have a member 'payload'");
+            return IOTHUBMESSAGE_REJECTED;
         }
+
+        method->callback(params, strlen(params), &methodResponse, &responseSize);
     }
 
     (*counter)++;
@@ -287,14 +555,12 @@ int DeviceDirectMethodCallback(const char* method_name, const unsigned char* pay
     *response = NULL;
     *resp_size = 0;
 
+    Globals::iothubClient->markActivity();
+
     // lookup if the method has been registered to a function
-    String methodName = method_name;
-    methodName.toUpperCase();
-    for(int i = 0; i < methodCallbackCount; i++) {
-        if (methodName == methodCallbackList[i].name) {
-            status = methodCallbackList[i].callback((const char*)payload, size, &methodResponse, &responseSize);
-            break;
-        }
+    CALLBACK_LOOKUP *method = callbackTableFind(&methodCallbacks, method_name, strlen(method_name));
+    if (method != NULL) {
+        status = method->callback((const char*)payload, size, &methodResponse, &responseSize);
     }
 
     Serial.printf("Device Method %s called\r\n", method_name);
@@ -315,143 +581,153 @@ int DeviceDirectMethodCallback(const char* method_name, const unsigned char* pay
     return status;
 }
 
-// every desired property change gets echoed back as a reported property
-void echoDesired(const char *propertyName, const char *message, const char *status, int statusCode) {
-    JSObject rootObject(message);
-    JSObject propertyNameObject, desiredObject, desiredObjectPropertyName;
+// handlers get the desired entry, e.g. {"value":3}, as a null terminated string
+static int callDesiredCallback(CALLBACK_LOOKUP *desired, const TWIN_PROPERTY *property, const char **status) {
+    static char valueBuffer[STRING_BUFFER_512];
 
-    const char* methodName = rootObject.getStringByName("methodName");
-    if (methodName == NULL) {
-        LOG_ERROR("Object doesn't have a member 'methodName'");
-        return;
+    if (!twinSpanCopy(property->desired, valueBuffer, sizeof(valueBuffer))) {
+        Serial.printf("Desired property %.*s is too large\r\n", property->name.length, property->name.start);
+        *status = "failed";
+        return 413;
     }
 
-    if (!rootObject.getObjectByName(propertyName, &propertyNameObject)) {
-        LOG_ERROR("Object doesn't have a member with propertyName");
-        return;
+    char *methodResponse = (char*) Globals::completedString;
+    size_t responseSize = 0;
+    int statusCode = desired->callback(valueBuffer, property->desired.length, &methodResponse, &responseSize);
+    *status = methodResponse != NULL ? methodResponse : Globals::completedString;
+    return statusCode;
+}
+
+// every desired property change gets echoed back as a reported property
+static bool queueReportedEntry(const TWIN_PROPERTY *property, const TWIN_SPAN &desiredVersion,
+                               const char *status, int statusCode) {
+    char entry[REPORTED_VALUE_MAX_SIZE];
+    JsonWriter writer(entry, sizeof(entry));
+    const TWIN_SPAN &value = property->desiredValue;
+
+    writer.beginObject();
+    if (value.length > 0) {
+        writer.appendJson(JSON_KEY("value"), value.start, value.length);
+    }
+    writer.appendInt(JSON_KEY("statusCode"), statusCode);
+    writer.appendString(JSON_KEY("status"), status);
+    if (desiredVersion.length > 0) {
+        writer.appendJson(JSON_KEY("desiredVersion"), desiredVersion.start, desiredVersion.length);
     }
+    writer.endObject();
 
-    const char *value, *desiredVersion;
-    if (rootObject.getObjectByName("desired", &desiredObject)) {
-        if (!desiredObject.getObjectByName(propertyName, &desiredObjectPropertyName)) {
-            LOG_ERROR("desiredObject doesn't have a member with propertyName");
-            return;
-        }
+    return !writer.hasOverflow() && Globals::iothubClient->setReportedProperty(
+        property->name.start, property->name.length, writer.getBuffer(), writer.getLength());
+}
 
-        value = desiredObjectPropertyName.getStringByName("value");
-        desiredVersion = desiredObject.getStringByName("$version");
-    } else {
-        propertyName = rootObject.getNameAt(0);
+// diffs desired against reported in one pass, runs every handler whose property changed
+// and acknowledges all of them with a single reported property patch
+static void reconcileTwin(const TWIN_DOCUMENT *twin, bool partial) {
+    unsigned entryCount = 0;
 
-        value = propertyNameObject.getStringByName("value");
-        desiredVersion = rootObject.getStringByName("$version");
-    }
+    for (unsigned i = 0; i < twin->propertyCount; i++) {
+        const TWIN_PROPERTY *property = &twin->properties[i];
+        if (!property->inDesired) {
+            continue;
+        }
 
-    const char* echoTemplate = "{\"%s\":{\"value\":%s, \"statusCode\":%d, \"status\":\"%s\", \"desiredVersion\":%s}}";
-    uint32_t buffer_size = snprintf(NULL, 0, echoTemplate, propertyName, value, statusCode, status, desiredVersion);
-    AutoString buffer(buffer_size);
-    if (buffer.getLength() == 0) {
-        Serial.printf("Desired property %s failed to be echoed back as a reported property (OUT OF MEMORY)\r\n", propertyName);
-        incrementErrorCount();
-        return;
-    }
+        CALLBACK_LOOKUP *desired = callbackTableFind(&desiredCallbacks, property->name.start,
+            property->name.length);
+        if (desired == NULL) {
+            continue;
+        }
 
-    snprintf(*buffer, buffer_size, echoTemplate, propertyName, value, statusCode, status, desiredVersion);
-    Serial.printf(*buffer);
+        // a partial update is always new, a full twin is compared with what was reported
+        if (!partial && property->inReported &&
+            twinSpanEquals(property->reportedDesiredVersion, twin->desiredVersion)) {
+            Serial.printf("key: %.*s found in reported and versions match\r\n",
+                property->name.length, property->name.start);
+            continue;
+        }
 
-    if (Globals::iothubClient->sendReportedProperty(*buffer)) {
-        Serial.printf("Desired property %s successfully echoed back as a reported property\r\n", propertyName);
-        incrementReportedCount();
-    } else {
-        Serial.printf("Desired property %s failed to be echoed back as a reported property\r\n", propertyName);
-        incrementErrorCount();
-    }
-}
+        const char *status = Globals::completedString;
+        int statusCode = 200;
+        if (partial || !property->inReported ||
+            !twinSpanEquals(property->reportedValue, property->desiredValue)) {
+            Serial.printf("key: %.*s either not found in reported or versions do not match\r\n",
+                property->name.length, property->name.start);
+            statusCode = callDesiredCallback(desired, property, &status);
+        }
+        // otherwise only the version moved, acknowledge it without running the handler again
 
-void callDesiredCallback(const char *propertyName, const char *payLoad, size_t size) {
-    int status = 0;
-    char *methodResponse;
-    size_t responseSize;
-    AutoString propName(propertyName, strlen(propertyName));
-    strupr(*propName);
-
-    for(int i = 0; i < desiredCallbackCount; i++) {
-        if (strcmp(*propName, desiredCallbackList[i].name) == 0) {
-            status = desiredCallbackList[i].callback(payLoad, size, &methodResponse, &responseSize);
-            echoDesired(propertyName, payLoad, methodResponse, status);
-            free(methodResponse);
-            break;
+        if (queueReportedEntry(property, twin->desiredVersion, status, statusCode)) {
+            entryCount++;
+        } else {
+            Serial.printf("Desired property %.*s failed to be echoed back as a reported property\r\n",
+                property->name.length, property->name.start);
+            incrementErrorCount();
         }
     }
+
+    // the acknowledgements go out together with anything else pending on the next pump
+    if (entryCount > 0) {
+        Globals::iothubClient->requestReportedFlush();
+    }
 }
 
 void deviceTwinGetStateCallback(DEVICE_TWIN_UPDATE_STATE update_state,
     const unsigned char* payLoad, size_t size, void* userContextCallback) {
+    static TWIN_DOCUMENT twin;
 
-    ((char*)payLoad)[size] = 0x00;
-    JSObject payloadObject((const char *)payLoad);
+    const unsigned long latency = Globals::iothubClient->getReceiveLatency();
+    Globals::iothubClient->markActivity();
+    recordTwinLatency(latency);
+    Serial.printf("Twin update read within %lu ms\r\n", latency);
 
-    if (update_state == DEVICE_TWIN_UPDATE_PARTIAL) {
-        callDesiredCallback(payloadObject.getNameAt(0), reinterpret_cast<const char*>(payLoad), size);
-    } else {
-        JSObject desired, reported;
-
-        // loop through all the desired properties
-        // look to see if the desired property has an associated reported property
-        // if so look if the versions match, if they match do nothing
-        // if they don't match then call the associated callback for the desired property
+    const bool partial = update_state == DEVICE_TWIN_UPDATE_PARTIAL;
+    if (!twinParse((const char*)payLoad, size, partial, &twin)) {
+        LOG_ERROR("parsing the twin failed");
+        incrementErrorCount();
+        return;
+    }
 
-        Serial.println("Processing complete twin");
+    if (twin.droppedCount > 0) {
+        Serial.printf("Twin has %u more properties than can be tracked\r\n", twin.droppedCount);
+    }
 
-        payloadObject.getObjectByName("desired", &desired);
-        payloadObject.getObjectByName("reported", &reported);
-
-        for (unsigned i = 0, count = desired.getCount(); i < count; i++) {
-            JSObject item;
-            const char * itemName = desired.getNameAt(i);
-            if (itemName[0] != '$') {
-                JSObject keyObject;
-                const char * version = NULL, * desiredVersion = NULL,
-                           * value = NULL, * desiredValue = NULL;
-                bool containsKey = reported.getObjectByName(itemName, &keyObject);
-
-                if (containsKey) {
-                    desiredVersion = reported.getStringByName("desiredVersion");
-                    version = desired.getStringByName("$version");
-                    desiredValue = reported.getStringByName("desiredValue");
-                    value = desired.getStringByName("value");
-                }
+    // the DoWork bound above misses the time in the hub and on the network, a
+    // patch carries the time the hub stored it. a full twin's is of the last patch
+    time_t updatedSeconds, nowSeconds;
+    unsigned updatedMillis, nowMillis;
+    if (partial && isTimeSynced() &&
+        parseIsoTimestamp(twin.desiredLastUpdated.start, twin.desiredLastUpdated.length,
+                          &updatedSeconds, &updatedMillis)) {
+        getCurrentTime(&nowSeconds, &nowMillis);
+        const long delivery = (long)(nowSeconds - updatedSeconds) * 1000 + (long)nowMillis - (long)updatedMillis;
+        recordTwinDeliveryLatency(delivery);
+        Serial.printf("Twin update delivered %ld ms after the hub stored it\r\n", delivery);
+    }
 
-                if (containsKey && strcmp(desiredVersion, version) == 0) {
-                    Serial.printf("key: %s found in reported and versions match\r\n", itemName);
-                } else if (containsKey && strcmp(desiredValue, value) != 0){
-                    Serial.printf("key: %s either not found in reported or versions do not match\r\n", itemName);
-                    JSObject itemValue;
-                    if (desired.getObjectAt(i, &itemValue) && itemValue.toString() != NULL) {
-                        Serial.println(itemValue.toString());
-                    } else {
-                        LOG_ERROR("desired doesn't have value at index");
-                    }
-                    callDesiredCallback(itemName, (const char*)payLoad, size);
-                } else {
-                    echoDesired(itemName, (const char*)payLoad, Globals::completedString, 200);
-                }
-            }
-        }
+    if (!partial) {
+        Serial.println("Processing complete twin");
     }
+
+    reconcileTwin(&twin, partial);
 }
 
+// the context carries the id of the confirmed patch
 static void deviceTwinConfirmationCallback(int status_code, void* userContextCallback) {
-    assert(userContextCallback == NULL); // NOOP for now, so it should be NULL
+    Globals::iothubClient->markActivity();
     LogInfo("DeviceTwin CallBack: Status_code = %u", status_code);
+    Globals::iothubClient->reportedPropertiesConfirmed((int)(intptr_t)userContextCallback, status_code);
 }
 
 static void connectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result,
     IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason, void* userContextCallback) {
 
+    Globals::iothubClient->setConnected(result == IOTHUB_CLIENT_CONNECTION_AUTHENTICATED);
+
     if (reason == IOTHUB_CLIENT_CONNECTION_NO_NETWORK) {
         Serial.println("No network connection");
+        ledIndicatorSignal(LED_EVENT_WIFI_DISCONNECTED);
         Globals::iothubClient->needsReconnect = true;
+    } else if (result == IOTHUB_CLIENT_CONNECTION_AUTHENTICATED) {
+        ledIndicatorSignal(LED_EVENT_WIFI_CONNECTED);
     } else if (result == IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED &&
                reason == IOTHUB_CLIENT_CONNECTION_EXPIRED_SAS_TOKEN) {
         Serial.println("Connection timeout");
@@ -462,12 +738,12 @@ static void connectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result,
 static void sendConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *userContextCallback) {
     static int callbackCounter = 0;
     EVENT_INSTANCE *eventInstance = (EVENT_INSTANCE *)userContextCallback;
+    Globals::iothubClient->messageConfirmed(eventInstance, result);
     Serial.printf("Confirmation[%d] received for message tracking id = %d \
         with result = %s\r\n", callbackCounter++, eventInstance->messageTrackingId,
         ENUM_TO_STRING(IOTHUB_CLIENT_CONFIRMATION_RESULT, result));
 
-    IoTHubMessage_Destroy(eventInstance->messageHandle);
-    free(eventInstance);
+    releaseMessageSlot(eventInstance);
 }
 
 // scrolling text global variables
@@ -500,5 +776,5 @@ void IoTHubClient::displayDeviceInfo() {
 
     snprintf(buff, STRING_BUFFER_128 - 1, "Device:\r\n%s\r\n%.16s\r\nf/w: %s",
         deviceId, displayHubName, AZIOTC_FW_VERSION);
-    Screen.print(0, buff);
+    displayModelSetText(buff);
 }
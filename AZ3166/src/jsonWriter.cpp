@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/jsonWriter.h"
+#include "../inc/utility.h"
+#include "../inc/fixedPoint.h"
+
+void JsonWriter::appendRaw(const char * text, unsigned textLength) {
+    if (overflow) return;
+
+    if (length + textLength >= capacity) {
+        overflow = true;
+        return;
+    }
+
+    memcpy(buffer + length, text, textLength);
+    length += textLength;
+    buffer[length] = char(0);
+}
+
+void JsonWriter::appendFloatValue(float value) {
+    char number[STRING_BUFFER_32];
+    // String(float) formats through dtostrf(value, decimalPlaces + 2, decimalPlaces)
+    dtostrf(value, 4, 2, number);
+    appendRaw(number, strlen(number));
+}
+
+void JsonWriter::appendIntValue(int value) {
+    appendFixedValue(value, 0, 0);
+}
+
+void JsonWriter::appendFixedValue(int32_t value, unsigned decimals, unsigned precision) {
+    char number[FIXED_FORMAT_SIZE];
+    appendRaw(number, formatFixed(value, decimals, precision, number));
+}
@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/ledIndicator.h"
+#include "../inc/device.h"
+#include "../inc/sensors.h"
+
+// durations in ms, even steps light the LED and odd steps turn it off
+typedef struct LED_PATTERN_TAG {
+    const uint16_t *steps;
+    uint8_t stepCount;
+    bool repeat;
+    bool restOn; // LED state once a non repeating pattern completes
+} LED_PATTERN;
+
+typedef struct LED_CHANNEL_TAG {
+    void (*setLed)(bool on);
+    const LED_PATTERN *pattern;
+    uint8_t step;
+    unsigned long stepStart;
+} LED_CHANNEL;
+
+static const uint16_t flashSteps[] = { 500 };
+static const uint16_t slowBlinkSteps[] = { 500, 500 };
+static const uint16_t stateBlinkSteps[] = { 150, 150, 150, 150 };
+
+static const LED_PATTERN sendPattern = { flashSteps, 1, false, false };
+static const LED_PATTERN errorPattern = { flashSteps, 1, false, false };
+static const LED_PATTERN wifiConnectedPattern = { NULL, 0, false, true };
+static const LED_PATTERN wifiDisconnectedPattern = { slowBlinkSteps, 2, true, false };
+static const LED_PATTERN devicePattern = { stateBlinkSteps, 4, false, true };
+
+static void setAzureLed(bool on) { digitalWrite(LED_AZURE, on ? 1 : 0); }
+static void setUserLed(bool on) { digitalWrite(LED_USER, on ? 1 : 0); }
+static void setWiFiLed(bool on) { digitalWrite(LED_WIFI, on ? 1 : 0); }
+
+static void setStateLed(bool on) {
+    if (on) {
+        DeviceControl::showState();
+    } else {
+        turnLedOff();
+    }
+}
+
+enum { AZURE_CHANNEL, USER_CHANNEL, WIFI_CHANNEL, STATE_CHANNEL, LED_CHANNEL_COUNT };
+
+static LED_CHANNEL channels[LED_CHANNEL_COUNT] = {
+    { setAzureLed, NULL, 0, 0 },
+    { setUserLed, NULL, 0, 0 },
+    { setWiFiLed, NULL, 0, 0 },
+    { setStateLed, NULL, 0, 0 }
+};
+
+static void startPattern(LED_CHANNEL *channel, const LED_PATTERN *pattern) {
+    channel->step = 0;
+    channel->stepStart = millis();
+
+    if (pattern->stepCount == 0) {
+        channel->pattern = NULL;
+        channel->setLed(pattern->restOn);
+    } else {
+        channel->pattern = pattern;
+        channel->setLed(true);
+    }
+}
+
+void ledIndicatorInit() {
+    for (int i = 0; i < LED_CHANNEL_COUNT; i++) {
+        channels[i].pattern = NULL;
+        channels[i].step = 0;
+    }
+}
+
+void ledIndicatorSignal(LedEvent event) {
+    switch (event) {
+        case LED_EVENT_SEND:
+            startPattern(&channels[AZURE_CHANNEL], &sendPattern);
+            break;
+        case LED_EVENT_ERROR:
+            startPattern(&channels[USER_CHANNEL], &errorPattern);
+            break;
+        case LED_EVENT_WIFI_CONNECTED:
+            startPattern(&channels[WIFI_CHANNEL], &wifiConnectedPattern);
+            break;
+        case LED_EVENT_WIFI_DISCONNECTED:
+            startPattern(&channels[WIFI_CHANNEL], &wifiDisconnectedPattern);
+            break;
+        case LED_EVENT_DEVICE_STATE:
+            startPattern(&channels[STATE_CHANNEL], &devicePattern);
+            break;
+    }
+}
+
+void ledIndicatorTick() {
+    const unsigned long now = millis();
+
+    for (int i = 0; i < LED_CHANNEL_COUNT; i++) {
+        LED_CHANNEL *channel = &channels[i];
+        const LED_PATTERN *pattern = channel->pattern;
+        if (pattern == NULL || now - channel->stepStart < pattern->steps[channel->step]) {
+            continue;
+        }
+
+        channel->step++;
+        channel->stepStart = now;
+
+        if (channel->step == pattern->stepCount) {
+            if (!pattern->repeat) {
+                channel->pattern = NULL;
+                channel->setLed(pattern->restOn);
+                continue;
+            }
+            channel->step = 0;
+        }
+
+        channel->setLed(channel->step % 2 == 0);
+    }
+}
@@ -13,40 +13,100 @@
 #include "../inc/stats.h"
 #include "../inc/registeredMethodHandlers.h"
 #include "../inc/oledAnimation.h"
+#include "../inc/animationFrames.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/telemetrySampler.h"
+#include "../inc/ledIndicator.h"
+#include "../inc/scheduler.h"
+#include "../inc/flashStore.h"
+#include "../inc/telemetryQueue.h"
+#include "../inc/deadband.h"
+#include "../inc/hts221.h"
+#include "../inc/vibration.h"
+#include "../inc/i2cBus.h"
+#include "../inc/sensorTrace.h"
+#include "../inc/displayModel.h"
+#include "../inc/telemetryPayload.h"
 
 #define traceOn false
 #define statePayloadTemplate "{\"%s\":\"%s\"}"
 
 // forward declarations
-void sendTelemetryPayload(const char *payload);
+bool sendTelemetryPayload(const char *payload, unsigned length, MessageFormat format);
+bool storeTelemetryPayload(const char *payload, unsigned length, MessageFormat format);
 void sendStateChange();
-void buildTelemetryPayload(String *payload);
 void rollDieAnimation(int value);
+void timeSyncTask();
+void buttonTask();
+void sampleTask();
+void telemetryTask();
+void batchTask();
+void shakeTask();
+void ledTask();
+void displayTask();
+void statsTask();
+void motionTask();
+void vibrationTask();
+void traceTask();
+void queueTask();
+void hubTask();
 
 const int telemetrySendInterval = 5000;
+const int telemetrySampleInterval = 500;
+// sensors are sampled between sends and summarized as min/max/mean/last
+const bool aggregateTelemetry = telemetrySampleInterval < telemetrySendInterval;
+const int telemetryBatchWindow = 0; // 0 sends every sample as its own message
+const bool deadbandTelemetry = false; // only send fields that changed, see deadband.h
+const MessageFormat telemetryFormat = MESSAGE_FORMAT_JSON; // MESSAGE_FORMAT_CBOR sends binary, unbatched
 const int reportedSendInterval = 2000;
+const int reportedFlushInterval = 1000; // reported properties set within this window share one patch
+const int maxMessagesInFlight = 4;
+const int backpressureSlowdown = 4; // sample period multiplier while backpressured
+const bool motionFifo = false; // aggregate every accelerometer and gyroscope sample, see motionFifo.h
+const bool vibrationTelemetry = false; // rms and band energies of the accelerometer spectrum, see vibration.h
+const MotionOdr motionFifoRate = vibrationTelemetry ? MOTION_ODR_416HZ : MOTION_ODR_26HZ;
+const unsigned motionFifoWatermark = 13; // samples, read about every half second
+const bool recordSensorTrace = false; // print every sensor each sample period as a trace record, see sensorTrace.h
+
+// task periods
+const int buttonPollInterval = 20;
+const int shakePollInterval = 50;
+const int batchCheckInterval = 100;
+const int ledTickInterval = 10;
+const int displayInterval = 250;
+const int statsInterval = 60 * 1000;
+const int motionDrainInterval = 250;
+const int vibrationInterval = 100;
+const int queueMaintenanceInterval = 1000;
 
 static bool reset = false;
 const int switchDebounceTime = 250;
 static bool connected;
-unsigned long lastTimeSync = 0;
 unsigned long timeSyncPeriod = 24 * 60 * 60 * 1000; // 24 Hours
-unsigned long lastTelemetrySend = 0;
-unsigned long lastShakeTime = 0;
+unsigned long timeSyncRetryPeriod = 60 * 1000;
 unsigned long lastSwitchPress = 0;
+static int timeSyncTaskId = -1;
+static int shakeTaskId = -1;
+static bool shakeLockout = false;
+static int hubTaskId = -1;
+static int sampleTaskId = -1;
+static int displayTaskId = -1;
 static int currentInfoPage = 0;
-static int lastInfoPage = -1;
 uint8_t telemetryState = 0xFF;
 
+static FlashIapStore telemetryStore(TELEMETRY_STORE_ADDRESS, TELEMETRY_STORE_SECTOR_SIZE,
+                                    TELEMETRY_STORE_SECTORS);
+static TelemetryQueue offlineQueue(telemetryStore);
+
 
 void telemetrySetup(const char* iotCentralConfig) {
     reset = false;
 
     randomSeed(analogRead(0));
+    ledIndicatorInit();
 
     // connect to the WiFi in config
     connected = initWiFi();
-    lastTimeSync = millis();
 
     // initialize the sensor array
     initSensors();
@@ -67,6 +127,17 @@ void telemetrySetup(const char* iotCentralConfig) {
         return;
     }
 
+    // pack samples into a single message for up to telemetryBatchWindow ms
+    Globals::iothubClient->setBatchWindow(telemetryBatchWindow);
+    Globals::iothubClient->setMaxInFlight(maxMessagesInFlight);
+    Globals::iothubClient->setReportedFlushInterval(reportedFlushInterval);
+
+    // keep telemetry in flash while the hub can't be reached, replay it later
+    const bool hasOfflineQueue = offlineQueue.init();
+    if (hasOfflineQueue) {
+        Globals::iothubClient->setOfflineQueue(&offlineQueue);
+    }
+
     // Register callbacks for cloud to device messages
     Globals::iothubClient->registerMethod("message", cloudMessage);  // C2D message
     Globals::iothubClient->registerMethod("rainbow", directMethod);  // direct method
@@ -76,15 +147,54 @@ void telemetrySetup(const char* iotCentralConfig) {
     Globals::iothubClient->registerDesiredProperty("setVoltage", voltageDesiredChange);
     Globals::iothubClient->registerDesiredProperty("setCurrent", currentDesiredChange);
     Globals::iothubClient->registerDesiredProperty("activateIR", irOnDesiredChange);
+    Globals::iothubClient->registerDesiredProperty("telemetryDeadband", deadbandDesiredChange);
 
     // show the state of the device on the RGB LED
-    DeviceControl::showState();
+    ledIndicatorSignal(LED_EVENT_DEVICE_STATE);
 
     // clear all the stat counters
     clearCounters();
 
     assert(iotCentralConfig != NULL);
     telemetryState = iotCentralConfig[2];
+    if ((motionFifo || vibrationTelemetry) && !enableMotionFifo(motionFifoRate, motionFifoWatermark)) {
+        Serial.println("Motion FIFO unavailable, sampling single values");
+    }
+    if (vibrationTelemetry && !vibrationInit()) {
+        Serial.println("Vibration telemetry unavailable");
+    }
+    samplerInit(telemetryState);
+    deadbandInit(deadbandTelemetry);
+
+    // every job of the telemetry loop runs on its own period
+    const unsigned long now = millis();
+    schedulerInit();
+    displayModelInit(DISPLAY_MIN_REFRESH_INTERVAL);
+    timeSyncTaskId = schedulerAddTask("timeSync", timeSyncPeriod, timeSyncTask, now);
+    schedulerAddTask("buttons", buttonPollInterval, buttonTask, now);
+    if (aggregateTelemetry) {
+        sampleTaskId = schedulerAddTask("sample", telemetrySampleInterval, sampleTask, now);
+    }
+    schedulerAddTask("telemetry", telemetrySendInterval, telemetryTask, now);
+    schedulerAddTask("batch", batchCheckInterval, batchTask, now);
+    shakeTaskId = schedulerAddTask("shake", shakePollInterval, shakeTask, now);
+    schedulerAddTask("led", ledTickInterval, ledTask, now);
+    displayTaskId = schedulerAddTask("display", displayInterval, displayTask, now);
+    schedulerAddTask("stats", statsInterval, statsTask, now);
+    if (isMotionFifoEnabled()) {
+        schedulerAddTask("motion", motionDrainInterval, motionTask, now);
+    }
+    if (isVibrationEnabled()) {
+        schedulerAddTask("vibration", vibrationInterval, vibrationTask, now);
+    }
+    if (recordSensorTrace) {
+        sensorTraceStart(now);
+        schedulerAddTask("trace", telemetrySampleInterval, traceTask, now);
+    }
+    if (hasOfflineQueue) {
+        schedulerAddTask("queue", queueMaintenanceInterval, queueTask, now);
+    }
+    hubTaskId = schedulerAddTask("hub", HUB_PUMP_BUSY_INTERVAL, hubTask, now);
 }
 
 
@@ -95,66 +205,143 @@ void telemetryLoop() {
       return;
     }
 
-    if (connected && (millis() - lastTimeSync > timeSyncPeriod)) {
-        // re-sync the time from ntp
-        if (SyncTimeToNTP()) {
-            lastTimeSync = millis();
-        }
+    schedulerRun(millis());
+
+    delay(1);  // good practice to help prevent lockups
+}
+
+void timeSyncTask() {
+    if (!connected) return;
+
+    // re-sync the time from ntp, retry sooner when no server answered
+    if (!SyncTimeToNTP()) {
+        schedulerRunIn(timeSyncTaskId, timeSyncRetryPeriod, millis());
     }
+}
+
+void buttonTask() {
+    if (millis() - lastSwitchPress <= switchDebounceTime) return;
 
     // look for button A pressed to signify state change
     // when the A button is pressed the device state rotates to the next value and a state telemetry message is sent
-    if (DeviceControl::IsButtonClicked(USER_BUTTON_A) &&
-        (millis() - lastSwitchPress > switchDebounceTime)) {
-
+    if (DeviceControl::IsButtonClicked(USER_BUTTON_A)) {
         DeviceControl::incrementDeviceState();
-        DeviceControl::showState();
+        ledIndicatorSignal(LED_EVENT_DEVICE_STATE);
         sendStateChange();
         lastSwitchPress = millis();
     }
 
     // look for button B pressed to page through info screens
-    if (DeviceControl::IsButtonClicked(USER_BUTTON_B) &&
-        (millis() - lastSwitchPress > switchDebounceTime)) {
-
+    if (DeviceControl::IsButtonClicked(USER_BUTTON_B)) {
         currentInfoPage = (currentInfoPage + 1) % 3;
         lastSwitchPress = millis();
     }
+}
 
-    // example of sending telemetry data
-    if (millis() - lastTelemetrySend >= telemetrySendInterval) {
-        String payload; // max payload size for Azure IoT
-
-        buildTelemetryPayload(&payload);
-        sendTelemetryPayload(payload.c_str());
-        lastTelemetrySend = millis();
-    }
+// sample the sensors between telemetry sends, slower while the hub is backed up
+void sampleTask() {
+    samplerTakeSample();
+    schedulerSetPeriod(sampleTaskId, Globals::iothubClient->isBackpressured() ?
+        telemetrySampleInterval * backpressureSlowdown : telemetrySampleInterval);
+}
 
-    // example of sending a device twin reported property when the accelerometer detects a double tap
-    if (checkForShake() && (millis() - lastShakeTime > reportedSendInterval)) {
-        String shakeProperty = F("{\"dieNumber\":{{die}}}");
-        randomSeed(analogRead(0));
-        int die = random(1, 7);
-        shakeProperty.replace("{{die}}", String(die));
+// example of sending telemetry data
+void telemetryTask() {
+    static char payload[STRING_BUFFER_4096];
 
-        Screen.clean();
-        rollDieAnimation(die);
+    // the link is stalled, this interval goes to the offline queue rather than
+    // another message in flight. without a queue the samples wait for the next interval
+    const bool backpressured = Globals::iothubClient->isBackpressured();
+    if (backpressured && !Globals::iothubClient->hasOfflineQueue()) {
+        Serial.println("Telemetry deferred, too many messages in flight");
+        return;
+    }
 
-        if (Globals::iothubClient->sendReportedProperty(shakeProperty.c_str())) {
-            Serial.println("Reported property dieNumber successfully sent");
-            incrementReportedCount();
+    unsigned fieldCount = 0;
+    const unsigned length = buildTelemetryPayload(payload, STRING_BUFFER_4096, telemetryFormat,
+                                                  aggregateTelemetry, &fieldCount);
+    if (length > 0) {
+        // nothing is sent while every field stays within its deadband. the
+        // deadband only moves on once the payload was sent or queued
+        bool sent = false;
+        if (fieldCount > 0 && backpressured) {
+            sent = storeTelemetryPayload(payload, length, telemetryFormat);
+        } else if (fieldCount > 0) {
+            sent = sendTelemetryPayload(payload, length, telemetryFormat);
+        }
+        if (sent) {
+            deadbandCommit(millis());
         } else {
-            Serial.println("Reported property dieNumber failed to during sending");
-            incrementErrorCount();
+            deadbandDiscard();
         }
-        lastShakeTime = millis();
+    } else {
+        incrementErrorCount();
     }
+}
 
-    // update the current display page
-    if (currentInfoPage != lastInfoPage) {
-        Screen.clean();
-        lastInfoPage = currentInfoPage;
+// move the LSM6DSL FIFO into the sample ring once it reached its watermark
+void motionTask() {
+    motionFifoDrain(false);
+}
+
+// analyze the accelerometer windows completed since the last run
+void vibrationTask() {
+    vibrationProcess();
+}
+
+// one trace record with every sensor
+void traceTask() {
+    sensorTraceCapture(millis());
+}
+
+// erase sectors the offline queue is done with, outside of DoWork and the
+// send confirmations. an erase holds up the loop for 1-2 s
+void queueTask() {
+    offlineQueue.maintain();
+}
+
+// send any open telemetry batch once its window has expired
+void batchTask() {
+    Globals::iothubClient->checkTelemetryBatch();
+}
+
+// example of sending a device twin reported property when the accelerometer detects a double tap
+void shakeTask() {
+    // the interrupt kept counting through the lockout after a roll, none of that is a new shake
+    if (shakeLockout) {
+        shakeLockout = false;
+        discardShakes();
     }
+    if (!checkForShake()) return;
+
+    randomSeed(analogRead(0));
+    int die = random(1, 7);
+
+    displayModelClear();
+    rollDieAnimation(die);
+
+    // queued, the hub client sends it with any other pending reported property
+    char dieValue[STRING_BUFFER_16];
+    snprintf(dieValue, sizeof(dieValue), "%d", die);
+    if (Globals::iothubClient->setReportedProperty("dieNumber", dieValue)) {
+        Serial.println("Reported property dieNumber queued");
+    } else {
+        Serial.println("Reported property dieNumber failed to be queued");
+        incrementErrorCount();
+    }
+
+    // ignore shakes until the reported property interval has passed
+    shakeLockout = true;
+    schedulerRunIn(shakeTaskId, reportedSendInterval, millis());
+}
+
+// blink patterns for the status LEDs
+void ledTask() {
+    ledIndicatorTick();
+}
+
+// render the current display page, only changed lines reach the screen
+void displayTask() {
     switch (currentInfoPage) {
         case 0: // message counts - page 1
         {
@@ -165,7 +352,7 @@ void telemetryLoop() {
                     getTelemetryCount(), getErrorCount(), getDesiredCount(),
                     getReportedCount());
 
-            Screen.print(0, buff);
+            displayModelSetText(buff);
         }
             break;
         case 1: // Device information
@@ -175,8 +362,69 @@ void telemetryLoop() {
             displayNetworkInfo();
             break;
     }
+    // a flush the refresh cap skipped runs as soon as the cap allows
+    const unsigned long now = millis();
+    displayModelFlush(now);
+    const unsigned long retry = displayModelFlushDelay(now);
+    if (retry > 0) {
+        schedulerRunIn(displayTaskId, retry, now);
+    }
+}
 
-    delay(1);  // good practice to help prevent lockups
+// service the IoT Hub connection, the client picks its own cadence
+void hubTask() {
+    schedulerRunIn(hubTaskId, Globals::iothubClient->pump(), millis());
+}
+
+void statsTask() {
+    schedulerPrintStats();
+    Serial.printf("twin read within avg %lu ms, max %lu ms; delivered avg %lu ms, max %lu ms of %lu\r\n",
+        getTwinLatencyAverage(), getTwinLatencyMax(), getTwinDeliveryLatencyAverage(),
+        getTwinDeliveryLatencyMax(), getTwinDeliveryCount());
+    Serial.printf("in flight %d, backpressured sends %d, message pool exhausted %d\r\n",
+        Globals::iothubClient->getInFlightCount(), getBackpressureCount(),
+        getPoolExhaustedCount());
+    Serial.printf("reported patches %d, coalesced values %d, retries %d\r\n",
+        getReportedPatchCount(), getReportedCoalescedCount(), getReportedRetryCount());
+    Serial.printf("offline queued %u, stored %d, replayed %d, dropped %d, downsampled %u\r\n",
+        offlineQueue.getCount(), getOfflineStoredCount(), getOfflineReplayedCount(),
+        getOfflineDroppedCount(), offlineQueue.getDownsampledCount());
+    if (isDeadbandEnabled()) {
+        Serial.print("deadband suppressed:");
+        for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+            Serial.printf(" %s %lu", telemetryFields[field].name, getDeadbandSuppressedCount(field));
+        }
+        Serial.printf(", total %lu\r\n", getDeadbandSuppressedTotal());
+    }
+    if (isMotionFifoEnabled()) {
+        Serial.printf("motion samples %lu, fifo overruns %lu, dropped words %lu, sampler missed %lu\r\n",
+            getMotionSampleCount(), getMotionFifoOverrunCount(), getMotionDroppedWordCount(),
+            getSamplerMotionMissedCount());
+    }
+    if (isVibrationEnabled()) {
+        Serial.printf("vibration windows %lu, missed samples %lu, analysis max %lu us\r\n",
+            getVibrationWindowCount(), getVibrationMissedCount(), getVibrationAnalysisTimeMax());
+    }
+    Serial.printf("shake interrupts %lu, wake ups %lu, shakes %lu\r\n", getShakeInterruptCount(),
+        getShakeWakeUpCount(), getShakeCount());
+    Serial.printf("hts221 conversions %lu\r\n", getHts221AcquisitionCount());
+    for (int device = 0; device < I2C_DEVICE_COUNT; device++) {
+        const I2C_DEVICE_STATS *bus = getI2cDeviceStats((I2cDevice)device);
+        Serial.printf("i2c %s transactions %lu, bytes %lu, bus time %lu us, errors %lu\r\n",
+            getI2cDeviceName((I2cDevice)device), bus->transactions, bus->bytes, bus->busTime, bus->errors);
+    }
+    Serial.printf("i2c merged reads %lu\r\n", getI2cMergedCount());
+    Serial.printf("telemetry %s avg %u bytes, encoded in %lu us\r\n",
+        telemetryFormat == MESSAGE_FORMAT_CBOR ? "cbor" : "json",
+        getTelemetrySizeAverage(), getTelemetryEncodeTimeAverage());
+
+    static unsigned long lastDisplayBusTime = 0;
+    const unsigned long displayBusTime = getDisplayBusTime();
+    Serial.printf("display lines drawn %lu, unchanged %lu, skipped flushes %lu, bus time %lu us/min\r\n",
+        getDisplayLinesDrawn(), getDisplayLinesUnchanged(), getDisplayFlushesSkipped(),
+        (displayBusTime - lastDisplayBusTime) * 60000UL / statsInterval);
+    lastDisplayBusTime = displayBusTime;
+    printConfirmLatencyHistogram();
 }
 
 void telemetryCleanup() {
@@ -189,86 +437,30 @@ void telemetryCleanup() {
     shutdownWiFi();
 }
 
-void buildTelemetryPayload(String *payload) {
-    *payload = "{";
-
-    // HTS221
-    float humidity = 0.0;
-    if ((telemetryState & HUMIDITY_CHECKED) == HUMIDITY_CHECKED) {
-        humidity = readHumidity();
-        payload->concat(",\"humidity\":");
-        payload->concat(String(humidity));
-    }
-
-    float temp = 0.0;
-    if ((telemetryState & TEMP_CHECKED) == TEMP_CHECKED) {
-        temp = readTemperature();
-        payload->concat(",\"temp\":");
-        payload->concat(String(temp));
-    }
-
-    // LPS22HB
-    float pressure = 0.0;
-    if ((telemetryState & PRESSURE_CHECKED) == PRESSURE_CHECKED) {
-        pressure = readPressure();
-        payload->concat(",\"pressure\":");
-        payload->concat(String(pressure));
-    }
-
-    // LIS2MDL
-    int magAxes[3];
-    if ((telemetryState & MAG_CHECKED) == MAG_CHECKED) {
-        readMagnetometer(magAxes);
-        payload->concat(",\"magnetometerX\":");
-        payload->concat(String(magAxes[0]));
-        payload->concat(",\"magnetometerY\":");
-        payload->concat(String(magAxes[1]));
-        payload->concat(",\"magnetometerZ\":");
-        payload->concat(String(magAxes[2]));
-    }
-
-    // LSM6DSL
-    int accelAxes[3];
-    if ((telemetryState & ACCEL_CHECKED) == ACCEL_CHECKED) {
-        readAccelerometer(accelAxes);
-        payload->concat(",\"accelerometerX\":");
-        payload->concat(String(accelAxes[0]));
-        payload->concat(",\"accelerometerY\":");
-        payload->concat(String(accelAxes[1]));
-        payload->concat(",\"accelerometerZ\":");
-        payload->concat(String(accelAxes[2]));
-    }
+bool sendTelemetryPayload(const char *payload, unsigned length, MessageFormat format) {
+    // Serial.println(payload);
 
-    int gyroAxes[3];
-    if ((telemetryState & GYRO_CHECKED) == GYRO_CHECKED) {
-        readGyroscope(gyroAxes);
-        payload->concat(",\"gyroscopeX\":");
-        payload->concat(String(gyroAxes[0]));
-        payload->concat(",\"gyroscopeY\":");
-        payload->concat(String(gyroAxes[1]));
-        payload->concat(",\"gyroscopeZ\":");
-        payload->concat(String(gyroAxes[2]));
+    if (Globals::iothubClient->sendTelemetry(payload, length, format)) {
+        // flash the Azure LED
+        ledIndicatorSignal(LED_EVENT_SEND);
+        incrementTelemetryCount();
+        return true;
     }
 
-    payload->concat("}");
-    payload->replace("{,", "{");
+    ledIndicatorSignal(LED_EVENT_ERROR);
+    incrementErrorCount();
+    return false;
 }
 
-void sendTelemetryPayload(const char *payload) {
-    // Serial.println(payload);
-
-    if (Globals::iothubClient->sendTelemetry(payload)) {
-        // flash the Azure LED
-        digitalWrite(LED_AZURE, 1);
-        delay(500);
-        digitalWrite(LED_AZURE, 0);
+bool storeTelemetryPayload(const char *payload, unsigned length, MessageFormat format) {
+    if (Globals::iothubClient->storeTelemetry(payload, length, format)) {
         incrementTelemetryCount();
-    } else {
-        digitalWrite(LED_USER, 1);
-        delay(500);
-        digitalWrite(LED_USER, 0);
-        incrementErrorCount();
+        return true;
     }
+
+    ledIndicatorSignal(LED_EVENT_ERROR);
+    incrementErrorCount();
+    return false;
 }
 
 void sendStateChange() {
@@ -293,73 +485,20 @@ void sendStateChange() {
                               statePayloadTemplate, "deviceState", value);
     stateChangePayload[length] = char(0);
 
-    sendTelemetryPayload(stateChangePayload);
+    sendTelemetryPayload(stateChangePayload, length, MESSAGE_FORMAT_JSON);
 }
 
 void rollDieAnimation(int value) {
 
-    char die1[] = {
-        '1', 'T', 'T', 'T', 'T', 'T', 'T', '2',
-        '<', '.', '.', '.', '.', '.', '.', '>',
-        '<', '.', '.', '.', '.', '.', '.', '>',
-        '<', '.', '.', '!', '@', '.', '.', '>',
-        '<', '.', '.', '#', '$', '.', '.', '>',
-        '<', '.', '.', '.', '.', '.', '.', '>',
-        '<', '.', '.', '.', '.', '.', '.', '>',
-        '3', 'b', 'b', 'b', 'b', 'b', 'b', '4'};
-
-    char die2[] = {
-        '1', 'T', 'T', 'T', 'T', 'T', 'T', '2',
-        '<', '!', '@', '.', '.', '.', '.', '>',
-        '<', '#', '$', '.', '.', '.', '.', '>',
-        '<', '.', '.', '.', '.', '.', '.', '>',
-        '<', '.', '.', '.', '.', '.', '.', '>',
-        '<', '.', '.', '.', '.', '!', '@', '>',
-        '<', '.', '.', '.', '.', '#', '$', '>',
-        '3', 'b', 'b', 'b', 'b', 'b', 'b', '4'};
-
-    char die3[] = {
-        '1', 'T', 'T', 'T', 'T', 'T', 'T', '2',
-        '<', '!', '@', '.', '.', '.', '.', '>',
-        '<', '#', '$', '.', '.', '.', '.', '>',
-        '<', '.', '.', '!', '@', '.', '.', '>',
-        '<', '.', '.', '#', '$', '.', '.', '>',
-        '<', '.', '.', '.', '.', '!', '@', '>',
-        '<', '.', '.', '.', '.', '#', '$', '>',
-        '3', 'b', 'b', 'b', 'b', 'b', 'b', '4'};
-
-    char die4[] = {
-        '1', 'T', 'T', 'T', 'T', 'T', 'T', '2',
-        '<', '!', '@', '.', '.', '!', '@', '>',
-        '<', '#', '$', '.', '.', '#', '$', '>',
-        '<', '.', '.', '.', '.', '.', '.', '>',
-        '<', '.', '.', '.', '.', '.', '.', '>',
-        '<', '!', '@', '.', '.', '!', '@', '>',
-        '<', '#', '$', '.', '.', '#', '$', '>',
-        '3', 'b', 'b', 'b', 'b', 'b', 'b', '4'};
-
-    char die5[] = {
-        '1', 'T', 'T', 'T', 'T', 'T', 'T', '2',
-        '<', '!', '@', '.', '.', '!', '@', '>',
-        '<', '#', '$', '.', '.', '#', '$', '>',
-        '<', '.', '.', '!', '@', '.', '.', '>',
-        '<', '.', '.', '#', '$', '.', '.', '>',
-        '<', '!', '@', '.', '.', '!', '@', '>',
-        '<', '#', '$', '.', '.', '#', '$', '>',
-        '3', 'b', 'b', 'b', 'b', 'b', 'b', '4'};
-
-    char die6[] = {
-        '1', 'T', 'T', 'T', 'T', 'T', 'T', '2',
-        '<', '!', '@', '.', '.', '!', '@', '>',
-        '<', '#', '$', '.', '.', '#', '$', '>',
-        '<', '!', '@', '.', '.', '!', '@', '>',
-        '<', '#', '$', '.', '.', '#', '$', '>',
-        '<', '!', '@', '.', '.', '!', '@', '>',
-        '<', '#', '$', '.', '.', '#', '$', '>',
-        '3', 'b', 'b', 'b', 'b', 'b', 'b', '4'};
-
-    char *die[] = { die1, die2, die3, die4, die5, die6 };
-    char *roll[5];
+    static constexpr Sprite die1 = compileSprite(dieArt[0]);
+    static constexpr Sprite die2 = compileSprite(dieArt[1]);
+    static constexpr Sprite die3 = compileSprite(dieArt[2]);
+    static constexpr Sprite die4 = compileSprite(dieArt[3]);
+    static constexpr Sprite die5 = compileSprite(dieArt[4]);
+    static constexpr Sprite die6 = compileSprite(dieArt[5]);
+
+    const Sprite *die[] = { &die1, &die2, &die3, &die4, &die5, &die6 };
+    const Sprite *roll[5];
 
     for (int i = 0; i < 4; i++) {
         int dieRoll = random(0, 6);
@@ -367,7 +506,7 @@ void rollDieAnimation(int value) {
     }
     roll[4] = die[value - 1];
 
-    animationInit(roll, 5, 64, 0, 1000, true);
+    animationInit(roll, 5, 0, 1000, true);
 
     // show the animation
     for(int i = 0; i < 4; i++) {
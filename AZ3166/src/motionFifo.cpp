@@ -0,0 +1,213 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/motionFifo.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/i2cBus.h"
+
+#include "LSM6DSLSensor.h"
+
+#define LSM6DSL_FIFO_CTRL1 0x06
+#define LSM6DSL_FIFO_CTRL2 0x07
+#define LSM6DSL_FIFO_CTRL3 0x08
+#define LSM6DSL_FIFO_CTRL5 0x0A
+#define LSM6DSL_FIFO_STATUS1 0x3A
+#define LSM6DSL_FIFO_DATA_OUT_L 0x3E
+
+#define FIFO_MODE_BYPASS 0x00
+#define FIFO_MODE_CONTINUOUS 0x06
+#define FIFO_NO_DECIMATION 0x01
+#define FIFO_STATUS2_WATERMARK 0x80
+#define FIFO_STATUS2_OVERRUN 0x40
+#define FIFO_MAX_WATERMARK 0x7FF // words
+
+// gyroscope x, y, z then accelerometer x, y, z
+#define WORDS_PER_SAMPLE 6
+#define BYTES_PER_SAMPLE (WORDS_PER_SAMPLE * 2)
+
+static const float odrHz[] = { 0, 12.5f, 26, 52, 104, 208, 416 };
+static const uint32_t odrMilliHz[] = { 0, 12500, 26000, 52000, 104000, 208000, 416000 };
+
+static bool enabled = false;
+static MotionOdr rate;
+static int32_t accelSensitivity; // ug per LSB
+static int32_t gyroSensitivity;  // udps per LSB
+
+static MOTION_SAMPLE ring[MOTION_RING_SIZE];
+static uint32_t writeCount = 0; // samples ever written, the ring index is writeCount % size
+
+typedef struct MOTION_READER_TAG {
+    bool used;
+    uint32_t cursor; // writeCount of the next sample to read
+    unsigned long overrunCount;
+} MOTION_READER;
+
+static MOTION_READER readers[MOTION_MAX_READERS];
+static unsigned long fifoOverrunCount = 0;
+static unsigned long droppedWordCount = 0;
+
+static bool readRegisters(uint8_t reg, uint8_t *data, uint16_t length) {
+    return i2cRead(I2C_DEVICE_LSM6DSL, reg, data, length);
+}
+
+static bool writeRegister(uint8_t reg, uint8_t value) {
+    return i2cWrite(I2C_DEVICE_LSM6DSL, reg, value);
+}
+
+bool motionFifoInit(LSM6DSLSensor *sensor, MotionOdr odr, unsigned watermark) {
+    enabled = false;
+    writeCount = 0;
+    memset(readers, 0, sizeof(readers));
+
+    float accelScale, gyroScale;
+    if (sensor->setXOdr(odrHz[odr]) != 0 || sensor->setGOdr(odrHz[odr]) != 0 ||
+        sensor->getXSensitivity(&accelScale) != 0 || sensor->getGSensitivity(&gyroScale) != 0) {
+        LOG_ERROR("Configuring the LSM6DSL for the FIFO failed");
+        return false;
+    }
+    accelSensitivity = toFixed(accelScale, 3);
+    gyroSensitivity = toFixed(gyroScale, 3);
+
+    const unsigned words = min(watermark * WORDS_PER_SAMPLE, (unsigned)FIFO_MAX_WATERMARK);
+
+    // bypass empties the FIFO before it is set up again
+    if (!writeRegister(LSM6DSL_FIFO_CTRL5, FIFO_MODE_BYPASS) ||
+        !writeRegister(LSM6DSL_FIFO_CTRL1, words & 0xFF) ||
+        !writeRegister(LSM6DSL_FIFO_CTRL2, (words >> 8) & 0x07) ||
+        !writeRegister(LSM6DSL_FIFO_CTRL3, (FIFO_NO_DECIMATION << 3) | FIFO_NO_DECIMATION) ||
+        !writeRegister(LSM6DSL_FIFO_CTRL5, (odr << 3) | FIFO_MODE_CONTINUOUS)) {
+        LOG_ERROR("Enabling the LSM6DSL FIFO failed");
+        return false;
+    }
+
+    rate = odr;
+    enabled = true;
+    return true;
+}
+
+bool isMotionFifoEnabled() {
+    return enabled;
+}
+
+unsigned motionFifoDrain(bool force) {
+    static uint8_t burst[MOTION_BURST_SAMPLES * BYTES_PER_SAMPLE];
+
+    if (!enabled) {
+        return 0;
+    }
+
+    // FIFO_STATUS1..4: unread words, flags and the position in the data pattern
+    uint8_t status[4];
+    if (!readRegisters(LSM6DSL_FIFO_STATUS1, status, sizeof(status))) {
+        return 0;
+    }
+
+    if (status[1] & FIFO_STATUS2_OVERRUN) {
+        fifoOverrunCount++;
+    }
+    if (!force && (status[1] & (FIFO_STATUS2_WATERMARK | FIFO_STATUS2_OVERRUN)) == 0) {
+        return 0;
+    }
+
+    unsigned words = ((status[1] & 0x07) << 8) | status[0];
+    const unsigned pattern = ((status[3] & 0x03) << 8) | status[2];
+
+    // start on a gyroscope x word, the address wraps within FIFO_DATA_OUT
+    if (pattern != 0 && words >= WORDS_PER_SAMPLE - pattern) {
+        const unsigned skip = WORDS_PER_SAMPLE - pattern;
+        if (!readRegisters(LSM6DSL_FIFO_DATA_OUT_L, burst, skip * 2)) {
+            return 0;
+        }
+        droppedWordCount += skip;
+        words -= skip;
+    }
+
+    unsigned added = 0;
+    unsigned samples = words / WORDS_PER_SAMPLE;
+    while (samples > 0) {
+        const unsigned count = min(samples, (unsigned)MOTION_BURST_SAMPLES);
+        if (!readRegisters(LSM6DSL_FIFO_DATA_OUT_L, burst, count * BYTES_PER_SAMPLE)) {
+            break;
+        }
+
+        for (unsigned i = 0; i < count; i++) {
+            const uint8_t *data = burst + i * BYTES_PER_SAMPLE;
+            MOTION_SAMPLE *sample = &ring[writeCount % MOTION_RING_SIZE];
+            for (int axis = 0; axis < 3; axis++) {
+                sample->gyro[axis] = (int16_t)(data[axis * 2] | (data[axis * 2 + 1] << 8));
+                sample->accel[axis] = (int16_t)(data[6 + axis * 2] | (data[6 + axis * 2 + 1] << 8));
+            }
+            writeCount++;
+        }
+
+        added += count;
+        samples -= count;
+    }
+
+    return added;
+}
+
+int motionAddReader() {
+    for (int reader = 0; reader < MOTION_MAX_READERS; reader++) {
+        if (!readers[reader].used) {
+            readers[reader].used = true;
+            readers[reader].cursor = writeCount;
+            readers[reader].overrunCount = 0;
+            return reader;
+        }
+    }
+    return -1;
+}
+
+unsigned motionRead(int reader, MOTION_SAMPLE *samples, unsigned maxSamples) {
+    assert(reader >= 0 && reader < MOTION_MAX_READERS && readers[reader].used);
+    MOTION_READER *state = &readers[reader];
+
+    uint32_t available = writeCount - state->cursor;
+    if (available > MOTION_RING_SIZE) {
+        // overwritten before this reader got to them
+        state->overrunCount += available - MOTION_RING_SIZE;
+        state->cursor = writeCount - MOTION_RING_SIZE;
+        available = MOTION_RING_SIZE;
+    }
+
+    const unsigned count = min((unsigned)available, maxSamples);
+    for (unsigned i = 0; i < count; i++) {
+        samples[i] = ring[(state->cursor + i) % MOTION_RING_SIZE];
+    }
+    state->cursor += count;
+    return count;
+}
+
+void motionToUnits(const MOTION_SAMPLE *sample, int32_t *accel, int32_t *gyro) {
+    for (int axis = 0; axis < 3; axis++) {
+        accel[axis] = (int32_t)((int64_t)sample->accel[axis] * accelSensitivity / 1000);
+        gyro[axis] = (int32_t)((int64_t)sample->gyro[axis] * gyroSensitivity / 1000);
+    }
+}
+
+int32_t getMotionAccelSensitivity() {
+    return accelSensitivity;
+}
+
+uint32_t getMotionOdrMilliHz() {
+    return enabled ? odrMilliHz[rate] : 0;
+}
+
+unsigned long getMotionSampleCount() {
+    return writeCount;
+}
+
+unsigned long getMotionFifoOverrunCount() {
+    return fifoOverrunCount;
+}
+
+unsigned long getMotionDroppedWordCount() {
+    return droppedWordCount;
+}
+
+unsigned long getMotionReaderOverrunCount(int reader) {
+    assert(reader >= 0 && reader < MOTION_MAX_READERS);
+    return readers[reader].overrunCount;
+}
@@ -10,6 +10,9 @@
 #include "../inc/stats.h"
 #include "../inc/device.h"
 #include "../inc/oledAnimation.h"
+#include "../inc/animationFrames.h"
+#include "../inc/displayModel.h"
+#include "../inc/deadband.h"
 
 #include "../inc/fanSound.h"
 
@@ -27,7 +30,7 @@ int cloudMessage(const char *payload, size_t size, char **response, size_t* resp
     }
 
     // display the message on the screen
-    Screen.clean();
+    displayModelClear();
     Screen.print(0, "New message:");
     Screen.print(1, text, true);
     delay(2000);
@@ -83,28 +86,12 @@ int directMethod(const char *payload, size_t size, char **response, size_t* resp
 
 // this is the callback method for the fanSpeed desired property
 int fanSpeedDesiredChange(const char *message, size_t size, char **response, size_t* resp_size) {
-    char fan1[] = {
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', 'L', '.', '.', '.', '.', 'R', '.',
-        '.', '.', 'L', '.', '.', 'R', '.', '.',
-        '.', '.', '.', 'X', 'X', '.', '.', '.',
-        '.', '.', '.', 'X', 'X', '.', '.', '.',
-        '.', '.', 'R', '.', '.', 'L', '.', '.',
-        '.', 'R', '.', '.', '.', '.', 'L', '.'};
-    char fan2[] = {
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', 'V', 'v', '.', '.', '.',
-        '.', '.', '.', 'V', 'v', '.', '.', '.',
-        '.', 'H', 'H', 'X', 'X', 'H', 'H', '.',
-        '.', 'h', 'h', 'X', 'X', 'h', 'h', '.',
-        '.', '.', '.', 'V', 'v', '.', '.', '.',
-        '.', '.', '.', 'V', 'v', '.', '.', '.'};
-
-    char *fan[] = {fan1, fan2};
-
-    animationInit(fan, 2, 64, 0, 0, true);
+    static constexpr Sprite fan1 = compileSprite(fanArt[0]);
+    static constexpr Sprite fan2 = compileSprite(fanArt[1]);
+
+    const Sprite *fan[] = {&fan1, &fan2};
+
+    animationInit(fan, 2, 0, 0, true);
 
     Serial.println("fanSpeed desired property just got called");
 
@@ -113,7 +100,7 @@ int fanSpeedDesiredChange(const char *message, size_t size, char **response, siz
     Audio.startPlay(fanSoundData, FAN_SOUND_DATA_SIZE);
 
     // show the animation
-    Screen.clean();
+    displayModelClear();
     for(int i = 0; i < 100; i++) {
         renderNextFrame();
     }
@@ -127,62 +114,18 @@ int fanSpeedDesiredChange(const char *message, size_t size, char **response, siz
 int voltageDesiredChange(const char *message, size_t size, char **response, size_t* resp_size) {
     Serial.println("setVoltage desired property just got called");
 
-    char voltage0[] = {
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.'};
-
-    char voltage1[] = {
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G'};
-
-    char voltage2[] = {
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G'};
-
-    char voltage3[] = {
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G'};
-
-    char voltage4[] = {
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G',
-        'G', 'G', 'G', 'G', 'G', 'G', 'G', 'G'};
-
-    char *voltage[] = {voltage0, voltage1, voltage2, voltage3, voltage4, voltage3, voltage2, voltage1, voltage0};
-
-    animationInit(voltage, 9, 64, 0, 30, true);
+    static constexpr Sprite voltage0 = compileSprite(voltageArt[0]);
+    static constexpr Sprite voltage1 = compileSprite(voltageArt[1]);
+    static constexpr Sprite voltage2 = compileSprite(voltageArt[2]);
+    static constexpr Sprite voltage3 = compileSprite(voltageArt[3]);
+    static constexpr Sprite voltage4 = compileSprite(voltageArt[4]);
+
+    const Sprite *voltage[] = {&voltage0, &voltage1, &voltage2, &voltage3, &voltage4, &voltage3, &voltage2, &voltage1, &voltage0};
+
+    animationInit(voltage, 9, 0, 30, true);
 
     // show the animation
-    Screen.clean();
+    displayModelClear();
     for(int i = 0; i < 54; i++) {
         renderNextFrame();
     }
@@ -196,62 +139,18 @@ int voltageDesiredChange(const char *message, size_t size, char **response, size
 int currentDesiredChange(const char *message, size_t size, char **response, size_t* resp_size) {
     Serial.println("setCurrent desired property just got called");
 
-    char current0[] = {
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.',
-        '.', '.', '.', '.', '.', '.', '.', '.'};
-
-    char current1[] = {
-        'g', 'g', '.', '.', '.', '.', '.', '.',
-        'g', 'g', '.', '.', '.', '.', '.', '.',
-        'g', 'g', '.', '.', '.', '.', '.', '.',
-        'g', 'g', '.', '.', '.', '.', '.', '.',
-        'g', 'g', '.', '.', '.', '.', '.', '.',
-        'g', 'g', '.', '.', '.', '.', '.', '.',
-        'g', 'g', '.', '.', '.', '.', '.', '.',
-        'g', 'g', '.', '.', '.', '.', '.', '.'};
-
-    char current2[] = {
-        'g', 'g', 'g', 'g', '.', '.', '.', '.',
-        'g', 'g', 'g', 'g', '.', '.', '.', '.',
-        'g', 'g', 'g', 'g', '.', '.', '.', '.',
-        'g', 'g', 'g', 'g', '.', '.', '.', '.',
-        'g', 'g', 'g', 'g', '.', '.', '.', '.',
-        'g', 'g', 'g', 'g', '.', '.', '.', '.',
-        'g', 'g', 'g', 'g', '.', '.', '.', '.',
-        'g', 'g', 'g', 'g', '.', '.', '.', '.'};
-
-    char current3[] = {
-        'g', 'g', 'g', 'g', 'g', 'g', '.', '.',
-        'g', 'g', 'g', 'g', 'g', 'g', '.', '.',
-        'g', 'g', 'g', 'g', 'g', 'g', '.', '.',
-        'g', 'g', 'g', 'g', 'g', 'g', '.', '.',
-        'g', 'g', 'g', 'g', 'g', 'g', '.', '.',
-        'g', 'g', 'g', 'g', 'g', 'g', '.', '.',
-        'g', 'g', 'g', 'g', 'g', 'g', '.', '.',
-        'g', 'g', 'g', 'g', 'g', 'g', '.', '.'};
-
-    char current4[] = {
-        'g', 'g', 'g', 'g', 'g', 'g', 'g', 'g',
-        'g', 'g', 'g', 'g', 'g', 'g', 'g', 'g',
-        'g', 'g', 'g', 'g', 'g', 'g', 'g', 'g',
-        'g', 'g', 'g', 'g', 'g', 'g', 'g', 'g',
-        'g', 'g', 'g', 'g', 'g', 'g', 'g', 'g',
-        'g', 'g', 'g', 'g', 'g', 'g', 'g', 'g',
-        'g', 'g', 'g', 'g', 'g', 'g', 'g', 'g',
-        'g', 'g', 'g', 'g', 'g', 'g', 'g', 'g'};
-
-    char *current[] = {current0, current1, current2, current3, current4, current3, current2, current1, current0};
-
-    animationInit(current, 9, 64, 0, 30, false);
+    static constexpr Sprite current0 = compileSprite(currentArt[0]);
+    static constexpr Sprite current1 = compileSprite(currentArt[1]);
+    static constexpr Sprite current2 = compileSprite(currentArt[2]);
+    static constexpr Sprite current3 = compileSprite(currentArt[3]);
+    static constexpr Sprite current4 = compileSprite(currentArt[4]);
+
+    const Sprite *current[] = {&current0, &current1, &current2, &current3, &current4, &current3, &current2, &current1, &current0};
+
+    animationInit(current, 9, 0, 30, false);
 
     // show the animation
-    Screen.clean();
+    displayModelClear();
     for(int i = 0; i < 54; i++) {
         renderNextFrame();
     }
@@ -265,7 +164,7 @@ int currentDesiredChange(const char *message, size_t size, char **response, size
 int irOnDesiredChange(const char *message, size_t size, char **response, size_t* resp_size) {
     Serial.println("activateIR desired property just got called");
 
-    Screen.clean();
+    displayModelClear();
     Screen.print(0, "Firing IR beam");
 
     transmitIR();
@@ -274,4 +173,22 @@ int irOnDesiredChange(const char *message, size_t size, char **response, size_t*
 
     *response = (char*) Globals::completedString;
     return 200; /* status */
-}
\ No newline at end of file
+}
+
+// this is the callback method for the telemetryDeadband desired property
+int deadbandDesiredChange(const char *message, size_t size, char **response, size_t* resp_size) {
+    Serial.println("telemetryDeadband desired property just got called");
+
+    JSObject json(message);
+    JSObject config;
+    if (!json.getObjectByName("value", &config) || !deadbandConfigure(&config)) {
+        LOG_ERROR("telemetryDeadband doesn't have a valid 'value'");
+        *response = (char*) "failed";
+        return 400; /* status */
+    }
+
+    incrementDesiredCount();
+
+    *response = (char*) Globals::completedString;
+    return 200; /* status */
+}
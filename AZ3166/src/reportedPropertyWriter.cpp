@@ -0,0 +1,171 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/reportedPropertyWriter.h"
+#include "../inc/stats.h"
+
+// "name":value plus the separator
+static inline unsigned entrySize(const REPORTED_ENTRY *entry) {
+    return entry->nameLength + entry->valueLength + 4;
+}
+
+REPORTED_ENTRY * ReportedPropertyWriter::findEntry(const char *name, unsigned nameLength) {
+    for (unsigned i = 0; i < entryCount; i++) {
+        if (entries[i].nameLength == nameLength && memcmp(entries[i].name, name, nameLength) == 0) {
+            return &entries[i];
+        }
+    }
+
+    REPORTED_ENTRY *entry = NULL;
+    if (entryCount < REPORTED_MAX_KEYS) {
+        entry = &entries[entryCount++];
+    } else {
+        // a key that is sent and confirmed is only kept for coalescing, its slot can be reused
+        for (unsigned i = 0; i < entryCount && entry == NULL; i++) {
+            if (!entries[i].dirty && !entries[i].inFlight) {
+                entry = &entries[i];
+            }
+        }
+        if (entry == NULL) {
+            return NULL;
+        }
+    }
+
+    memset(entry, 0, sizeof(REPORTED_ENTRY));
+    memcpy(entry->name, name, nameLength);
+    entry->nameLength = nameLength;
+    return entry;
+}
+
+bool ReportedPropertyWriter::set(const char *name, unsigned nameLength, const char *json, unsigned jsonLength) {
+    if (nameLength == 0 || nameLength >= REPORTED_NAME_MAX_SIZE || jsonLength >= REPORTED_VALUE_MAX_SIZE) {
+        LOG_ERROR("Reported property is too large");
+        return false;
+    }
+
+    REPORTED_ENTRY *entry = findEntry(name, nameLength);
+    if (entry == NULL) {
+        LOG_ERROR("Too many reported properties");
+        return false;
+    }
+
+    if (entry->dirty) {
+        pendingBytes -= entrySize(entry);
+        incrementReportedCoalescedCount(); // the previous value is never sent
+    } else if (pendingBytes == 0) {
+        firstPendingTime = millis();
+    }
+
+    memcpy(entry->value, json, jsonLength);
+    entry->value[jsonLength] = char(0);
+    entry->valueLength = jsonLength;
+    entry->dirty = true;
+    pendingBytes += entrySize(entry);
+
+    return true;
+}
+
+bool ReportedPropertyWriter::isFlushDue(unsigned long now) {
+    if (awaitingConfirmation) {
+        if (now - sentTime < REPORTED_CONFIRM_TIMEOUT) {
+            return false;
+        }
+        Serial.println("Reported property patch wasn't confirmed in time");
+        patchConfirmed(patchId, -1, now);
+    }
+
+    if (pendingBytes == 0 || (retryCount > 0 && (long)(now - retryTime) < 0)) {
+        return false;
+    }
+
+    return flushRequested || retryCount > 0 || pendingBytes >= REPORTED_FLUSH_SIZE ||
+           now - firstPendingTime >= flushInterval;
+}
+
+unsigned ReportedPropertyWriter::buildPatch(char *buffer, unsigned bufferSize, unsigned long now) {
+    unsigned length = 0;
+    buffer[length++] = '{';
+
+    for (unsigned i = 0; i < entryCount; i++) {
+        REPORTED_ENTRY *entry = &entries[i];
+        // keys that don't fit stay pending for the next patch
+        if (!entry->dirty || length + entrySize(entry) + 1 >= bufferSize) {
+            continue;
+        }
+
+        if (length > 1) {
+            buffer[length++] = ',';
+        }
+        buffer[length++] = '"';
+        memcpy(buffer + length, entry->name, entry->nameLength);
+        length += entry->nameLength;
+        buffer[length++] = '"';
+        buffer[length++] = ':';
+        memcpy(buffer + length, entry->value, entry->valueLength);
+        length += entry->valueLength;
+
+        pendingBytes -= entrySize(entry);
+        entry->dirty = false;
+        entry->inFlight = true;
+    }
+
+    if (length == 1) {
+        return 0;
+    }
+
+    buffer[length++] = '}';
+    buffer[length] = char(0);
+
+    if (pendingBytes > 0) {
+        firstPendingTime = now;
+    }
+    flushRequested = false;
+    awaitingConfirmation = true;
+    sentTime = now;
+    patchId++;
+    incrementReportedPatchCount();
+
+    return length;
+}
+
+void ReportedPropertyWriter::patchConfirmed(int id, int statusCode, unsigned long now) {
+    if (!awaitingConfirmation || id != patchId) {
+        return; // confirmation of a patch that already timed out
+    }
+    awaitingConfirmation = false;
+
+    const bool success = statusCode >= 200 && statusCode < 300;
+    if (success) {
+        retryCount = 0;
+    } else if (retryCount < REPORTED_MAX_RETRIES) {
+        retryCount++;
+        retryTime = now + (REPORTED_RETRY_DELAY << (retryCount - 1));
+        incrementReportedRetryCount();
+        Serial.printf("Reported property patch failed (%d), retry %u\r\n", statusCode, retryCount);
+    } else {
+        retryCount = 0;
+        Serial.printf("Reported property patch failed (%d), giving up\r\n", statusCode);
+    }
+
+    for (unsigned i = 0; i < entryCount; i++) {
+        REPORTED_ENTRY *entry = &entries[i];
+        if (!entry->inFlight) {
+            continue;
+        }
+        entry->inFlight = false;
+
+        if (success) {
+            incrementReportedCount();
+        } else if (retryCount == 0) {
+            incrementErrorCount();
+        } else if (!entry->dirty) {
+            // resend the latest value, a newer one is already pending otherwise
+            if (pendingBytes == 0) {
+                firstPendingTime = now;
+            }
+            entry->dirty = true;
+            pendingBytes += entrySize(entry);
+        }
+    }
+}
@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/scheduler.h"
+
+static SCHEDULER_TASK tasks[SCHEDULER_MAX_TASKS];
+static int taskCount = 0;
+
+// min-heap of task ids ordered by nextDeadline
+static int heap[SCHEDULER_MAX_TASKS];
+static int heapPosition[SCHEDULER_MAX_TASKS];
+
+// millis() wraps after ~49 days, compare deadlines by their signed distance.
+// times are taken as 32 bit like millis() on the board, also where long is wider
+static inline bool isBefore(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static inline bool isDue(uint32_t deadline, unsigned long now) {
+    return (int32_t)((uint32_t)now - deadline) >= 0;
+}
+
+static void swapNodes(int i, int j) {
+    int task = heap[i];
+    heap[i] = heap[j];
+    heap[j] = task;
+    heapPosition[heap[i]] = i;
+    heapPosition[heap[j]] = j;
+}
+
+static void siftUp(int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!isBefore(tasks[heap[i]].nextDeadline, tasks[heap[parent]].nextDeadline)) break;
+        swapNodes(i, parent);
+        i = parent;
+    }
+}
+
+static void siftDown(int i) {
+    for (;;) {
+        int left = 2 * i + 1, right = left + 1, smallest = i;
+        if (left < taskCount && isBefore(tasks[heap[left]].nextDeadline, tasks[heap[smallest]].nextDeadline)) {
+            smallest = left;
+        }
+        if (right < taskCount && isBefore(tasks[heap[right]].nextDeadline, tasks[heap[smallest]].nextDeadline)) {
+            smallest = right;
+        }
+        if (smallest == i) break;
+        swapNodes(i, smallest);
+        i = smallest;
+    }
+}
+
+void schedulerInit() {
+    taskCount = 0;
+    memset(tasks, 0, sizeof(tasks));
+}
+
+int schedulerAddTask(const char *name, unsigned long period, schedulerCallback callback,
+                     unsigned long now) {
+    if (taskCount >= SCHEDULER_MAX_TASKS || callback == NULL || period == 0) {
+        LOG_ERROR("Unable to add the scheduler task");
+        return -1;
+    }
+
+    const int taskId = taskCount++;
+    SCHEDULER_TASK *task = &tasks[taskId];
+    memset(task, 0, sizeof(SCHEDULER_TASK));
+    task->name = name;
+    task->callback = callback;
+    task->period = period;
+    task->nextDeadline = now + period;
+
+    heap[taskId] = taskId;
+    heapPosition[taskId] = taskId;
+    siftUp(taskId);
+
+    return taskId;
+}
+
+void schedulerRunIn(int taskId, unsigned long delay, unsigned long now) {
+    assert(taskId >= 0 && taskId < taskCount);
+    tasks[taskId].nextDeadline = now + delay;
+    siftUp(heapPosition[taskId]);
+    siftDown(heapPosition[taskId]);
+}
+
+void schedulerSetPeriod(int taskId, unsigned long period) {
+    assert(taskId >= 0 && taskId < taskCount && period != 0);
+    tasks[taskId].period = period;
+}
+
+void schedulerRun(unsigned long now) {
+    while (taskCount > 0 && isDue(tasks[heap[0]].nextDeadline, now)) {
+        const int taskId = heap[0];
+        SCHEDULER_TASK *task = &tasks[taskId];
+        const uint32_t deadline = task->nextDeadline;
+
+        const unsigned long lateness = (uint32_t)now - deadline;
+        if (lateness > task->maxLateness) {
+            task->maxLateness = lateness;
+        }
+
+        // absolute deadlines keep the period free of drift, whole periods
+        // that already passed are skipped instead of run back to back
+        const unsigned long missed = lateness / task->period;
+        task->skippedCount += missed;
+        task->nextDeadline = deadline + (missed + 1) * task->period;
+        siftDown(0);
+
+        const unsigned long start = micros();
+        task->callback();
+        const unsigned long runTime = micros() - start;
+
+        task->runCount++;
+        task->totalRunTime += runTime;
+        if (runTime > task->maxRunTime) {
+            task->maxRunTime = runTime;
+        }
+    }
+}
+
+const SCHEDULER_TASK * schedulerGetTask(int taskId) {
+    if (taskId < 0 || taskId >= taskCount) return NULL;
+    return &tasks[taskId];
+}
+
+int schedulerGetTaskCount() {
+    return taskCount;
+}
+
+void schedulerPrintStats() {
+    Serial.println("task: runs, avg us, max us, max late ms, skipped");
+    for (int i = 0; i < taskCount; i++) {
+        const SCHEDULER_TASK *task = &tasks[i];
+        Serial.printf("%s: %lu, %lu, %lu, %lu, %lu\r\n", task->name, task->runCount,
+            task->runCount ? task->totalRunTime / task->runCount : 0,
+            task->maxRunTime, task->maxLateness, task->skippedCount);
+    }
+}
@@ -0,0 +1,251 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/sensorTrace.h"
+#include "../inc/sensors.h"
+
+static unsigned long traceStart = 0;
+
+static void printHex(const void *data, unsigned size) {
+    static const char digits[] = "0123456789abcdef";
+    char line[sizeof(SENSOR_TRACE_PREFIX) + 2 * sizeof(SENSOR_TRACE_RECORD)];
+    assert(size <= sizeof(SENSOR_TRACE_RECORD));
+
+    strcpy(line, SENSOR_TRACE_PREFIX);
+    char *position = line + sizeof(SENSOR_TRACE_PREFIX) - 1;
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (unsigned i = 0; i < size; i++) {
+        *position++ = digits[bytes[i] >> 4];
+        *position++ = digits[bytes[i] & 0x0F];
+    }
+    *position = 0;
+    Serial.println(line);
+}
+
+void sensorTraceStart(unsigned long now) {
+    traceStart = now;
+
+    SENSOR_TRACE_HEADER header;
+    header.magic = SENSOR_TRACE_MAGIC;
+    header.version = SENSOR_TRACE_VERSION;
+    header.recordSize = sizeof(SENSOR_TRACE_RECORD);
+    printHex(&header, sizeof(header));
+}
+
+void sensorTraceCapture(unsigned long now) {
+    SENSOR_TRACE_RECORD record;
+    int axes[3];
+    int gyroAxes[3];
+
+    record.time = now - traceStart;
+    record.humidity = readHumidity();
+    record.temperature = readTemperature();
+    record.pressure = readPressure();
+
+    readMagnetometer(axes);
+    for (int axis = 0; axis < 3; axis++) {
+        record.magnetometer[axis] = axes[axis];
+    }
+
+    readMotion(axes, gyroAxes);
+    for (int axis = 0; axis < 3; axis++) {
+        record.accelerometer[axis] = axes[axis];
+        record.gyroscope[axis] = gyroAxes[axis];
+    }
+
+    printHex(&record, sizeof(record));
+}
+
+#ifdef SENSOR_TRACE_REPLAY
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static SENSOR_TRACE_RECORD *records = NULL;
+static unsigned recordCount = 0;
+static unsigned cursor = 0;
+static unsigned replaySpeed = 0;
+static unsigned long replayStart = 0;
+static uint32_t seekTime = 0;
+
+bool sensorReplayOpen(const char *path, unsigned speed) {
+    sensorReplayClose();
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        LOG_ERROR("Opening the sensor trace failed");
+        return false;
+    }
+
+    SENSOR_TRACE_HEADER header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != SENSOR_TRACE_MAGIC ||
+        header.version != SENSOR_TRACE_VERSION || header.recordSize != sizeof(SENSOR_TRACE_RECORD)) {
+        LOG_ERROR("Not a sensor trace of this version");
+        fclose(file);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file) - (long)sizeof(header);
+    fseek(file, sizeof(header), SEEK_SET);
+
+    recordCount = size > 0 ? size / sizeof(SENSOR_TRACE_RECORD) : 0;
+    records = recordCount > 0 ? (SENSOR_TRACE_RECORD *)malloc(recordCount * sizeof(SENSOR_TRACE_RECORD)) : NULL;
+    if (records == NULL || fread(records, sizeof(SENSOR_TRACE_RECORD), recordCount, file) != recordCount) {
+        LOG_ERROR("Reading the sensor trace records failed");
+        fclose(file);
+        sensorReplayClose();
+        return false;
+    }
+    fclose(file);
+
+    cursor = 0;
+    replaySpeed = speed;
+    replayStart = millis();
+    seekTime = 0;
+    return true;
+}
+
+void sensorReplayClose() {
+    free(records);
+    records = NULL;
+    recordCount = 0;
+}
+
+void sensorReplaySeek(uint32_t time) {
+    seekTime = time;
+}
+
+const SENSOR_TRACE_RECORD *sensorReplayCurrent() {
+    if (records == NULL) {
+        return NULL;
+    }
+
+    uint32_t time = replaySpeed > 0 ? (uint32_t)((millis() - replayStart) * replaySpeed) : seekTime;
+    time %= records[recordCount - 1].time + 1;
+
+    if (time < records[cursor].time) {
+        cursor = 0;
+    }
+    while (cursor + 1 < recordCount && records[cursor + 1].time <= time) {
+        cursor++;
+    }
+    return &records[cursor];
+}
+
+unsigned getSensorReplayRecordCount() {
+    return recordCount;
+}
+
+// sensors.h from the trace
+
+void initSensors() {
+    sensorReplayOpen(SENSOR_TRACE_PATH, SENSOR_TRACE_SPEED);
+}
+
+int32_t readHumidity() {
+    const SENSOR_TRACE_RECORD *record = sensorReplayCurrent();
+    return record != NULL ? record->humidity : SENSOR_READ_ERROR(HUMIDITY_DECIMALS);
+}
+
+int32_t readTemperature() {
+    const SENSOR_TRACE_RECORD *record = sensorReplayCurrent();
+    return record != NULL ? record->temperature : SENSOR_READ_ERROR(TEMPERATURE_DECIMALS);
+}
+
+int32_t readPressure() {
+    const SENSOR_TRACE_RECORD *record = sensorReplayCurrent();
+    return record != NULL ? record->pressure : SENSOR_READ_ERROR(PRESSURE_DECIMALS);
+}
+
+static void copyAxes(const int32_t *values, int *axes) {
+    for (int axis = 0; axis < 3; axis++) {
+        axes[axis] = values != NULL ? values[axis] : 0xFFFF;
+    }
+}
+
+void readMagnetometer(int *axes) {
+    const SENSOR_TRACE_RECORD *record = sensorReplayCurrent();
+    copyAxes(record != NULL ? record->magnetometer : NULL, axes);
+}
+
+void readMotion(int *accel, int *gyro) {
+    const SENSOR_TRACE_RECORD *record = sensorReplayCurrent();
+    if (accel != NULL) {
+        copyAxes(record != NULL ? record->accelerometer : NULL, accel);
+    }
+    if (gyro != NULL) {
+        copyAxes(record != NULL ? record->gyroscope : NULL, gyro);
+    }
+}
+
+void readAccelerometer(int *axes) {
+    readMotion(axes, NULL);
+}
+
+void readGyroscope(int *axes) {
+    readMotion(NULL, axes);
+}
+
+bool checkForShake() {
+    return false;
+}
+
+void discardShakes() {
+}
+
+unsigned long getShakeInterruptCount() {
+    return 0;
+}
+
+unsigned long getShakeWakeUpCount() {
+    return 0;
+}
+
+unsigned long getShakeCount() {
+    return 0;
+}
+
+// a trace holds single readings, the motion sensors are sampled without the FIFO
+bool enableMotionFifo(MotionOdr odr, unsigned watermark) {
+    return false;
+}
+
+bool isMotionFifoEnabled() {
+    return false;
+}
+
+int motionAddReader() {
+    return -1;
+}
+
+unsigned motionRead(int reader, MOTION_SAMPLE *samples, unsigned maxSamples) {
+    return 0;
+}
+
+void motionToUnits(const MOTION_SAMPLE *sample, int32_t *accel, int32_t *gyro) {
+}
+
+int32_t getMotionAccelSensitivity() {
+    return 0;
+}
+
+uint32_t getMotionOdrMilliHz() {
+    return 0;
+}
+
+unsigned long getMotionReaderOverrunCount(int reader) {
+    return 0;
+}
+
+void setLedColor(uint8_t red, uint8_t green, uint8_t blue) {
+}
+
+void turnLedOff() {
+}
+
+void transmitIR() {
+}
+
+#endif // SENSOR_TRACE_REPLAY
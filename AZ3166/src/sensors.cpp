@@ -6,40 +6,108 @@
 
 #include "LSM6DSLSensor.h"
 #include "LIS2MDLSensor.h"
-#include "HTS221Sensor.h"
 #include "LPS22HBSensor.h"
 #include "RGB_LED.h"
 #include "IrDASensor.h"
 
 #include "../inc/sensors.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/hts221.h"
+#include "../inc/i2cBus.h"
+#include "../inc/shakeDetector.h"
+
+// The wake up event fires when the slope, half the change of the acceleration
+// between two samples, stays above WAKE_THS for longer than WAKE_DUR samples. Both
+// count in samples of the ODR the accelerometer runs at, which the motion FIFO
+// changes, so they are set from a rate of change and a time instead.
+#define SHAKE_JERK 40000 // mg/s, about a 1.5 g shake at 4 Hz
+#define SHAKE_WAKE_UP_DURATION 8 // ms above the threshold
+#define LSM6DSL_CTRL1_XL 0x10
+#define LSM6DSL_WAKE_UP_DUR 0x5C
+#define WAKE_UP_THS_MAX 0x3F
+#define WAKE_DUR_MAX 3
+#define WAKE_DUR_SHIFT 5
+
+// gyroscope then accelerometer outputs, adjacent so both are one burst
+#define LSM6DSL_OUTX_L_G 0x22
+#define LSM6DSL_OUTX_L_XL 0x28
 
 DevI2C *i2c;
 LSM6DSLSensor *accelGyro;
 LIS2MDLSensor *magnetometer;
-HTS221Sensor *tempHumidity;
 LPS22HBSensor *pressure;
 RGB_LED rgbLed;
 IRDASensor *irdaSensor;
 
+static float accelSensitivity = 0; // mg per LSB
+static float gyroSensitivity = 0;  // mdps per LSB
+
+static SHAKE_DETECTOR shakeDetector;
+
+static void shakeInterrupt() {
+    shakeDetectorWakeUp(&shakeDetector, millis());
+}
+
+// CTRL1_XL ODR_XL codes 1 .. 10 are 12.5 Hz doubling up to 6.66 kHz, in mHz
+static uint32_t accelOdrMilliHz(uint8_t ctrl1) {
+    const unsigned code = ctrl1 >> 4;
+    return code == 0 || code > 10 ? 0 : 12500u << (code - 1);
+}
+
+// CTRL1_XL FS_XL codes are 2, 16, 4 and 8 g, the wake up threshold is 1/64 of it
+static uint32_t accelFullScaleMg(uint8_t ctrl1) {
+    static const uint32_t fullScale[] = { 2000, 16000, 4000, 8000 };
+    return fullScale[(ctrl1 >> 2) & 0x03];
+}
+
+// sets the wake up threshold and duration for the accelerometer ODR in use,
+// again whenever something changes the ODR
+static bool configureShakeDetection() {
+    uint8_t ctrl1, wakeUpDur;
+    if (!i2cRead(I2C_DEVICE_LSM6DSL, LSM6DSL_CTRL1_XL, &ctrl1, 1) ||
+        !i2cRead(I2C_DEVICE_LSM6DSL, LSM6DSL_WAKE_UP_DUR, &wakeUpDur, 1)) {
+        return false;
+    }
+    const uint32_t odr = accelOdrMilliHz(ctrl1);
+    if (odr == 0) {
+        return false;
+    }
+
+    // slope per sample in threshold LSB, rounded
+    const uint64_t slope = (uint64_t)SHAKE_JERK * 1000 / 2 * 64 / odr;
+    const uint32_t threshold = (uint32_t)((slope + accelFullScaleMg(ctrl1) / 2) / accelFullScaleMg(ctrl1));
+    const uint32_t samples = (uint32_t)((uint64_t)SHAKE_WAKE_UP_DURATION * odr / 1000000);
+    const uint8_t duration = min(samples, (uint32_t)WAKE_DUR_MAX);
+
+    wakeUpDur = (wakeUpDur & ~(WAKE_DUR_MAX << WAKE_DUR_SHIFT)) | (duration << WAKE_DUR_SHIFT);
+    return accelGyro->setWakeUpThreshold(max(min(threshold, (uint32_t)WAKE_UP_THS_MAX), (uint32_t)1)) == 0 &&
+           i2cWrite(I2C_DEVICE_LSM6DSL, LSM6DSL_WAKE_UP_DUR, wakeUpDur);
+}
+
 void initSensors() {
     // LSM6DSL
     i2c = new DevI2C(D14, D15);
+    i2cBusInit(i2c);
     accelGyro = new LSM6DSLSensor(*i2c, D4, D5);
     accelGyro->init(NULL);
     accelGyro->enableAccelerator();
     accelGyro->enableGyroscope();
+    accelGyro->getXSensitivity(&accelSensitivity);
+    accelGyro->getGSensitivity(&gyroSensitivity);
 
-    // enable double tap detection
-    accelGyro->enablePedometer();
-    accelGyro->setPedometerThreshold(LSM6DSL_PEDOMETER_THRESHOLD_MID_LOW);
+    // shakes raise INT1, there is no bus traffic until one happens
+    if (accelGyro->enableWakeUpDetection(LSM6DSL_INT1_PIN) != 0 || !configureShakeDetection()) {
+        LOG_ERROR("Enabling the LSM6DSL wake up interrupt failed");
+    }
+    accelGyro->attachInt1Irq(shakeInterrupt);
+    accelGyro->enableInt1Irq();
 
     // LIS2MDL
     magnetometer = new LIS2MDLSensor(*i2c);
     magnetometer->init(NULL);
 
     // HTS221
-    tempHumidity = new HTS221Sensor(*i2c);
-    tempHumidity->init(NULL);
+    hts221Init();
 
     // LPS22HB
     pressure = new LPS22HBSensor(*i2c);
@@ -51,37 +119,41 @@ void initSensors() {
     irdaSensor->init();
 }
 
-// HTS221
-float readHumidity() {
-    float humidityValue;
-    tempHumidity->reset();
-    if (tempHumidity->getHumidity(&humidityValue) == 0)
-        return humidityValue;
+// HTS221, both values come from the same cached conversion
+int32_t readHumidity() {
+    const HTS221_READING *reading = hts221Read(millis());
+    if (reading->valid)
+        return reading->humidity;
     else
-        return 0xFFFF;
+        return SENSOR_READ_ERROR(HUMIDITY_DECIMALS);
 }
 
-float readTemperature() {
-    float tempValue;
-    tempHumidity->reset();
-    if (tempHumidity->getTemperature(&tempValue) == 0)
-        return tempValue;
+int32_t readTemperature() {
+    const HTS221_READING *reading = hts221Read(millis());
+    if (reading->valid)
+        return reading->temperature;
     else
-        return 0xFFFF;
+        return SENSOR_READ_ERROR(TEMPERATURE_DECIMALS);
 }
 
-// LPS22HB
-float readPressure() {
+// LPS22HB, the driver reads the pressure outputs in one burst
+int32_t readPressure() {
     float presureValue;
-    if (pressure->getPressure(&presureValue) == 0)
-        return presureValue;
+    const unsigned long start = micros();
+    const bool ok = pressure->getPressure(&presureValue) == 0;
+    i2cAccount(I2C_DEVICE_LPS22HB, start, 1, 3, ok);
+    if (ok)
+        return toFixed(presureValue, PRESSURE_DECIMALS);
     else
-        return 0xFFFF;
+        return SENSOR_READ_ERROR(PRESSURE_DECIMALS);
 }
 
-// LIS2MDL
+// LIS2MDL, the driver reads the three axes in one burst
 void readMagnetometer(int *axes) {
-    if (magnetometer->getMAxes(axes) != 0) {
+    const unsigned long start = micros();
+    const bool ok = magnetometer->getMAxes(axes) == 0;
+    i2cAccount(I2C_DEVICE_LIS2MDL, start, 1, 6, ok);
+    if (!ok) {
         axes[0] = 0xFFFF;
         axes[1] = 0xFFFF;
         axes[2] = 0xFFFF;
@@ -89,32 +161,76 @@ void readMagnetometer(int *axes) {
 }
 
 // LSM6DSL
-void readAccelerometer(int *axes) {
-    if (accelGyro->getXAxes(axes) != 0) {
-        axes[0] = 0xFFFF;
-        axes[1] = 0xFFFF;
-        axes[2] = 0xFFFF;
+static void readDone(bool ok, void *context) {
+    *(bool *)context = ok;
+}
+
+static void toAxes(const uint8_t *data, bool ok, float sensitivity, int *axes) {
+    for (int axis = 0; axis < 3; axis++) {
+        const int16_t raw = (int16_t)(data[2 * axis] | (data[2 * axis + 1] << 8));
+        axes[axis] = ok ? (int)(raw * sensitivity) : 0xFFFF;
+    }
+}
+
+void readMotion(int *accel, int *gyro) {
+    uint8_t gyroData[6];
+    uint8_t accelData[6];
+    bool gyroOk = false;
+    bool accelOk = false;
+
+    if (gyro != NULL) {
+        i2cQueueRead(I2C_DEVICE_LSM6DSL, LSM6DSL_OUTX_L_G, gyroData, sizeof(gyroData), readDone, &gyroOk);
+    }
+    if (accel != NULL) {
+        i2cQueueRead(I2C_DEVICE_LSM6DSL, LSM6DSL_OUTX_L_XL, accelData, sizeof(accelData), readDone, &accelOk);
+    }
+    i2cBusFlush();
+
+    if (gyro != NULL) {
+        toAxes(gyroData, gyroOk, gyroSensitivity, gyro);
     }
+    if (accel != NULL) {
+        toAxes(accelData, accelOk, accelSensitivity, accel);
+    }
+}
+
+void readAccelerometer(int *axes) {
+    readMotion(axes, NULL);
 }
 
 void readGyroscope(int *axes) {
-    if (accelGyro->getGAxes(axes) != 0) {
-        axes[0] = 0xFFFF;
-        axes[1] = 0xFFFF;
-        axes[2] = 0xFFFF;
+    readMotion(NULL, axes);
+}
+
+bool enableMotionFifo(MotionOdr odr, unsigned watermark) {
+    if (!motionFifoInit(accelGyro, odr, watermark)) {
+        return false;
     }
+    // the FIFO set a new ODR, the wake up settings count in its samples
+    if (!configureShakeDetection()) {
+        LOG_ERROR("Setting the LSM6DSL wake up threshold for the FIFO rate failed");
+    }
+    return true;
 }
 
 bool checkForShake() {
-    int steps = 0;
-    bool shake = false;
-    accelGyro->getStepCounter(&steps);
-    if (steps > 1) {
-        shake = true;
-    }
-    accelGyro->resetStepCounter();
+    return shakeDetectorCheck(&shakeDetector, millis());
+}
+
+void discardShakes() {
+    shakeDetectorDiscard(&shakeDetector);
+}
+
+unsigned long getShakeInterruptCount() {
+    return shakeDetector.interruptCount;
+}
+
+unsigned long getShakeWakeUpCount() {
+    return shakeDetector.wakeUpCount;
+}
 
-    return shake;
+unsigned long getShakeCount() {
+    return shakeDetector.shakeCount;
 }
 
 // RGB LED
@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/shakeDetector.h"
+
+void shakeDetectorWakeUp(SHAKE_DETECTOR *detector, unsigned long now) {
+    detector->interruptCount++;
+    if (detector->wakeUpCount > 0 && now - detector->lastWakeUpTime < SHAKE_MIN_SPACING) {
+        return;
+    }
+    detector->lastWakeUpTime = now;
+    detector->wakeUpCount++;
+}
+
+bool shakeDetectorCheck(SHAKE_DETECTOR *detector, unsigned long now) {
+    const unsigned long wakeUps = detector->wakeUpCount;
+    if (wakeUps == detector->handledCount) {
+        return false;
+    }
+    const unsigned long previous = detector->handledCount;
+    detector->handledCount = wakeUps;
+
+    if (now - detector->windowStart > SHAKE_WINDOW) {
+        detector->windowStart = now;
+        detector->windowCount = previous;
+    }
+    if (wakeUps - detector->windowCount < 2) {
+        return false;
+    }
+
+    detector->windowCount = wakeUps;
+    detector->shakeCount++;
+    return true;
+}
+
+void shakeDetectorDiscard(SHAKE_DETECTOR *detector) {
+    const unsigned long wakeUps = detector->wakeUpCount;
+    detector->handledCount = wakeUps;
+    detector->windowCount = wakeUps;
+}
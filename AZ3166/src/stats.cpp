@@ -7,12 +7,59 @@ static int telemetryCount;
 static int reportedCount;
 static int desiredCount;
 static int errorCount;
+static int batchCount;
+static int batchedSampleCount;
+static unsigned long clearedTime;
+static unsigned long twinLatencyCount;
+static unsigned long twinLatencyTotal;
+static unsigned long twinLatencyMax;
+static unsigned long twinDeliveryCount;
+static unsigned long twinDeliveryTotal;
+static unsigned long twinDeliveryMax;
+static int backpressureCount;
+static int poolExhaustedCount;
+static int reportedCoalescedCount;
+static int reportedPatchCount;
+static int reportedRetryCount;
+static int offlineStoredCount;
+static int offlineReplayedCount;
+static int offlineDroppedCount;
+static unsigned long encodedCount;
+static unsigned long encodedSizeTotal;
+static unsigned long encodeTimeTotal;
+
+// send to confirmation latency buckets (ms), the last one is open ended
+#define CONFIRM_LATENCY_BUCKETS 8
+static const unsigned long confirmLatencyBounds[CONFIRM_LATENCY_BUCKETS - 1] =
+    { 100, 250, 500, 1000, 2500, 5000, 10000 };
+static unsigned long confirmLatencyHistogram[CONFIRM_LATENCY_BUCKETS];
 
 void clearCounters() {
     telemetryCount = 0;
     reportedCount = 0;
     desiredCount = 0;
     errorCount = 0;
+    batchCount = 0;
+    batchedSampleCount = 0;
+    clearedTime = millis();
+    twinLatencyCount = 0;
+    twinLatencyTotal = 0;
+    twinLatencyMax = 0;
+    twinDeliveryCount = 0;
+    twinDeliveryTotal = 0;
+    twinDeliveryMax = 0;
+    backpressureCount = 0;
+    poolExhaustedCount = 0;
+    reportedCoalescedCount = 0;
+    reportedPatchCount = 0;
+    reportedRetryCount = 0;
+    offlineStoredCount = 0;
+    offlineReplayedCount = 0;
+    offlineDroppedCount = 0;
+    encodedCount = 0;
+    encodedSizeTotal = 0;
+    encodeTimeTotal = 0;
+    memset(confirmLatencyHistogram, 0, sizeof(confirmLatencyHistogram));
 }
 
 void incrementReportedCount() {
@@ -39,6 +86,80 @@ void incrementDesiredCount() {
     desiredCount++;
 }
 
+void incrementBatchCount(int sampleCount) {
+    batchCount++;
+    batchedSampleCount += sampleCount;
+}
+
+// time (ms) a twin update could have waited before the client read it
+void recordTwinLatency(unsigned long latency) {
+    twinLatencyCount++;
+    twinLatencyTotal += latency;
+    if (latency > twinLatencyMax) {
+        twinLatencyMax = latency;
+    }
+}
+
+// time (ms) from the hub storing a desired update to the client reading it,
+// on the synced clock. an update seemingly from the future is the clock error
+void recordTwinDeliveryLatency(long latency) {
+    const unsigned long delivered = latency > 0 ? (unsigned long)latency : 0;
+    twinDeliveryCount++;
+    twinDeliveryTotal += delivered;
+    if (delivered > twinDeliveryMax) {
+        twinDeliveryMax = delivered;
+    }
+}
+
+void recordConfirmLatency(unsigned long latency) {
+    int bucket = 0;
+    while (bucket < CONFIRM_LATENCY_BUCKETS - 1 && latency >= confirmLatencyBounds[bucket]) {
+        bucket++;
+    }
+    confirmLatencyHistogram[bucket]++;
+}
+
+void incrementBackpressureCount() {
+    backpressureCount++;
+}
+
+void incrementPoolExhaustedCount() {
+    poolExhaustedCount++;
+}
+
+// reported property values replaced before they were sent
+void incrementReportedCoalescedCount() {
+    reportedCoalescedCount++;
+}
+
+void incrementReportedPatchCount() {
+    reportedPatchCount++;
+}
+
+void incrementReportedRetryCount() {
+    reportedRetryCount++;
+}
+
+// telemetry written to the offline queue and later confirmed by the hub
+void incrementOfflineStoredCount() {
+    offlineStoredCount++;
+}
+
+void incrementOfflineReplayedCount() {
+    offlineReplayedCount++;
+}
+
+void incrementOfflineDroppedCount() {
+    offlineDroppedCount++;
+}
+
+// size (bytes) and time (us) it took to build a telemetry payload
+void recordTelemetryEncoding(unsigned payloadSize, unsigned long encodeTime) {
+    encodedCount++;
+    encodedSizeTotal += payloadSize;
+    encodeTimeTotal += encodeTime;
+}
+
 int getReportedCount(){
     return reportedCount;
 }
@@ -53,4 +174,91 @@ int getTelemetryCount() {
 
 int getDesiredCount() {
     return desiredCount;
+}
+
+int getBatchCount() {
+    return batchCount;
+}
+
+int getBatchedSampleCount() {
+    return batchedSampleCount;
+}
+
+// messages that batching avoided sending, scaled to one hour of uptime
+int getMessagesSavedPerHour() {
+    unsigned long elapsed = millis() - clearedTime;
+    if (elapsed == 0) {
+        return 0;
+    }
+
+    return (int)((uint64_t)(batchedSampleCount - batchCount) * 3600000 / elapsed);
+}
+
+unsigned long getTwinLatencyAverage() {
+    return twinLatencyCount == 0 ? 0 : twinLatencyTotal / twinLatencyCount;
+}
+
+unsigned long getTwinLatencyMax() {
+    return twinLatencyMax;
+}
+
+unsigned long getTwinDeliveryLatencyAverage() {
+    return twinDeliveryCount == 0 ? 0 : twinDeliveryTotal / twinDeliveryCount;
+}
+
+unsigned long getTwinDeliveryLatencyMax() {
+    return twinDeliveryMax;
+}
+
+unsigned long getTwinDeliveryCount() {
+    return twinDeliveryCount;
+}
+
+int getBackpressureCount() {
+    return backpressureCount;
+}
+
+int getPoolExhaustedCount() {
+    return poolExhaustedCount;
+}
+
+int getReportedCoalescedCount() {
+    return reportedCoalescedCount;
+}
+
+int getReportedPatchCount() {
+    return reportedPatchCount;
+}
+
+int getReportedRetryCount() {
+    return reportedRetryCount;
+}
+
+int getOfflineStoredCount() {
+    return offlineStoredCount;
+}
+
+int getOfflineReplayedCount() {
+    return offlineReplayedCount;
+}
+
+int getOfflineDroppedCount() {
+    return offlineDroppedCount;
+}
+
+unsigned getTelemetrySizeAverage() {
+    return encodedCount == 0 ? 0 : encodedSizeTotal / encodedCount;
+}
+
+unsigned long getTelemetryEncodeTimeAverage() {
+    return encodedCount == 0 ? 0 : encodeTimeTotal / encodedCount;
+}
+
+void printConfirmLatencyHistogram() {
+    Serial.print("confirm latency ms:");
+    for (int i = 0; i < CONFIRM_LATENCY_BUCKETS - 1; i++) {
+        Serial.printf(" <%lu:%lu", confirmLatencyBounds[i], confirmLatencyHistogram[i]);
+    }
+    Serial.printf(" >=%lu:%lu\r\n", confirmLatencyBounds[CONFIRM_LATENCY_BUCKETS - 2],
+        confirmLatencyHistogram[CONFIRM_LATENCY_BUCKETS - 1]);
 }
\ No newline at end of file
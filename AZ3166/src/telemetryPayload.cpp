@@ -0,0 +1,147 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/telemetryPayload.h"
+#include "../inc/telemetrySampler.h"
+#include "../inc/jsonWriter.h"
+#include "../inc/cborWriter.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/deadband.h"
+#include "../inc/vibration.h"
+#include "../inc/stats.h"
+
+static void appendFieldValue(JsonWriter &writer, int field, FieldKey key, int32_t value) {
+    const TELEMETRY_FIELD_INFO &info = telemetryFields[field];
+    writer.appendFixed(info.keys[key], info.keyLengths[key], value,
+                       getFieldDecimals(field, key), getFieldPrecision(field, key));
+}
+
+static void appendField(JsonWriter &writer, int field, const FIELD_AGGREGATE &values, bool aggregate) {
+    appendFieldValue(writer, field, FIELD_LAST, values.last);
+    if (aggregate) {
+        appendFieldValue(writer, field, FIELD_MIN, values.min);
+        appendFieldValue(writer, field, FIELD_MAX, values.max);
+        appendFieldValue(writer, field, FIELD_MEAN, values.mean);
+    }
+}
+
+static void appendCborValue(CborWriter &writer, int field, FieldKey key, int32_t value) {
+    const unsigned decimals = getFieldDecimals(field, key);
+    const unsigned precision = getFieldPrecision(field, key);
+    if (precision == 0) {
+        writer.appendIntValue(rescaleFixed(value, decimals, 0));
+    } else {
+        writer.appendFloatValue(fixedToFloat(rescaleFixed(value, decimals, precision), precision));
+    }
+}
+
+// the field name once, aggregates as [last, min, max, mean] instead of the
+// four suffixed JSON keys
+static void appendField(CborWriter &writer, int field, const FIELD_AGGREGATE &values, bool aggregate) {
+    writer.appendKey(telemetryFields[field].name, strlen(telemetryFields[field].name));
+    if (aggregate) {
+        writer.beginArray(FIELD_KEY_COUNT);
+        appendCborValue(writer, field, FIELD_LAST, values.last);
+        appendCborValue(writer, field, FIELD_MIN, values.min);
+        appendCborValue(writer, field, FIELD_MAX, values.max);
+        appendCborValue(writer, field, FIELD_MEAN, values.mean);
+    } else {
+        appendCborValue(writer, field, FIELD_LAST, values.last);
+    }
+}
+
+static const char *vibrationBandKeys[VIBRATION_BAND_COUNT] = {
+    JSON_KEY("vibrationBand0"), JSON_KEY("vibrationBand1"),
+    JSON_KEY("vibrationBand2"), JSON_KEY("vibrationBand3")
+};
+
+static void appendVibration(JsonWriter &writer, const VIBRATION_SUMMARY &vibration) {
+    writer.appendFixed(JSON_KEY("vibrationRms"), sizeof(JSON_KEY("vibrationRms")) - 1,
+                       vibration.rms, VIBRATION_DECIMALS, VIBRATION_DECIMALS);
+    writer.appendFixed(JSON_KEY("vibrationPeak"), sizeof(JSON_KEY("vibrationPeak")) - 1,
+                       vibration.peakFrequency, VIBRATION_DECIMALS, VIBRATION_DECIMALS);
+    for (int band = 0; band < VIBRATION_BAND_COUNT; band++) {
+        writer.appendFixed(vibrationBandKeys[band], strlen(vibrationBandKeys[band]),
+                           vibration.bands[band], VIBRATION_DECIMALS, VIBRATION_DECIMALS);
+    }
+}
+
+// the bands as one array like the aggregates
+static void appendVibration(CborWriter &writer, const VIBRATION_SUMMARY &vibration) {
+    writer.appendFloat("vibrationRms", fixedToFloat(vibration.rms, VIBRATION_DECIMALS));
+    writer.appendFloat("vibrationPeak", fixedToFloat(vibration.peakFrequency, VIBRATION_DECIMALS));
+    writer.appendKey("vibrationBands", strlen("vibrationBands"));
+    writer.beginArray(VIBRATION_BAND_COUNT);
+    for (int band = 0; band < VIBRATION_BAND_COUNT; band++) {
+        writer.appendFloatValue(fixedToFloat(vibration.bands[band], VIBRATION_DECIMALS));
+    }
+}
+
+template <class Writer>
+static unsigned appendTelemetryFields(Writer &writer, const FIELD_AGGREGATE *aggregates, bool aggregate) {
+    const unsigned long now = millis();
+    unsigned fieldCount = 0;
+    for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+        if (!isFieldSelected(field) || !deadbandShouldSend(field, aggregates[field], now)) continue;
+        fieldCount++;
+        appendField(writer, field, aggregates[field], aggregate);
+    }
+    return fieldCount;
+}
+
+unsigned buildTelemetryPayload(char *payload, unsigned payloadSize, MessageFormat format,
+                               bool aggregate, unsigned *fieldCount) {
+    FIELD_AGGREGATE aggregates[TELEMETRY_FIELD_COUNT];
+    unsigned sampleCount = samplerAggregate(aggregates);
+    if (sampleCount == 0) {
+        // nothing sampled since the last send, read the sensors now
+        samplerTakeSample();
+        sampleCount = samplerAggregate(aggregates);
+    }
+
+    VIBRATION_SUMMARY vibration;
+    const bool hasVibration = vibrationTakeSummary(&vibration);
+
+    const unsigned long encodeStart = micros();
+    unsigned length;
+    bool overflow;
+
+    if (format == MESSAGE_FORMAT_CBOR) {
+        CborWriter writer((uint8_t *)payload, payloadSize);
+        writer.beginMap();
+        *fieldCount = appendTelemetryFields(writer, aggregates, aggregate);
+        if (hasVibration) {
+            appendVibration(writer, vibration);
+            (*fieldCount)++;
+        }
+        if (aggregate) {
+            writer.appendInt("sampleCount", sampleCount);
+        }
+        writer.endMap();
+        length = writer.getLength();
+        overflow = writer.hasOverflow();
+    } else {
+        JsonWriter writer(payload, payloadSize);
+        writer.beginObject();
+        *fieldCount = appendTelemetryFields(writer, aggregates, aggregate);
+        if (hasVibration) {
+            appendVibration(writer, vibration);
+            (*fieldCount)++;
+        }
+        if (aggregate) {
+            writer.appendInt(JSON_KEY("sampleCount"), sampleCount);
+        }
+        writer.endObject();
+        length = writer.getLength();
+        overflow = writer.hasOverflow();
+    }
+
+    if (overflow) {
+        LOG_ERROR("Telemetry payload exceeds the payload buffer");
+        return 0;
+    }
+
+    recordTelemetryEncoding(length, micros() - encodeStart);
+    return length;
+}
@@ -0,0 +1,497 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/telemetryQueue.h"
+#include <stddef.h>
+
+#define SECTOR_MAGIC 0x51544D54 // "TMTQ"
+#define RECORD_MAGIC 0x5152 // JSON payload
+#define RECORD_MAGIC_CBOR 0x5153
+#define SECTOR_FREE 0xFFFFFFFF
+#define SECTOR_RETIRED 0xFFFFFFFE // in sectorSequence, waiting for maintain() to erase it
+
+typedef struct SECTOR_HEADER_TAG {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t mergedThrough; // newest sequence a downsample copied in, SECTOR_FREE if none
+    uint32_t retired; // 0 once every record is replayed or merged, the sector only needs an erase
+} SECTOR_HEADER;
+
+// a record is its header followed by the payload, padded to 4 bytes
+typedef struct QUEUE_RECORD_TAG {
+    uint16_t magic;
+    uint16_t length;
+    uint32_t messageId;
+    uint32_t sampleTime;
+    uint16_t sampleMillis;
+    uint8_t level;
+    uint8_t consumed; // 0xFF until the replayed message is confirmed
+} QUEUE_RECORD;
+
+#define COPY_CHUNK_SIZE STRING_BUFFER_128
+
+// the payload format is kept in the record magic
+static inline bool isRecordMagic(uint16_t magic) {
+    return magic == RECORD_MAGIC || magic == RECORD_MAGIC_CBOR;
+}
+
+static inline uint32_t recordSize(unsigned length) {
+    return (sizeof(QUEUE_RECORD) + length + 3) & ~3U;
+}
+
+static inline uint32_t sectorAddress(int sector, uint32_t sectorSize) {
+    return (uint32_t)sector * sectorSize;
+}
+
+static bool isErased(FlashStore &flash, uint32_t address, uint32_t size) {
+    uint8_t chunk[COPY_CHUNK_SIZE];
+
+    while (size > 0) {
+        const uint32_t length = min(size, (uint32_t)COPY_CHUNK_SIZE);
+        if (!flash.read(address, chunk, length)) return false;
+        for (uint32_t i = 0; i < length; i++) {
+            if (chunk[i] != 0xFF) return false;
+        }
+        address += length;
+        size -= length;
+    }
+    return true;
+}
+
+// oldest or newest used sector, optionally the next one after a given sector
+int TelemetryQueue::findSector(bool oldest, int after) {
+    const uint32_t bound = after < 0 ? 0 : sectorSequence[after];
+    int found = -1;
+
+    for (unsigned i = 0; i < sectorCount; i++) {
+        const uint32_t sequence = sectorSequence[i];
+        if (sequence == SECTOR_FREE || sequence == SECTOR_RETIRED || (after >= 0 && sequence <= bound)) continue;
+        if (found < 0 || (oldest ? sequence < sectorSequence[found] : sequence > sectorSequence[found])) {
+            found = i;
+        }
+    }
+    return found;
+}
+
+int TelemetryQueue::findFreeSector() {
+    for (unsigned i = 0; i < sectorCount; i++) {
+        if (sectorSequence[i] == SECTOR_FREE) return i;
+    }
+    return -1;
+}
+
+unsigned TelemetryQueue::getFreeSectorCount() {
+    unsigned freeCount = 0;
+    for (unsigned i = 0; i < sectorCount; i++) {
+        if (sectorSequence[i] == SECTOR_FREE) freeCount++;
+    }
+    return freeCount;
+}
+
+int TelemetryQueue::findRetiredSector() {
+    for (unsigned i = 0; i < sectorCount; i++) {
+        if (sectorSequence[i] == SECTOR_RETIRED) return i;
+    }
+    return -1;
+}
+
+bool TelemetryQueue::eraseSector(int sector) {
+    sectorSequence[sector] = SECTOR_FREE;
+    if (sector == writeSector) {
+        writeSector = -1;
+    }
+
+    if (!flash.erase(sector)) {
+        LOG_ERROR("Erasing the telemetry queue sector failed");
+        return false;
+    }
+    return true;
+}
+
+// the magic goes last, a header or record torn by a reset isn't taken for a
+// complete one
+static bool programSectorHeader(FlashStore &flash, uint32_t address, uint32_t sequence, uint32_t mergedThrough) {
+    SECTOR_HEADER header = { SECTOR_MAGIC, sequence, mergedThrough, SECTOR_FREE };
+    return flash.program(address + sizeof(header.magic), &header.sequence,
+                         sizeof(header) - sizeof(header.magic)) &&
+           flash.program(address, &header.magic, sizeof(header.magic));
+}
+
+static bool programRecord(FlashStore &flash, uint32_t address, const QUEUE_RECORD *record) {
+    return flash.program(address + sizeof(record->magic), &record->length,
+                         sizeof(*record) - sizeof(record->magic)) &&
+           flash.program(address, &record->magic, sizeof(record->magic));
+}
+
+// a single word program, the erase is left to maintain()
+bool TelemetryQueue::retireSector(int sector) {
+    sectorSequence[sector] = SECTOR_RETIRED;
+    if (sector == writeSector) {
+        writeSector = -1;
+    }
+
+    const uint32_t retired = 0;
+    if (!flash.program(sectorAddress(sector, sectorSize) + offsetof(SECTOR_HEADER, retired), &retired,
+                       sizeof(retired))) {
+        LOG_ERROR("Retiring the telemetry queue sector failed");
+        return false;
+    }
+    return true;
+}
+
+// walks the records of a sector, returns false when the sector can't take more records
+bool TelemetryQueue::scanSector(int sector, uint32_t *endOffset, uint32_t *maxMessageId) {
+    const uint32_t base = sectorAddress(sector, sectorSize);
+    uint32_t offset = sizeof(SECTOR_HEADER);
+    QUEUE_RECORD record;
+
+    while (offset + sizeof(QUEUE_RECORD) <= sectorSize) {
+        if (!flash.read(base + offset, &record, sizeof(record))) return false;
+
+        if (!isRecordMagic(record.magic)) {
+            *endOffset = offset;
+            // anything but erased flash after the last record is a torn write
+            return isErased(flash, base + offset, sectorSize - offset);
+        }
+
+        if (record.messageId > *maxMessageId) {
+            *maxMessageId = record.messageId;
+        }
+        if (record.consumed == 0xFF) {
+            count++;
+        }
+        offset += recordSize(record.length);
+    }
+
+    *endOffset = sectorSize;
+    return false;
+}
+
+bool TelemetryQueue::init() {
+    ready = false;
+    count = 0;
+    writeSector = -1;
+    readSector = -1;
+
+    if (!flash.init()) {
+        return false;
+    }
+
+    sectorSize = flash.getSectorSize();
+    sectorCount = min(flash.getSectorCount(), (unsigned)TELEMETRY_QUEUE_MAX_SECTORS);
+    if (sectorCount < 3) {
+        LOG_ERROR("The telemetry queue needs at least three sectors");
+        return false;
+    }
+
+    SECTOR_HEADER header;
+    uint32_t lastSequence[TELEMETRY_QUEUE_MAX_SECTORS]; // newest sequence whose records a sector holds
+    for (unsigned i = 0; i < sectorCount; i++) {
+        sectorSequence[i] = SECTOR_FREE;
+        if (!flash.read(sectorAddress(i, sectorSize), &header, sizeof(header))) return false;
+
+        if (header.magic == SECTOR_MAGIC && header.retired != SECTOR_FREE) {
+            // retired before the reset, nothing in it is replayed again
+            if (!eraseSector(i)) return false;
+        } else if (header.magic == SECTOR_MAGIC) {
+            sectorSequence[i] = header.sequence;
+            lastSequence[i] = header.mergedThrough == SECTOR_FREE ? header.sequence : header.mergedThrough;
+        } else if (!isErased(flash, sectorAddress(i, sectorSize), sizeof(header) + COPY_CHUNK_SIZE)) {
+            // a merge or sector open that didn't complete, start the sector over
+            if (!eraseSector(i)) return false;
+        }
+    }
+
+    // a merge reset before both of its sources were retired leaves sources
+    // whose records the complete merged copy already holds, they are dropped
+    for (unsigned i = 0; i < sectorCount; i++) {
+        for (unsigned j = 0; j < sectorCount; j++) {
+            if (i == j || sectorSequence[i] == SECTOR_FREE || sectorSequence[j] == SECTOR_FREE) continue;
+            const bool covered = sectorSequence[j] >= sectorSequence[i] && lastSequence[j] <= lastSequence[i];
+            const bool same = sectorSequence[j] == sectorSequence[i] && lastSequence[j] == lastSequence[i];
+            if (covered && !same) {
+                if (!eraseSector(j)) return false;
+            }
+        }
+    }
+
+    uint32_t maxMessageId = 0;
+    for (unsigned i = 0; i < sectorCount; i++) {
+        if (sectorSequence[i] == SECTOR_FREE) continue;
+
+        uint32_t endOffset;
+        const bool open = scanSector(i, &endOffset, &maxMessageId);
+        if (sectorSequence[i] >= nextSequence) {
+            nextSequence = sectorSequence[i] + 1;
+        }
+        if ((int)i == findSector(false, -1)) {
+            writeSector = i;
+            writeOffset = open ? endOffset : sectorSize;
+        }
+    }
+    nextMessageId = maxMessageId + 1;
+
+    ready = true;
+    advanceRead(findSector(true, -1), sizeof(SECTOR_HEADER));
+
+    Serial.printf("Telemetry queue holds %u messages\r\n", count);
+    return true;
+}
+
+bool TelemetryQueue::findUnconsumed(int sector, uint32_t from, uint32_t *offset) {
+    const uint32_t base = sectorAddress(sector, sectorSize);
+    const uint32_t end = sector == writeSector ? writeOffset : sectorSize;
+    QUEUE_RECORD record;
+
+    while (from + sizeof(QUEUE_RECORD) <= end) {
+        if (!flash.read(base + from, &record, sizeof(record)) || !isRecordMagic(record.magic)) {
+            return false;
+        }
+        if (record.consumed == 0xFF) {
+            *offset = from;
+            return true;
+        }
+        from += recordSize(record.length);
+    }
+    return false;
+}
+
+// moves the read position to the next unconsumed record, sectors left
+// behind hold nothing but replayed messages and are retired
+void TelemetryQueue::advanceRead(int sector, uint32_t from) {
+    while (sector >= 0) {
+        uint32_t offset;
+        if (findUnconsumed(sector, from, &offset)) {
+            readSector = sector;
+            readOffset = offset;
+            return;
+        }
+
+        const int next = findSector(true, sector);
+        if (sector != writeSector) {
+            retireSector(sector);
+        }
+        sector = next;
+        from = sizeof(SECTOR_HEADER);
+    }
+
+    readSector = -1;
+}
+
+// only takes a sector maintain() already erased, push never waits for an erase
+bool TelemetryQueue::openSector() {
+    // everything was replayed, the full write sector can be recycled
+    if (count == 0 && writeSector >= 0) {
+        retireSector(writeSector);
+    }
+
+    // keep one sector erased for merging
+    if (getFreeSectorCount() < 2) {
+        LOG_ERROR("Telemetry queue has no erased sector, maintain() is behind");
+        return false;
+    }
+
+    const int sector = findFreeSector();
+    if (!programSectorHeader(flash, sectorAddress(sector, sectorSize), nextSequence, SECTOR_FREE)) {
+        LOG_ERROR("Opening a telemetry queue sector failed");
+        return false;
+    }
+
+    sectorSequence[sector] = nextSequence++;
+    writeSector = sector;
+    writeOffset = sizeof(SECTOR_HEADER);
+    return true;
+}
+
+// merges the two oldest sectors into the spare one keeping every other unconsumed
+// record, the two are retired. writing carries on in the merged sector when it
+// holds the newest records
+bool TelemetryQueue::downsample() {
+    const int first = findSector(true, -1);
+    const int second = first < 0 ? -1 : findSector(true, first);
+    const int spare = findFreeSector();
+    if (second < 0 || spare < 0) {
+        LOG_ERROR("Telemetry queue has no sectors to downsample");
+        return false;
+    }
+
+    const uint32_t target = sectorAddress(spare, sectorSize);
+    uint32_t targetOffset = sizeof(SECTOR_HEADER);
+    uint8_t chunk[COPY_CHUNK_SIZE];
+    unsigned kept = 0, dropped = 0;
+    bool keep = true;
+
+    const int sources[2] = { first, second };
+    for (int s = 0; s < 2; s++) {
+        const uint32_t base = sectorAddress(sources[s], sectorSize);
+        const uint32_t end = sources[s] == writeSector ? writeOffset : sectorSize;
+        uint32_t offset = sizeof(SECTOR_HEADER);
+        QUEUE_RECORD record;
+
+        while (offset + sizeof(QUEUE_RECORD) <= end) {
+            if (!flash.read(base + offset, &record, sizeof(record)) || !isRecordMagic(record.magic)) break;
+
+            const uint32_t size = recordSize(record.length);
+            if (record.consumed == 0xFF) {
+                if (keep && targetOffset + size <= sectorSize) {
+                    // payload first, a record only exists once its header is written
+                    for (uint32_t copied = 0; copied < record.length; copied += COPY_CHUNK_SIZE) {
+                        const uint32_t length = min((uint32_t)record.length - copied, (uint32_t)COPY_CHUNK_SIZE);
+                        if (!flash.read(base + offset + sizeof(record) + copied, chunk, length) ||
+                            !flash.program(target + targetOffset + sizeof(record) + copied, chunk, length)) {
+                            LOG_ERROR("Copying a telemetry record failed");
+                            return false;
+                        }
+                    }
+                    record.level++;
+                    if (!programRecord(flash, target + targetOffset, &record)) return false;
+                    targetOffset += size;
+                    kept++;
+                } else {
+                    dropped++;
+                }
+                keep = !keep;
+            }
+            offset += size;
+        }
+    }
+
+    // the merged sector takes the place of the oldest one in the replay order,
+    // once its header is complete init() drops whichever source wasn't retired yet
+    SECTOR_HEADER header;
+    if (!flash.read(sectorAddress(second, sectorSize), &header, sizeof(header)) ||
+        !programSectorHeader(flash, target, sectorSequence[first],
+                             header.mergedThrough == SECTOR_FREE ? sectorSequence[second] : header.mergedThrough)) {
+        return false;
+    }
+
+    const bool continueWriting = second == writeSector;
+    sectorSequence[spare] = sectorSequence[first];
+    if (!retireSector(first) || !retireSector(second)) {
+        return false;
+    }
+    if (continueWriting) {
+        writeSector = spare;
+        writeOffset = targetOffset;
+    }
+
+    count -= dropped;
+    downsampledCount += dropped;
+    Serial.printf("Telemetry queue downsampled, kept %u dropped %u messages\r\n", kept, dropped);
+
+    advanceRead(findSector(true, -1), sizeof(SECTOR_HEADER));
+    return true;
+}
+
+bool TelemetryQueue::maintain() {
+    if (!ready) {
+        return false;
+    }
+
+    const int retired = findRetiredSector();
+    if (retired >= 0) {
+        eraseSector(retired);
+        return true;
+    }
+
+    // merge while the write sector still has room for what arrives until
+    // the two merged sectors are erased
+    if (getFreeSectorCount() < 2 && writeSector >= 0 && writeOffset > sectorSize / 2) {
+        downsample();
+        return true;
+    }
+
+    return false;
+}
+
+bool TelemetryQueue::push(const char *payload, unsigned length, MessageFormat format, time_t sampleTime,
+                          unsigned sampleMillis) {
+    if (!ready) {
+        return false;
+    }
+
+    const uint32_t size = recordSize(length);
+    if (length > 0xFFFF || size > sectorSize - sizeof(SECTOR_HEADER)) {
+        LOG_ERROR("Message is too large for the telemetry queue");
+        return false;
+    }
+
+    if (writeSector < 0 || writeOffset + size > sectorSize) {
+        if (!openSector()) return false;
+    }
+
+    const uint32_t address = sectorAddress(writeSector, sectorSize) + writeOffset;
+    QUEUE_RECORD record;
+    record.magic = format == MESSAGE_FORMAT_CBOR ? RECORD_MAGIC_CBOR : RECORD_MAGIC;
+    record.length = (uint16_t)length;
+    record.messageId = nextMessageId;
+    record.sampleTime = (uint32_t)sampleTime;
+    record.sampleMillis = (uint16_t)sampleMillis;
+    record.level = 0;
+    record.consumed = 0xFF;
+
+    if (!flash.program(address + sizeof(record), payload, length) ||
+        !programRecord(flash, address, &record)) {
+        LOG_ERROR("Writing to the telemetry queue failed");
+        writeOffset = sectorSize; // don't program over a partial record
+        return false;
+    }
+
+    if (readSector < 0) {
+        readSector = writeSector;
+        readOffset = writeOffset;
+    }
+
+    writeOffset += size;
+    nextMessageId++;
+    count++;
+    return true;
+}
+
+bool TelemetryQueue::peek(QUEUED_MESSAGE *message, char *payload, unsigned payloadSize) {
+    if (!ready || readSector < 0) {
+        return false;
+    }
+
+    const uint32_t address = sectorAddress(readSector, sectorSize) + readOffset;
+    QUEUE_RECORD record;
+    if (!flash.read(address, &record, sizeof(record))) {
+        return false;
+    }
+
+    message->messageId = record.messageId;
+    message->format = record.magic == RECORD_MAGIC_CBOR ? MESSAGE_FORMAT_CBOR : MESSAGE_FORMAT_JSON;
+    message->sampleTime = (time_t)record.sampleTime;
+    message->sampleMillis = record.sampleMillis;
+    message->level = record.level;
+    message->length = record.length;
+
+    if (record.length >= payloadSize || !flash.read(address + sizeof(record), payload, record.length)) {
+        return false;
+    }
+    payload[record.length] = char(0);
+    return true;
+}
+
+bool TelemetryQueue::pop(uint32_t messageId) {
+    if (!ready || readSector < 0) {
+        return false;
+    }
+
+    const uint32_t address = sectorAddress(readSector, sectorSize) + readOffset;
+    QUEUE_RECORD record;
+    if (!flash.read(address, &record, sizeof(record)) || record.messageId != messageId) {
+        return false;
+    }
+
+    const uint8_t consumed = 0;
+    if (!flash.program(address + offsetof(QUEUE_RECORD, consumed), &consumed, 1)) {
+        LOG_ERROR("Marking the telemetry record as sent failed");
+        return false;
+    }
+
+    count--;
+    advanceRead(readSector, readOffset + recordSize(record.length));
+    return true;
+}
@@ -0,0 +1,212 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/telemetrySampler.h"
+#include "../inc/jsonWriter.h"
+#include "../inc/config.h"
+#include "../inc/sensors.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/motionFifo.h"
+
+#define FIELD_KEY_LENGTH(name) (sizeof(JSON_KEY(name)) - 1)
+
+#define TELEMETRY_FIELD(name, sensorMask, decimals, precision, meanPrecision) \
+    { name, { JSON_KEY(name), JSON_KEY(name "Min"), JSON_KEY(name "Max"), JSON_KEY(name "Mean") }, \
+      { FIELD_KEY_LENGTH(name), FIELD_KEY_LENGTH(name "Min"), FIELD_KEY_LENGTH(name "Max"), \
+        FIELD_KEY_LENGTH(name "Mean") }, sensorMask, decimals, precision, meanPrecision }
+
+// the motion sensors report whole units, their means are sent with two decimals
+const TELEMETRY_FIELD_INFO telemetryFields[TELEMETRY_FIELD_COUNT] = {
+    TELEMETRY_FIELD("humidity", HUMIDITY_CHECKED, HUMIDITY_DECIMALS, 2, 2),
+    TELEMETRY_FIELD("temp", TEMP_CHECKED, TEMPERATURE_DECIMALS, 2, 2),
+    TELEMETRY_FIELD("pressure", PRESSURE_CHECKED, PRESSURE_DECIMALS, 2, 2),
+    TELEMETRY_FIELD("magnetometerX", MAG_CHECKED, 0, 0, 2),
+    TELEMETRY_FIELD("magnetometerY", MAG_CHECKED, 0, 0, 2),
+    TELEMETRY_FIELD("magnetometerZ", MAG_CHECKED, 0, 0, 2),
+    TELEMETRY_FIELD("accelerometerX", ACCEL_CHECKED, 0, 0, 2),
+    TELEMETRY_FIELD("accelerometerY", ACCEL_CHECKED, 0, 0, 2),
+    TELEMETRY_FIELD("accelerometerZ", ACCEL_CHECKED, 0, 0, 2),
+    TELEMETRY_FIELD("gyroscopeX", GYRO_CHECKED, 0, 0, 2),
+    TELEMETRY_FIELD("gyroscopeY", GYRO_CHECKED, 0, 0, 2),
+    TELEMETRY_FIELD("gyroscopeZ", GYRO_CHECKED, 0, 0, 2)
+};
+
+static uint8_t selectedSensors = 0;
+static TELEMETRY_SAMPLE samples[SAMPLER_BUFFER_SIZE];
+static unsigned sampleHead = 0; // next slot to write
+static unsigned sampleCount = 0;
+static unsigned overwriteCount = 0;
+
+// with the motion FIFO every accelerometer and gyroscope sample is folded
+// in here, ACCEL_X_FIELD to GYRO_Z_FIELD
+#define MOTION_FIELD_COUNT 6
+static int motionReader = -1;
+static int32_t motionMin[MOTION_FIELD_COUNT];
+static int32_t motionMax[MOTION_FIELD_COUNT];
+static int32_t motionLast[MOTION_FIELD_COUNT];
+static int64_t motionSum[MOTION_FIELD_COUNT];
+static unsigned motionCount = 0;
+
+void samplerInit(uint8_t telemetryState) {
+    selectedSensors = telemetryState;
+    sampleHead = 0;
+    sampleCount = 0;
+    overwriteCount = 0;
+
+    motionCount = 0;
+    memset(motionLast, 0, sizeof(motionLast));
+    if (motionReader < 0 && isMotionFifoEnabled()) {
+        motionReader = motionAddReader();
+    }
+}
+
+static void takeMotionSamples(TELEMETRY_SAMPLE *sample) {
+    MOTION_SAMPLE samples[MOTION_BURST_SAMPLES];
+    unsigned count;
+
+    while ((count = motionRead(motionReader, samples, MOTION_BURST_SAMPLES)) > 0) {
+        for (unsigned i = 0; i < count; i++) {
+            int32_t values[MOTION_FIELD_COUNT]; // accelerometer then gyroscope, as the fields
+            motionToUnits(&samples[i], values, values + 3);
+
+            for (int field = 0; field < MOTION_FIELD_COUNT; field++) {
+                if (motionCount == 0 || values[field] < motionMin[field]) motionMin[field] = values[field];
+                if (motionCount == 0 || values[field] > motionMax[field]) motionMax[field] = values[field];
+                motionSum[field] = (motionCount == 0 ? 0 : motionSum[field]) + values[field];
+                motionLast[field] = values[field];
+            }
+            motionCount++;
+        }
+    }
+
+    for (int field = 0; field < MOTION_FIELD_COUNT; field++) {
+        sample->values[ACCEL_X_FIELD + field] = motionLast[field];
+    }
+}
+
+bool isFieldSelected(int field) {
+    const uint8_t mask = telemetryFields[field].sensorMask;
+    return (selectedSensors & mask) == mask;
+}
+
+void samplerTakeSample() {
+    TELEMETRY_SAMPLE *sample = &samples[sampleHead];
+    memset(sample, 0, sizeof(TELEMETRY_SAMPLE));
+    sample->sampleTime = millis();
+
+    // HTS221
+    if ((selectedSensors & HUMIDITY_CHECKED) == HUMIDITY_CHECKED) {
+        sample->values[HUMIDITY_FIELD] = readHumidity();
+    }
+
+    if ((selectedSensors & TEMP_CHECKED) == TEMP_CHECKED) {
+        sample->values[TEMP_FIELD] = readTemperature();
+    }
+
+    // LPS22HB
+    if ((selectedSensors & PRESSURE_CHECKED) == PRESSURE_CHECKED) {
+        sample->values[PRESSURE_FIELD] = readPressure();
+    }
+
+    int axes[3];
+
+    if (motionReader >= 0) {
+        takeMotionSamples(sample);
+    }
+
+    // LIS2MDL
+    if ((selectedSensors & MAG_CHECKED) == MAG_CHECKED) {
+        readMagnetometer(axes);
+        sample->values[MAG_X_FIELD] = axes[0];
+        sample->values[MAG_Y_FIELD] = axes[1];
+        sample->values[MAG_Z_FIELD] = axes[2];
+    }
+
+    // LSM6DSL
+    const bool accel = (selectedSensors & ACCEL_CHECKED) == ACCEL_CHECKED;
+    const bool gyro = (selectedSensors & GYRO_CHECKED) == GYRO_CHECKED;
+    if (motionReader < 0 && (accel || gyro)) {
+        int gyroAxes[3];
+        readMotion(accel ? axes : NULL, gyro ? gyroAxes : NULL);
+        if (accel) {
+            sample->values[ACCEL_X_FIELD] = axes[0];
+            sample->values[ACCEL_Y_FIELD] = axes[1];
+            sample->values[ACCEL_Z_FIELD] = axes[2];
+        }
+        if (gyro) {
+            sample->values[GYRO_X_FIELD] = gyroAxes[0];
+            sample->values[GYRO_Y_FIELD] = gyroAxes[1];
+            sample->values[GYRO_Z_FIELD] = gyroAxes[2];
+        }
+    }
+
+    sampleHead = (sampleHead + 1) % SAMPLER_BUFFER_SIZE;
+    if (sampleCount < SAMPLER_BUFFER_SIZE) {
+        sampleCount++;
+    } else {
+        overwriteCount++; // the oldest sample was replaced
+    }
+}
+
+// rounded half away from zero at the decimals of the mean
+static int32_t getMean(int field, int64_t sum, unsigned count) {
+    const int64_t scaled = sum * fixedScales[getMeanDecimals(field) - telemetryFields[field].decimals];
+    const int64_t half = count / 2;
+    return (int32_t)((scaled < 0 ? scaled - half : scaled + half) / (int64_t)count);
+}
+
+unsigned samplerAggregate(FIELD_AGGREGATE *aggregates) {
+    const unsigned count = sampleCount;
+    if (count == 0) {
+        return 0;
+    }
+
+    // walk from the oldest to the newest sample
+    unsigned index = (sampleHead + SAMPLER_BUFFER_SIZE - count) % SAMPLER_BUFFER_SIZE;
+    int64_t sums[TELEMETRY_FIELD_COUNT];
+    for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+        aggregates[field].min = samples[index].values[field];
+        aggregates[field].max = samples[index].values[field];
+        sums[field] = 0;
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        const TELEMETRY_SAMPLE *sample = &samples[index];
+        for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+            const int32_t value = sample->values[field];
+            if (value < aggregates[field].min) aggregates[field].min = value;
+            if (value > aggregates[field].max) aggregates[field].max = value;
+            sums[field] += value;
+            aggregates[field].last = value;
+        }
+        index = (index + 1) % SAMPLER_BUFFER_SIZE;
+    }
+
+    for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+        aggregates[field].mean = getMean(field, sums[field], count);
+    }
+
+    // every FIFO sample since the last aggregate rather than one per telemetry sample
+    if (motionCount > 0) {
+        for (int field = 0; field < MOTION_FIELD_COUNT; field++) {
+            FIELD_AGGREGATE *aggregate = &aggregates[ACCEL_X_FIELD + field];
+            aggregate->min = motionMin[field];
+            aggregate->max = motionMax[field];
+            aggregate->mean = getMean(ACCEL_X_FIELD + field, motionSum[field], motionCount);
+            aggregate->last = motionLast[field];
+        }
+        motionCount = 0;
+    }
+
+    sampleCount = 0;
+    return count;
+}
+
+unsigned getSamplerOverwriteCount() {
+    return overwriteCount;
+}
+
+unsigned long getSamplerMotionMissedCount() {
+    return motionReader < 0 ? 0 : getMotionReaderOverrunCount(motionReader);
+}
@@ -0,0 +1,177 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/timestamp.h"
+
+#define ISO8601_SECONDS_LENGTH 19 // "2017-10-01T18:18:36"
+
+// the utc second that started at millis() == anchorMillis
+static time_t anchorSeconds = 0;
+static unsigned long anchorMillis = 0;
+static bool anchored = false;
+static bool synced = false;
+
+static time_t cachedSecond = (time_t)-1;
+static char cachedText[ISO8601_SECONDS_LENGTH + 1];
+
+static inline char * writeDigits(char *out, unsigned value, int digits) {
+    for (int i = digits - 1; i >= 0; i--) {
+        out[i] = '0' + (value % 10);
+        value /= 10;
+    }
+    return out + digits;
+}
+
+static void formatSeconds(time_t seconds, char *out) {
+    struct tm parts;
+    gmtime_r(&seconds, &parts);
+
+    out = writeDigits(out, parts.tm_year + 1900, 4);
+    *out++ = '-';
+    out = writeDigits(out, parts.tm_mon + 1, 2);
+    *out++ = '-';
+    out = writeDigits(out, parts.tm_mday, 2);
+    *out++ = 'T';
+    out = writeDigits(out, parts.tm_hour, 2);
+    *out++ = ':';
+    out = writeDigits(out, parts.tm_min, 2);
+    *out++ = ':';
+    out = writeDigits(out, parts.tm_sec, 2);
+    *out = char(0);
+}
+
+static unsigned appendMilliseconds(const char *secondsText, unsigned milliseconds,
+                                   char *buffer, unsigned bufferSize) {
+    if (bufferSize <= ISO8601_TIMESTAMP_LENGTH) {
+        LOG_ERROR("Timestamp buffer is too small");
+        if (bufferSize > 0) buffer[0] = char(0);
+        return 0;
+    }
+
+    memcpy(buffer, secondsText, ISO8601_SECONDS_LENGTH);
+    char *out = buffer + ISO8601_SECONDS_LENGTH;
+    *out++ = '.';
+    out = writeDigits(out, milliseconds, 3);
+    *out++ = 'Z';
+    *out = char(0);
+
+    return ISO8601_TIMESTAMP_LENGTH;
+}
+
+static void anchor() {
+    anchorSeconds = time(NULL);
+    anchorMillis = millis();
+    anchored = true;
+}
+
+void anchorCurrentTime() {
+    anchor();
+    synced = true;
+}
+
+bool isTimeSynced() {
+    return synced;
+}
+
+// time() only has second resolution, the time is counted in milliseconds
+// from the second the RTC was anchored at. If the RTC moves more than a second
+// away from that count it was set again, and the count moves by the whole
+// seconds between them. Taking the anchor again here would start the
+// milliseconds at .000 wherever in the RTC second this call happens to be.
+// The calendar part is only recomputed when the second changes, and the
+// anchor follows it so the elapsed count stays short of a millis() wrap.
+void getCurrentTime(time_t *seconds, unsigned *milliseconds) {
+    const time_t rtc = time(NULL);
+    if (!anchored) {
+        anchor();
+    }
+
+    unsigned long elapsed = millis() - anchorMillis;
+    time_t now = anchorSeconds + (time_t)(elapsed / 1000);
+    if (rtc > now + 1 || rtc < now - 1) {
+        anchorSeconds += rtc - now;
+        now = rtc;
+    }
+
+    if (now != cachedSecond) {
+        cachedSecond = now;
+        formatSeconds(now, cachedText);
+        anchorMillis += elapsed - elapsed % 1000;
+        anchorSeconds = now;
+        elapsed %= 1000;
+    }
+
+    *seconds = now;
+    *milliseconds = (unsigned)(elapsed % 1000);
+}
+
+unsigned formatIsoTimestamp(char *buffer, unsigned bufferSize) {
+    time_t seconds;
+    unsigned milliseconds;
+    getCurrentTime(&seconds, &milliseconds);
+
+    return appendMilliseconds(cachedText, milliseconds, buffer, bufferSize);
+}
+
+// days since 1970-01-01 of a proleptic gregorian date
+static long daysFromCivil(long year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const long era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = (unsigned)(year - era * 400);
+    const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (long)dayOfEra - 719468;
+}
+
+static bool readDigits(const char *&in, const char *end, int digits, unsigned *value) {
+    *value = 0;
+    for (int i = 0; i < digits; i++, in++) {
+        if (in >= end || *in < '0' || *in > '9') return false;
+        *value = *value * 10 + (*in - '0');
+    }
+    return true;
+}
+
+static bool readSeparator(const char *&in, const char *end, char separator) {
+    return in < end && *in++ == separator;
+}
+
+bool parseIsoTimestamp(const char *text, unsigned length, time_t *seconds, unsigned *milliseconds) {
+    const char *in = text, *end = text + length;
+    unsigned year, month, day, hour, minute, second;
+    if (!readDigits(in, end, 4, &year) || !readSeparator(in, end, '-') ||
+        !readDigits(in, end, 2, &month) || !readSeparator(in, end, '-') ||
+        !readDigits(in, end, 2, &day) || !readSeparator(in, end, 'T') ||
+        !readDigits(in, end, 2, &hour) || !readSeparator(in, end, ':') ||
+        !readDigits(in, end, 2, &minute) || !readSeparator(in, end, ':') ||
+        !readDigits(in, end, 2, &second)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    // the first three fraction digits are the milliseconds, the rest is cut off
+    unsigned fraction = 0, scale = 100;
+    if (in < end && *in == '.') {
+        for (in++; in < end && *in >= '0' && *in <= '9'; in++) {
+            fraction += (*in - '0') * scale;
+            scale /= 10;
+        }
+    }
+    if (!readSeparator(in, end, 'Z') || in != end) {
+        return false;
+    }
+
+    *seconds = (time_t)(daysFromCivil(year, month, day) * 86400L + hour * 3600L + minute * 60L + second);
+    *milliseconds = fraction;
+    return true;
+}
+
+unsigned formatIsoTimestampAt(time_t seconds, unsigned milliseconds, char *buffer, unsigned bufferSize) {
+    char secondsText[ISO8601_SECONDS_LENGTH + 1];
+    formatSeconds(seconds, secondsText);
+
+    return appendMilliseconds(secondsText, milliseconds % 1000, buffer, bufferSize);
+}
@@ -0,0 +1,240 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/twinParser.h"
+
+typedef struct TWIN_CURSOR_TAG {
+    const char *position;
+    const char *end;
+} TWIN_CURSOR;
+
+enum { DESIRED_SECTION, REPORTED_SECTION };
+
+static inline bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void skipWhitespace(TWIN_CURSOR *cursor) {
+    while (cursor->position < cursor->end && isWhitespace(*cursor->position)) {
+        cursor->position++;
+    }
+}
+
+static bool consume(TWIN_CURSOR *cursor, char expected) {
+    skipWhitespace(cursor);
+    if (cursor->position < cursor->end && *cursor->position == expected) {
+        cursor->position++;
+        return true;
+    }
+    return false;
+}
+
+static inline bool spanIs(const TWIN_SPAN &span, const char *text, unsigned length) {
+    return span.length == length && memcmp(span.start, text, length) == 0;
+}
+
+#define SPAN_IS(span, literal) spanIs(span, literal, sizeof(literal) - 1)
+
+// span excludes the quotes, escapes are left as they are
+static bool scanString(TWIN_CURSOR *cursor, TWIN_SPAN *span) {
+    if (!consume(cursor, '"')) return false;
+
+    span->start = cursor->position;
+    while (cursor->position < cursor->end) {
+        const char c = *cursor->position++;
+        if (c == '\\') {
+            cursor->position++;
+        } else if (c == '"') {
+            span->length = cursor->position - 1 - span->start;
+            return true;
+        }
+    }
+    return false;
+}
+
+// span covers the whole value including quotes and brackets
+static bool scanValue(TWIN_CURSOR *cursor, TWIN_SPAN *span) {
+    skipWhitespace(cursor);
+    if (cursor->position >= cursor->end) return false;
+
+    span->start = cursor->position;
+    const char first = *cursor->position;
+
+    if (first == '"') {
+        TWIN_SPAN text;
+        if (!scanString(cursor, &text)) return false;
+    } else if (first == '{' || first == '[') {
+        int depth = 0;
+        bool inString = false;
+        while (cursor->position < cursor->end) {
+            const char c = *cursor->position++;
+            if (inString) {
+                if (c == '\\') cursor->position++;
+                else if (c == '"') inString = false;
+            } else if (c == '"') {
+                inString = true;
+            } else if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                break;
+            }
+        }
+        if (depth != 0) return false;
+    } else {
+        // number, true, false or null
+        while (cursor->position < cursor->end) {
+            const char c = *cursor->position;
+            if (c == ',' || c == '}' || c == ']' || isWhitespace(c)) break;
+            cursor->position++;
+        }
+    }
+
+    span->length = cursor->position - span->start;
+    return span->length > 0;
+}
+
+// walks the members of an object, stops on the closing brace
+static bool nextMember(TWIN_CURSOR *cursor, bool first, TWIN_SPAN *name) {
+    if (!first && !consume(cursor, ',')) return false;
+    return scanString(cursor, name) && consume(cursor, ':');
+}
+
+static bool isObjectEnd(TWIN_CURSOR *cursor) {
+    skipWhitespace(cursor);
+    if (cursor->position < cursor->end && *cursor->position == '}') {
+        cursor->position++;
+        return true;
+    }
+    return false;
+}
+
+static TWIN_PROPERTY * findProperty(TWIN_DOCUMENT *document, const TWIN_SPAN &name) {
+    for (unsigned i = 0; i < document->propertyCount; i++) {
+        if (twinSpanEquals(document->properties[i].name, name)) {
+            return &document->properties[i];
+        }
+    }
+
+    if (document->propertyCount == TWIN_MAX_PROPERTIES) {
+        document->droppedCount++;
+        return NULL;
+    }
+
+    TWIN_PROPERTY *property = &document->properties[document->propertyCount++];
+    memset(property, 0, sizeof(TWIN_PROPERTY));
+    property->name = name;
+    return property;
+}
+
+// {"value":..., "desiredVersion":...} or a plain value
+static bool scanEntry(TWIN_CURSOR *cursor, TWIN_SPAN *entry, TWIN_SPAN *value, TWIN_SPAN *desiredVersion) {
+    skipWhitespace(cursor);
+    if (cursor->position >= cursor->end) return false;
+
+    if (*cursor->position != '{') {
+        if (!scanValue(cursor, entry)) return false;
+        *value = *entry;
+        return true;
+    }
+
+    entry->start = cursor->position++;
+    TWIN_SPAN name, member;
+    for (bool first = true; !isObjectEnd(cursor); first = false) {
+        if (!nextMember(cursor, first, &name) || !scanValue(cursor, &member)) return false;
+
+        if (SPAN_IS(name, "value")) {
+            *value = member;
+        } else if (desiredVersion != NULL && SPAN_IS(name, "desiredVersion")) {
+            *desiredVersion = member;
+        }
+    }
+    entry->length = cursor->position - entry->start;
+    return true;
+}
+
+// only the top level "$lastUpdated" of a $metadata object, the per property ones are skipped
+static bool scanMetadata(TWIN_CURSOR *cursor, TWIN_SPAN *lastUpdated) {
+    if (!consume(cursor, '{')) return false;
+
+    TWIN_SPAN name, member;
+    for (bool first = true; !isObjectEnd(cursor); first = false) {
+        if (!nextMember(cursor, first, &name) || !scanValue(cursor, &member)) return false;
+
+        if (SPAN_IS(name, "$lastUpdated") && member.length >= 2 && member.start[0] == '"') {
+            lastUpdated->start = member.start + 1;
+            lastUpdated->length = member.length - 2;
+        }
+    }
+    return true;
+}
+
+static bool parseSection(TWIN_CURSOR *cursor, TWIN_DOCUMENT *document, int section) {
+    if (!consume(cursor, '{')) return false;
+
+    TWIN_SPAN name, skipped;
+    for (bool first = true; !isObjectEnd(cursor); first = false) {
+        if (!nextMember(cursor, first, &name)) return false;
+
+        if (section == DESIRED_SECTION && SPAN_IS(name, "$metadata")) {
+            if (!scanMetadata(cursor, &document->desiredLastUpdated)) return false;
+            continue;
+        }
+
+        if (name.length > 0 && name.start[0] == '$') {
+            if (!scanValue(cursor, &skipped)) return false;
+            if (SPAN_IS(name, "$version")) {
+                if (section == DESIRED_SECTION) document->desiredVersion = skipped;
+                else document->reportedVersion = skipped;
+            }
+            continue;
+        }
+
+        TWIN_PROPERTY *property = findProperty(document, name);
+        if (property == NULL) {
+            if (!scanValue(cursor, &skipped)) return false;
+        } else if (section == DESIRED_SECTION) {
+            if (!scanEntry(cursor, &property->desired, &property->desiredValue, NULL)) return false;
+            property->inDesired = true;
+        } else {
+            if (!scanEntry(cursor, &skipped, &property->reportedValue,
+                           &property->reportedDesiredVersion)) return false;
+            property->inReported = true;
+        }
+    }
+    return true;
+}
+
+bool twinParse(const char *payload, unsigned size, bool partial, TWIN_DOCUMENT *document) {
+    memset(document, 0, sizeof(TWIN_DOCUMENT));
+
+    TWIN_CURSOR cursor = { payload, payload + size };
+    if (partial) {
+        return parseSection(&cursor, document, DESIRED_SECTION);
+    }
+
+    if (!consume(&cursor, '{')) return false;
+
+    TWIN_SPAN name, skipped;
+    for (bool first = true; !isObjectEnd(&cursor); first = false) {
+        if (!nextMember(&cursor, first, &name)) return false;
+
+        if (SPAN_IS(name, "desired")) {
+            if (!parseSection(&cursor, document, DESIRED_SECTION)) return false;
+        } else if (SPAN_IS(name, "reported")) {
+            if (!parseSection(&cursor, document, REPORTED_SECTION)) return false;
+        } else if (!scanValue(&cursor, &skipped)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool twinSpanCopy(const TWIN_SPAN &span, char *buffer, unsigned bufferSize) {
+    if (span.length >= bufferSize) {
+        return false;
+    }
+    memcpy(buffer, span.start, span.length);
+    buffer[span.length] = char(0);
+    return true;
+}
@@ -3,6 +3,8 @@
 
 #include "../inc/globals.h"
 #include "../inc/utility.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/timestamp.h"
 
 #include "SystemWiFi.h"
 #include "NTPClient.h"
@@ -84,6 +86,7 @@ bool JSObject::getObjectByName(const char * name, JSObject * outJSObject) {
 }
 
 // As there is a problem of sprintf %f in Arduino, follow https://github.com/blynkkk/blynk-library/issues/14 to implement dtostrf
+// width is ignored and prec is capped at FIXED_MAX_DECIMALS
 char * dtostrf(double number, signed char width, unsigned char prec, char *s) {
     if(isnan(number)) {
         strcpy(s, "nan");
@@ -98,39 +101,35 @@ char * dtostrf(double number, signed char width, unsigned char prec, char *s) {
         strcpy(s, "ovf");
         return s;
     }
-    char* out = s;
-    // Handle negative numbers
-    if(number < 0.0) {
-        *out = '-';
-        ++out;
+
+    if (prec > FIXED_MAX_DECIMALS) {
+        prec = FIXED_MAX_DECIMALS;
+    }
+
+    const bool negative = number < 0.0;
+    if (negative) {
         number = -number;
     }
+
     // Round correctly so that print(1.999, 2) prints as "2.00"
-    double rounding = 0.5;
-    for(uint8_t i = 0; i < prec; ++i) {
-        rounding /= 10.0;
+    number += 0.5 / fixedScales[prec];
+    uint32_t intPart = (uint32_t) number;
+    uint32_t fraction = (uint32_t) ((number - intPart) * fixedScales[prec]);
+    if (fraction >= fixedScales[prec]) {
+        fraction = 0; // the fraction can't round up past its digits
+        intPart++;
     }
-    number += rounding;
 
-    // Extract the integer part of the number and print it
-    unsigned long int_part = (unsigned long) number;
-    double remainder = number - (double) int_part;
-    out += sprintf(out, "%d", int_part);
-
-    // Print the decimal point, but only if there are digits beyond
-    if(prec > 0) {
-        *out = '.';
-        ++out;
+    char* out = s;
+    if (negative && (intPart != 0 || fraction != 0)) {
+        *out++ = '-';
     }
-
-    while(prec-- > 0) {
-        remainder *= 10.0;
-        if((int)remainder == 0){
-            *out = '0';
-            ++out;
-        }
+    out += formatUnsigned(intPart, 1, out);
+    if (prec > 0) {
+        *out++ = '.';
+        out += formatUnsigned(fraction, prec, out);
     }
-    sprintf(out, "%d", (int) remainder);
+    *out = char(0);
     return s;
 }
 
@@ -188,6 +187,7 @@ bool SyncTimeToNTP() {
         NTPClient ntp(WiFiInterface());
         NTPResult res = ntp.setTime((char*)ntpHost[i]);
         if (res == NTP_OK) {
+            anchorCurrentTime();
             time_t t = time(NULL);
             (void)Serial.printf("Time from %s, now is (UTC): %s\r\n", ntpHost[i], ctime(&t));
             return true;
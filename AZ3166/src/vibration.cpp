@@ -0,0 +1,182 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "../inc/globals.h"
+#include "../inc/vibration.h"
+#include "../inc/fixedFft.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/motionFifo.h"
+
+#define AXIS_COUNT 3
+#define MAX_SHIFT 15
+
+// upper edges (Hz) of all but the last band, which runs to half the data rate
+static const uint16_t bandLimits[VIBRATION_BAND_COUNT - 1] = { 10, 50, 100 };
+
+static int reader = -1;
+static int16_t windows[AXIS_COUNT][FFT_SIZE];
+static unsigned filled = 0;
+
+// energies in (1/100 mg)^2, summed over the axes and windows of a summary
+static uint64_t rmsEnergy;
+static uint64_t bandEnergy[VIBRATION_BAND_COUNT];
+static uint64_t peakPower; // normalized to MAX_SHIFT so axes and windows compare
+static unsigned peakBin;
+static unsigned summaryWindows;
+
+static unsigned long windowCount = 0;
+static unsigned long analysisTimeMax = 0;
+
+bool vibrationInit() {
+    if (!isMotionFifoEnabled()) {
+        LOG_ERROR("Vibration telemetry needs the motion FIFO");
+        return false;
+    }
+
+    reader = motionAddReader();
+    if (reader < 0) {
+        LOG_ERROR("No motion FIFO reader left for the vibration analysis");
+        return false;
+    }
+
+    fftInit();
+    filled = 0;
+    summaryWindows = 0;
+    return true;
+}
+
+bool isVibrationEnabled() {
+    return reader >= 0;
+}
+
+// converts (raw LSB)^2 scaled by 4^shift into (1/100 mg)^2, 1 LSB is sensitivity / 10
+static uint64_t toEnergy(uint64_t value, int shift) {
+    const uint64_t sensitivity = getMotionAccelSensitivity();
+    value *= sensitivity * sensitivity;
+    value = shift >= 0 ? value >> (2 * shift) : value << (-2 * shift);
+    return value / 100;
+}
+
+static void analyzeAxis(const int16_t *raw, uint32_t binHz) {
+    static int16_t samples[FFT_SIZE];
+    static uint32_t power[FFT_BINS];
+
+    int32_t sum = 0;
+    for (int n = 0; n < FFT_SIZE; n++) {
+        sum += raw[n];
+    }
+    const int32_t mean = sum / FFT_SIZE;
+
+    int32_t maxAbs = 0;
+    uint64_t sumSquares = 0;
+    for (int n = 0; n < FFT_SIZE; n++) {
+        const int32_t centered = raw[n] - mean;
+        maxAbs = max(maxAbs, abs(centered));
+        sumSquares += (uint64_t)((int64_t)centered * centered);
+    }
+    if (maxAbs == 0) {
+        return;
+    }
+    rmsEnergy += toEnergy(sumSquares / FFT_SIZE, 0);
+
+    // block floating point, the largest sample uses the full Q15 range
+    int shift = maxAbs > 32767 ? -1 : 0;
+    while (shift < MAX_SHIFT && (maxAbs << (shift + 1)) <= 32767) {
+        shift++;
+    }
+    for (int n = 0; n < FFT_SIZE; n++) {
+        const int32_t centered = raw[n] - mean;
+        samples[n] = (int16_t)(shift >= 0 ? centered << shift : centered >> -shift);
+    }
+
+    fftApplyWindow(samples);
+    fftRealPower(samples, power);
+
+    // one sided spectrum, the Hann window keeps 3/8 of the power
+    uint64_t bands[VIBRATION_BAND_COUNT] = { 0 };
+    int band = 0;
+    for (unsigned k = 1; k < FFT_BINS; k++) {
+        while (band < VIBRATION_BAND_COUNT - 1 && k * binHz >= bandLimits[band] * 1000U) {
+            band++;
+        }
+        bands[band] += (uint64_t)power[k] * (k < FFT_BINS - 1 ? 2 : 1);
+
+        const uint64_t normalized = (uint64_t)power[k] << (2 * (MAX_SHIFT - shift));
+        if (normalized > peakPower) {
+            peakPower = normalized;
+            peakBin = k;
+        }
+    }
+
+    for (int b = 0; b < VIBRATION_BAND_COUNT; b++) {
+        bandEnergy[b] += toEnergy(bands[b] * 8 / 3, shift);
+    }
+}
+
+static void analyzeWindow() {
+    const unsigned long start = micros();
+
+    if (summaryWindows == 0) {
+        rmsEnergy = 0;
+        memset(bandEnergy, 0, sizeof(bandEnergy));
+        peakPower = 0;
+        peakBin = 0;
+    }
+
+    const uint32_t binHz = getMotionOdrMilliHz() / FFT_SIZE; // bin width in mHz
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        analyzeAxis(windows[axis], binHz);
+    }
+
+    summaryWindows++;
+    windowCount++;
+    analysisTimeMax = max(analysisTimeMax, micros() - start);
+}
+
+void vibrationProcess() {
+    if (reader < 0) {
+        return;
+    }
+
+    MOTION_SAMPLE samples[MOTION_BURST_SAMPLES];
+    unsigned count;
+    while ((count = motionRead(reader, samples, MOTION_BURST_SAMPLES)) > 0) {
+        for (unsigned i = 0; i < count; i++) {
+            for (int axis = 0; axis < AXIS_COUNT; axis++) {
+                windows[axis][filled] = samples[i].accel[axis];
+            }
+            if (++filled == FFT_SIZE) {
+                analyzeWindow();
+                filled = 0;
+            }
+        }
+    }
+}
+
+bool vibrationTakeSummary(VIBRATION_SUMMARY *summary) {
+    if (summaryWindows == 0) {
+        return false;
+    }
+
+    summary->rms = integerSqrt(rmsEnergy / summaryWindows);
+    for (int b = 0; b < VIBRATION_BAND_COUNT; b++) {
+        summary->bands[b] = integerSqrt(bandEnergy[b] / summaryWindows);
+    }
+    summary->peakFrequency = (int32_t)((uint64_t)peakBin * getMotionOdrMilliHz() / FFT_SIZE / 10);
+    summary->windowCount = summaryWindows;
+
+    summaryWindows = 0;
+    return true;
+}
+
+unsigned long getVibrationWindowCount() {
+    return windowCount;
+}
+
+unsigned long getVibrationMissedCount() {
+    return reader < 0 ? 0 : getMotionReaderOverrunCount(reader);
+}
+
+unsigned long getVibrationAnalysisTimeMax() {
+    return analysisTimeMax;
+}
@@ -4,6 +4,8 @@
 #include "../inc/globals.h"
 #include "AZ3166WiFi.h"
 #include "../inc/config.h"
+#include "../inc/ledIndicator.h"
+#include "../inc/displayModel.h"
 
 bool initApWiFi() {
     char ap_name[STRING_BUFFER_32] = {0};
@@ -43,9 +45,10 @@ bool initWiFi() {
 
     if(WiFi.begin() == WL_CONNECTED) {
         Serial.println("WiFi WL_CONNECTED");
-        digitalWrite(LED_WIFI, 1);
+        ledIndicatorSignal(LED_EVENT_WIFI_CONNECTED);
         connected = true;
     } else {
+        ledIndicatorSignal(LED_EVENT_WIFI_DISCONNECTED);
         Screen.print("WiFi\r\nNot Connected\r\nEnter AP Mode?\r\n");
     }
 
@@ -110,5 +113,5 @@ void displayNetworkInfo() {
         mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 
     buff[length] = char(0);
-    Screen.print(0, buff);
+    displayModelSetText(buff);
 }
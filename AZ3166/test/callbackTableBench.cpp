@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Method and desired property lookup with the table full at MAX_CALLBACK_COUNT:
+// the hash table against the uppercase String copy and linear compare it
+// replaced, on the same mixed case names, hits and misses.
+
+#include "../inc/globals.h"
+#include "../inc/callbackTable.h"
+#include "hostTest.h"
+
+#define LOOKUP_ROUNDS 20000
+
+static int handler(const char *, size_t, char **, size_t *) { return 200; }
+
+// the sketch's own names first, the rest of the table filled up
+static const char *sketchNames[] = {
+    "message", "rainbow", "fanSpeed", "setVoltage", "setCurrent", "activateIR", "telemetryDeadband"
+};
+
+static CALLBACK_LOOKUP oldList[MAX_CALLBACK_COUNT];
+static int oldCount = 0;
+
+// the lookup of DeviceDirectMethodCallback() before the table
+static CALLBACK_LOOKUP *oldFind(const char *name) {
+    String methodName = name;
+    methodName.toUpperCase();
+    for (int i = 0; i < oldCount; i++) {
+        if (methodName == oldList[i].name) {
+            return &oldList[i];
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    static CALLBACK_TABLE table;
+    char names[MAX_CALLBACK_COUNT][STRING_BUFFER_32];
+    for (int i = 0; i < MAX_CALLBACK_COUNT; i++) {
+        if (i < (int)(sizeof(sketchNames) / sizeof(sketchNames[0]))) {
+            snprintf(names[i], sizeof(names[i]), "%s", sketchNames[i]);
+        } else {
+            snprintf(names[i], sizeof(names[i]), "desiredProperty%d", i);
+        }
+        callbackTableAdd(&table, names[i], handler);
+
+        oldList[i].name = strdup(names[i]);
+        strupr(oldList[i].name);
+        oldList[i].callback = handler;
+        oldCount++;
+    }
+
+    // every name in the case the hub may send it, and as many names that aren't registered
+    const int queryCount = 4 * MAX_CALLBACK_COUNT;
+    char queries[4 * MAX_CALLBACK_COUNT][STRING_BUFFER_32];
+    for (int i = 0; i < MAX_CALLBACK_COUNT; i++) {
+        snprintf(queries[4 * i], sizeof(queries[0]), "%s", names[i]);
+        snprintf(queries[4 * i + 1], sizeof(queries[0]), "%s", names[i]);
+        strupr(queries[4 * i + 1]);
+        snprintf(queries[4 * i + 2], sizeof(queries[0]), "%sX", names[i]);
+        snprintf(queries[4 * i + 3], sizeof(queries[0]), "unknown%d", i);
+    }
+
+    unsigned mismatches = 0, hits = 0;
+    for (int q = 0; q < queryCount; q++) {
+        CALLBACK_LOOKUP *entry = callbackTableFind(&table, queries[q], strlen(queries[q]));
+        CALLBACK_LOOKUP *old = oldFind(queries[q]);
+        const int index = entry != NULL ? (int)(entry - table.list) : -1;
+        const int oldIndex = old != NULL ? (int)(old - oldList) : -1;
+        if (index != oldIndex) {
+            if (mismatches++ < 5) {
+                printf("mismatch %s: table %d old %d\n", queries[q], index, oldIndex);
+            }
+        }
+        hits += index >= 0;
+    }
+
+    volatile uintptr_t sink = 0;
+    const unsigned long allocationsBefore = hostStringAllocations();
+    uint64_t start = hostNanoseconds(), startCycles = hostCycles();
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (int q = 0; q < queryCount; q++) {
+            sink = sink + (uintptr_t)oldFind(queries[q]);
+        }
+    }
+    const uint64_t oldNs = hostNanoseconds() - start, oldCycles = hostCycles() - startCycles;
+    const unsigned long oldAllocations = hostStringAllocations() - allocationsBefore;
+
+    start = hostNanoseconds();
+    startCycles = hostCycles();
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (int q = 0; q < queryCount; q++) {
+            sink = sink + (uintptr_t)callbackTableFind(&table, queries[q], strlen(queries[q]));
+        }
+    }
+    const uint64_t tableNs = hostNanoseconds() - start, tableCycles = hostCycles() - startCycles;
+
+    const double lookups = (double)LOOKUP_ROUNDS * queryCount;
+    printf("callbacks           %d registered, %d names, %u found, %u mismatches\n",
+           MAX_CALLBACK_COUNT, queryCount, hits, mismatches);
+    printf("string and scan     %8.1f ns %8.0f cycles %6.1f heap calls\n",
+           oldNs / lookups, oldCycles / lookups, oldAllocations / lookups);
+    printf("hash table          %8.1f ns %8.0f cycles %6.1f heap calls\n",
+           tableNs / lookups, tableCycles / lookups, 0.0);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The method and desired property table: names match whatever their case,
+// only whole names match, and entries sharing a bucket or a whole hash are
+// still told apart, up to a full table of MAX_CALLBACK_COUNT.
+
+#include "../inc/globals.h"
+#include "../inc/callbackTable.h"
+#include "hostTest.h"
+
+// the callbacks only tell the entries apart
+static int first(const char *, size_t, char **, size_t *) { return 1; }
+static int second(const char *, size_t, char **, size_t *) { return 2; }
+static int third(const char *, size_t, char **, size_t *) { return 3; }
+
+static int callFound(CALLBACK_TABLE *table, const char *name) {
+    CALLBACK_LOOKUP *entry = callbackTableFind(table, name, strlen(name));
+    return entry != NULL ? entry->callback(NULL, 0, NULL, NULL) : 0;
+}
+
+static void testEmpty() {
+    CALLBACK_TABLE table = {};
+    CHECK(callbackTableFind(&table, "fanSpeed", 8) == NULL);
+    CHECK(callbackTableAdd(&table, "fanSpeed", first));
+    CHECK(callbackTableFind(&table, NULL, 0) == NULL);
+}
+
+static void testCaseInsensitive() {
+    CALLBACK_TABLE table = {};
+    CHECK(callbackTableAdd(&table, "fanSpeed", first));
+    CHECK(callbackTableAdd(&table, "setVoltage", second));
+    CHECK_STRING("FANSPEED", table.list[0].name);
+
+    CHECK_EQUAL(1, callFound(&table, "fanSpeed"));
+    CHECK_EQUAL(1, callFound(&table, "FANSPEED"));
+    CHECK_EQUAL(1, callFound(&table, "fanspeed"));
+    CHECK_EQUAL(1, callFound(&table, "FaNsPeEd"));
+    CHECK_EQUAL(2, callFound(&table, "SETvoltage"));
+    CHECK_EQUAL(callbackNameHash("fanSpeed", 8), callbackNameHash("FANSPEED", 8));
+
+    // only whole names
+    CHECK_EQUAL(0, callFound(&table, "fanSpee"));
+    CHECK_EQUAL(0, callFound(&table, "fanSpeeds"));
+    CHECK_EQUAL(0, callFound(&table, "fan_Speed"));
+    CHECK_EQUAL(0, callFound(&table, ""));
+
+    // a name inside a twin document isn't null terminated
+    const char *twin = "{\"setVoltage\":{\"value\":3}}";
+    CALLBACK_LOOKUP *entry = callbackTableFind(&table, twin + 2, 10);
+    CHECK(entry != NULL && entry->callback == second);
+    CHECK(callbackTableFind(&table, twin + 2, 9) == NULL);
+    CHECK(callbackTableFind(&table, twin + 2, 11) == NULL);
+}
+
+// names that land in the same bucket are probed past each other, also where
+// the probe wraps from the last bucket to the first
+static void testBucketCollisions() {
+    char names[3][STRING_BUFFER_16];
+    int found = 0;
+    unsigned bucket = CALLBACK_TABLE_SIZE - 1;
+    for (unsigned i = 0; found < 3; i++) {
+        snprintf(names[found], sizeof(names[found]), "method%u", i);
+        if (callbackNameHash(names[found], strlen(names[found])) % CALLBACK_TABLE_SIZE == bucket) {
+            found++;
+        }
+    }
+
+    CALLBACK_TABLE table = {};
+    CHECK(callbackTableAdd(&table, names[0], first));
+    CHECK(callbackTableAdd(&table, names[1], second));
+    CHECK(callbackTableAdd(&table, names[2], third));
+    CHECK_EQUAL(0, table.buckets[CALLBACK_TABLE_SIZE - 1]);
+    CHECK_EQUAL(1, table.buckets[0]);
+    CHECK_EQUAL(2, table.buckets[1]);
+
+    CHECK_EQUAL(1, callFound(&table, names[0]));
+    CHECK_EQUAL(2, callFound(&table, names[1]));
+    CHECK_EQUAL(3, callFound(&table, names[2]));
+
+    // a miss in the same bucket walks the chain to the empty bucket after it
+    for (unsigned i = 0; ; i++) {
+        char miss[STRING_BUFFER_16];
+        snprintf(miss, sizeof(miss), "other%u", i);
+        if (callbackNameHash(miss, strlen(miss)) % CALLBACK_TABLE_SIZE == bucket) {
+            CHECK_EQUAL(0, callFound(&table, miss));
+            break;
+        }
+    }
+}
+
+// two names with the same 32 bit hash, only the name compare tells them apart
+static void testHashCollision() {
+    CHECK_EQUAL(callbackNameHash("method412789", 12), callbackNameHash("method649192", 12));
+
+    CALLBACK_TABLE table = {};
+    CHECK(callbackTableAdd(&table, "method412789", first));
+    CHECK_EQUAL(0, callFound(&table, "method649192"));
+    CHECK(callbackTableAdd(&table, "METHOD649192", second));
+    CHECK_EQUAL(1, callFound(&table, "Method412789"));
+    CHECK_EQUAL(2, callFound(&table, "method649192"));
+}
+
+static void testFull() {
+    CALLBACK_TABLE table = {};
+    char names[MAX_CALLBACK_COUNT][STRING_BUFFER_16];
+    for (int i = 0; i < MAX_CALLBACK_COUNT; i++) {
+        snprintf(names[i], sizeof(names[i]), "property%d", i);
+        CHECK(callbackTableAdd(&table, names[i], i % 2 == 0 ? first : second));
+    }
+    CHECK_EQUAL(MAX_CALLBACK_COUNT, table.count);
+    CHECK(!callbackTableAdd(&table, "oneTooMany", third));
+    CHECK_EQUAL(MAX_CALLBACK_COUNT, table.count);
+
+    for (int i = 0; i < MAX_CALLBACK_COUNT; i++) {
+        CALLBACK_LOOKUP *entry = callbackTableFind(&table, names[i], strlen(names[i]));
+        CHECK(entry == &table.list[i]);
+    }
+    CHECK_EQUAL(0, callFound(&table, "oneTooMany"));
+    CHECK_EQUAL(0, callFound(&table, "property32"));
+}
+
+int main() {
+    testEmpty();
+    testCaseInsensitive();
+    testBucketCollisions();
+    testHashCollision();
+    testFull();
+    return hostTestResult("callbackTableTest");
+}
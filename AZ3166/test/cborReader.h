@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef CBOR_READER_H
+#define CBOR_READER_H
+
+// Decodes the CBOR (RFC 7049) the sketch sends, on the host only: the
+// receiving side of CborWriter for the tests and benchmarks. Integers, text
+// keys, definite arrays, indefinite maps and half, single and double floats;
+// anything else, or reading past the end, sets error.
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct CBOR_READER_TAG {
+    const uint8_t *position;
+    const uint8_t *end;
+    bool error;
+} CBOR_READER;
+
+#define CBOR_READER_BREAK 0xFF
+
+static inline CBOR_READER cborReaderInit(const void *data, unsigned length) {
+    CBOR_READER reader = { (const uint8_t *)data, (const uint8_t *)data + length, false };
+    return reader;
+}
+
+static inline bool cborAtEnd(const CBOR_READER *reader) {
+    return reader->error || reader->position >= reader->end;
+}
+
+static inline uint8_t cborPeek(CBOR_READER *reader) {
+    if (cborAtEnd(reader)) {
+        reader->error = true;
+        return 0;
+    }
+    return *reader->position;
+}
+
+// big endian argument of count bytes
+static inline uint64_t cborReadBytes(CBOR_READER *reader, unsigned count) {
+    if (reader->error || reader->end - reader->position < (long)count) {
+        reader->error = true;
+        return 0;
+    }
+    uint64_t value = 0;
+    for (unsigned i = 0; i < count; i++) {
+        value = (value << 8) | *reader->position++;
+    }
+    return value;
+}
+
+// the initial byte and its argument, additional info 31 (indefinite) gives argument 0
+static inline uint64_t cborReadHead(CBOR_READER *reader, uint8_t *majorType, uint8_t *info) {
+    const uint8_t initial = (uint8_t)cborReadBytes(reader, 1);
+    *majorType = initial >> 5;
+    *info = initial & 0x1F;
+    if (*info < 24 || *info == 31) return *info < 24 ? *info : 0;
+    if (*info == 24) return cborReadBytes(reader, 1);
+    if (*info == 25) return cborReadBytes(reader, 2);
+    if (*info == 26) return cborReadBytes(reader, 4);
+    if (*info == 27) return cborReadBytes(reader, 8);
+    reader->error = true;
+    return 0;
+}
+
+static inline double cborHalfToDouble(uint16_t half) {
+    const int exponent = (half >> 10) & 0x1F;
+    const int mantissa = half & 0x3FF;
+    double value;
+    if (exponent == 0) value = ldexp(mantissa, -24);
+    else if (exponent != 31) value = ldexp(mantissa + 1024, exponent - 25);
+    else value = mantissa == 0 ? INFINITY : NAN;
+    return (half & 0x8000) ? -value : value;
+}
+
+// an integer or a float
+static inline double cborReadNumber(CBOR_READER *reader) {
+    uint8_t majorType, info;
+    const uint64_t argument = cborReadHead(reader, &majorType, &info);
+    if (majorType == 0) return (double)argument;
+    if (majorType == 1) return -1.0 - (double)argument;
+    if (majorType == 7 && info == 25) return cborHalfToDouble((uint16_t)argument);
+    if (majorType == 7 && info == 26) {
+        const uint32_t bits = (uint32_t)argument;
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    if (majorType == 7 && info == 27) {
+        double value;
+        memcpy(&value, &argument, sizeof(value));
+        return value;
+    }
+    reader->error = true;
+    return 0;
+}
+
+// a definite text string, not null terminated
+static inline unsigned cborReadText(CBOR_READER *reader, const char **text) {
+    uint8_t majorType, info;
+    const uint64_t length = cborReadHead(reader, &majorType, &info);
+    if (majorType != 3 || info == 31 || reader->end - reader->position < (long)length) {
+        reader->error = true;
+        return 0;
+    }
+    *text = (const char *)reader->position;
+    reader->position += length;
+    return (unsigned)length;
+}
+
+// element count of a definite array
+static inline unsigned cborReadArray(CBOR_READER *reader) {
+    uint8_t majorType, info;
+    const uint64_t count = cborReadHead(reader, &majorType, &info);
+    if (majorType != 4 || info == 31) {
+        reader->error = true;
+    }
+    return (unsigned)count;
+}
+
+// an indefinite map, its members are read until cborReadBreak() is true
+static inline bool cborReadMapStart(CBOR_READER *reader) {
+    uint8_t majorType, info;
+    cborReadHead(reader, &majorType, &info);
+    if (majorType != 5 || info != 31) {
+        reader->error = true;
+    }
+    return !reader->error;
+}
+
+static inline bool cborReadBreak(CBOR_READER *reader) {
+    if (cborPeek(reader) == CBOR_READER_BREAK) {
+        reader->position++;
+        return true;
+    }
+    return false;
+}
+
+#endif // CBOR_READER_H
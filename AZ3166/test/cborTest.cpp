@@ -0,0 +1,257 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// CborWriter against the examples of RFC 7049 appendix A, and the CBOR
+// telemetry payload decoded back and compared with the JSON one built from
+// the same samples: every field and aggregate must carry the same value.
+
+#include "../inc/globals.h"
+#include "../inc/config.h"
+#include "../inc/cborWriter.h"
+#include "../inc/sensorTrace.h"
+#include "../inc/telemetrySampler.h"
+#include "../inc/telemetryPayload.h"
+#include "../inc/deadband.h"
+#include "cborReader.h"
+#include "hostTest.h"
+
+#define SAMPLE_INTERVAL 500
+#define SAMPLES_PER_SEND 10
+
+static bool encodes(const uint8_t *expected, unsigned expectedLength, const uint8_t *actual, unsigned length) {
+    return length == expectedLength && memcmp(expected, actual, length) == 0;
+}
+
+#define CHECK_INT(value, ...) \
+    do { \
+        const uint8_t expected[] = { __VA_ARGS__ }; \
+        uint8_t buffer[16]; \
+        CborWriter writer(buffer, sizeof(buffer)); \
+        writer.appendIntValue(value); \
+        CHECK(encodes(expected, sizeof(expected), buffer, writer.getLength())); \
+        CBOR_READER reader = cborReaderInit(buffer, writer.getLength()); \
+        CHECK(cborReadNumber(&reader) == (double)(value) && !reader.error && cborAtEnd(&reader)); \
+    } while (0)
+
+#define CHECK_FLOAT(value, ...) \
+    do { \
+        const uint8_t expected[] = { __VA_ARGS__ }; \
+        uint8_t buffer[16]; \
+        CborWriter writer(buffer, sizeof(buffer)); \
+        writer.appendFloatValue(value); \
+        CHECK(encodes(expected, sizeof(expected), buffer, writer.getLength())); \
+        CBOR_READER reader = cborReaderInit(buffer, writer.getLength()); \
+        const double decoded = cborReadNumber(&reader); \
+        CHECK(!reader.error && cborAtEnd(&reader)); \
+        CHECK(isnan(value) ? isnan(decoded) : decoded == (double)(value) && signbit(decoded) == signbit(value)); \
+    } while (0)
+
+static void testRfcExamples() {
+    CHECK_INT(0, 0x00);
+    CHECK_INT(1, 0x01);
+    CHECK_INT(10, 0x0a);
+    CHECK_INT(23, 0x17);
+    CHECK_INT(24, 0x18, 0x18);
+    CHECK_INT(25, 0x18, 0x19);
+    CHECK_INT(100, 0x18, 0x64);
+    CHECK_INT(1000, 0x19, 0x03, 0xe8);
+    CHECK_INT(1000000, 0x1a, 0x00, 0x0f, 0x42, 0x40);
+    CHECK_INT(-1, 0x20);
+    CHECK_INT(-10, 0x29);
+    CHECK_INT(-100, 0x38, 0x63);
+    CHECK_INT(-1000, 0x39, 0x03, 0xe7);
+    CHECK_INT(2147483647, 0x1a, 0x7f, 0xff, 0xff, 0xff);
+    CHECK_INT(-2147483647 - 1, 0x3a, 0x7f, 0xff, 0xff, 0xff);
+
+    CHECK_FLOAT(0.0f, 0xf9, 0x00, 0x00);
+    CHECK_FLOAT(-0.0f, 0xf9, 0x80, 0x00);
+    CHECK_FLOAT(1.0f, 0xf9, 0x3c, 0x00);
+    CHECK_FLOAT(1.5f, 0xf9, 0x3e, 0x00);
+    CHECK_FLOAT(65504.0f, 0xf9, 0x7b, 0xff);
+    CHECK_FLOAT(100000.0f, 0xfa, 0x47, 0xc3, 0x50, 0x00);
+    CHECK_FLOAT(3.4028234663852886e+38f, 0xfa, 0x7f, 0x7f, 0xff, 0xff);
+    CHECK_FLOAT(0.00006103515625f, 0xf9, 0x04, 0x00);
+    CHECK_FLOAT(-4.0f, 0xf9, 0xc4, 0x00);
+    CHECK_FLOAT(INFINITY, 0xf9, 0x7c, 0x00);
+    CHECK_FLOAT(NAN, 0xf9, 0x7e, 0x00);
+    CHECK_FLOAT(-INFINITY, 0xf9, 0xfc, 0x00);
+    // subnormal halves aren't written, single precision keeps them exact
+    CHECK_FLOAT(5.960464477539063e-8f, 0xfa, 0x33, 0x80, 0x00, 0x00);
+    // two decimals rarely fit a half
+    CHECK_FLOAT(23.25f, 0xf9, 0x4d, 0xd0);
+    CHECK_FLOAT(23.1f, 0xfa, 0x41, 0xb8, 0xcc, 0xcd);
+}
+
+static void testMapAndOverflow() {
+    uint8_t buffer[32];
+    CborWriter writer(buffer, sizeof(buffer));
+    writer.beginMap();
+    writer.appendInt("a", 1);
+    writer.appendKey("b", 1);
+    writer.beginArray(2);
+    writer.appendIntValue(2);
+    writer.appendIntValue(3);
+    writer.endMap();
+    const uint8_t expected[] = { 0xbf, 0x61, 0x61, 0x01, 0x61, 0x62, 0x82, 0x02, 0x03, 0xff };
+    CHECK(encodes(expected, sizeof(expected), buffer, writer.getLength()));
+    CHECK(!writer.hasOverflow());
+
+    // nothing past a write that didn't fit, not even a shorter one
+    CborWriter small(buffer, 4);
+    small.beginMap();
+    small.appendInt("key", 1);
+    small.appendIntValue(0);
+    CHECK(small.hasOverflow());
+    CHECK_EQUAL(2, small.getLength()); // the map and the key's head
+}
+
+typedef struct DECODED_FIELD_TAG {
+    char name[STRING_BUFFER_32];
+    double values[FIELD_KEY_COUNT];
+    unsigned count;
+} DECODED_FIELD;
+
+// the telemetry map: every member a number or an array of numbers
+static unsigned decodePayload(const char *payload, unsigned length, DECODED_FIELD *fields, unsigned maxFields) {
+    CBOR_READER reader = cborReaderInit(payload, length);
+    unsigned count = 0;
+    if (!cborReadMapStart(&reader)) return 0;
+
+    while (!cborReadBreak(&reader) && !reader.error && count < maxFields) {
+        DECODED_FIELD *field = &fields[count++];
+        const char *name = "";
+        const unsigned nameLength = cborReadText(&reader, &name);
+        snprintf(field->name, sizeof(field->name), "%.*s", nameLength, name);
+
+        if ((cborPeek(&reader) >> 5) == 4) {
+            field->count = cborReadArray(&reader);
+            if (field->count > FIELD_KEY_COUNT) return 0;
+            for (unsigned i = 0; i < field->count; i++) {
+                field->values[i] = cborReadNumber(&reader);
+            }
+        } else {
+            field->count = 1;
+            field->values[0] = cborReadNumber(&reader);
+        }
+    }
+    return !reader.error && cborAtEnd(&reader) ? count : 0;
+}
+
+static bool jsonNumber(const char *json, const char *name, const char *suffix, double *value) {
+    char pattern[STRING_BUFFER_128];
+    snprintf(pattern, sizeof(pattern), "\"%.32s%.8s\":", name, suffix);
+    const char *found = strstr(json, pattern);
+    if (found == NULL) return false;
+    *value = strtod(found + strlen(pattern), NULL);
+    return true;
+}
+
+// the JSON text has the decimals of the field, the CBOR float the nearest float to it
+static void checkSameValue(const char *json, const char *name, const char *suffix, double cborValue) {
+    double jsonValue = 0;
+    CHECK(jsonNumber(json, name, suffix, &jsonValue));
+    CHECK(fabs(cborValue - jsonValue) <= 1e-6 * fmax(1.0, fabs(jsonValue)));
+}
+
+static const char *aggregateSuffixes[FIELD_KEY_COUNT] = { "", "Min", "Max", "Mean" };
+
+static void samplePeriod(uint32_t start) {
+    for (int i = 0; i < SAMPLES_PER_SEND; i++) {
+        sensorReplaySeek(start + i * SAMPLE_INTERVAL);
+        samplerTakeSample();
+    }
+}
+
+// the same samples encoded twice
+static void checkPayloads(uint32_t start, bool aggregate, unsigned *jsonBytes, unsigned *cborBytes) {
+    static char json[STRING_BUFFER_4096];
+    static char cbor[STRING_BUFFER_4096];
+    unsigned fieldCount;
+
+    samplePeriod(start);
+    const unsigned jsonLength = buildTelemetryPayload(json, sizeof(json) - 1, MESSAGE_FORMAT_JSON, aggregate, &fieldCount);
+    json[jsonLength] = char(0);
+    CHECK_EQUAL(TELEMETRY_FIELD_COUNT, fieldCount);
+    samplePeriod(start);
+    const unsigned cborLength = buildTelemetryPayload(cbor, sizeof(cbor), MESSAGE_FORMAT_CBOR, aggregate, &fieldCount);
+    CHECK(jsonLength > 0 && cborLength > 0);
+    *jsonBytes = jsonLength;
+    *cborBytes = cborLength;
+
+    DECODED_FIELD fields[TELEMETRY_FIELD_COUNT + 2];
+    const unsigned decoded = decodePayload(cbor, cborLength, fields, TELEMETRY_FIELD_COUNT + 2);
+    CHECK_EQUAL(TELEMETRY_FIELD_COUNT + (aggregate ? 1 : 0), decoded);
+
+    unsigned values = 0;
+    for (unsigned f = 0; f < decoded; f++) {
+        const DECODED_FIELD &field = fields[f];
+        if (f < TELEMETRY_FIELD_COUNT) {
+            CHECK_STRING(telemetryFields[f].name, field.name);
+            CHECK_EQUAL(aggregate ? FIELD_KEY_COUNT : 1, field.count);
+        }
+        for (unsigned i = 0; i < field.count; i++) {
+            checkSameValue(json, field.name, field.count > 1 ? aggregateSuffixes[i] : "", field.values[i]);
+            values++;
+        }
+    }
+
+    // and nothing in the JSON that isn't in the CBOR
+    unsigned members = 0;
+    for (const char *c = json; *c != char(0); c++) {
+        members += *c == ':';
+    }
+    CHECK_EQUAL(members, values);
+}
+
+static const char *writeTrace() {
+    static const char *path = "cborTest.trace";
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    SENSOR_TRACE_HEADER header = { SENSOR_TRACE_MAGIC, SENSOR_TRACE_VERSION, sizeof(SENSOR_TRACE_RECORD) };
+    fwrite(&header, sizeof(header), 1, file);
+    for (uint32_t time = 0; time < 10 * 60 * 1000; time += SAMPLE_INTERVAL) {
+        const double phase = time / 60000.0;
+        SENSOR_TRACE_RECORD record;
+        record.time = time;
+        record.humidity = (int32_t)(4500 + 300 * sin(phase * 7));
+        record.temperature = (int32_t)(-250 + 3000 * sin(phase * 3));
+        record.pressure = (int32_t)(101325 + 400 * sin(phase * 5));
+        for (int axis = 0; axis < 3; axis++) {
+            record.magnetometer[axis] = (int32_t)(30000 * sin(phase * 11 + axis));
+            record.accelerometer[axis] = (int32_t)(2000 * sin(phase * 13 + axis));
+            record.gyroscope[axis] = (int32_t)(70000 * sin(phase * 17 + axis));
+        }
+        fwrite(&record, sizeof(record), 1, file);
+    }
+    fclose(file);
+    return path;
+}
+
+static void testPayloadRoundTrip() {
+    const char *path = writeTrace();
+    CHECK(path != NULL && sensorReplayOpen(path, 0));
+    samplerInit(TEMP_CHECKED | HUMIDITY_CHECKED | PRESSURE_CHECKED | ACCEL_CHECKED | GYRO_CHECKED | MAG_CHECKED);
+    deadbandInit(false);
+
+    unsigned long jsonTotal = 0, cborTotal = 0;
+    const int sends = 100;
+    for (int send = 0; send < sends; send++) {
+        unsigned jsonBytes, cborBytes;
+        checkPayloads(send * SAMPLES_PER_SEND * SAMPLE_INTERVAL, send % 4 != 3, &jsonBytes, &cborBytes);
+        CHECK(cborBytes < jsonBytes);
+        jsonTotal += jsonBytes;
+        cborTotal += cborBytes;
+    }
+    printf("  %d payloads, json %lu bytes, cbor %lu bytes\n", sends, jsonTotal / sends, cborTotal / sends);
+    sensorReplayClose();
+}
+
+int main() {
+    testRfcExamples();
+    testMapAndOverflow();
+    testPayloadRoundTrip();
+    return hostTestResult("cborTest");
+}
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Deadband decisions on the temperature field, 0.2 C by default
+
+#include "../inc/globals.h"
+#include "../inc/deadband.h"
+#include "../inc/fixedPoint.h"
+#include "hostTest.h"
+
+static FIELD_AGGREGATE temperature(float last, float min, float max) {
+    const unsigned decimals = telemetryFields[TEMP_FIELD].decimals;
+    FIELD_AGGREGATE values;
+    values.last = toFixed(last, decimals);
+    values.min = toFixed(min, decimals);
+    values.max = toFixed(max, decimals);
+    values.mean = values.last;
+    return values;
+}
+
+static FIELD_AGGREGATE temperature(float value) {
+    return temperature(value, value, value);
+}
+
+// sends and commits like telemetryTask does
+static bool send(const FIELD_AGGREGATE &values, unsigned long now) {
+    const bool sent = deadbandShouldSend(TEMP_FIELD, values, now);
+    deadbandCommit(now);
+    return sent;
+}
+
+static void testLastValue() {
+    deadbandInit(true);
+    CHECK(send(temperature(23.0f), 0));
+    CHECK(!send(temperature(23.1f), 1000));
+    CHECK(!send(temperature(22.9f), 2000));
+    CHECK(send(temperature(23.3f), 3000));
+    CHECK(!send(temperature(23.2f), 4000)); // compared with 23.3 now
+    CHECK_EQUAL(3, getDeadbandSuppressedCount(TEMP_FIELD));
+
+    // the heartbeat sends it anyway
+    CHECK(send(temperature(23.3f), 3000 + DEADBAND_DEFAULT_HEARTBEAT));
+
+    // disabled sends everything
+    deadbandInit(false);
+    CHECK(send(temperature(23.0f), 0));
+    CHECK(send(temperature(23.0f), 1000));
+}
+
+// a spike between two sends shows in min or max while the last value is back
+static void testMinMax() {
+    deadbandInit(true);
+    CHECK(send(temperature(23.0f), 0));
+    CHECK(send(temperature(23.0f, 23.0f, 24.0f), 1000));
+    CHECK(send(temperature(23.0f, 22.0f, 23.0f), 2000));
+    CHECK(!send(temperature(23.0f, 22.9f, 23.1f), 3000));
+}
+
+// a payload that wasn't sent leaves the last sent value as it was
+static void testCommitOnlyAfterSend() {
+    deadbandInit(true);
+    CHECK(send(temperature(23.0f), 0));
+
+    CHECK(deadbandShouldSend(TEMP_FIELD, temperature(23.5f), 1000));
+    deadbandDiscard();
+    CHECK(!send(temperature(23.1f), 2000)); // still against 23.0
+    CHECK(send(temperature(23.5f), 3000));
+
+    // nothing committed, the heartbeat keeps counting from the last send
+    CHECK(deadbandShouldSend(TEMP_FIELD, temperature(23.5f), 3000 + DEADBAND_DEFAULT_HEARTBEAT));
+    deadbandDiscard();
+    CHECK(deadbandShouldSend(TEMP_FIELD, temperature(23.5f), 3001 + DEADBAND_DEFAULT_HEARTBEAT));
+
+    // a suppressed field isn't taken on a later commit
+    deadbandDiscard();
+    CHECK(!send(temperature(23.6f), 4000));
+    CHECK(!send(temperature(23.3f), 5000)); // against 23.5
+}
+
+int main() {
+    testLastValue();
+    testMinMax();
+    testCommitOnlyAfterSend();
+    return hostTestResult("deadbandTest");
+}
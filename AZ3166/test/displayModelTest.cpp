@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The display model: only changed lines reach the screen, and a flush the
+// refresh cap skips is run again rather than waiting for the next page.
+
+#include "../inc/globals.h"
+#include "../inc/displayModel.h"
+#include "OledDisplay.h"
+#include "hostTest.h"
+
+#define TASK_PERIOD 250 // displayInterval of mainTelemetry.cpp
+
+static void testChangedLinesOnly() {
+    displayModelInit(DISPLAY_MIN_REFRESH_INTERVAL);
+    displayModelSetText("one\r\ntwo\r\nthree\r\nfour");
+    CHECK_EQUAL(4, displayModelFlush(1000));
+
+    displayModelSetLine(2, "3");
+    CHECK_EQUAL(1, displayModelFlush(1000 + TASK_PERIOD));
+    CHECK_EQUAL('3', Screen.lines[2][0]);
+    CHECK_EQUAL(' ', Screen.lines[2][1]);
+
+    // the screen was drawn on behind the model
+    displayModelClear();
+    CHECK_EQUAL(4, displayModelFlush(1000 + 2 * TASK_PERIOD));
+}
+
+// a task run a few ms late, or early after one that was late, isn't capped
+static void testTaskJitterNotSkipped() {
+    CHECK(DISPLAY_MIN_REFRESH_INTERVAL < TASK_PERIOD);
+    displayModelInit(DISPLAY_MIN_REFRESH_INTERVAL);
+    const unsigned long skipped = getDisplayFlushesSkipped();
+
+    unsigned long now = 5000;
+    for (int run = 0; run < 20; run++) {
+        char text[STRING_BUFFER_16];
+        snprintf(text, sizeof(text), "run %d", run);
+        displayModelSetLine(0, text);
+        CHECK_EQUAL(run == 0 ? 4 : 1, displayModelFlush(now));
+        CHECK_EQUAL(0, displayModelFlushDelay(now));
+        now += run % 2 == 0 ? TASK_PERIOD + 30 : TASK_PERIOD - 30;
+    }
+    CHECK_EQUAL(skipped, getDisplayFlushesSkipped());
+}
+
+static void testSkippedFlushRetried() {
+    displayModelInit(DISPLAY_MIN_REFRESH_INTERVAL);
+    CHECK_EQUAL(4, displayModelFlush(10000));
+    CHECK_EQUAL(0, displayModelFlushDelay(10000));
+
+    displayModelSetLine(1, "changed");
+    CHECK_EQUAL(0, displayModelFlush(10050));
+    CHECK_EQUAL(DISPLAY_MIN_REFRESH_INTERVAL - 50, displayModelFlushDelay(10050));
+
+    // the retry sends what the skipped flush would have
+    const unsigned long retry = 10050 + displayModelFlushDelay(10050);
+    CHECK_EQUAL(1, displayModelFlush(retry));
+    CHECK_EQUAL('c', Screen.lines[1][0]);
+    CHECK_EQUAL(0, displayModelFlushDelay(retry));
+}
+
+int main() {
+    testChangedLinesOnly();
+    testTaskJitterNotSkipped();
+    testSkippedFlushRetried();
+    return hostTestResult("displayModelTest");
+}
@@ -0,0 +1,230 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// fixedFft.cpp and the vibration analysis against a double precision DFT.
+// Built twice, as fftTest on the portable code and as fftDspTest with
+// __ARM_FEATURE_DSP on the Cortex-M4 intrinsics emulated in host/cmsis.h.
+
+#include "../inc/globals.h"
+#include "../inc/fixedFft.h"
+#include "../inc/vibration.h"
+#include "../inc/motionFifo.h"
+#include "hostTest.h"
+
+#define AXIS_COUNT 3
+#define ODR_MILLI_HZ 416000
+#define SENSITIVITY 61 // ug per LSB at +-2 g
+#define WINDOWS 4
+
+static const double pi = 3.14159265358979323846;
+
+// |DFT / FFT_SIZE|^2 of bins 0 .. FFT_SIZE / 2
+static void referencePower(const double *samples, double *power) {
+    for (int k = 0; k < FFT_BINS; k++) {
+        double re = 0, im = 0;
+        for (int n = 0; n < FFT_SIZE; n++) {
+            re += samples[n] * cos(2 * pi * k * n / FFT_SIZE);
+            im -= samples[n] * sin(2 * pi * k * n / FFT_SIZE);
+        }
+        re /= FFT_SIZE;
+        im /= FFT_SIZE;
+        power[k] = re * re + im * im;
+    }
+}
+
+static unsigned strongestBin(const double *power) {
+    unsigned peak = 1;
+    for (unsigned k = 2; k < FFT_BINS; k++) {
+        if (power[k] > power[peak]) peak = k;
+    }
+    return peak;
+}
+
+// largest magnitude error of any bin, in Q15 LSB of the scaled DFT
+static double checkSpectrum(const char *name, const int16_t *samples) {
+    static uint32_t power[FFT_BINS];
+    double input[FFT_SIZE], expected[FFT_BINS];
+    for (int n = 0; n < FFT_SIZE; n++) {
+        input[n] = samples[n];
+    }
+
+    fftRealPower(samples, power);
+    referencePower(input, expected);
+
+    double worst = 0;
+    for (int k = 0; k < FFT_BINS; k++) {
+        worst = max(worst, fabs(sqrt((double)power[k]) - sqrt(expected[k])));
+    }
+    // every halving stage truncates, a few LSB of the 16384 a full scale tone reaches
+    CHECK(worst < 8.0);
+    if (worst >= 8.0) {
+        printf("  %s: bin error %.2f\n", name, worst);
+    }
+
+    // the peak search of the vibration analysis skips DC
+    unsigned peak = 1;
+    for (unsigned k = 2; k < FFT_BINS; k++) {
+        if (power[k] > power[peak]) peak = k;
+    }
+    if (expected[strongestBin(expected)] > 100 * 100) {
+        CHECK_EQUAL(strongestBin(expected), peak);
+    }
+    return worst;
+}
+
+static int16_t clampQ15(double value) {
+    return (int16_t)(value > 32767 ? 32767 : value < -32767 ? -32767 : floor(value + 0.5));
+}
+
+static void testSpectrum() {
+    int16_t samples[FFT_SIZE];
+    double worst = 0;
+
+    // a full scale tone on every bin, the DC and Nyquist bins included
+    for (int bin = 0; bin <= FFT_SIZE / 2; bin++) {
+        for (int n = 0; n < FFT_SIZE; n++) {
+            samples[n] = clampQ15(32767 * cos(2 * pi * bin * n / FFT_SIZE + 0.3));
+        }
+        worst = max(worst, checkSpectrum("tone", samples));
+    }
+
+    // tones between bins, mixed with a weaker one
+    for (double frequency = 3.3; frequency < FFT_SIZE / 2 - 10; frequency += 7.7) {
+        for (int n = 0; n < FFT_SIZE; n++) {
+            samples[n] = clampQ15(24000 * sin(2 * pi * frequency * n / FFT_SIZE) +
+                                  6000 * sin(2 * pi * (frequency + 5.5) * n / FFT_SIZE));
+        }
+        worst = max(worst, checkSpectrum("two tones", samples));
+    }
+
+    // a tone in noise
+    srand(7);
+    for (int n = 0; n < FFT_SIZE; n++) {
+        samples[n] = clampQ15(16000 * sin(2 * pi * 40 * n / FFT_SIZE) + (rand() % 8001 - 4000));
+    }
+    worst = max(worst, checkSpectrum("noise", samples));
+
+    printf("  largest bin magnitude error %.2f LSB\n", worst);
+}
+
+// the FIFO the vibration analysis reads, filled with generated windows
+static MOTION_SAMPLE generated[WINDOWS * FFT_SIZE];
+static unsigned generatedRead = 0;
+
+bool isMotionFifoEnabled() { return true; }
+int motionAddReader() { return 0; }
+int32_t getMotionAccelSensitivity() { return SENSITIVITY; }
+uint32_t getMotionOdrMilliHz() { return ODR_MILLI_HZ; }
+unsigned long getMotionReaderOverrunCount(int reader) { return 0; }
+
+unsigned motionRead(int reader, MOTION_SAMPLE *samples, unsigned maxSamples) {
+    const unsigned count = min(maxSamples, WINDOWS * FFT_SIZE - generatedRead);
+    memcpy(samples, generated + generatedRead, count * sizeof(MOTION_SAMPLE));
+    generatedRead += count;
+    return count;
+}
+
+static void generateMotion() {
+    const double odr = ODR_MILLI_HZ / 1000.0;
+    srand(11);
+    for (int i = 0; i < WINDOWS * FFT_SIZE; i++) {
+        const double t = i / odr;
+        // x a 30 Hz hum, y 75 Hz and noise, z gravity and a slow 5 Hz sway plus 150 Hz
+        const double axes[AXIS_COUNT] = {
+            2000 * sin(2 * pi * 30 * t),
+            800 * sin(2 * pi * 75 * t) + (rand() % 201 - 100),
+            16393 + 300 * sin(2 * pi * 5 * t) + 120 * sin(2 * pi * 150 * t)
+        };
+        for (int axis = 0; axis < AXIS_COUNT; axis++) {
+            generated[i].accel[axis] = (int16_t)floor(axes[axis] + 0.5);
+            generated[i].gyro[axis] = 0;
+        }
+    }
+}
+
+// the analysis of vibration.cpp in double precision, energies in (1/100 mg)^2
+static void referenceVibration(double *rms, double *bands, double *peakFrequency) {
+    static const double bandLimits[VIBRATION_BAND_COUNT - 1] = { 10, 50, 100 };
+    const unsigned binMilliHz = ODR_MILLI_HZ / FFT_SIZE;
+    const double lsbEnergy = SENSITIVITY * SENSITIVITY / 100.0;
+
+    double rmsEnergy = 0, bandEnergy[VIBRATION_BAND_COUNT] = { 0 }, peakPower = 0;
+    unsigned peakBin = 0;
+
+    for (int window = 0; window < WINDOWS; window++) {
+        for (int axis = 0; axis < AXIS_COUNT; axis++) {
+            const MOTION_SAMPLE *raw = generated + window * FFT_SIZE;
+            int32_t sum = 0;
+            for (int n = 0; n < FFT_SIZE; n++) {
+                sum += raw[n].accel[axis];
+            }
+            const int32_t mean = sum / FFT_SIZE;
+
+            double windowed[FFT_SIZE], power[FFT_BINS], variance = 0;
+            for (int n = 0; n < FFT_SIZE; n++) {
+                const double centered = raw[n].accel[axis] - mean;
+                variance += centered * centered / FFT_SIZE;
+                windowed[n] = centered * (0.5 - 0.5 * cos(2 * pi * n / FFT_SIZE));
+            }
+            rmsEnergy += variance * lsbEnergy;
+            referencePower(windowed, power);
+
+            int band = 0;
+            for (unsigned k = 1; k < FFT_BINS; k++) {
+                while (band < VIBRATION_BAND_COUNT - 1 && k * binMilliHz >= bandLimits[band] * 1000) {
+                    band++;
+                }
+                bandEnergy[band] += power[k] * (k < FFT_BINS - 1 ? 2 : 1) * 8 / 3 * lsbEnergy;
+                if (power[k] > peakPower) {
+                    peakPower = power[k];
+                    peakBin = k;
+                }
+            }
+        }
+    }
+
+    *rms = sqrt(rmsEnergy / WINDOWS);
+    for (int b = 0; b < VIBRATION_BAND_COUNT; b++) {
+        bands[b] = sqrt(bandEnergy[b] / WINDOWS);
+    }
+    *peakFrequency = (double)peakBin * binMilliHz / 10;
+}
+
+static void testVibration() {
+    generateMotion();
+    CHECK(vibrationInit());
+    vibrationProcess();
+
+    VIBRATION_SUMMARY summary, empty;
+    CHECK(vibrationTakeSummary(&summary));
+    CHECK_EQUAL(WINDOWS, summary.windowCount);
+    CHECK(!vibrationTakeSummary(&empty));
+
+    double rms, bands[VIBRATION_BAND_COUNT], peakFrequency;
+    referenceVibration(&rms, bands, &peakFrequency);
+
+    // rms is exact up to the integer square root
+    CHECK(fabs(summary.rms - rms) <= 1);
+    CHECK_EQUAL((int32_t)peakFrequency, summary.peakFrequency);
+
+    printf("  rms %d (%.1f), peak %d (%.1f), bands", summary.rms, rms, summary.peakFrequency, peakFrequency);
+    for (int b = 0; b < VIBRATION_BAND_COUNT; b++) {
+        printf(" %d (%.1f)", summary.bands[b], bands[b]);
+        // within 1 % of the band or 0.1 % of the total
+        CHECK(fabs(summary.bands[b] - bands[b]) <= max(bands[b] * 0.01, rms * 0.001));
+    }
+    printf("\n");
+}
+
+int main() {
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+    const char *name = "fftDspTest";
+#else
+    const char *name = "fftTest";
+#endif
+
+    fftInit();
+    testSpectrum();
+    testVibration();
+    return hostTestResult(name);
+}
@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Number formatting of the telemetry payload: formatFixed() on the scaled
+// integers against both paths it replaced, the old dtostrf() that String(float)
+// and appendFloatValue() went through for the two decimal readings, and the
+// digit at a time loop of appendIntValue() for the motion axes.
+
+#include "../inc/globals.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/utility.h"
+#include "oldDtostrf.h"
+#include "hostTest.h"
+
+#define VALUE_COUNT 100000
+#define ROUNDS 20
+
+// appendIntValue() before formatFixed()
+static unsigned oldFormatInt(int value, char *buffer) {
+    char number[STRING_BUFFER_16];
+    char *digit = number + sizeof(number);
+    unsigned magnitude = value < 0 ? 0U - (unsigned)value : (unsigned)value;
+
+    do {
+        *--digit = '0' + (magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (value < 0) {
+        *--digit = '-';
+    }
+
+    const unsigned length = (unsigned)(number + sizeof(number) - digit);
+    memcpy(buffer, digit, length);
+    buffer[length] = char(0);
+    return length;
+}
+
+static volatile unsigned sink = 0;
+
+#define TIME(label, count, statement) \
+    do { \
+        const uint64_t start = hostNanoseconds(), startCycles = hostCycles(); \
+        for (int round = 0; round < ROUNDS; round++) { \
+            for (int i = 0; i < (count); i++) { \
+                statement; \
+                sink = sink + (unsigned char)text[0]; \
+            } \
+        } \
+        const double calls = (double)ROUNDS * (count); \
+        printf("%-28s %6.1f ns %6.0f cycles\n", label, (hostNanoseconds() - start) / calls, \
+               (hostCycles() - startCycles) / calls); \
+    } while (0)
+
+int main() {
+    // humidity, temperature and pressure in hundredths, the motion axes in whole units
+    static int32_t readings[VALUE_COUNT];
+    static float readingFloats[VALUE_COUNT];
+    static int32_t axes[VALUE_COUNT];
+    srand(3);
+    for (int i = 0; i < VALUE_COUNT; i++) {
+        switch (i % 3) {
+        case 0: readings[i] = rand() % 10001; break;
+        case 1: readings[i] = rand() % 16001 - 4000; break;
+        default: readings[i] = 26000 + rand() % 100001; break;
+        }
+        readingFloats[i] = fixedToFloat(readings[i], 2);
+        axes[i] = rand() % 4000001 - 2000000;
+    }
+
+    // the text is the same before it is timed
+    unsigned mismatches = 0;
+    char text[STRING_BUFFER_32], expected[STRING_BUFFER_32];
+    for (int i = 0; i < VALUE_COUNT; i++) {
+        formatFixed(readings[i], 2, 2, expected);
+        mismatches += strcmp(expected, dtostrf(readingFloats[i], 4, 2, text)) != 0;
+        formatFixed(axes[i], 0, 0, expected);
+        oldFormatInt(axes[i], text);
+        mismatches += strcmp(expected, text) != 0;
+    }
+
+    printf("values              %d, %u mismatches\n", VALUE_COUNT, mismatches);
+    TIME("two decimals  old dtostrf", VALUE_COUNT, oldDtostrf(readingFloats[i], 4, 2, text));
+    TIME("two decimals  dtostrf", VALUE_COUNT, dtostrf(readingFloats[i], 4, 2, text));
+    TIME("two decimals  formatFixed", VALUE_COUNT, formatFixed(readings[i], 2, 2, text));
+    TIME("integer       old loop", VALUE_COUNT, oldFormatInt(axes[i], text));
+    TIME("integer       formatFixed", VALUE_COUNT, formatFixed(axes[i], 0, 0, text));
+    return mismatches == 0 ? 0 : 1;
+}
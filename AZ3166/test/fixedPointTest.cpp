@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The scaled integer helpers of fixedPoint.cpp against 64 bit integer
+// arithmetic and printf over whole ranges of values, and the dtostrf rebuilt
+// on them against the one it replaced wherever that one was right.
+
+#include "../inc/globals.h"
+#include "../inc/fixedPoint.h"
+#include "../inc/utility.h"
+#include "oldDtostrf.h"
+#include "hostTest.h"
+
+// every value in [-RANGE, RANGE] at every number of decimals
+#define RANGE 500000
+
+// mismatches are counted, only the first few are printed
+static unsigned reported = 0;
+
+#define CHECK_TEXT(expected, actual, value) \
+    do { \
+        hostChecks++; \
+        if (strcmp((expected), (actual)) != 0) { \
+            hostFailures++; \
+            if (reported++ < 10) printf("FAIL %s:%d: %.17g expected \"%s\" got \"%s\"\n", \
+                                        __FILE__, __LINE__, (double)(value), (expected), (actual)); \
+        } \
+    } while (0)
+
+// the digits of value with a decimal point decimals from the end, from printf
+static void referenceFixed(int64_t value, unsigned decimals, char *buffer) {
+    const int64_t scale = fixedScales[decimals];
+    const uint64_t magnitude = value < 0 ? -value : value;
+    if (decimals == 0) {
+        sprintf(buffer, "%s%llu", value < 0 ? "-" : "", (unsigned long long)magnitude);
+    } else {
+        sprintf(buffer, "%s%llu.%0*llu", value < 0 ? "-" : "", (unsigned long long)(magnitude / scale),
+                (int)decimals, (unsigned long long)(magnitude % scale));
+    }
+}
+
+// half away from zero in 64 bits
+static int64_t referenceRescale(int64_t value, unsigned decimals, unsigned newDecimals) {
+    if (newDecimals >= decimals) {
+        return value * (int64_t)fixedScales[newDecimals - decimals];
+    }
+    const int64_t divisor = fixedScales[decimals - newDecimals];
+    const int64_t magnitude = ((value < 0 ? -value : value) + divisor / 2) / divisor;
+    return value < 0 ? -magnitude : magnitude;
+}
+
+static void checkFormat(int32_t value, unsigned decimals, unsigned precision) {
+    char expected[FIXED_FORMAT_SIZE + 8], actual[FIXED_FORMAT_SIZE];
+    int64_t rounded = referenceRescale(value, decimals, precision);
+    referenceFixed(rounded, precision, expected);
+
+    const unsigned length = formatFixed(value, decimals, precision, actual);
+    CHECK_TEXT(expected, actual, value);
+    CHECK_EQUAL(strlen(expected), length);
+}
+
+// formatted text parses back to the same scaled integer
+static void testFormatRoundTrip() {
+    for (unsigned decimals = 0; decimals <= FIXED_MAX_DECIMALS; decimals++) {
+        for (int32_t value = -RANGE; value <= RANGE; value++) {
+            checkFormat(value, decimals, decimals);
+        }
+    }
+
+    // the ends of int32 and around the powers of ten
+    const int32_t edges[] = { INT32_MIN, INT32_MIN + 1, INT32_MAX, INT32_MAX - 1, -1000000000, 999999999 };
+    for (unsigned decimals = 0; decimals <= FIXED_MAX_DECIMALS; decimals++) {
+        for (unsigned i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+            checkFormat(edges[i], decimals, decimals);
+        }
+        for (unsigned power = 1; power <= FIXED_MAX_DECIMALS; power++) {
+            for (int delta = -1; delta <= 1; delta++) {
+                checkFormat((int32_t)fixedScales[power] + delta, decimals, decimals);
+                checkFormat(-(int32_t)fixedScales[power] + delta, decimals, decimals);
+            }
+        }
+    }
+}
+
+// fewer or more decimals than the value has, rounding half away from zero
+static void testFormatPrecision() {
+    for (unsigned decimals = 0; decimals <= 4; decimals++) {
+        for (unsigned precision = 0; precision <= FIXED_MAX_DECIMALS; precision++) {
+            for (int32_t value = -RANGE / 10; value <= RANGE / 10; value++) {
+                checkFormat(value, decimals, precision);
+            }
+        }
+    }
+
+    char text[FIXED_FORMAT_SIZE];
+    formatFixed(-4, 2, 1, text);
+    CHECK_STRING("0.0", text);
+    formatFixed(-5, 2, 1, text);
+    CHECK_STRING("-0.1", text);
+    formatFixed(-4, 1, 0, text);
+    CHECK_STRING("0", text); // never "-0"
+    formatFixed(INT32_MIN, 9, 0, text);
+    CHECK_STRING("-2", text);
+    formatFixed(INT32_MAX, 0, 9, text);
+    CHECK_STRING("2147483647.000000000", text);
+}
+
+static void testRescale() {
+    for (unsigned decimals = 0; decimals <= FIXED_MAX_DECIMALS; decimals++) {
+        for (unsigned newDecimals = 0; newDecimals <= decimals; newDecimals++) {
+            for (int32_t value = -RANGE / 10; value <= RANGE / 10; value++) {
+                CHECK_EQUAL(referenceRescale(value, decimals, newDecimals), rescaleFixed(value, decimals, newDecimals));
+            }
+            CHECK_EQUAL(referenceRescale(INT32_MIN, decimals, newDecimals), rescaleFixed(INT32_MIN, decimals, newDecimals));
+            CHECK_EQUAL(referenceRescale(INT32_MAX, decimals, newDecimals), rescaleFixed(INT32_MAX, decimals, newDecimals));
+        }
+    }
+    // more decimals, as long as the result fits
+    CHECK_EQUAL(-123400, rescaleFixed(-1234, 1, 3));
+    CHECK_EQUAL(2000000000, rescaleFixed(2, 0, 9));
+}
+
+// every scaled integer a float holds to within a quarter step comes back
+static void testFloatRoundTrip() {
+    for (unsigned decimals = 0; decimals <= 3; decimals++) {
+        const int32_t limit = (1 << 22) >> decimals;
+        for (int32_t value = -limit; value <= limit; value++) {
+            CHECK_EQUAL(value, toFixed(fixedToFloat(value, decimals), decimals));
+        }
+    }
+    CHECK_EQUAL(2481, toFixed(24.81f, 2));
+    CHECK_EQUAL(-2481, toFixed(-24.81f, 2));
+    CHECK_EQUAL(3, toFixed(0.025f, 2)); // 0.0250000004
+    CHECK_EQUAL(-3, toFixed(-0.025f, 2));
+    CHECK_EQUAL(101325, toFixed(1013.25f, 2));
+}
+
+static void testUnsignedAndSqrt() {
+    char expected[STRING_BUFFER_32], actual[STRING_BUFFER_32];
+    for (uint32_t value = 0; value <= RANGE; value++) {
+        const unsigned minDigits = value % 12;
+        sprintf(expected, "%0*u", (int)minDigits, value);
+        actual[formatUnsigned(value, minDigits, actual)] = char(0);
+        CHECK_TEXT(expected, actual, value);
+    }
+    actual[formatUnsigned(UINT32_MAX, 1, actual)] = char(0);
+    CHECK_STRING("4294967295", actual);
+
+    for (uint64_t value = 0; value <= RANGE; value++) {
+        const uint64_t root = integerSqrt(value);
+        CHECK(root * root <= value && (root + 1) * (root + 1) > value);
+    }
+    // squares and their neighbours up to 2^64
+    for (uint64_t root = 1; root < 0x100000000ULL; root += root / 7 + 1) {
+        CHECK_EQUAL(root, integerSqrt(root * root));
+        CHECK_EQUAL(root - 1, integerSqrt(root * root - 1));
+        if (root < 0xFFFFFFFFULL) {
+            CHECK_EQUAL(root, integerSqrt(root * root + 2 * root));
+        }
+    }
+    CHECK_EQUAL(0xFFFFFFFFULL, integerSqrt(UINT64_MAX));
+}
+
+// what the old one wrote with its two slips undone: "-" on values that round to
+// zero, and one '0' too many when every decimal is zero
+static const char *oldCorrected(char *old) {
+    const char *point = strchr(old, '.');
+    if (point != NULL && point[1] != char(0) && strspn(point + 1, "0") == strlen(point + 1)) {
+        old[strlen(old) - 1] = char(0);
+    }
+    if (old[0] == '-' && strspn(old + 1, "0.") == strlen(old + 1)) {
+        return old + 1;
+    }
+    return old;
+}
+
+// the float String(float) and the telemetry JSON format, every two decimal value
+// past the range of the sensors comes out as the scaled integer it was made from
+static void testDtostrfRoundTrip() {
+    char expected[FIXED_FORMAT_SIZE], actual[STRING_BUFFER_32], old[STRING_BUFFER_32];
+    for (int32_t value = -2 * RANGE; value <= 2 * RANGE; value++) {
+        const float number = fixedToFloat(value, 2);
+        formatFixed(value, 2, 2, expected);
+        dtostrf(number, 4, 2, actual);
+        CHECK_TEXT(expected, actual, number);
+
+        oldDtostrf(number, 4, 2, old);
+        CHECK_TEXT(expected, oldCorrected(old), number);
+    }
+}
+
+// the old one at 1 to 6 decimals, where its integer part fit in an int
+static void testDtostrfAgainstOld() {
+    char actual[STRING_BUFFER_32], old[STRING_BUFFER_32];
+    srand(17);
+    for (int i = 0; i < RANGE; i++) {
+        const unsigned prec = 1 + i % 6;
+        const double magnitude = pow(10.0, rand() % 9);
+        const double number = ((double)rand() / RAND_MAX - 0.5) * 2 * magnitude;
+        dtostrf(number, prec + 2, prec, actual);
+        oldDtostrf(number, prec + 2, prec, old);
+        CHECK_TEXT(oldCorrected(old), actual, number);
+    }
+}
+
+// where the old one went wrong
+static void testDtostrfFixes() {
+    char text[STRING_BUFFER_32];
+    CHECK_STRING("3000000000.00", dtostrf(3000000000.0, 4, 2, text));
+    CHECK_STRING("-4294967040.0", dtostrf(-4294967040.0, 3, 1, text));
+    CHECK_STRING("0.00", dtostrf(-0.001, 4, 2, text));
+    CHECK_STRING("2", dtostrf(2.3, 1, 0, text)); // the old one appended the fraction digit, "20"
+    CHECK_STRING("20", oldDtostrf(2.3, 1, 0, text));
+    CHECK_STRING("5.000", oldDtostrf(5.0, 4, 2, text));
+    CHECK_STRING("2.00", dtostrf(1.999, 4, 2, text));
+    CHECK_STRING("1.000000000", dtostrf(1.0, 11, 12, text)); // capped at FIXED_MAX_DECIMALS
+    CHECK_STRING("ovf", dtostrf(5e9, 4, 2, text));
+    CHECK_STRING("nan", dtostrf(NAN, 4, 2, text));
+    CHECK_STRING("inf", dtostrf(-INFINITY, 4, 2, text));
+}
+
+int main() {
+    testFormatRoundTrip();
+    testFormatPrecision();
+    testRescale();
+    testFloatRoundTrip();
+    testUnsignedAndSqrt();
+    testDtostrfRoundTrip();
+    testDtostrfAgainstOld();
+    testDtostrfFixes();
+    return hostTestResult("fixedPointTest");
+}
@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Host stand-in for the AZ3166 Arduino core, just enough for the sketch
+// sources under test. millis(), micros() and time() run on a virtual clock
+// that only moves with delay() or hostAdvanceTime().
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef int PinName;
+
+#define F(x) x
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+enum { LED_WIFI = 1, LED_AZURE, LED_USER, USER_BUTTON_A, USER_BUTTON_B, D4, D5, D14, D15 };
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// virtual clock, starts at 0
+void hostSetTime(unsigned long ms);
+void hostAdvanceTime(unsigned long ms);
+
+// the RTC runs on the virtual clock as well, set_time() starts its second
+void set_time(time_t seconds);
+time_t hostRtcTime(time_t *seconds);
+#define time(seconds) hostRtcTime(seconds)
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int analogRead(int pin);
+long random(long low, long high);
+void randomSeed(unsigned long seed);
+
+char *strupr(char *text);
+
+template <class A, class B> auto min(A a, B b) -> decltype(a + b) { return a < b ? a : b; }
+template <class A, class B> auto max(A a, B b) -> decltype(a + b) { return a > b ? a : b; }
+
+// heap backed like WString, every growth reallocates to the exact new length
+class String {
+    char *buffer;
+    unsigned len;
+
+    void grow(unsigned length);
+    void assign(const char *text, unsigned length);
+
+public:
+    String(): buffer(NULL), len(0) { }
+    String(const char *text);
+    String(const String &other);
+    explicit String(int value);
+    explicit String(float value, unsigned char decimals = 2);
+    ~String() { free(buffer); }
+
+    String &operator=(const char *text);
+    String &operator=(const String &other);
+
+    void concat(const char *text);
+    void concat(const String &other) { concat(other.c_str()); }
+    void concat(char c);
+    void replace(const char *find, const char *replacement);
+    void toUpperCase();
+
+    bool operator==(const char *text) const { return strcmp(c_str(), text) == 0; }
+
+    const char *c_str() const { return buffer != NULL ? buffer : ""; }
+    unsigned length() const { return len; }
+    int indexOf(const char *text) const;
+    String substring(unsigned from, unsigned to) const;
+    String substring(unsigned from) const { return substring(from, len); }
+};
+
+// reallocations done by every String so far
+unsigned long hostStringAllocations();
+
+class HostSerial {
+public:
+    void begin(long baud) { }
+    int printf(const char *format, ...);
+    void print(const char *text);
+    void println(const char *text);
+    void println(const String &text) { println(text.c_str()); }
+};
+
+extern HostSerial Serial;
+
+// Serial output goes to stdout only while echo is on, it is off by default
+void hostSerialEcho(bool echo);
+
+#include "OledDisplay.h"
+
+#endif // HOST_ARDUINO_H
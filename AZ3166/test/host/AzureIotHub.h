@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Fake Azure IoT Hub transport. Messages handed to SendEventAsync are kept
+// with their confirmation callback until the test confirms them from
+// IoTHubClient_LL_DoWork, like the SDK does. Reported property patches are
+// kept as well and confirmed on the next DoWork. The hostHub* functions steer
+// failures and let tests call the registered twin and method callbacks.
+
+#ifndef HOST_AZURE_IOT_HUB_H
+#define HOST_AZURE_IOT_HUB_H
+
+#include "Arduino.h"
+
+typedef struct HOST_MESSAGE_TAG *IOTHUB_MESSAGE_HANDLE;
+typedef struct HOST_CLIENT_TAG *IOTHUB_CLIENT_LL_HANDLE;
+typedef struct HOST_MAP_TAG *MAP_HANDLE;
+
+typedef enum { IOTHUB_CLIENT_OK, IOTHUB_CLIENT_ERROR } IOTHUB_CLIENT_RESULT;
+typedef enum { IOTHUB_MESSAGE_OK, IOTHUB_MESSAGE_ERROR } IOTHUB_MESSAGE_RESULT;
+typedef enum { MAP_OK, MAP_ERROR } MAP_RESULT;
+typedef enum { IOTHUBMESSAGE_ACCEPTED, IOTHUBMESSAGE_REJECTED, IOTHUBMESSAGE_ABANDONED } IOTHUBMESSAGE_DISPOSITION_RESULT;
+typedef enum { DEVICE_TWIN_UPDATE_COMPLETE, DEVICE_TWIN_UPDATE_PARTIAL } DEVICE_TWIN_UPDATE_STATE;
+typedef enum { IOTHUB_CLIENT_CONNECTION_AUTHENTICATED, IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED } IOTHUB_CLIENT_CONNECTION_STATUS;
+typedef enum {
+    IOTHUB_CLIENT_CONNECTION_EXPIRED_SAS_TOKEN, IOTHUB_CLIENT_CONNECTION_NO_NETWORK, IOTHUB_CLIENT_CONNECTION_OK
+} IOTHUB_CLIENT_CONNECTION_STATUS_REASON;
+typedef enum { IOTHUB_CLIENT_CONFIRMATION_OK, IOTHUB_CLIENT_CONFIRMATION_ERROR } IOTHUB_CLIENT_CONFIRMATION_RESULT;
+typedef enum { IOTHUB_CLIENT_SEND_STATUS_IDLE, IOTHUB_CLIENT_SEND_STATUS_BUSY } IOTHUB_CLIENT_STATUS;
+typedef enum { IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF } IOTHUB_CLIENT_RETRY_POLICY;
+
+typedef IOTHUBMESSAGE_DISPOSITION_RESULT (*HOST_MESSAGE_CALLBACK)(IOTHUB_MESSAGE_HANDLE, void *);
+typedef void (*HOST_TWIN_CALLBACK)(DEVICE_TWIN_UPDATE_STATE, const unsigned char *, size_t, void *);
+typedef int (*HOST_METHOD_CALLBACK)(const char *, const unsigned char *, size_t, unsigned char **, size_t *, void *);
+typedef void (*HOST_STATUS_CALLBACK)(IOTHUB_CLIENT_CONNECTION_STATUS, IOTHUB_CLIENT_CONNECTION_STATUS_REASON, void *);
+typedef void (*HOST_CONFIRMATION_CALLBACK)(IOTHUB_CLIENT_CONFIRMATION_RESULT, void *);
+typedef void (*HOST_REPORTED_CALLBACK)(int, void *);
+
+#define ENUM_TO_STRING(type, value) #type
+#define LogError(...)
+#define LogInfo(...)
+
+#define AZ_IOT_HUB_MAX_LEN 512
+#define AZ_IOT_HUB_ZONE_IDX 5
+#define WIFI_SSID_ZONE_IDX 3
+#define WIFI_PWD_ZONE_IDX 10
+#define WIFI_SSID_MAX_LEN 32
+#define WIFI_PWD_MAX_LEN 64
+
+extern const char *certificates;
+extern void *MQTT_Protocol;
+
+int platform_init();
+void ThreadAPI_Sleep(unsigned milliseconds);
+
+IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateFromConnectionString(const char *connectionString, void *protocol);
+void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE handle);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetRetryPolicy(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY policy, size_t timeout);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE handle, const char *name, const void *value);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE handle, HOST_MESSAGE_CALLBACK callback, void *context);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetDeviceTwinCallback(IOTHUB_CLIENT_LL_HANDLE handle, HOST_TWIN_CALLBACK callback, void *context);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetDeviceMethodCallback(IOTHUB_CLIENT_LL_HANDLE handle, HOST_METHOD_CALLBACK callback, void *context);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetConnectionStatusCallback(IOTHUB_CLIENT_LL_HANDLE handle, HOST_STATUS_CALLBACK callback, void *context);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_MESSAGE_HANDLE message,
+                                                    HOST_CONFIRMATION_CALLBACK callback, void *context);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendReportedState(IOTHUB_CLIENT_LL_HANDLE handle, const unsigned char *state, size_t size,
+                                                       HOST_REPORTED_CALLBACK callback, void *context);
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetSendStatus(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_CLIENT_STATUS *status);
+void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE handle);
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char *bytes, size_t size);
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char *text);
+IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE message, const unsigned char **bytes, size_t *size);
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetMessageId(IOTHUB_MESSAGE_HANDLE message, const char *messageId);
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetContentTypeSystemProperty(IOTHUB_MESSAGE_HANDLE message, const char *contentType);
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetContentEncodingSystemProperty(IOTHUB_MESSAGE_HANDLE message, const char *encoding);
+MAP_HANDLE IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE message);
+void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE message);
+MAP_RESULT Map_AddOrUpdate(MAP_HANDLE map, const char *key, const char *value);
+
+// fake transport control
+
+#define HOST_HUB_MAX_MESSAGES 64
+
+typedef struct HOST_SENT_MESSAGE_TAG {
+    char *payload;
+    size_t length;
+    char messageId[16];
+    bool confirmed;
+} HOST_SENT_MESSAGE;
+
+// clears the sent log, failures and registered callbacks
+void hostHubReset();
+
+// the next count calls fail
+void hostHubFailMessageCreate(unsigned count);
+void hostHubFailSend(unsigned count);
+
+// runs the confirmation of the oldest unconfirmed messages on the next DoWork
+void hostHubConfirm(unsigned count, IOTHUB_CLIENT_CONFIRMATION_RESULT result);
+
+unsigned hostHubSentCount();
+const HOST_SENT_MESSAGE *hostHubSent(unsigned index);
+unsigned hostHubPendingCount(); // sent and not confirmed yet
+unsigned long hostHubDoWorkCount();
+
+// reported property patches in the order sent, confirmed with statusCode, 200 after a reset
+void hostHubReportedStatus(int statusCode);
+unsigned hostHubReportedCount();
+const char *hostHubReported(unsigned index);
+
+// calls the callbacks registered by the client under test
+void hostHubTwin(DEVICE_TWIN_UPDATE_STATE state, const char *twin);
+int hostHubMethod(const char *methodName, const char *payload);
+void hostHubConnectionStatus(IOTHUB_CLIENT_CONNECTION_STATUS status, IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason);
+
+#endif // HOST_AZURE_IOT_HUB_H
@@ -0,0 +1,21 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef HOST_DEV_I2C_H
+#define HOST_DEV_I2C_H
+
+#include "Arduino.h"
+
+// The blocking transfers of the board's I2C driver. A test that links
+// i2cBus.cpp defines them and with that what is on the bus. The host build
+// has no DEVICE_I2C_ASYNCH, so queued reads run as blocking transfers.
+class DevI2C {
+public:
+    DevI2C(PinName sda, PinName scl) { }
+
+    // 0 on success, like the board driver
+    int i2c_read(uint8_t *buffer, uint8_t deviceAddress, uint8_t registerAddress, uint16_t length);
+    int i2c_write(uint8_t *buffer, uint8_t deviceAddress, uint8_t registerAddress, uint16_t length);
+};
+
+#endif // HOST_DEV_I2C_H
@@ -0,0 +1,19 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef HOST_EEPROM_INTERFACE_H
+#define HOST_EEPROM_INTERFACE_H
+
+#include "AzureIotHub.h"
+
+#define HOST_EEPROM_ZONES 16
+#define HOST_EEPROM_ZONE_SIZE AZ_IOT_HUB_MAX_LEN
+
+// secure storage zones kept in memory for the life of the process
+class EEPROMInterface {
+public:
+    int write(uint8_t *data, int length, uint8_t zone);
+    int read(uint8_t *data, int length, int offset, uint8_t zone);
+};
+
+#endif // HOST_EEPROM_INTERFACE_H
@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef HOST_LSM6DSL_SENSOR_H
+#define HOST_LSM6DSL_SENSOR_H
+
+// the part of the vendor driver the motion FIFO configures the sensor with,
+// register traffic goes through the i2cRead() and i2cWrite() of the test
+class LSM6DSLSensor {
+public:
+    float accelOdr;
+    float gyroOdr;
+    float accelSensitivity; // mg per LSB
+    float gyroSensitivity;  // mdps per LSB
+
+    LSM6DSLSensor(): accelOdr(0), gyroOdr(0), accelSensitivity(0.061f), gyroSensitivity(4.375f) { }
+
+    int setXOdr(float odr) { accelOdr = odr; return 0; }
+    int setGOdr(float odr) { gyroOdr = odr; return 0; }
+    int getXSensitivity(float *sensitivity) { *sensitivity = accelSensitivity; return 0; }
+    int getGSensitivity(float *sensitivity) { *sensitivity = gyroSensitivity; return 0; }
+};
+
+#endif // HOST_LSM6DSL_SENSOR_H
@@ -0,0 +1,18 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef HOST_NTP_CLIENT_H
+#define HOST_NTP_CLIENT_H
+
+#include "SystemWiFi.h"
+
+typedef enum { NTP_OK, NTP_TIMEOUT } NTPResult;
+
+// no server answers on the host
+class NTPClient {
+public:
+    NTPClient(NetworkInterface *network) { }
+    NTPResult setTime(char *host) { return NTP_TIMEOUT; }
+};
+
+#endif // HOST_NTP_CLIENT_H
@@ -0,0 +1,27 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef HOST_OLED_DISPLAY_H
+#define HOST_OLED_DISPLAY_H
+
+#define HOST_SCREEN_LINES 4
+
+// keeps the text of each line, the last bitmap drawn and counts what reached the display
+class OledDisplay {
+public:
+    char lines[HOST_SCREEN_LINES][32];
+    unsigned long printCount;
+    unsigned long cleanCount;
+    unsigned long drawCount;
+    int drawArea[4]; // x0, y0, x1, y1 of the last draw
+    const unsigned char *drawBitmap;
+
+    void print(const char *text, bool wrap = false);
+    void print(unsigned line, const char *text, bool wrap = false);
+    void clean();
+    void draw(int x0, int y0, int x1, int y1, unsigned char *bitmap);
+};
+
+extern OledDisplay Screen;
+
+#endif // HOST_OLED_DISPLAY_H
@@ -0,0 +1,12 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef HOST_SYSTEM_WIFI_H
+#define HOST_SYSTEM_WIFI_H
+
+#include "Arduino.h"
+
+class NetworkInterface;
+NetworkInterface *WiFiInterface();
+
+#endif // HOST_SYSTEM_WIFI_H
@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Cortex-M4 SIMD intrinsics used by fixedFft.cpp, emulated so its
+// __ARM_FEATURE_DSP path can be checked on the host
+
+#ifndef HOST_CMSIS_H
+#define HOST_CMSIS_H
+
+#include <stdint.h>
+
+static inline int32_t hostLow16(uint32_t value) { return (int16_t)(value & 0xFFFF); }
+static inline int32_t hostHigh16(uint32_t value) { return (int16_t)(value >> 16); }
+
+static inline uint32_t hostPack16(int32_t low, int32_t high) {
+    return (uint16_t)low | ((uint32_t)(uint16_t)high << 16);
+}
+
+static inline uint32_t __SMUSD(uint32_t a, uint32_t b) {
+    return (uint32_t)(hostLow16(a) * hostLow16(b) - hostHigh16(a) * hostHigh16(b));
+}
+
+static inline uint32_t __SMUADX(uint32_t a, uint32_t b) {
+    return (uint32_t)(hostLow16(a) * hostHigh16(b) + hostHigh16(a) * hostLow16(b));
+}
+
+static inline uint32_t __SHADD16(uint32_t a, uint32_t b) {
+    return hostPack16((hostLow16(a) + hostLow16(b)) >> 1, (hostHigh16(a) + hostHigh16(b)) >> 1);
+}
+
+static inline uint32_t __SHSUB16(uint32_t a, uint32_t b) {
+    return hostPack16((hostLow16(a) - hostLow16(b)) >> 1, (hostHigh16(a) - hostHigh16(b)) >> 1);
+}
+
+#endif // HOST_CMSIS_H
@@ -0,0 +1,290 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#include "AzureIotHub.h"
+
+struct HOST_MESSAGE_TAG {
+    unsigned char *bytes;
+    size_t size;
+    char messageId[16];
+};
+
+struct HOST_CLIENT_TAG {
+    int unused;
+};
+
+typedef struct PENDING_CONFIRMATION_TAG {
+    HOST_CONFIRMATION_CALLBACK callback;
+    void *context;
+} PENDING_CONFIRMATION;
+
+typedef struct PENDING_REPORTED_TAG {
+    HOST_REPORTED_CALLBACK callback;
+    void *context;
+} PENDING_REPORTED;
+
+const char *certificates = "";
+void *MQTT_Protocol = NULL;
+
+static HOST_CLIENT_TAG client;
+static HOST_SENT_MESSAGE sent[HOST_HUB_MAX_MESSAGES];
+static PENDING_CONFIRMATION pending[HOST_HUB_MAX_MESSAGES];
+static unsigned sentCount = 0;
+static unsigned confirmedCount = 0; // sent[0 .. confirmedCount) are confirmed
+static unsigned confirmDue = 0;
+static IOTHUB_CLIENT_CONFIRMATION_RESULT confirmResult = IOTHUB_CLIENT_CONFIRMATION_OK;
+static unsigned failCreateCount = 0;
+static unsigned failSendCount = 0;
+static unsigned long doWorkCount = 0;
+
+static char *reported[HOST_HUB_MAX_MESSAGES];
+static PENDING_REPORTED pendingReported[HOST_HUB_MAX_MESSAGES];
+static unsigned reportedCount = 0;
+static unsigned reportedConfirmedCount = 0;
+static int reportedStatus = 200;
+
+static HOST_TWIN_CALLBACK twinCallback = NULL;
+static void *twinContext = NULL;
+static HOST_METHOD_CALLBACK methodCallback = NULL;
+static void *methodContext = NULL;
+static HOST_STATUS_CALLBACK statusCallback = NULL;
+static void *statusContext = NULL;
+
+int platform_init() {
+    return 0;
+}
+
+void ThreadAPI_Sleep(unsigned milliseconds) {
+    delay(milliseconds);
+}
+
+IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateFromConnectionString(const char *connectionString, void *protocol) {
+    return &client;
+}
+
+void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE handle) {
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetRetryPolicy(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY policy,
+                                                    size_t timeout) {
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE handle, const char *name, const void *value) {
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE handle, HOST_MESSAGE_CALLBACK callback,
+                                                        void *context) {
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetDeviceTwinCallback(IOTHUB_CLIENT_LL_HANDLE handle, HOST_TWIN_CALLBACK callback,
+                                                           void *context) {
+    twinCallback = callback;
+    twinContext = context;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetDeviceMethodCallback(IOTHUB_CLIENT_LL_HANDLE handle, HOST_METHOD_CALLBACK callback,
+                                                             void *context) {
+    methodCallback = callback;
+    methodContext = context;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetConnectionStatusCallback(IOTHUB_CLIENT_LL_HANDLE handle,
+                                                                 HOST_STATUS_CALLBACK callback, void *context) {
+    statusCallback = callback;
+    statusContext = context;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_MESSAGE_HANDLE message,
+                                                    HOST_CONFIRMATION_CALLBACK callback, void *context) {
+    if (failSendCount > 0) {
+        failSendCount--;
+        return IOTHUB_CLIENT_ERROR;
+    }
+    if (sentCount == HOST_HUB_MAX_MESSAGES) {
+        return IOTHUB_CLIENT_ERROR;
+    }
+
+    HOST_SENT_MESSAGE *entry = &sent[sentCount];
+    entry->payload = (char *)malloc(message->size + 1);
+    memcpy(entry->payload, message->bytes, message->size);
+    entry->payload[message->size] = 0;
+    entry->length = message->size;
+    strcpy(entry->messageId, message->messageId);
+    entry->confirmed = false;
+    pending[sentCount].callback = callback;
+    pending[sentCount].context = context;
+    sentCount++;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendReportedState(IOTHUB_CLIENT_LL_HANDLE handle, const unsigned char *state,
+                                                       size_t size, HOST_REPORTED_CALLBACK callback, void *context) {
+    if (reportedCount == HOST_HUB_MAX_MESSAGES) {
+        return IOTHUB_CLIENT_ERROR;
+    }
+
+    reported[reportedCount] = (char *)malloc(size + 1);
+    memcpy(reported[reportedCount], state, size);
+    reported[reportedCount][size] = 0;
+    pendingReported[reportedCount].callback = callback;
+    pendingReported[reportedCount].context = context;
+    reportedCount++;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetSendStatus(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_CLIENT_STATUS *status) {
+    *status = hostHubPendingCount() > 0 ? IOTHUB_CLIENT_SEND_STATUS_BUSY : IOTHUB_CLIENT_SEND_STATUS_IDLE;
+    return IOTHUB_CLIENT_OK;
+}
+
+void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE handle) {
+    doWorkCount++;
+    while (confirmDue > 0 && confirmedCount < sentCount) {
+        confirmDue--;
+        sent[confirmedCount].confirmed = true;
+        const PENDING_CONFIRMATION confirmation = pending[confirmedCount++];
+        confirmation.callback(confirmResult, confirmation.context);
+    }
+    while (reportedConfirmedCount < reportedCount) {
+        const PENDING_REPORTED confirmation = pendingReported[reportedConfirmedCount++];
+        confirmation.callback(reportedStatus, confirmation.context);
+    }
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char *bytes, size_t size) {
+    if (failCreateCount > 0) {
+        failCreateCount--;
+        return NULL;
+    }
+
+    IOTHUB_MESSAGE_HANDLE message = (IOTHUB_MESSAGE_HANDLE)calloc(1, sizeof(HOST_MESSAGE_TAG));
+    message->bytes = (unsigned char *)malloc(size);
+    memcpy(message->bytes, bytes, size);
+    message->size = size;
+    return message;
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char *text) {
+    return IoTHubMessage_CreateFromByteArray((const unsigned char *)text, strlen(text));
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE message, const unsigned char **bytes,
+                                                 size_t *size) {
+    *bytes = message->bytes;
+    *size = message->size;
+    return IOTHUB_MESSAGE_OK;
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetMessageId(IOTHUB_MESSAGE_HANDLE message, const char *messageId) {
+    snprintf(message->messageId, sizeof(message->messageId), "%s", messageId);
+    return IOTHUB_MESSAGE_OK;
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetContentTypeSystemProperty(IOTHUB_MESSAGE_HANDLE message,
+                                                                 const char *contentType) {
+    return IOTHUB_MESSAGE_OK;
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetContentEncodingSystemProperty(IOTHUB_MESSAGE_HANDLE message,
+                                                                     const char *encoding) {
+    return IOTHUB_MESSAGE_OK;
+}
+
+MAP_HANDLE IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE message) {
+    return NULL;
+}
+
+void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE message) {
+    if (message != NULL) {
+        free(message->bytes);
+        free(message);
+    }
+}
+
+MAP_RESULT Map_AddOrUpdate(MAP_HANDLE map, const char *key, const char *value) {
+    return MAP_OK;
+}
+
+// control
+
+void hostHubReset() {
+    for (unsigned i = 0; i < sentCount; i++) {
+        free(sent[i].payload);
+    }
+    sentCount = 0;
+    confirmedCount = 0;
+    for (unsigned i = 0; i < reportedCount; i++) {
+        free(reported[i]);
+    }
+    reportedCount = 0;
+    reportedConfirmedCount = 0;
+    reportedStatus = 200;
+    confirmDue = 0;
+    failCreateCount = 0;
+    failSendCount = 0;
+    doWorkCount = 0;
+}
+
+void hostHubFailMessageCreate(unsigned count) {
+    failCreateCount = count;
+}
+
+void hostHubFailSend(unsigned count) {
+    failSendCount = count;
+}
+
+void hostHubConfirm(unsigned count, IOTHUB_CLIENT_CONFIRMATION_RESULT result) {
+    confirmDue = count;
+    confirmResult = result;
+}
+
+unsigned hostHubSentCount() {
+    return sentCount;
+}
+
+const HOST_SENT_MESSAGE *hostHubSent(unsigned index) {
+    return index < sentCount ? &sent[index] : NULL;
+}
+
+unsigned hostHubPendingCount() {
+    return sentCount - confirmedCount;
+}
+
+void hostHubReportedStatus(int statusCode) {
+    reportedStatus = statusCode;
+}
+
+unsigned hostHubReportedCount() {
+    return reportedCount;
+}
+
+const char *hostHubReported(unsigned index) {
+    return index < reportedCount ? reported[index] : NULL;
+}
+
+unsigned long hostHubDoWorkCount() {
+    return doWorkCount;
+}
+
+void hostHubTwin(DEVICE_TWIN_UPDATE_STATE state, const char *twin) {
+    twinCallback(state, (const unsigned char *)twin, strlen(twin), twinContext);
+}
+
+int hostHubMethod(const char *methodName, const char *payload) {
+    unsigned char *response = NULL;
+    size_t responseSize = 0;
+    const int status = methodCallback(methodName, (const unsigned char *)payload, strlen(payload),
+                                      &response, &responseSize, methodContext);
+    free(response);
+    return status;
+}
+
+void hostHubConnectionStatus(IOTHUB_CLIENT_CONNECTION_STATUS status, IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason) {
+    statusCallback(status, reason, statusContext);
+}
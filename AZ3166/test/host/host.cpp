@@ -0,0 +1,309 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Arduino core, display, parson, WiFi and EEPROM stand-ins for the host build
+
+#include "Arduino.h"
+#include "EEPROMInterface.h"
+#include "SystemWiFi.h"
+#include "parson/parson.h"
+
+#include <ctype.h>
+
+// virtual clock
+
+static unsigned long long hostTime = 0; // us
+
+unsigned long millis() {
+    return (unsigned long)(hostTime / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)hostTime;
+}
+
+void delay(unsigned long ms) {
+    hostAdvanceTime(ms);
+}
+
+void hostSetTime(unsigned long ms) {
+    hostTime = (unsigned long long)ms * 1000;
+}
+
+void hostAdvanceTime(unsigned long ms) {
+    hostTime += (unsigned long long)ms * 1000;
+}
+
+static time_t rtcSeconds = 0;
+static unsigned long long rtcSetTime = 0; // us
+
+void set_time(time_t seconds) {
+    rtcSeconds = seconds;
+    rtcSetTime = hostTime;
+}
+
+time_t hostRtcTime(time_t *seconds) {
+    const time_t now = rtcSeconds + (time_t)(((long long)hostTime - (long long)rtcSetTime) / 1000000);
+    if (seconds != NULL) {
+        *seconds = now;
+    }
+    return now;
+}
+
+// pins
+
+static int pinValues[64];
+
+void pinMode(int pin, int mode) {
+}
+
+void digitalWrite(int pin, int value) {
+    pinValues[pin & 63] = value;
+}
+
+// buttons are active low
+int digitalRead(int pin) {
+    return pin == USER_BUTTON_A || pin == USER_BUTTON_B ? HIGH : pinValues[pin & 63];
+}
+
+int analogRead(int pin) {
+    return 0;
+}
+
+long random(long low, long high) {
+    return high > low ? low + rand() % (high - low) : low;
+}
+
+void randomSeed(unsigned long seed) {
+    srand(seed);
+}
+
+char *strupr(char *text) {
+    for (char *c = text; *c != 0; c++) {
+        *c = toupper((unsigned char)*c);
+    }
+    return text;
+}
+
+// String
+
+static unsigned long stringAllocations = 0;
+
+unsigned long hostStringAllocations() {
+    return stringAllocations;
+}
+
+void String::grow(unsigned length) {
+    buffer = (char *)realloc(buffer, length + 1);
+    stringAllocations++;
+}
+
+void String::assign(const char *text, unsigned length) {
+    if (buffer == NULL || length > len) {
+        grow(length);
+    }
+    memcpy(buffer, text, length);
+    buffer[length] = 0;
+    len = length;
+}
+
+String::String(const char *text): buffer(NULL), len(0) {
+    if (text != NULL) {
+        assign(text, strlen(text));
+    }
+}
+
+String::String(const String &other): buffer(NULL), len(0) {
+    assign(other.c_str(), other.len);
+}
+
+String::String(int value): buffer(NULL), len(0) {
+    char digits[16];
+    assign(digits, snprintf(digits, sizeof(digits), "%d", value));
+}
+
+// the sketch's dtostrf in utility.cpp takes over where it is linked, as on the board
+__attribute__((weak)) char *dtostrf(double number, signed char width, unsigned char prec, char *s) {
+    sprintf(s, "%*.*f", width, prec, number);
+    return s;
+}
+
+// WString formats floats with dtostrf(value, decimals + 2, decimals)
+String::String(float value, unsigned char decimals): buffer(NULL), len(0) {
+    char digits[48];
+    dtostrf(value, decimals + 2, decimals, digits);
+    assign(digits, strlen(digits));
+}
+
+String &String::operator=(const char *text) {
+    assign(text, strlen(text));
+    return *this;
+}
+
+String &String::operator=(const String &other) {
+    if (this != &other) {
+        assign(other.c_str(), other.len);
+    }
+    return *this;
+}
+
+void String::concat(const char *text) {
+    const unsigned length = strlen(text);
+    if (length == 0) {
+        return;
+    }
+    grow(len + length);
+    memcpy(buffer + len, text, length + 1);
+    len += length;
+}
+
+void String::concat(char c) {
+    const char text[2] = { c, 0 };
+    concat(text);
+}
+
+void String::replace(const char *find, const char *replacement) {
+    const char *found = len > 0 ? strstr(buffer, find) : NULL;
+    if (found == NULL) {
+        return;
+    }
+
+    String result;
+    const char *start = buffer;
+    for (; found != NULL; found = strstr(start, find)) {
+        const unsigned prefix = found - start;
+        char *part = (char *)malloc(prefix + 1);
+        memcpy(part, start, prefix);
+        part[prefix] = 0;
+        result.concat(part);
+        free(part);
+        result.concat(replacement);
+        start = found + strlen(find);
+    }
+    result.concat(start);
+    *this = result;
+}
+
+void String::toUpperCase() {
+    if (buffer != NULL) {
+        strupr(buffer);
+    }
+}
+
+int String::indexOf(const char *text) const {
+    const char *found = len > 0 ? strstr(buffer, text) : NULL;
+    return found != NULL ? (int)(found - buffer) : -1;
+}
+
+String String::substring(unsigned from, unsigned to) const {
+    if (to > len) {
+        to = len;
+    }
+    String result;
+    if (from < to) {
+        result.assign(buffer + from, to - from);
+    }
+    return result;
+}
+
+// Serial
+
+HostSerial Serial;
+static bool serialEcho = false;
+
+void hostSerialEcho(bool echo) {
+    serialEcho = echo;
+}
+
+int HostSerial::printf(const char *format, ...) {
+    if (!serialEcho) {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, format);
+    const int result = vprintf(format, args);
+    va_end(args);
+    return result;
+}
+
+void HostSerial::print(const char *text) {
+    if (serialEcho) {
+        fputs(text, stdout);
+    }
+}
+
+void HostSerial::println(const char *text) {
+    if (serialEcho) {
+        puts(text);
+    }
+}
+
+// display
+
+OledDisplay Screen;
+
+void OledDisplay::print(const char *text, bool wrap) {
+    print(0, text, wrap);
+}
+
+void OledDisplay::print(unsigned line, const char *text, bool wrap) {
+    if (line < HOST_SCREEN_LINES) {
+        snprintf(lines[line], sizeof(lines[line]), "%s", text);
+    }
+    printCount++;
+}
+
+void OledDisplay::clean() {
+    memset(lines, 0, sizeof(lines));
+    cleanCount++;
+}
+
+void OledDisplay::draw(int x0, int y0, int x1, int y1, unsigned char *bitmap) {
+    drawArea[0] = x0;
+    drawArea[1] = y0;
+    drawArea[2] = x1;
+    drawArea[3] = y1;
+    drawBitmap = bitmap;
+    drawCount++;
+}
+
+// parson, nothing parses
+
+JSON_Value *json_parse_string(const char *string) { return NULL; }
+void json_value_free(JSON_Value *value) { }
+JSON_Object *json_value_get_object(const JSON_Value *value) { return NULL; }
+const char *json_value_get_string(const JSON_Value *value) { return NULL; }
+size_t json_object_get_count(const JSON_Object *object) { return 0; }
+const char *json_object_get_name(const JSON_Object *object, size_t index) { return NULL; }
+JSON_Value *json_object_get_value_at(const JSON_Object *object, size_t index) { return NULL; }
+int json_object_has_value(const JSON_Object *object, const char *name) { return 0; }
+JSON_Object *json_object_get_object(const JSON_Object *object, const char *name) { return NULL; }
+const char *json_object_get_string(const JSON_Object *object, const char *name) { return NULL; }
+double json_object_get_number(const JSON_Object *object, const char *name) { return 0; }
+int json_object_get_boolean(const JSON_Object *object, const char *name) { return -1; }
+
+// WiFi and EEPROM
+
+NetworkInterface *WiFiInterface() {
+    return NULL;
+}
+
+static uint8_t eepromZones[HOST_EEPROM_ZONES][HOST_EEPROM_ZONE_SIZE];
+
+int EEPROMInterface::write(uint8_t *data, int length, uint8_t zone) {
+    if (zone >= HOST_EEPROM_ZONES || length > HOST_EEPROM_ZONE_SIZE) {
+        return -1;
+    }
+    memset(eepromZones[zone], 0, HOST_EEPROM_ZONE_SIZE);
+    memcpy(eepromZones[zone], data, length);
+    return 0;
+}
+
+int EEPROMInterface::read(uint8_t *data, int length, int offset, uint8_t zone) {
+    if (zone >= HOST_EEPROM_ZONES || offset + length > HOST_EEPROM_ZONE_SIZE) {
+        return -1;
+    }
+    memcpy(data, eepromZones[zone] + offset, length);
+    return length;
+}
@@ -0,0 +1,30 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Declarations of the parson API the sketch uses. The host build doesn't
+// parse JSON with it, json_parse_string() always fails.
+
+#ifndef HOST_PARSON_H
+#define HOST_PARSON_H
+
+#include <stddef.h>
+
+typedef struct json_object_t JSON_Object;
+typedef struct json_array_t JSON_Array;
+typedef struct json_value_t JSON_Value;
+typedef int JSON_Value_Type;
+
+JSON_Value *json_parse_string(const char *string);
+void json_value_free(JSON_Value *value);
+JSON_Object *json_value_get_object(const JSON_Value *value);
+const char *json_value_get_string(const JSON_Value *value);
+size_t json_object_get_count(const JSON_Object *object);
+const char *json_object_get_name(const JSON_Object *object, size_t index);
+JSON_Value *json_object_get_value_at(const JSON_Object *object, size_t index);
+int json_object_has_value(const JSON_Object *object, const char *name);
+JSON_Object *json_object_get_object(const JSON_Object *object, const char *name);
+const char *json_object_get_string(const JSON_Object *object, const char *name);
+double json_object_get_number(const JSON_Object *object, const char *name);
+int json_object_get_boolean(const JSON_Object *object, const char *name);
+
+#endif // HOST_PARSON_H
@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static int hostFailures = 0;
+static int hostChecks = 0;
+
+#define CHECK(condition) \
+    do { \
+        hostChecks++; \
+        if (!(condition)) { \
+            hostFailures++; \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+    do { \
+        hostChecks++; \
+        const long long expected_ = (long long)(expected); \
+        const long long actual_ = (long long)(actual); \
+        if (expected_ != actual_) { \
+            hostFailures++; \
+            printf("FAIL %s:%d: %s == %s, expected %lld got %lld\n", __FILE__, __LINE__, \
+                   #expected, #actual, expected_, actual_); \
+        } \
+    } while (0)
+
+#define CHECK_STRING(expected, actual) \
+    do { \
+        hostChecks++; \
+        if (strcmp((expected), (actual)) != 0) { \
+            hostFailures++; \
+            printf("FAIL %s:%d: expected \"%s\" got \"%s\"\n", __FILE__, __LINE__, (expected), (actual)); \
+        } \
+    } while (0)
+
+// prints the summary, the exit code of a test
+static inline int hostTestResult(const char *name) {
+    printf("%s: %d checks, %d failed\n", name, hostChecks, hostFailures);
+    return hostFailures == 0 ? 0 : 1;
+}
+
+// wall clock for benchmarks, the virtual clock of the shims doesn't move by itself
+static inline uint64_t hostNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// time stamp counter where there is one, otherwise nanoseconds
+static inline uint64_t hostCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return hostNanoseconds();
+#endif
+}
+
+#endif // HOST_TEST_H
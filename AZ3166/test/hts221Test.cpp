@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The HTS221 one shot driver against a register file standing in for the
+// sensor behind i2cRead() and i2cWrite(): the integer calibration against the
+// datasheet's floating point interpolation over every output value, the
+// humidity clamp, the data ready timeout, and one conversion of three bus
+// transactions shared by every read within the cache period.
+
+#include "../inc/globals.h"
+#include "../inc/hts221.h"
+#include "../inc/i2cBus.h"
+#include "hostTest.h"
+
+#define CTRL_REG2 0x21
+#define STATUS_REG 0x27
+#define HUMIDITY_OUT_L 0x28
+#define TEMPERATURE_OUT_L 0x2A
+#define CALIBRATION_REG 0x30
+
+static uint8_t registers[0x40];
+static unsigned transactions = 0;
+static unsigned conversions = 0;
+static unsigned readyAfterPolls = 0; // status polls before data ready, UINT_MAX never
+static unsigned statusPolls = 0;
+
+bool i2cRead(I2cDevice device, uint8_t reg, uint8_t *data, uint16_t length) {
+    transactions++;
+    if (device != I2C_DEVICE_HTS221 || reg + length > sizeof(registers)) {
+        return false;
+    }
+    if (reg == STATUS_REG) {
+        registers[STATUS_REG] = statusPolls++ >= readyAfterPolls ? 0x03 : 0x00;
+    }
+    memcpy(data, registers + reg, length);
+    return true;
+}
+
+bool i2cWrite(I2cDevice device, uint8_t reg, uint8_t value) {
+    transactions++;
+    if (device != I2C_DEVICE_HTS221 || reg >= sizeof(registers)) {
+        return false;
+    }
+    registers[reg] = value;
+    if (reg == CTRL_REG2 && (value & 0x01)) {
+        conversions++;
+        statusPolls = 0;
+    }
+    return true;
+}
+
+typedef struct CALIBRATION_TAG {
+    uint16_t h0RhX2, h1RhX2;     // 8 bit
+    uint16_t t0DegCX8, t1DegCX8; // 10 bit
+    int16_t h0Out, h1Out, t0Out, t1Out;
+} CALIBRATION;
+
+static void putInt16(uint8_t reg, int16_t value) {
+    registers[reg] = (uint8_t)value;
+    registers[reg + 1] = (uint8_t)((uint16_t)value >> 8);
+}
+
+// the calibration registers as the datasheet lays them out
+static void setCalibration(const CALIBRATION &cal) {
+    memset(registers, 0, sizeof(registers));
+    registers[0x0F] = 0xBC;
+    registers[CALIBRATION_REG + 0] = (uint8_t)cal.h0RhX2;
+    registers[CALIBRATION_REG + 1] = (uint8_t)cal.h1RhX2;
+    registers[CALIBRATION_REG + 2] = (uint8_t)cal.t0DegCX8;
+    registers[CALIBRATION_REG + 3] = (uint8_t)cal.t1DegCX8;
+    registers[CALIBRATION_REG + 5] = (uint8_t)((cal.t0DegCX8 >> 8) | ((cal.t1DegCX8 >> 8) << 2));
+    putInt16(CALIBRATION_REG + 6, cal.h0Out);
+    putInt16(CALIBRATION_REG + 10, cal.h1Out);
+    putInt16(CALIBRATION_REG + 12, cal.t0Out);
+    putInt16(CALIBRATION_REG + 14, cal.t1Out);
+}
+
+// the datasheet's interpolation, in hundredths
+static double datasheetHumidity(const CALIBRATION &cal, int16_t out) {
+    const double h0 = cal.h0RhX2 / 2.0, h1 = cal.h1RhX2 / 2.0;
+    const double humidity = (h1 - h0) * (out - cal.h0Out) / (cal.h1Out - cal.h0Out) + h0;
+    return humidity * 100;
+}
+
+static double datasheetTemperature(const CALIBRATION &cal, int16_t out) {
+    const double t0 = cal.t0DegCX8 / 8.0, t1 = cal.t1DegCX8 / 8.0;
+    return ((t1 - t0) * (out - cal.t0Out) / (cal.t1Out - cal.t0Out) + t0) * 100;
+}
+
+static unsigned long now = 1000;
+
+// a new conversion of the given outputs
+static const HTS221_READING *convert(int16_t humidityOut, int16_t temperatureOut) {
+    putInt16(HUMIDITY_OUT_L, humidityOut);
+    putInt16(TEMPERATURE_OUT_L, temperatureOut);
+    now += HTS221_CACHE_PERIOD;
+    return hts221Read(now);
+}
+
+// a board's calibration, one with 10 bit temperatures and a falling humidity
+// slope, and one with the outputs at the ends of int16
+static const CALIBRATION calibrations[] = {
+    { 66, 156, 159, 513, -6, -10420, 293, 700 },
+    { 0, 200, 1023, 40, 12000, -12000, -300, 400 },
+    { 40, 180, 200, 800, -32768, 32767, 32767, -32768 },
+};
+
+static void testCalibration() {
+    unsigned largestError = 0;
+    for (unsigned c = 0; c < sizeof(calibrations) / sizeof(calibrations[0]); c++) {
+        const CALIBRATION &cal = calibrations[c];
+        setCalibration(cal);
+        readyAfterPolls = 0;
+        CHECK(hts221Init());
+
+        for (int32_t out = INT16_MIN; out <= INT16_MAX; out++) {
+            const HTS221_READING *reading = convert((int16_t)out, (int16_t)out);
+            CHECK(reading->valid);
+
+            // the integer math truncates, within a hundredth of the exact value
+            double expected = datasheetHumidity(cal, (int16_t)out);
+            expected = expected < 0 ? 0 : expected > 10000 ? 10000 : expected;
+            const double humidityError = fabs(reading->humidity - expected);
+            const double temperatureError = fabs(reading->temperature - datasheetTemperature(cal, (int16_t)out));
+            if (humidityError >= 1 || temperatureError >= 1) {
+                CHECK(humidityError < 1);
+                CHECK(temperatureError < 1);
+                printf("  calibration %u output %d: %d %d\n", c, out, reading->humidity, reading->temperature);
+            }
+            largestError = max(largestError, (unsigned)(max(humidityError, temperatureError) * 100));
+        }
+    }
+    printf("  largest error %.2f hundredths\n", largestError / 100.0);
+}
+
+// extrapolated humidity outside 0 .. 100 %RH is clamped, temperature isn't
+static void testHumidityClamp() {
+    const CALIBRATION &cal = calibrations[0];
+    setCalibration(cal);
+    readyAfterPolls = 0;
+    CHECK(hts221Init());
+
+    const HTS221_READING *reading = convert(10000, cal.t0Out);
+    CHECK_EQUAL(0, reading->humidity);
+    CHECK_EQUAL(cal.t0DegCX8 * 100 / 8, reading->temperature);
+    reading = convert(-20000, cal.t1Out);
+    CHECK_EQUAL(10000, reading->humidity);
+    CHECK_EQUAL(cal.t1DegCX8 * 100 / 8, reading->temperature);
+    reading = convert(cal.h1Out, 32767);
+    CHECK_EQUAL(cal.h1RhX2 * 50, reading->humidity);
+    CHECK(reading->temperature > 20000);
+}
+
+// every read within the cache period shares one conversion of three transactions
+static void testCacheSharing() {
+    setCalibration(calibrations[0]);
+    readyAfterPolls = 0;
+    CHECK(hts221Init());
+
+    const unsigned long acquisitions = getHts221AcquisitionCount();
+    transactions = 0;
+    conversions = 0;
+    now += HTS221_CACHE_PERIOD;
+    const unsigned long start = now;
+    for (; now < start + HTS221_CACHE_PERIOD; now += 10) {
+        CHECK(hts221Read(now)->valid);
+        CHECK_EQUAL(start, hts221Read(now)->sampleTime);
+    }
+    CHECK_EQUAL(1, conversions);
+    CHECK_EQUAL(3, transactions); // one shot, data ready, both outputs
+    CHECK_EQUAL(acquisitions + 1, getHts221AcquisitionCount());
+
+    hts221Read(now);
+    CHECK_EQUAL(2, conversions);
+    CHECK_EQUAL(6, transactions);
+
+    // a conversion that takes a few polls
+    readyAfterPolls = 3;
+    now += HTS221_CACHE_PERIOD;
+    CHECK(hts221Read(now)->valid);
+    CHECK_EQUAL(6 + 3 + 3, transactions);
+}
+
+// a conversion that never finishes gives up after HTS221_READY_TIMEOUT ms and
+// isn't retried before the cache period
+static void testReadyTimeout() {
+    setCalibration(calibrations[0]);
+    readyAfterPolls = UINT_MAX;
+    CHECK(hts221Init());
+
+    const unsigned long acquisitions = getHts221AcquisitionCount();
+    now += HTS221_CACHE_PERIOD;
+    const unsigned long clockBefore = millis();
+    conversions = 0;
+    CHECK(!hts221Read(now)->valid);
+    CHECK(millis() - clockBefore > HTS221_READY_TIMEOUT);
+    CHECK(millis() - clockBefore <= HTS221_READY_TIMEOUT + 2);
+    CHECK_EQUAL(acquisitions, getHts221AcquisitionCount());
+
+    CHECK(!hts221Read(now + HTS221_CACHE_PERIOD - 1)->valid);
+    CHECK_EQUAL(1, conversions);
+
+    readyAfterPolls = 0;
+    CHECK(hts221Read(now + HTS221_CACHE_PERIOD)->valid);
+    CHECK_EQUAL(2, conversions);
+}
+
+static void testInitFailures() {
+    CALIBRATION cal = calibrations[0];
+    setCalibration(cal);
+    registers[0x0F] = 0xBD;
+    CHECK(!hts221Init());
+    CHECK(!hts221Read(now += HTS221_CACHE_PERIOD)->valid);
+
+    cal.h1Out = cal.h0Out;
+    setCalibration(cal);
+    CHECK(!hts221Init());
+
+    cal = calibrations[0];
+    cal.t1Out = cal.t0Out;
+    setCalibration(cal);
+    CHECK(!hts221Init());
+}
+
+int main() {
+    testCalibration();
+    testHumidityClamp();
+    testCacheSharing();
+    testReadyTimeout();
+    testInitFailures();
+    return hostTestResult("hts221Test");
+}
@@ -0,0 +1,314 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Queued reads on the shared sensor bus against a simulated bus: adjacent
+// reads of one device merge into a single burst whether they come after or
+// before it, each part gets its own bytes, I2C_BURST_PARTS and I2C_BURST_MAX
+// bound a burst, other devices never join it, the HTS221 gets its auto
+// increment bit, and every transaction is accounted to its device.
+
+#include "../inc/globals.h"
+#include "../inc/i2cBus.h"
+#include "DevI2C.h"
+#include "hostTest.h"
+
+#define LSM6DSL_ADDRESS 0xD6
+#define HTS221_ADDRESS 0xBE
+#define LPS22HB_ADDRESS 0xBA
+#define HTS221_AUTO_INCREMENT 0x80
+
+#define LOG_SIZE 32
+
+typedef struct TRANSACTION_TAG {
+    uint8_t address;
+    uint8_t reg;
+    uint16_t length;
+    bool write;
+} TRANSACTION;
+
+static TRANSACTION transactionLog[LOG_SIZE];
+static unsigned transactionCount = 0;
+static unsigned failCount = 0; // the next reads that fail
+
+// what a register holds, different for every device
+static uint8_t registerValue(uint8_t address, uint8_t reg) {
+    return (uint8_t)(address * 31 + reg * 7 + 1);
+}
+
+static void logTransaction(uint8_t address, uint8_t reg, uint16_t length, bool write) {
+    if (transactionCount < LOG_SIZE) {
+        const TRANSACTION transaction = { address, reg, length, write };
+        transactionLog[transactionCount] = transaction;
+    }
+    transactionCount++;
+}
+
+int DevI2C::i2c_read(uint8_t *buffer, uint8_t deviceAddress, uint8_t registerAddress, uint16_t length) {
+    logTransaction(deviceAddress, registerAddress, length, false);
+    if (failCount > 0) {
+        failCount--;
+        return -1;
+    }
+
+    // without its auto increment bit the HTS221 reads the same register over and over
+    uint8_t reg = registerAddress;
+    const bool hts221 = deviceAddress == HTS221_ADDRESS;
+    const bool increment = !hts221 || (registerAddress & HTS221_AUTO_INCREMENT) != 0;
+    if (hts221) {
+        reg &= ~HTS221_AUTO_INCREMENT;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        buffer[i] = registerValue(deviceAddress, (uint8_t)(reg + (increment ? i : 0)));
+    }
+    return 0;
+}
+
+int DevI2C::i2c_write(uint8_t *buffer, uint8_t deviceAddress, uint8_t registerAddress, uint16_t length) {
+    logTransaction(deviceAddress, registerAddress, length, true);
+    return 0;
+}
+
+static DevI2C bus(D14, D15);
+
+static void reset() {
+    i2cBusInit(&bus);
+    transactionCount = 0;
+    failCount = 0;
+}
+
+static bool registersMatch(uint8_t address, uint8_t reg, const uint8_t *data, unsigned length) {
+    for (unsigned i = 0; i < length; i++) {
+        if (data[i] != registerValue(address, (uint8_t)(reg + i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkTransaction(unsigned index, uint8_t address, uint8_t reg, uint16_t length) {
+    CHECK(index < transactionCount);
+    if (index < transactionCount) {
+        CHECK_EQUAL(address, transactionLog[index].address);
+        CHECK_EQUAL(reg, transactionLog[index].reg);
+        CHECK_EQUAL(length, transactionLog[index].length);
+    }
+}
+
+// completed reads, the context is the index of the part
+static int completedOrder[LOG_SIZE];
+static bool completedOk[LOG_SIZE];
+static unsigned completedCount = 0;
+
+static void readDone(bool ok, void *context) {
+    if (completedCount < LOG_SIZE) {
+        completedOrder[completedCount] = (int)(intptr_t)context;
+        completedOk[completedCount] = ok;
+    }
+    completedCount++;
+}
+
+// a read of the registers after a queued one joins it at the end
+static void testAppend() {
+    reset();
+    completedCount = 0;
+    uint8_t gyro[6], accel[6];
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x22, gyro, sizeof(gyro), readDone, (void *)1));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x28, accel, sizeof(accel), readDone, (void *)2));
+    CHECK_EQUAL(1, getI2cMergedCount());
+    CHECK_EQUAL(0, transactionCount);
+
+    i2cBusFlush();
+    CHECK_EQUAL(1, transactionCount);
+    checkTransaction(0, LSM6DSL_ADDRESS, 0x22, 12);
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x22, gyro, sizeof(gyro)));
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x28, accel, sizeof(accel)));
+
+    // callbacks in the order the reads were queued
+    CHECK_EQUAL(2, completedCount);
+    CHECK_EQUAL(1, completedOrder[0]);
+    CHECK_EQUAL(2, completedOrder[1]);
+    CHECK(completedOk[0] && completedOk[1]);
+}
+
+// a read of the registers before a queued one joins it at the front, the
+// parts already in it move up
+static void testPrepend() {
+    reset();
+    uint8_t accel[6], gyro[6], temperature[2];
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x28, accel, sizeof(accel)));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x22, gyro, sizeof(gyro)));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x20, temperature, sizeof(temperature)));
+    CHECK_EQUAL(2, getI2cMergedCount());
+
+    i2cBusFlush();
+    CHECK_EQUAL(1, transactionCount);
+    checkTransaction(0, LSM6DSL_ADDRESS, 0x20, 14);
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x20, temperature, sizeof(temperature)));
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x22, gyro, sizeof(gyro)));
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x28, accel, sizeof(accel)));
+
+    // both ways on one burst
+    reset();
+    uint8_t a[2], b[3], c[1], d[4];
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x10, a, sizeof(a)));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x12, b, sizeof(b)));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x0F, c, sizeof(c)));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x0B, d, sizeof(d)));
+    i2cBusFlush();
+    CHECK_EQUAL(1, transactionCount);
+    checkTransaction(0, LSM6DSL_ADDRESS, 0x0B, 10);
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x10, a, sizeof(a)));
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x12, b, sizeof(b)));
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x0F, c, sizeof(c)));
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x0B, d, sizeof(d)));
+}
+
+static void testLimits() {
+    // I2C_BURST_PARTS reads to a burst
+    reset();
+    uint8_t bytes[I2C_BURST_PARTS + 1];
+    for (unsigned i = 0; i <= I2C_BURST_PARTS; i++) {
+        CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x30 + i, bytes + i, 1));
+    }
+    i2cBusFlush();
+    CHECK_EQUAL(2, transactionCount);
+    checkTransaction(0, LSM6DSL_ADDRESS, 0x30, I2C_BURST_PARTS);
+    checkTransaction(1, LSM6DSL_ADDRESS, 0x30 + I2C_BURST_PARTS, 1);
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x30, bytes, sizeof(bytes)));
+
+    // I2C_BURST_MAX bytes to a burst, exactly that many still merge
+    reset();
+    uint8_t data[I2C_BURST_MAX * 2];
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x40, data, I2C_BURST_MAX / 2));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x40 + I2C_BURST_MAX / 2, data + I2C_BURST_MAX / 2, I2C_BURST_MAX / 2));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x40 + I2C_BURST_MAX, data + I2C_BURST_MAX, 1));
+    i2cBusFlush();
+    CHECK_EQUAL(2, transactionCount);
+    checkTransaction(0, LSM6DSL_ADDRESS, 0x40, I2C_BURST_MAX);
+    checkTransaction(1, LSM6DSL_ADDRESS, 0x40 + I2C_BURST_MAX, 1);
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x40, data, I2C_BURST_MAX + 1));
+
+    CHECK(!i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x40, data, I2C_BURST_MAX + 1));
+    CHECK(!i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x40, data, 0));
+
+    // I2C_QUEUE_SIZE bursts that can't merge
+    reset();
+    for (unsigned i = 0; i < I2C_QUEUE_SIZE; i++) {
+        CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x10 + i * 4, data + i, 1));
+    }
+    CHECK(!i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x70, data, 1));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x11, data + I2C_QUEUE_SIZE, 1)); // merging still works
+    i2cBusFlush();
+    CHECK_EQUAL(I2C_QUEUE_SIZE, transactionCount);
+}
+
+// adjacent registers of another device, or of the same device with a gap, are a burst of their own
+static void testNoMergeAcrossDevices() {
+    reset();
+    uint8_t pressure[3], motion[2], gap[1];
+    CHECK(i2cQueueRead(I2C_DEVICE_LPS22HB, 0x28, pressure, sizeof(pressure)));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x2B, motion, sizeof(motion)));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x26, gap, sizeof(gap)));
+    CHECK_EQUAL(0, getI2cMergedCount());
+
+    i2cBusFlush();
+    CHECK_EQUAL(3, transactionCount);
+    checkTransaction(0, LPS22HB_ADDRESS, 0x28, 3);
+    checkTransaction(1, LSM6DSL_ADDRESS, 0x2B, 2);
+    checkTransaction(2, LSM6DSL_ADDRESS, 0x26, 1);
+    CHECK(registersMatch(LPS22HB_ADDRESS, 0x28, pressure, sizeof(pressure)));
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x2B, motion, sizeof(motion)));
+    CHECK(registersMatch(LSM6DSL_ADDRESS, 0x26, gap, sizeof(gap)));
+}
+
+// multi byte HTS221 access sets bit 7 of the register address, single bytes and writes don't
+static void testHts221AutoIncrement() {
+    reset();
+    uint8_t humidity[2], temperature[2], status;
+    CHECK(i2cQueueRead(I2C_DEVICE_HTS221, 0x28, humidity, sizeof(humidity)));
+    CHECK(i2cQueueRead(I2C_DEVICE_HTS221, 0x2A, temperature, sizeof(temperature)));
+    i2cBusFlush();
+    checkTransaction(0, HTS221_ADDRESS, 0x28 | HTS221_AUTO_INCREMENT, 4);
+    CHECK(registersMatch(HTS221_ADDRESS, 0x28, humidity, sizeof(humidity)));
+    CHECK(registersMatch(HTS221_ADDRESS, 0x2A, temperature, sizeof(temperature)));
+
+    CHECK(i2cRead(I2C_DEVICE_HTS221, 0x27, &status, 1));
+    checkTransaction(1, HTS221_ADDRESS, 0x27, 1);
+    CHECK(registersMatch(HTS221_ADDRESS, 0x27, &status, 1));
+    CHECK(i2cRead(I2C_DEVICE_HTS221, 0x30, humidity, sizeof(humidity)));
+    checkTransaction(2, HTS221_ADDRESS, 0x30 | HTS221_AUTO_INCREMENT, 2);
+    CHECK(registersMatch(HTS221_ADDRESS, 0x30, humidity, sizeof(humidity)));
+    CHECK(i2cWrite(I2C_DEVICE_HTS221, 0x21, 0x01));
+    checkTransaction(3, HTS221_ADDRESS, 0x21, 1);
+
+    // the other sensors increment by themselves
+    CHECK(i2cRead(I2C_DEVICE_LSM6DSL, 0x22, humidity, sizeof(humidity)));
+    checkTransaction(4, LSM6DSL_ADDRESS, 0x22, 2);
+}
+
+// transactions and bytes per device, a failed burst counts an error and fails every part
+static void testAccounting() {
+    reset();
+    uint8_t data[I2C_BURST_MAX];
+    const uint8_t untouched[4] = { 0xEE, 0xEE, 0xEE, 0xEE };
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x22, data, 6));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x28, data + 6, 6));
+    CHECK(i2cQueueRead(I2C_DEVICE_LPS22HB, 0x28, data + 12, 3));
+    i2cBusFlush();
+    CHECK(i2cRead(I2C_DEVICE_HTS221, 0x27, data, 1));
+    CHECK(i2cWrite(I2C_DEVICE_HTS221, 0x21, 0x01));
+
+    CHECK_EQUAL(1, getI2cDeviceStats(I2C_DEVICE_LSM6DSL)->transactions);
+    CHECK_EQUAL(12, getI2cDeviceStats(I2C_DEVICE_LSM6DSL)->bytes);
+    CHECK_EQUAL(1, getI2cDeviceStats(I2C_DEVICE_LPS22HB)->transactions);
+    CHECK_EQUAL(3, getI2cDeviceStats(I2C_DEVICE_LPS22HB)->bytes);
+    CHECK_EQUAL(2, getI2cDeviceStats(I2C_DEVICE_HTS221)->transactions);
+    CHECK_EQUAL(2, getI2cDeviceStats(I2C_DEVICE_HTS221)->bytes);
+    CHECK_EQUAL(0, getI2cDeviceStats(I2C_DEVICE_LIS2MDL)->transactions);
+
+    completedCount = 0;
+    memcpy(data, untouched, sizeof(untouched));
+    failCount = 1;
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x22, data, 2, readDone, (void *)1));
+    CHECK(i2cQueueRead(I2C_DEVICE_LSM6DSL, 0x24, data + 2, 2, readDone, (void *)2));
+    i2cBusFlush();
+    CHECK_EQUAL(2, completedCount);
+    CHECK(!completedOk[0] && !completedOk[1]);
+    CHECK(memcmp(data, untouched, sizeof(untouched)) == 0);
+    CHECK_EQUAL(1, getI2cDeviceStats(I2C_DEVICE_LSM6DSL)->errors);
+    CHECK_EQUAL(2, getI2cDeviceStats(I2C_DEVICE_LSM6DSL)->transactions);
+
+    // vendor driver traffic
+    i2cAccount(I2C_DEVICE_LIS2MDL, micros(), 2, 7, true);
+    CHECK_EQUAL(2, getI2cDeviceStats(I2C_DEVICE_LIS2MDL)->transactions);
+    CHECK_EQUAL(7, getI2cDeviceStats(I2C_DEVICE_LIS2MDL)->bytes);
+    CHECK_STRING("lis2mdl", getI2cDeviceName(I2C_DEVICE_LIS2MDL));
+}
+
+// a callback may queue the next read, it runs in the same flush
+static uint8_t chained[2];
+
+static void queueAnother(bool ok, void *context) {
+    CHECK(ok);
+    CHECK(i2cQueueRead(I2C_DEVICE_LPS22HB, 0x2B, chained, sizeof(chained)));
+}
+
+static void testQueueFromCallback() {
+    reset();
+    uint8_t first[3];
+    CHECK(i2cQueueRead(I2C_DEVICE_LPS22HB, 0x28, first, sizeof(first), queueAnother));
+    i2cBusFlush();
+    CHECK_EQUAL(2, transactionCount);
+    CHECK(registersMatch(LPS22HB_ADDRESS, 0x2B, chained, sizeof(chained)));
+}
+
+int main() {
+    testAppend();
+    testPrepend();
+    testLimits();
+    testNoMergeAcrossDevices();
+    testHts221AutoIncrement();
+    testAccounting();
+    testQueueFromCallback();
+    return hostTestResult("i2cBusTest");
+}
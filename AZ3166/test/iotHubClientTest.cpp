@@ -0,0 +1,389 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// IoTHubClient against the fake transport in host/fakeHub.cpp: telemetry
+// batching, what happens to a batch or a message the SDK doesn't take, and
+// twin updates acknowledged with a single reported property patch.
+
+#include "../inc/globals.h"
+#include "../inc/iotHubClient.h"
+#include "../inc/ledIndicator.h"
+#include "../inc/stats.h"
+#include "../inc/timestamp.h"
+#include "hostTest.h"
+
+#define STORE_PATH "iotHubClientTest.bin"
+
+// board parts the client reaches through Globals
+const char *Globals::completedString = "completed";
+IoTHubClient *Globals::iothubClient = NULL;
+
+void ledIndicatorSignal(LedEvent event) {
+}
+
+static IoTHubClient *createClient() {
+    hostHubReset();
+    hostSetTime(1000);
+    IoTHubClient *client = new IoTHubClient(false);
+    Globals::iothubClient = client;
+    client->setConnected(true);
+    return client;
+}
+
+// confirms every message sent so far
+static void confirmAll(IoTHubClient *client) {
+    hostHubConfirm(hostHubPendingCount(), IOTHUB_CLIENT_CONFIRMATION_OK);
+    client->pump();
+}
+
+// the message pool is static, its slots are released by the confirmations
+static void destroyClient(IoTHubClient *client) {
+    while (hostHubPendingCount() > 0) {
+        confirmAll(client);
+    }
+    CHECK_EQUAL(0, client->getInFlightCount());
+    Globals::iothubClient = NULL;
+    delete client;
+}
+
+static unsigned countSamples(const char *batch) {
+    unsigned count = 0;
+    for (const char *found = strstr(batch, "\"timestamp\""); found != NULL; found = strstr(found + 1, "\"timestamp\"")) {
+        count++;
+    }
+    return count;
+}
+
+static void testBatch() {
+    IoTHubClient *client = createClient();
+    client->setBatchWindow(1000);
+
+    CHECK(client->sendTelemetry("{\"temp\":1}"));
+    CHECK(client->sendTelemetry("{\"temp\":2}"));
+    CHECK(client->sendTelemetry("{}"));
+    CHECK_EQUAL(0, hostHubSentCount());
+
+    hostAdvanceTime(1000);
+    client->checkTelemetryBatch();
+    CHECK_EQUAL(1, hostHubSentCount());
+
+    const char *batch = hostHubSent(0)->payload;
+    CHECK_EQUAL('[', batch[0]);
+    CHECK_EQUAL(']', batch[hostHubSent(0)->length - 1]);
+    CHECK_EQUAL(3, countSamples(batch));
+    CHECK(strstr(batch, "\"temp\":1}") != NULL);
+    CHECK(strstr(batch, "\"temp\":2}") != NULL);
+    CHECK(strstr(batch, "\"}]") != NULL); // the empty sample only has its timestamp
+
+    // nothing left to flush
+    CHECK(client->flushTelemetryBatch());
+    CHECK_EQUAL(1, hostHubSentCount());
+    destroyClient(client);
+}
+
+// a failed flush keeps every sample, later ones are still added
+static void testBatchKeptWhenSendFails() {
+    IoTHubClient *client = createClient();
+    client->setBatchWindow(1000);
+
+    CHECK(client->sendTelemetry("{\"temp\":1}"));
+    hostHubFailMessageCreate(1);
+    CHECK(!client->flushTelemetryBatch());
+    CHECK_EQUAL(0, hostHubSentCount());
+
+    CHECK(client->sendTelemetry("{\"temp\":2}"));
+    hostHubFailSend(1);
+    CHECK(!client->flushTelemetryBatch());
+    CHECK_EQUAL(0, hostHubSentCount());
+    CHECK_EQUAL(0, client->getInFlightCount());
+
+    CHECK(client->flushTelemetryBatch());
+    CHECK_EQUAL(1, hostHubSentCount());
+    CHECK_EQUAL(2, countSamples(hostHubSent(0)->payload));
+    CHECK_EQUAL(']', hostHubSent(0)->payload[hostHubSent(0)->length - 1]);
+    destroyClient(client);
+}
+
+static void testBatchKeptWhileBackpressured() {
+    IoTHubClient *client = createClient();
+    client->setMaxInFlight(1);
+    CHECK(client->sendTelemetry("{\"live\":1}", 10, MESSAGE_FORMAT_JSON));
+    CHECK(client->isBackpressured());
+
+    client->setBatchWindow(1000);
+    CHECK(client->sendTelemetry("{\"temp\":1}"));
+    CHECK(!client->flushTelemetryBatch());
+    CHECK_EQUAL(1, hostHubSentCount());
+
+    confirmAll(client);
+    CHECK(!client->isBackpressured());
+    CHECK(client->flushTelemetryBatch());
+    CHECK_EQUAL(2, hostHubSentCount());
+    CHECK_EQUAL(1, countSamples(hostHubSent(1)->payload));
+    destroyClient(client);
+}
+
+// a full batch that can't be sent takes no more samples instead of dropping itself
+static void testFullBatchNotDropped() {
+    IoTHubClient *client = createClient();
+    client->setBatchWindow(60000);
+
+    char sample[STRING_BUFFER_512];
+    memset(sample, 0, sizeof(sample));
+    strcpy(sample, "{\"pad\":\"");
+    memset(sample + strlen(sample), 'x', 400);
+    strcat(sample, "\"}");
+
+    unsigned added = 0;
+    while (hostHubSentCount() == 0) {
+        hostHubFailMessageCreate(1); // only the flush of a full batch creates a message
+        if (!client->sendTelemetry(sample)) break;
+        added++;
+    }
+    CHECK(added > 1);
+    CHECK_EQUAL(0, hostHubSentCount());
+
+    CHECK(client->flushTelemetryBatch());
+    CHECK_EQUAL(1, hostHubSentCount());
+    CHECK_EQUAL(added, countSamples(hostHubSent(0)->payload));
+    CHECK(hostHubSent(0)->length <= IOTHUB_BATCH_MAX_SIZE);
+    destroyClient(client);
+}
+
+// with an offline queue nothing waits in the batch, what the SDK refuses is queued
+static void testRefusedTelemetryQueued() {
+    remove(STORE_PATH);
+    FileFlashStore file(STORE_PATH, 1024, 3);
+    TelemetryQueue queue(file);
+    CHECK(queue.init());
+
+    IoTHubClient *client = createClient();
+    client->setOfflineQueue(&queue);
+    client->setBatchWindow(1000);
+
+    CHECK(client->sendTelemetry("{\"temp\":1}"));
+    hostHubFailSend(1);
+    CHECK(client->flushTelemetryBatch());
+    CHECK_EQUAL(1, queue.getCount());
+    CHECK_EQUAL(0, hostHubSentCount());
+
+    // live messages the same, whether the SDK refuses them or the window is full
+    client->setBatchWindow(0);
+    hostHubFailMessageCreate(1);
+    CHECK(client->sendTelemetry("{\"temp\":2}"));
+    CHECK_EQUAL(2, queue.getCount());
+
+    client->setMaxInFlight(1);
+    CHECK(client->sendTelemetry("{\"temp\":3}"));
+    CHECK(client->sendTelemetry("{\"temp\":4}"));
+    CHECK_EQUAL(1, hostHubSentCount());
+    CHECK_EQUAL(3, queue.getCount());
+
+    // and replayed in order once there is room
+    client->setMaxInFlight(DEFAULT_MAX_IN_FLIGHT);
+    for (int i = 0; i < 20 && queue.getCount() > 0; i++) {
+        hostAdvanceTime(TELEMETRY_REPLAY_INTERVAL);
+        confirmAll(client);
+    }
+    CHECK_EQUAL(0, queue.getCount());
+    CHECK_EQUAL(4, hostHubSentCount());
+    CHECK(strstr(hostHubSent(1)->payload, "\"temp\":1}]") != NULL);
+    CHECK_STRING("{\"temp\":2}", hostHubSent(2)->payload);
+    CHECK_STRING("{\"temp\":4}", hostHubSent(3)->payload);
+
+    destroyClient(client);
+    remove(STORE_PATH);
+}
+
+// a message the hub rejects goes to the queue as well
+static void testRejectedTelemetryQueued() {
+    remove(STORE_PATH);
+    FileFlashStore file(STORE_PATH, 1024, 3);
+    TelemetryQueue queue(file);
+    CHECK(queue.init());
+
+    IoTHubClient *client = createClient();
+    client->setOfflineQueue(&queue);
+    CHECK(client->sendTelemetry("{\"temp\":1}"));
+    hostHubConfirm(1, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+    client->pump();
+    CHECK_EQUAL(0, client->getInFlightCount());
+    CHECK_EQUAL(1, queue.getCount());
+
+    // the payload is read back from the SDK's message
+    QUEUED_MESSAGE queued;
+    char payload[STRING_BUFFER_128] = {0};
+    CHECK(queue.peek(&queued, payload, sizeof(payload)));
+    CHECK_EQUAL(10, queued.length);
+    CHECK_STRING("{\"temp\":1}", payload);
+
+    destroyClient(client);
+    remove(STORE_PATH);
+}
+
+// a message too large to ever be sent isn't queued, and one already in the
+// queue is dropped instead of holding up the replay of everything behind it
+static void testOversizedTelemetryDropped() {
+    remove(STORE_PATH);
+    FileFlashStore file(STORE_PATH, 2 * IOTHUB_MESSAGE_MAX_SIZE, 3);
+    TelemetryQueue queue(file);
+    CHECK(queue.init());
+
+    IoTHubClient *client = createClient();
+    client->setOfflineQueue(&queue);
+
+    static char large[IOTHUB_MESSAGE_MAX_SIZE];
+    memset(large, ' ', sizeof(large));
+    large[0] = '{';
+    large[sizeof(large) - 1] = '}';
+    CHECK(!client->sendTelemetry(large, IOTHUB_BATCH_MAX_SIZE + 1, MESSAGE_FORMAT_JSON));
+    CHECK_EQUAL(0, queue.getCount());
+    CHECK_EQUAL(0, hostHubSentCount());
+
+    // left by a build that still queued it
+    const int dropped = getOfflineDroppedCount();
+    CHECK(queue.push(large, sizeof(large), MESSAGE_FORMAT_JSON, 0, 0));
+    CHECK(queue.push("{\"temp\":1}", 10, MESSAGE_FORMAT_JSON, 0, 0));
+    for (int i = 0; i < 10 && queue.getCount() > 0; i++) {
+        hostAdvanceTime(TELEMETRY_REPLAY_INTERVAL);
+        confirmAll(client);
+    }
+    CHECK_EQUAL(0, queue.getCount());
+    CHECK_EQUAL(dropped + 1, getOfflineDroppedCount());
+    CHECK_EQUAL(1, hostHubSentCount());
+    CHECK_STRING("{\"temp\":1}", hostHubSent(0)->payload);
+
+    destroyClient(client);
+    remove(STORE_PATH);
+}
+
+// a desired patch is timed from when the hub stored it, on the synced clock
+static void testTwinDeliveryLatency() {
+    IoTHubClient *client = createClient();
+    const unsigned long deliveries = getTwinDeliveryCount();
+
+    // before the clock is synced the hub time isn't comparable
+    hostHubTwin(DEVICE_TWIN_UPDATE_PARTIAL,
+        "{\"fanSpeed\":1,\"$metadata\":{\"$lastUpdated\":\"2017-10-01T18:02:16.4801234Z\"},\"$version\":2}");
+    CHECK_EQUAL(deliveries, getTwinDeliveryCount());
+
+    set_time(1506880936 + 2);
+    anchorCurrentTime();
+    hostAdvanceTime(130);
+    hostHubTwin(DEVICE_TWIN_UPDATE_PARTIAL,
+        "{\"fanSpeed\":2,\"$metadata\":{\"$lastUpdated\":\"2017-10-01T18:02:16.4801234Z\","
+        "\"fanSpeed\":{\"$lastUpdated\":\"2017-10-01T18:02:00.0Z\"}},\"$version\":3}");
+    CHECK_EQUAL(deliveries + 1, getTwinDeliveryCount());
+    CHECK_EQUAL(2000 + 130 - 480, getTwinDeliveryLatencyMax());
+
+    // a full twin carries the time of an older patch
+    hostHubTwin(DEVICE_TWIN_UPDATE_COMPLETE,
+        "{\"desired\":{\"$metadata\":{\"$lastUpdated\":\"2017-10-01T18:00:00Z\"},\"$version\":3},"
+        "\"reported\":{\"$version\":1}}");
+    CHECK_EQUAL(deliveries + 1, getTwinDeliveryCount());
+    destroyClient(client);
+}
+
+// desired property handlers of the twin tests, counting their calls
+static int twinFanCalls = 0;
+static int twinVoltageCalls = 0;
+static int twinModeCalls = 0;
+
+static int twinFan(const char *, size_t, char **, size_t *) { twinFanCalls++; return 200; }
+static int twinVoltage(const char *, size_t, char **, size_t *) { twinVoltageCalls++; return 200; }
+static int twinMode(const char *, size_t, char **, size_t *) { twinModeCalls++; return 200; }
+
+// the desired callbacks are static, registered once for every client
+static void registerTwinHandlers(IoTHubClient *client) {
+    static bool registered = false;
+    if (!registered) {
+        CHECK(client->registerDesiredProperty("twinFan", twinFan));
+        CHECK(client->registerDesiredProperty("twinVoltage", twinVoltage));
+        CHECK(client->registerDesiredProperty("twinMode", twinMode));
+        registered = true;
+    }
+    twinFanCalls = twinVoltageCalls = twinModeCalls = 0;
+}
+
+// every handler of a partial update runs, their acknowledgements go out as one patch
+static void testTwinPatchMerged() {
+    IoTHubClient *client = createClient();
+    registerTwinHandlers(client);
+    const int reportedCount = getReportedCount();
+
+    hostHubTwin(DEVICE_TWIN_UPDATE_PARTIAL,
+        "{\"twinFan\":{\"value\":3},\"twinVoltage\":5,\"twinMode\":\"eco\",\"unregistered\":1,\"$version\":7}");
+    CHECK_EQUAL(1, twinFanCalls);
+    CHECK_EQUAL(1, twinVoltageCalls);
+    CHECK_EQUAL(1, twinModeCalls);
+    CHECK_EQUAL(0, hostHubReportedCount());
+
+    client->pump();
+    CHECK_EQUAL(1, hostHubReportedCount());
+    const char *patch = hostHubReported(0);
+    CHECK(strstr(patch, "\"twinFan\":{\"value\":3,\"statusCode\":200,\"status\":\"completed\",\"desiredVersion\":7}")
+          != NULL);
+    CHECK(strstr(patch, "\"twinVoltage\":{\"value\":5,") != NULL);
+    CHECK(strstr(patch, "\"twinMode\":{\"value\":\"eco\",") != NULL);
+    CHECK(strstr(patch, "unregistered") == NULL);
+
+    // confirmed on the same pump, nothing is sent again
+    CHECK_EQUAL(reportedCount + 3, getReportedCount());
+    client->pump();
+    CHECK_EQUAL(1, hostHubReportedCount());
+    destroyClient(client);
+}
+
+// a full twin whose reported side already acknowledged the desired version runs nothing
+static void testTwinAlreadyReported() {
+    IoTHubClient *client = createClient();
+    registerTwinHandlers(client);
+
+    hostHubTwin(DEVICE_TWIN_UPDATE_COMPLETE,
+        "{\"desired\":{\"twinFan\":{\"value\":3},\"twinVoltage\":5,\"$version\":7},"
+        "\"reported\":{\"twinFan\":{\"value\":3,\"statusCode\":200,\"status\":\"completed\",\"desiredVersion\":7},"
+        "\"twinVoltage\":{\"value\":5,\"statusCode\":200,\"status\":\"completed\",\"desiredVersion\":7},"
+        "\"$version\":4}}");
+    client->pump();
+    CHECK_EQUAL(0, twinFanCalls);
+    CHECK_EQUAL(0, twinVoltageCalls);
+    CHECK_EQUAL(0, hostHubReportedCount());
+    destroyClient(client);
+}
+
+// only the desired version moved: acknowledged under the new version, the handler doesn't run again,
+// a value that did change still runs its handler
+static void testTwinVersionOnlyChange() {
+    IoTHubClient *client = createClient();
+    registerTwinHandlers(client);
+
+    hostHubTwin(DEVICE_TWIN_UPDATE_COMPLETE,
+        "{\"desired\":{\"twinFan\":{\"value\":3},\"twinVoltage\":6,\"$version\":8},"
+        "\"reported\":{\"twinFan\":{\"value\":3,\"statusCode\":200,\"status\":\"completed\",\"desiredVersion\":7},"
+        "\"twinVoltage\":{\"value\":5,\"statusCode\":200,\"status\":\"completed\",\"desiredVersion\":7},"
+        "\"$version\":4}}");
+    CHECK_EQUAL(0, twinFanCalls);
+    CHECK_EQUAL(1, twinVoltageCalls);
+
+    client->pump();
+    CHECK_EQUAL(1, hostHubReportedCount());
+    CHECK(strstr(hostHubReported(0),
+                 "\"twinFan\":{\"value\":3,\"statusCode\":200,\"status\":\"completed\",\"desiredVersion\":8}") != NULL);
+    CHECK(strstr(hostHubReported(0), "\"twinVoltage\":{\"value\":6,") != NULL);
+    destroyClient(client);
+}
+
+int main() {
+    testBatch();
+    testBatchKeptWhenSendFails();
+    testBatchKeptWhileBackpressured();
+    testFullBatchNotDropped();
+    testRefusedTelemetryQueued();
+    testRejectedTelemetryQueued();
+    testOversizedTelemetryDropped();
+    testTwinDeliveryLatency();
+    testTwinPatchMerged();
+    testTwinAlreadyReported();
+    testTwinVersionOnlyChange();
+    return hostTestResult("iotHubClientTest");
+}
@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The motion FIFO drain against a simulated LSM6DSL FIFO behind i2cRead()
+// and i2cWrite(): realigning on a FIFO that starts within a sample, a partial
+// sample left for the next drain, the watermark, and readers that keep up or
+// fall more than MOTION_RING_SIZE samples behind.
+
+#include "../inc/globals.h"
+#include "../inc/motionFifo.h"
+#include "../inc/i2cBus.h"
+#include "LSM6DSLSensor.h"
+#include "hostTest.h"
+
+#define FIFO_CTRL1 0x06
+#define FIFO_CTRL2 0x07
+#define FIFO_CTRL5 0x0A
+#define FIFO_STATUS1 0x3A
+#define FIFO_DATA_OUT_L 0x3E
+
+#define FIFO_WORDS 4096 // the sensor holds 4 KB, 2048 words
+#define WORDS_PER_SAMPLE 6
+
+// words the sensor wrote, numbered from the first gyroscope x of the run
+static uint32_t fifoWritten = 0;
+static uint32_t fifoRead = 0;
+static unsigned watermarkWords = 0;
+static bool overrun = false;
+static unsigned dataReads = 0;
+
+// gyroscope x, y, z then accelerometer x, y, z of sample word / 6
+static int16_t wordValue(uint32_t word) {
+    const uint32_t sample = word / WORDS_PER_SAMPLE;
+    const unsigned position = word % WORDS_PER_SAMPLE;
+    return (int16_t)((sample % 4096) * 8 * (position < 3 ? 1 : -1) + position);
+}
+
+static void checkSample(uint32_t sample, const MOTION_SAMPLE &actual) {
+    bool matches = true;
+    for (int axis = 0; axis < 3; axis++) {
+        matches = matches && actual.gyro[axis] == wordValue(sample * WORDS_PER_SAMPLE + axis) &&
+                  actual.accel[axis] == wordValue(sample * WORDS_PER_SAMPLE + 3 + axis);
+    }
+    CHECK(matches);
+}
+
+bool i2cRead(I2cDevice device, uint8_t reg, uint8_t *data, uint16_t length) {
+    if (device != I2C_DEVICE_LSM6DSL) {
+        return false;
+    }
+
+    const unsigned unread = fifoWritten - fifoRead;
+    if (reg == FIFO_STATUS1 && length == 4) {
+        const unsigned pattern = fifoRead % WORDS_PER_SAMPLE;
+        data[0] = unread & 0xFF;
+        data[1] = ((unread >> 8) & 0x07) | (unread >= watermarkWords ? 0x80 : 0) | (overrun ? 0x40 : 0);
+        data[2] = pattern & 0xFF;
+        data[3] = pattern >> 8;
+        return true;
+    }
+
+    // the address wraps within FIFO_DATA_OUT_L and _H, every two bytes are the next word
+    if (reg == FIFO_DATA_OUT_L && length % 2 == 0 && length / 2 <= unread) {
+        for (unsigned i = 0; i < length / 2; i++) {
+            const uint16_t word = (uint16_t)wordValue(fifoRead++);
+            data[i * 2] = word & 0xFF;
+            data[i * 2 + 1] = word >> 8;
+        }
+        dataReads++;
+        return true;
+    }
+    return false;
+}
+
+bool i2cWrite(I2cDevice device, uint8_t reg, uint8_t value) {
+    if (reg == FIFO_CTRL1) {
+        watermarkWords = (watermarkWords & 0x700) | value;
+    } else if (reg == FIFO_CTRL2) {
+        watermarkWords = (watermarkWords & 0xFF) | ((value & 0x07) << 8);
+    }
+    return device == I2C_DEVICE_LSM6DSL;
+}
+
+// the sensor starts its FIFO at firstWord, as if it was running before
+static void restart(uint32_t firstWord, unsigned watermark) {
+    static LSM6DSLSensor sensor;
+    fifoWritten = fifoRead = firstWord;
+    overrun = false;
+    CHECK(motionFifoInit(&sensor, MOTION_ODR_416HZ, watermark));
+    CHECK_EQUAL(watermark * WORDS_PER_SAMPLE, watermarkWords);
+    CHECK_EQUAL(416.0f, sensor.accelOdr);
+    CHECK_EQUAL(416.0f, sensor.gyroOdr);
+}
+
+static void produce(unsigned words) {
+    fifoWritten += words;
+    assert(fifoWritten - fifoRead <= FIFO_WORDS);
+}
+
+// reads everything a reader has, checking it is samples first .. first + count - 1
+static void checkRead(int reader, uint32_t first, unsigned count) {
+    static MOTION_SAMPLE samples[MOTION_RING_SIZE + 1];
+    CHECK_EQUAL(count, motionRead(reader, samples, MOTION_RING_SIZE + 1));
+    for (unsigned i = 0; i < count; i++) {
+        checkSample(first + i, samples[i]);
+    }
+}
+
+// the FIFO didn't start on a gyroscope x word: the rest of that sample is
+// dropped and every sample after it is whole
+static void testPatternRealign() {
+    const uint32_t start = 10 * WORDS_PER_SAMPLE + 4;
+    restart(start, 4);
+    const int reader = motionAddReader();
+    CHECK(reader >= 0);
+    const unsigned long dropped = getMotionDroppedWordCount();
+
+    produce(2 + 5 * WORDS_PER_SAMPLE);
+    CHECK_EQUAL(5, motionFifoDrain(false));
+    CHECK_EQUAL(dropped + 2, getMotionDroppedWordCount());
+    checkRead(reader, 11, 5);
+
+    // fewer words than the rest of the sample: nothing is skipped yet
+    restart(20 * WORDS_PER_SAMPLE + 1, 1);
+    const int second = motionAddReader();
+    produce(3);
+    CHECK_EQUAL(0, motionFifoDrain(true));
+    CHECK_EQUAL(dropped + 2, getMotionDroppedWordCount());
+    produce(2 + WORDS_PER_SAMPLE);
+    CHECK_EQUAL(1, motionFifoDrain(true));
+    CHECK_EQUAL(dropped + 2 + 5, getMotionDroppedWordCount());
+    checkRead(second, 21, 1);
+}
+
+// a sample only partly in the FIFO stays there for the next drain
+static void testPartialSample() {
+    restart(0, 8);
+    const int reader = motionAddReader();
+
+    produce(3 * WORDS_PER_SAMPLE + 4);
+    CHECK_EQUAL(0, motionFifoDrain(false)); // below the watermark
+    CHECK_EQUAL(3, motionFifoDrain(true));
+    CHECK_EQUAL(4, fifoWritten - fifoRead);
+    checkRead(reader, 0, 3);
+
+    produce(2);
+    CHECK_EQUAL(1, motionFifoDrain(true));
+    CHECK_EQUAL(0, fifoWritten - fifoRead);
+    checkRead(reader, 3, 1);
+    CHECK_EQUAL(4, getMotionSampleCount());
+}
+
+// a drain reads MOTION_BURST_SAMPLES at a time, a sensor overrun is counted
+static void testBursts() {
+    restart(0, 40);
+    const int reader = motionAddReader();
+
+    produce(40 * WORDS_PER_SAMPLE + 3);
+    dataReads = 0;
+    CHECK_EQUAL(40, motionFifoDrain(false));
+    CHECK_EQUAL((40 + MOTION_BURST_SAMPLES - 1) / MOTION_BURST_SAMPLES, dataReads);
+    checkRead(reader, 0, 40);
+
+    const unsigned long overruns = getMotionFifoOverrunCount();
+    overrun = true;
+    produce(3);
+    CHECK_EQUAL(1, motionFifoDrain(false));
+    CHECK_EQUAL(overruns + 1, getMotionFifoOverrunCount());
+    checkRead(reader, 40, 1);
+}
+
+// a reader more than MOTION_RING_SIZE behind gets the newest MOTION_RING_SIZE
+// samples and counts the rest, the others aren't affected
+static void testReaderOverrun() {
+    restart(0, 32);
+    const int fast = motionAddReader();
+    const int slow = motionAddReader();
+    CHECK(fast >= 0 && slow >= 0 && fast != slow);
+
+    const unsigned total = MOTION_RING_SIZE + 100;
+    for (unsigned drained = 0; drained < total; drained += 32) {
+        produce(32 * WORDS_PER_SAMPLE);
+        CHECK_EQUAL(32, motionFifoDrain(false));
+        checkRead(fast, drained, 32);
+    }
+    const unsigned written = (total + 31) / 32 * 32;
+    CHECK_EQUAL(0, getMotionReaderOverrunCount(fast));
+
+    checkRead(slow, written - MOTION_RING_SIZE, MOTION_RING_SIZE);
+    CHECK_EQUAL(written - MOTION_RING_SIZE, getMotionReaderOverrunCount(slow));
+
+    // caught up, nothing more is missed
+    produce(32 * WORDS_PER_SAMPLE);
+    motionFifoDrain(false);
+    checkRead(slow, written, 32);
+    CHECK_EQUAL(written - MOTION_RING_SIZE, getMotionReaderOverrunCount(slow));
+
+    // a reader added now starts at the next sample
+    const int late = motionAddReader();
+    checkRead(late, 0, 0);
+    produce(32 * WORDS_PER_SAMPLE);
+    motionFifoDrain(false);
+    checkRead(late, written + 32, 32);
+    CHECK(motionAddReader() >= 0);
+    CHECK_EQUAL(-1, motionAddReader()); // MOTION_MAX_READERS taken
+}
+
+// raw words to mg and mdps with the sensitivity the driver reported
+static void testUnits() {
+    restart(0, 1);
+    MOTION_SAMPLE sample = { { 1000, -1000, 32767 }, { 16394, -16394, 0 } };
+    int32_t accel[3], gyro[3];
+    motionToUnits(&sample, accel, gyro);
+    CHECK_EQUAL(61, getMotionAccelSensitivity());
+    CHECK_EQUAL(1000, accel[0]); // 16394 * 0.061 mg, truncated
+    CHECK_EQUAL(-1000, accel[1]);
+    CHECK_EQUAL(0, accel[2]);
+    CHECK_EQUAL(4375, gyro[0]);
+    CHECK_EQUAL(-4375, gyro[1]);
+    CHECK_EQUAL(143355, gyro[2]);
+    CHECK_EQUAL(416000, getMotionOdrMilliHz());
+}
+
+int main() {
+    testPatternRealign();
+    testPartialSample();
+    testBursts();
+    testReaderOverrun();
+    testUnits();
+    return hostTestResult("motionFifoTest");
+}
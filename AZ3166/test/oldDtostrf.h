@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef OLD_DTOSTRF_H
+#define OLD_DTOSTRF_H
+
+// The dtostrf of utility.cpp before it was rebuilt on formatUnsigned(), kept
+// for the tests and benchmarks to compare with. The integer part goes through
+// sprintf("%d"), cast to int as the 32 bit unsigned long is on the board, so
+// values past 2^31 print negative like they did there.
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static char *oldDtostrf(double number, signed char width, unsigned char prec, char *s) {
+    if(isnan(number)) {
+        strcpy(s, "nan");
+        return s;
+    }
+    if(isinf(number)) {
+        strcpy(s, "inf");
+        return s;
+    }
+
+    if(number > 4294967040.0 || number < -4294967040.0) {
+        strcpy(s, "ovf");
+        return s;
+    }
+    char* out = s;
+    // Handle negative numbers
+    if(number < 0.0) {
+        *out = '-';
+        ++out;
+        number = -number;
+    }
+    // Round correctly so that print(1.999, 2) prints as "2.00"
+    double rounding = 0.5;
+    for(uint8_t i = 0; i < prec; ++i) {
+        rounding /= 10.0;
+    }
+    number += rounding;
+
+    // Extract the integer part of the number and print it
+    uint32_t int_part = (uint32_t) number;
+    double remainder = number - (double) int_part;
+    out += sprintf(out, "%d", (int) int_part);
+
+    // Print the decimal point, but only if there are digits beyond
+    if(prec > 0) {
+        *out = '.';
+        ++out;
+    }
+
+    while(prec-- > 0) {
+        remainder *= 10.0;
+        if((int)remainder == 0){
+            *out = '0';
+            ++out;
+        }
+    }
+    sprintf(out, "%d", (int) remainder);
+    return s;
+}
+
+#endif // OLD_DTOSTRF_H
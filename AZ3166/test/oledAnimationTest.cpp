@@ -0,0 +1,152 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The sprites compileSprite() builds at compile time against the renderer it
+// replaced, which expanded the ASCII art into a heap buffer on every frame:
+// every animation frame and a frame of every tile must come out byte for
+// byte the same, and renderNextFrame() must draw them in the same place.
+
+#include "../inc/globals.h"
+#include "OledDisplay.h"
+#include "../inc/oledAnimation.h"
+#include "../inc/animationFrames.h"
+#include "hostTest.h"
+
+#define OLD_WIDTH 64
+#define OLD_BUFFER_SIZE 1024
+
+// a few bytes checked while compiling, the pads stay clear
+static_assert(compileSprite(dieArt[0]).bitmap[0] == 0x00, "left pad");
+static_assert(compileSprite(dieArt[0]).bitmap[SPRITE_PAD] == 0xFF, "corner left top");
+static_assert(compileSprite(dieArt[0]).bitmap[SPRITE_PAD + 2] == 0x03, "corner left top");
+static_assert(compileSprite(dieArt[0]).bitmap[SPRITE_PAD + SPRITE_WIDTH] == 0x00, "right pad");
+static_assert(compileSprite(dieArt[0]).bitmap[7 * SPRITE_STRIDE + SPRITE_PAD + 7 * 8 + 1] == 0x00,
+              "corner right bottom");
+static_assert(compileSprite(fanArt[0]).bitmap[2 * SPRITE_STRIDE + SPRITE_PAD + 8] == 0x03, "diagonal");
+
+// the tiles and the compare chain of the old renderNextFrame()
+static const unsigned char block[]  = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static const unsigned char blockGap[]  = {0x7E, 0x7E, 0x7E, 0x7E, 0x7E, 0x7E, 0x7E, 0x7E};
+static const unsigned char blockVGap[]  = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00};
+static const unsigned char cross[]  = {0x81, 0x42, 0x24, 0x18, 0x18, 0x24, 0x42, 0x81};
+static const unsigned char diagRL[] = {0xC0, 0xE0, 0x70, 0x38, 0x1C, 0x0E, 0x07, 0x03};
+static const unsigned char diagLR[] = {0x03, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xC0};
+static const unsigned char horzB[]  = {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01};
+static const unsigned char horzT[]  = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80};
+static const unsigned char vertL[]  = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF};
+static const unsigned char vertR[]  = {0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+static const unsigned char circle[] = {0x18, 0x7E, 0x7E, 0xFF, 0xFF, 0x7E, 0x7E, 0x18};
+static const unsigned char clear[]  = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+static const unsigned char borderBottom[]  = {0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0};
+static const unsigned char borderTop[]  = {0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03};
+static const unsigned char borderLeft[]  = {0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+static const unsigned char borderRight[]  = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF};
+static const unsigned char cornerLB[]  = {0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0};
+static const unsigned char cornerRB[]  = {0xC0, 0x00, 0xC0, 0xC0, 0xC0, 0xC0, 0xFF, 0xFF};
+static const unsigned char cornerLT[]  = {0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03};
+static const unsigned char cornerRT[]  = {0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0xFF, 0xFF};
+static const unsigned char circleLT[]  = {0x00, 0xF0, 0xF8, 0xFC, 0xFC, 0xFE, 0xFE, 0xFE};
+static const unsigned char circleRT[]  = {0xFE, 0xFE, 0xFE, 0xFC, 0xFC, 0xF8, 0xF0, 0x00};
+static const unsigned char circleLB[]  = {0x00, 0x0F, 0x1F, 0x3F, 0x3F, 0x7F, 0x7F, 0x7F};
+static const unsigned char circleRB[]  = {0x7F, 0x7F, 0x7F, 0x3F, 0x3F, 0x1F, 0x0F, 0x00};
+
+static const struct { char cell; const unsigned char *tile; } oldTiles[] = {
+    {'B', block}, {'G', blockGap}, {'g', blockVGap}, {'X', cross}, {'L', diagLR}, {'R', diagRL},
+    {'H', horzT}, {'h', horzB}, {'V', vertL}, {'v', vertR}, {'O', circle}, {'.', clear},
+    {'T', borderTop}, {'b', borderBottom}, {'<', borderLeft}, {'>', borderRight},
+    {'1', cornerLT}, {'2', cornerRT}, {'3', cornerLB}, {'4', cornerRB},
+    {'!', circleLT}, {'@', circleRT}, {'#', circleLB}, {'$', circleRB}
+};
+
+static void oldRender(const char *image, unsigned char *buf) {
+    int columnPad = 3;
+    memset(buf, 0x00, OLD_BUFFER_SIZE);
+    const int colLimit = OLD_WIDTH / 8;
+
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < colLimit; x++) {
+            for (unsigned t = 0; t < sizeof(oldTiles) / sizeof(oldTiles[0]); t++) {
+                if (image[(y * colLimit) + x] == oldTiles[t].cell) {
+                    memcpy(buf + columnPad, oldTiles[t].tile, 8);
+                    break;
+                }
+            }
+            columnPad = columnPad + 8;
+        }
+        columnPad = columnPad + 8;
+    }
+}
+
+// what the old renderer put on the display, the draw covers (x1 - x0) * 8 bytes
+static void checkSprite(const char *art, const Sprite &sprite) {
+    static unsigned char buf[OLD_BUFFER_SIZE];
+    oldRender(art, buf);
+    CHECK_EQUAL((OLD_WIDTH + 8) * 8, sizeof(sprite.bitmap));
+    CHECK(memcmp(buf, sprite.bitmap, sizeof(sprite.bitmap)) == 0);
+}
+
+static void testFrames() {
+    for (unsigned i = 0; i < FAN_FRAME_COUNT; i++) {
+        checkSprite(fanArt[i], compileSprite(fanArt[i]));
+    }
+    for (unsigned i = 0; i < VOLTAGE_FRAME_COUNT; i++) {
+        checkSprite(voltageArt[i], compileSprite(voltageArt[i]));
+    }
+    for (unsigned i = 0; i < CURRENT_FRAME_COUNT; i++) {
+        checkSprite(currentArt[i], compileSprite(currentArt[i]));
+    }
+    for (unsigned i = 0; i < DIE_FRAME_COUNT; i++) {
+        checkSprite(dieArt[i], compileSprite(dieArt[i]));
+    }
+}
+
+// every tile character, and characters that aren't tiles left clear
+static void testEveryTile() {
+    static constexpr char art[SPRITE_CELLS + 1] =
+        ".BGgXRLH"
+        "hVvOTb<>"
+        "1234!@#$"
+        "?a Z0~*&"
+        "$#@!4321"
+        "><bTOvVh"
+        "HLRXgGB."
+        "B?B?B?B?";
+    static constexpr Sprite sprite = compileSprite(art);
+    checkSprite(art, sprite);
+}
+
+// the old renderer drew at the same place, from one draw of 72 x 8 pixels
+static void checkDraws(const Sprite **frames, int count, int moveLimit, bool center) {
+    animationInit(frames, count, moveLimit, 0, center);
+    int move = 0;
+    for (int i = 0; i < 3 * count; i++) {
+        const int centerPad = center ? (126 - OLD_WIDTH) / 2 : 0;
+        CHECK_EQUAL(move + centerPad, Screen.drawArea[0]);
+        CHECK_EQUAL(0, Screen.drawArea[1]);
+        CHECK_EQUAL(OLD_WIDTH + 8 + move + centerPad, Screen.drawArea[2]);
+        CHECK_EQUAL(8, Screen.drawArea[3]);
+        CHECK(Screen.drawBitmap == frames[i % count]->bitmap);
+
+        move = move / 8 < moveLimit ? move + 8 : 0;
+        renderNextFrame();
+    }
+    animationEnd();
+}
+
+static void testDraws() {
+    static constexpr Sprite die1 = compileSprite(dieArt[0]);
+    static constexpr Sprite die2 = compileSprite(dieArt[1]);
+    static constexpr Sprite die3 = compileSprite(dieArt[2]);
+    const Sprite *frames[] = { &die1, &die2, &die3 };
+
+    checkDraws(frames, 3, 0, true);
+    checkDraws(frames, 3, 0, false);
+    checkDraws(frames, 3, 4, false);
+}
+
+int main() {
+    testFrames();
+    testEveryTile();
+    testDraws();
+    return hostTestResult("oledAnimationTest");
+}
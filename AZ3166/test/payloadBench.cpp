@@ -0,0 +1,183 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The telemetry payload built through JsonWriter against the Arduino String
+// concatenation it replaced, on the same sensor readings: the output must be
+// byte for byte the same, and every heap call and cycle of each is counted.
+
+#include "../inc/globals.h"
+#include "../inc/jsonWriter.h"
+#include "../inc/utility.h"
+#include "hostTest.h"
+
+#include <malloc.h>
+
+#define PAYLOAD_COUNT 100000
+
+// every heap call of the program goes through these, glibc's own do the work
+static unsigned long heapCalls = 0;
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+
+extern "C" void *malloc(size_t size) {
+    heapCalls++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size) {
+    heapCalls++;
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+    heapCalls++;
+    return __libc_calloc(count, size);
+}
+
+// what the sensors returned before the readings became scaled integers
+typedef struct READINGS_TAG {
+    float humidity;
+    float temp;
+    float pressure;
+    int magnetometer[3];
+    int accelerometer[3];
+    int gyroscope[3];
+} READINGS;
+
+// the String path of buildTelemetryPayload() before JsonWriter, every sensor selected
+static void buildStringPayload(const READINGS &readings, String *payload) {
+    *payload = "{";
+
+    payload->concat(",\"humidity\":");
+    payload->concat(String(readings.humidity));
+    payload->concat(",\"temp\":");
+    payload->concat(String(readings.temp));
+    payload->concat(",\"pressure\":");
+    payload->concat(String(readings.pressure));
+
+    payload->concat(",\"magnetometerX\":");
+    payload->concat(String(readings.magnetometer[0]));
+    payload->concat(",\"magnetometerY\":");
+    payload->concat(String(readings.magnetometer[1]));
+    payload->concat(",\"magnetometerZ\":");
+    payload->concat(String(readings.magnetometer[2]));
+
+    payload->concat(",\"accelerometerX\":");
+    payload->concat(String(readings.accelerometer[0]));
+    payload->concat(",\"accelerometerY\":");
+    payload->concat(String(readings.accelerometer[1]));
+    payload->concat(",\"accelerometerZ\":");
+    payload->concat(String(readings.accelerometer[2]));
+
+    payload->concat(",\"gyroscopeX\":");
+    payload->concat(String(readings.gyroscope[0]));
+    payload->concat(",\"gyroscopeY\":");
+    payload->concat(String(readings.gyroscope[1]));
+    payload->concat(",\"gyroscopeZ\":");
+    payload->concat(String(readings.gyroscope[2]));
+
+    payload->concat("}");
+    payload->replace("{,", "{");
+}
+
+// the same payload through JsonWriter, as buildTelemetryPayload() wrote it with float readings
+static unsigned buildWriterPayload(const READINGS &readings, char *payload, unsigned payloadSize) {
+    JsonWriter writer(payload, payloadSize);
+    writer.beginObject();
+
+    writer.appendFloat(JSON_KEY("humidity"), readings.humidity);
+    writer.appendFloat(JSON_KEY("temp"), readings.temp);
+    writer.appendFloat(JSON_KEY("pressure"), readings.pressure);
+
+    writer.appendInt(JSON_KEY("magnetometerX"), readings.magnetometer[0]);
+    writer.appendInt(JSON_KEY("magnetometerY"), readings.magnetometer[1]);
+    writer.appendInt(JSON_KEY("magnetometerZ"), readings.magnetometer[2]);
+
+    writer.appendInt(JSON_KEY("accelerometerX"), readings.accelerometer[0]);
+    writer.appendInt(JSON_KEY("accelerometerY"), readings.accelerometer[1]);
+    writer.appendInt(JSON_KEY("accelerometerZ"), readings.accelerometer[2]);
+
+    writer.appendInt(JSON_KEY("gyroscopeX"), readings.gyroscope[0]);
+    writer.appendInt(JSON_KEY("gyroscopeY"), readings.gyroscope[1]);
+    writer.appendInt(JSON_KEY("gyroscopeZ"), readings.gyroscope[2]);
+
+    writer.endObject();
+    return writer.hasOverflow() ? 0 : writer.getLength();
+}
+
+static float randomFloat(float low, float high) {
+    return low + (high - low) * (float)rand() / RAND_MAX;
+}
+
+// the ranges of the HTS221, LPS22HB, LIS2MDL and LSM6DSL in the units the sketch sends
+static void randomReadings(READINGS *readings) {
+    readings->humidity = randomFloat(0, 100);
+    readings->temp = randomFloat(-40, 120);
+    readings->pressure = randomFloat(260, 1260);
+    for (int axis = 0; axis < 3; axis++) {
+        readings->magnetometer[axis] = rand() % 100001 - 50000;
+        readings->accelerometer[axis] = rand() % 4001 - 2000;
+        readings->gyroscope[axis] = rand() % 4000001 - 2000000;
+    }
+}
+
+int main() {
+    static READINGS readings[PAYLOAD_COUNT];
+    srand(1);
+    for (int i = 0; i < PAYLOAD_COUNT; i++) {
+        randomReadings(&readings[i]);
+    }
+    // values where rounding to two decimals carries into the integer part
+    readings[0].humidity = 99.996f;
+    readings[1].temp = -0.004f;
+    readings[2].pressure = 1013.255f;
+
+    char payload[STRING_BUFFER_512];
+    unsigned mismatches = 0;
+    unsigned long bytes = 0;
+
+    // byte for byte the same text
+    for (int i = 0; i < PAYLOAD_COUNT; i++) {
+        String expected;
+        buildStringPayload(readings[i], &expected);
+        const unsigned length = buildWriterPayload(readings[i], payload, sizeof(payload));
+        bytes += length;
+        if (length != expected.length() || memcmp(payload, expected.c_str(), length) != 0) {
+            if (mismatches++ < 5) {
+                printf("mismatch\n  string %s\n  writer %s\n", expected.c_str(), payload);
+            }
+        }
+    }
+
+    // time and heap calls of each path on its own
+    const unsigned long stringReallocs = hostStringAllocations();
+    unsigned long heapBefore = heapCalls;
+    uint64_t start = hostNanoseconds(), startCycles = hostCycles();
+    for (int i = 0; i < PAYLOAD_COUNT; i++) {
+        String built;
+        buildStringPayload(readings[i], &built);
+    }
+    const uint64_t stringNs = hostNanoseconds() - start, stringCycles = hostCycles() - startCycles;
+    const unsigned long stringHeap = heapCalls - heapBefore;
+    const unsigned long stringGrowths = hostStringAllocations() - stringReallocs;
+
+    heapBefore = heapCalls;
+    start = hostNanoseconds();
+    startCycles = hostCycles();
+    for (int i = 0; i < PAYLOAD_COUNT; i++) {
+        buildWriterPayload(readings[i], payload, sizeof(payload));
+    }
+    const uint64_t writerNs = hostNanoseconds() - start, writerCycles = hostCycles() - startCycles;
+    const unsigned long writerHeap = heapCalls - heapBefore;
+
+    printf("payloads            %d, %lu bytes avg, %u mismatches\n", PAYLOAD_COUNT, bytes / PAYLOAD_COUNT, mismatches);
+    printf("string              %8.0f ns %8.0f cycles %6.1f heap calls (%.1f reallocs)\n",
+           (double)stringNs / PAYLOAD_COUNT, (double)stringCycles / PAYLOAD_COUNT,
+           (double)stringHeap / PAYLOAD_COUNT, (double)stringGrowths / PAYLOAD_COUNT);
+    printf("json writer         %8.0f ns %8.0f cycles %6.1f heap calls\n",
+           (double)writerNs / PAYLOAD_COUNT, (double)writerCycles / PAYLOAD_COUNT,
+           (double)writerHeap / PAYLOAD_COUNT);
+    return mismatches == 0 && writerHeap == 0 ? 0 : 1;
+}
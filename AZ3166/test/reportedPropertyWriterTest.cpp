@@ -0,0 +1,191 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Reported property coalescing: the latest value of a key wins, patches go
+// out on the interval, on request or once enough bytes are pending, a failed
+// or unconfirmed patch is sent again with the latest values and given up
+// after REPORTED_MAX_RETRIES, and keys that were sent free their entry.
+
+#include "../inc/globals.h"
+#include "../inc/reportedPropertyWriter.h"
+#include "../inc/stats.h"
+#include "hostTest.h"
+
+static bool set(ReportedPropertyWriter &writer, const char *name, const char *json) {
+    return writer.set(name, strlen(name), json, strlen(json));
+}
+
+// the patch if one is due now, "" otherwise
+static const char *flush(ReportedPropertyWriter &writer) {
+    static char patch[REPORTED_PATCH_MAX_SIZE];
+    patch[0] = char(0);
+    if (writer.isFlushDue(millis())) {
+        writer.buildPatch(patch, sizeof(patch), millis());
+    }
+    return patch;
+}
+
+static void testLatestValueWins() {
+    hostSetTime(1000);
+    clearCounters();
+    ReportedPropertyWriter writer;
+    writer.setFlushInterval(500);
+
+    CHECK(set(writer, "fanSpeed", "1"));
+    CHECK(set(writer, "dieNumber", "4"));
+    CHECK(set(writer, "fanSpeed", "2"));
+    CHECK(set(writer, "fanSpeed", "{\"value\":3}"));
+    CHECK_EQUAL(2, getReportedCoalescedCount());
+
+    hostAdvanceTime(499);
+    CHECK_STRING("", flush(writer));
+    hostAdvanceTime(1);
+    CHECK_STRING("{\"fanSpeed\":{\"value\":3},\"dieNumber\":4}", flush(writer));
+    CHECK_EQUAL(1, getReportedPatchCount());
+
+    // one patch in flight at a time
+    CHECK(set(writer, "dieNumber", "5"));
+    writer.requestFlush();
+    CHECK_STRING("", flush(writer));
+    writer.patchConfirmed(writer.getPatchId(), 204, millis());
+    CHECK_EQUAL(2, getReportedCount());
+    CHECK_STRING("{\"dieNumber\":5}", flush(writer));
+    writer.patchConfirmed(writer.getPatchId(), 200, millis());
+    CHECK(!writer.hasPending());
+    CHECK_EQUAL(3, getReportedCount());
+}
+
+static void testFlushTriggers() {
+    hostSetTime(1000);
+    ReportedPropertyWriter writer;
+    writer.setFlushInterval(60000);
+
+    CHECK(set(writer, "a", "1"));
+    CHECK_STRING("", flush(writer));
+    writer.requestFlush();
+    CHECK_STRING("{\"a\":1}", flush(writer));
+    writer.patchConfirmed(writer.getPatchId(), 200, millis());
+
+    // enough bytes pending sends without waiting for the interval
+    char value[REPORTED_VALUE_MAX_SIZE];
+    memset(value, '1', REPORTED_FLUSH_SIZE / 2);
+    value[REPORTED_FLUSH_SIZE / 2] = char(0);
+    CHECK(set(writer, "b", value));
+    CHECK_STRING("", flush(writer));
+    CHECK(set(writer, "c", value));
+    CHECK(strlen(flush(writer)) > REPORTED_FLUSH_SIZE);
+    writer.patchConfirmed(writer.getPatchId(), 200, millis());
+
+    // values that don't fit
+    memset(value, '1', sizeof(value));
+    CHECK(!writer.set("d", 1, value, sizeof(value)));
+    CHECK(!set(writer, "a-name-longer-than-the-entry-holds", "1"));
+    CHECK(!writer.hasPending());
+}
+
+// a failed patch goes out again with the latest values, after a growing delay
+static void testFailedPatchResent() {
+    hostSetTime(1000);
+    clearCounters();
+    ReportedPropertyWriter writer;
+    writer.setFlushInterval(0);
+
+    CHECK(set(writer, "fanSpeed", "1"));
+    CHECK(set(writer, "dieNumber", "4"));
+    CHECK_STRING("{\"fanSpeed\":1,\"dieNumber\":4}", flush(writer));
+    CHECK(set(writer, "fanSpeed", "2"));
+    writer.patchConfirmed(writer.getPatchId(), 500, millis());
+    CHECK_EQUAL(1, getReportedRetryCount());
+
+    hostAdvanceTime(REPORTED_RETRY_DELAY - 1);
+    CHECK_STRING("", flush(writer));
+    hostAdvanceTime(1);
+    CHECK_STRING("{\"fanSpeed\":2,\"dieNumber\":4}", flush(writer));
+
+    // not confirmed in time counts as failed, the second retry waits twice as long
+    hostAdvanceTime(REPORTED_CONFIRM_TIMEOUT - 1);
+    CHECK_STRING("", flush(writer));
+    hostAdvanceTime(1);
+    CHECK_STRING("", flush(writer));
+    CHECK_EQUAL(2, getReportedRetryCount());
+    hostAdvanceTime(2 * REPORTED_RETRY_DELAY);
+    const int patchId = writer.getPatchId();
+    CHECK_STRING("{\"fanSpeed\":2,\"dieNumber\":4}", flush(writer));
+
+    // the late confirmation of the timed out patch is ignored
+    writer.patchConfirmed(patchId, 200, millis());
+    CHECK_EQUAL(0, getReportedCount());
+    writer.patchConfirmed(writer.getPatchId(), 200, millis());
+    CHECK_EQUAL(2, getReportedCount());
+    CHECK(!writer.hasPending());
+}
+
+static void testGiveUp() {
+    hostSetTime(1000);
+    clearCounters();
+    ReportedPropertyWriter writer;
+    writer.setFlushInterval(0);
+
+    CHECK(set(writer, "fanSpeed", "1"));
+    unsigned patches = 0;
+    for (int attempt = 0; attempt < 2 * REPORTED_MAX_RETRIES; attempt++) {
+        hostAdvanceTime(REPORTED_RETRY_DELAY << REPORTED_MAX_RETRIES);
+        if (strlen(flush(writer)) == 0) {
+            break;
+        }
+        patches++;
+        writer.patchConfirmed(writer.getPatchId(), 429, millis());
+    }
+    CHECK_EQUAL(REPORTED_MAX_RETRIES + 1, patches);
+    CHECK_EQUAL(REPORTED_MAX_RETRIES, getReportedRetryCount());
+    CHECK_EQUAL(1, getErrorCount());
+    CHECK(!writer.hasPending());
+
+    // the next value starts over without a retry delay
+    CHECK(set(writer, "fanSpeed", "2"));
+    CHECK_STRING("{\"fanSpeed\":2}", flush(writer));
+    writer.patchConfirmed(writer.getPatchId(), 200, millis());
+    CHECK_EQUAL(1, getReportedCount());
+}
+
+// keys sent and confirmed give up their entry, only pending ones are limited
+static void testManyKeys() {
+    hostSetTime(1000);
+    clearCounters();
+    ReportedPropertyWriter writer;
+    writer.setFlushInterval(0);
+
+    char name[STRING_BUFFER_16];
+    for (int key = 0; key < 4 * REPORTED_MAX_KEYS; key++) {
+        snprintf(name, sizeof(name), "key%d", key);
+        CHECK(set(writer, name, "true"));
+        CHECK(strstr(flush(writer), name) != NULL);
+        writer.patchConfirmed(writer.getPatchId(), 200, millis());
+    }
+    CHECK_EQUAL(4 * REPORTED_MAX_KEYS, getReportedCount());
+
+    for (int key = 0; key < REPORTED_MAX_KEYS; key++) {
+        snprintf(name, sizeof(name), "pending%d", key);
+        CHECK(set(writer, name, "1"));
+    }
+    CHECK(!set(writer, "oneTooMany", "1"));
+    CHECK(set(writer, "pending0", "2"));
+
+    // in flight entries aren't reused either
+    const char *patch = flush(writer);
+    CHECK(strstr(patch, "\"pending0\":2") != NULL);
+    CHECK(strstr(patch, "\"pending7\":1") != NULL);
+    CHECK(!set(writer, "oneTooMany", "1"));
+    writer.patchConfirmed(writer.getPatchId(), 200, millis());
+    CHECK(set(writer, "oneTooMany", "1"));
+    CHECK_STRING("{\"oneTooMany\":1}", flush(writer));
+}
+
+int main() {
+    testLatestValueWins();
+    testFlushTriggers();
+    testFailedPatchResent();
+    testGiveUp();
+    testManyKeys();
+    return hostTestResult("reportedPropertyWriterTest");
+}
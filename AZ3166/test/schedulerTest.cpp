@@ -0,0 +1,153 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The scheduler on a virtual millis(): deadlines across the 32 bit wrap of
+// millis() after ~49 days, whole periods skipped when a task runs late, and
+// the order tasks run in.
+
+#include "../inc/globals.h"
+#include "../inc/scheduler.h"
+#include "hostTest.h"
+
+#define WRAP_START 0xFFFFF000u // 4096 ms before millis() wraps on the board
+
+// the time the scheduler is run at, a 32 bit millis() value like on the board
+static uint32_t now = 0;
+
+static unsigned long fastRuns = 0, slowRuns = 0, rescheduledRuns = 0;
+static int runOrder[8];
+static int runOrderCount = 0;
+static int rescheduledId = -1;
+
+static void fastTask() {
+    fastRuns++;
+    if (runOrderCount < 8) runOrder[runOrderCount++] = 0;
+}
+
+static void slowTask() {
+    slowRuns++;
+    if (runOrderCount < 8) runOrder[runOrderCount++] = 1;
+}
+
+// runs again 30 ms after each run, whatever its period
+static void rescheduledTask() {
+    rescheduledRuns++;
+    schedulerRunIn(rescheduledId, 30, now);
+}
+
+static void reset() {
+    schedulerInit();
+    fastRuns = slowRuns = rescheduledRuns = 0;
+    runOrderCount = 0;
+}
+
+// run every ms, the periods must hold on either side of the wrap
+static void testWrap() {
+    reset();
+    now = WRAP_START;
+    const int fast = schedulerAddTask("fast", 100, fastTask, now);
+    const int slow = schedulerAddTask("slow", 250, slowTask, now);
+
+    unsigned long previousFast = fastRuns;
+    uint32_t previousFastTime = now;
+    for (unsigned step = 0; step < 10000; step++) {
+        now++;
+        schedulerRun(now);
+        if (fastRuns != previousFast) {
+            CHECK_EQUAL(previousFast + 1, fastRuns);
+            CHECK_EQUAL(100, (uint32_t)(now - previousFastTime));
+            previousFast = fastRuns;
+            previousFastTime = now;
+        }
+    }
+
+    CHECK(now < WRAP_START); // it did wrap
+    CHECK_EQUAL(100, fastRuns);
+    CHECK_EQUAL(40, slowRuns);
+    CHECK_EQUAL(0, schedulerGetTask(fast)->skippedCount);
+    CHECK_EQUAL(0, schedulerGetTask(slow)->skippedCount);
+    CHECK_EQUAL(0, schedulerGetTask(fast)->maxLateness);
+    CHECK_EQUAL((uint32_t)(WRAP_START + 10100), schedulerGetTask(fast)->nextDeadline);
+}
+
+// a wrapped deadline is later than one just before the wrap, the heap keeps them in order
+static void testOrderAcrossWrap() {
+    reset();
+    now = 0xFFFFFFF0u;
+    schedulerAddTask("slow", 40, slowTask, now); // due at 0x18, after the wrap
+    schedulerAddTask("fast", 10, fastTask, now); // due at 0xFFFFFFFA, before it
+
+    now = 0xFFFFFFFFu;
+    schedulerRun(now);
+    CHECK_EQUAL(1, fastRuns);
+    CHECK_EQUAL(0, slowRuns);
+
+    // both late, the earlier deadline runs first
+    now = 0x20;
+    schedulerRun(now);
+    CHECK_EQUAL(1, slowRuns);
+    CHECK(runOrderCount >= 3);
+    CHECK_EQUAL(0, runOrder[0]);
+    CHECK_EQUAL(0, runOrder[1]); // fast was due at 0x4, before slow at 0x18
+    CHECK_EQUAL(1, runOrder[2]);
+}
+
+// a task that ran late runs once, the periods it missed are skipped and the
+// next deadline stays on the period grid
+static void testSkipWholePeriods() {
+    reset();
+    now = WRAP_START;
+    const int fast = schedulerAddTask("fast", 100, fastTask, now);
+
+    now += 100;
+    schedulerRun(now);
+    CHECK_EQUAL(1, fastRuns);
+
+    // stalled for just over ten periods, across the wrap
+    now += 1050;
+    schedulerRun(now);
+    CHECK_EQUAL(2, fastRuns);
+    CHECK_EQUAL(9, schedulerGetTask(fast)->skippedCount);
+    CHECK_EQUAL(950, schedulerGetTask(fast)->maxLateness);
+    CHECK_EQUAL((uint32_t)(WRAP_START + 1200), schedulerGetTask(fast)->nextDeadline);
+
+    // not run again before that deadline
+    now += 49;
+    schedulerRun(now);
+    CHECK_EQUAL(2, fastRuns);
+    now += 1;
+    schedulerRun(now);
+    CHECK_EQUAL(3, fastRuns);
+    CHECK_EQUAL(9, schedulerGetTask(fast)->skippedCount);
+
+    // late by less than a period skips nothing
+    now += 199;
+    schedulerRun(now);
+    CHECK_EQUAL(4, fastRuns);
+    CHECK_EQUAL(9, schedulerGetTask(fast)->skippedCount);
+    CHECK_EQUAL((uint32_t)(WRAP_START + 1400), schedulerGetTask(fast)->nextDeadline);
+}
+
+// schedulerRunIn from the callback replaces the period step, across the wrap too
+static void testRunInAcrossWrap() {
+    reset();
+    now = 0xFFFFFF00u;
+    rescheduledId = schedulerAddTask("rescheduled", 1000, rescheduledTask, now);
+    schedulerRunIn(rescheduledId, 10, now);
+
+    for (unsigned step = 0; step < 600; step++) {
+        now++;
+        schedulerRun(now);
+    }
+    // first run at +10, then every 30 ms up to +600
+    CHECK_EQUAL(20, rescheduledRuns);
+    CHECK_EQUAL(0, schedulerGetTask(rescheduledId)->skippedCount);
+}
+
+int main() {
+    testWrap();
+    testOrderAcrossWrap();
+    testSkipWholePeriods();
+    testRunInAcrossWrap();
+    return hostTestResult("schedulerTest");
+}
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Wake up interrupts to shakes: a second wake up within the window is a
+// shake, bounces of one jolt count once, and wake ups discarded during the
+// lockout after a roll never make the next shake.
+
+#include "../inc/globals.h"
+#include "../inc/shakeDetector.h"
+#include "hostTest.h"
+
+// polled every 50 ms like shakeTask() does
+#define POLL_INTERVAL 50
+
+static void testShake() {
+    SHAKE_DETECTOR detector = {};
+    CHECK(!shakeDetectorCheck(&detector, 1000));
+
+    shakeDetectorWakeUp(&detector, 1000);
+    CHECK(!shakeDetectorCheck(&detector, 1000 + POLL_INTERVAL));
+    shakeDetectorWakeUp(&detector, 1400);
+    CHECK(shakeDetectorCheck(&detector, 1400 + POLL_INTERVAL));
+    CHECK(!shakeDetectorCheck(&detector, 1400 + 2 * POLL_INTERVAL));
+    CHECK_EQUAL(1, detector.shakeCount);
+
+    // too far apart
+    shakeDetectorWakeUp(&detector, 5000);
+    CHECK(!shakeDetectorCheck(&detector, 5000 + POLL_INTERVAL));
+    shakeDetectorWakeUp(&detector, 5000 + SHAKE_WINDOW + POLL_INTERVAL * 3);
+    CHECK(!shakeDetectorCheck(&detector, 5000 + SHAKE_WINDOW + POLL_INTERVAL * 4));
+    CHECK_EQUAL(1, detector.shakeCount);
+}
+
+// interrupts within SHAKE_MIN_SPACING of the last counted one are the same jolt
+static void testBounce() {
+    SHAKE_DETECTOR detector = {};
+    for (unsigned long now = 1000; now < 1000 + SHAKE_MIN_SPACING; now += 20) {
+        shakeDetectorWakeUp(&detector, now);
+    }
+    CHECK(!shakeDetectorCheck(&detector, 1000 + SHAKE_MIN_SPACING));
+    CHECK_EQUAL(8, detector.interruptCount);
+    CHECK_EQUAL(1, detector.wakeUpCount);
+}
+
+// a shake while the task isn't polled, after a roll, doesn't roll again
+static void testLockout() {
+    SHAKE_DETECTOR detector = {};
+    shakeDetectorWakeUp(&detector, 1000);
+    shakeDetectorWakeUp(&detector, 1300);
+    CHECK(shakeDetectorCheck(&detector, 1300 + POLL_INTERVAL));
+
+    // a 2 s lockout with another shake in it
+    shakeDetectorWakeUp(&detector, 2000);
+    shakeDetectorWakeUp(&detector, 2300);
+    shakeDetectorWakeUp(&detector, 2600);
+    const unsigned long lockoutEnd = 1300 + POLL_INTERVAL + 2000;
+    shakeDetectorDiscard(&detector);
+    CHECK(!shakeDetectorCheck(&detector, lockoutEnd));
+    CHECK_EQUAL(1, detector.shakeCount);
+
+    // the first wake up after it starts a new shake, the second completes it
+    shakeDetectorWakeUp(&detector, lockoutEnd + 100);
+    CHECK(!shakeDetectorCheck(&detector, lockoutEnd + 100 + POLL_INTERVAL));
+    shakeDetectorWakeUp(&detector, lockoutEnd + 400);
+    CHECK(shakeDetectorCheck(&detector, lockoutEnd + 400 + POLL_INTERVAL));
+    CHECK_EQUAL(2, detector.shakeCount);
+
+    // discarded within an open window, the window starts over
+    shakeDetectorWakeUp(&detector, 8000);
+    CHECK(!shakeDetectorCheck(&detector, 8000 + POLL_INTERVAL));
+    shakeDetectorWakeUp(&detector, 8200);
+    shakeDetectorDiscard(&detector);
+    CHECK(!shakeDetectorCheck(&detector, 8200 + POLL_INTERVAL));
+    shakeDetectorWakeUp(&detector, 8400);
+    CHECK(!shakeDetectorCheck(&detector, 8400 + POLL_INTERVAL));
+    CHECK_EQUAL(2, detector.shakeCount);
+}
+
+int main() {
+    testShake();
+    testBounce();
+    testLockout();
+    return hostTestResult("shakeDetectorTest");
+}
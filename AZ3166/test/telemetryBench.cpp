@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Replays a sensor trace through the sampler, the aggregation and both
+// payload encodings and reports the host time of each stage, the size of
+// each payload and the time to decode the CBOR one on the receiving side.
+//   telemetryBench [sensors.trace]
+// Without a trace a synthetic one is written to the working directory.
+
+#include "../inc/globals.h"
+#include "../inc/config.h"
+#include "../inc/sensorTrace.h"
+#include "../inc/telemetrySampler.h"
+#include "../inc/telemetryPayload.h"
+#include "../inc/deadband.h"
+#include "cborReader.h"
+#include "hostTest.h"
+
+#define SAMPLE_INTERVAL 500
+#define SEND_INTERVAL 5000
+#define SAMPLES_PER_SEND (SEND_INTERVAL / SAMPLE_INTERVAL)
+#define SEND_COUNT 2000
+
+static const char *writeSyntheticTrace() {
+    static const char *path = "synthetic.trace";
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    SENSOR_TRACE_HEADER header = { SENSOR_TRACE_MAGIC, SENSOR_TRACE_VERSION, sizeof(SENSOR_TRACE_RECORD) };
+    fwrite(&header, sizeof(header), 1, file);
+
+    // an hour of slowly drifting climate and a device being moved around
+    for (uint32_t time = 0; time < 60 * 60 * 1000; time += SAMPLE_INTERVAL) {
+        const double phase = time / 60000.0;
+        SENSOR_TRACE_RECORD record;
+        record.time = time;
+        record.humidity = (int32_t)(4500 + 300 * sin(phase / 7));
+        record.temperature = (int32_t)(2350 + 150 * sin(phase / 11));
+        record.pressure = (int32_t)(101325 + 40 * sin(phase / 3));
+        for (int axis = 0; axis < 3; axis++) {
+            record.magnetometer[axis] = (int32_t)(300 * sin(phase + axis));
+            record.accelerometer[axis] = (int32_t)((axis == 2 ? 1000 : 0) + 80 * sin(phase * 13 + axis));
+            record.gyroscope[axis] = (int32_t)(1500 * sin(phase * 17 + axis));
+        }
+        fwrite(&record, sizeof(record), 1, file);
+    }
+
+    fclose(file);
+    return path;
+}
+
+// the members of the telemetry map, 0 when it isn't well formed
+static unsigned decodeCbor(const char *payload, unsigned length) {
+    CBOR_READER reader = cborReaderInit(payload, length);
+    unsigned members = 0;
+    if (!cborReadMapStart(&reader)) return 0;
+
+    while (!cborReadBreak(&reader) && !reader.error) {
+        const char *name;
+        cborReadText(&reader, &name);
+        const unsigned count = (cborPeek(&reader) >> 5) == 4 ? cborReadArray(&reader) : 1;
+        for (unsigned i = 0; i < count; i++) {
+            cborReadNumber(&reader);
+        }
+        members++;
+    }
+    return !reader.error && cborAtEnd(&reader) ? members : 0;
+}
+
+static uint64_t takeSamples() {
+    uint64_t elapsed = 0;
+    for (int i = 0; i < SAMPLES_PER_SEND; i++) {
+        const uint64_t start = hostNanoseconds();
+        samplerTakeSample();
+        elapsed += hostNanoseconds() - start;
+        hostAdvanceTime(SAMPLE_INTERVAL);
+    }
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : writeSyntheticTrace();
+    if (path == NULL || !sensorReplayOpen(path, 1)) {
+        printf("no sensor trace\n");
+        return 1;
+    }
+
+    samplerInit(TEMP_CHECKED | HUMIDITY_CHECKED | PRESSURE_CHECKED | ACCEL_CHECKED | GYRO_CHECKED | MAG_CHECKED);
+    deadbandInit(false);
+
+    static char payload[STRING_BUFFER_4096];
+    FIELD_AGGREGATE aggregates[TELEMETRY_FIELD_COUNT];
+    uint64_t sampleTime = 0, aggregateTime = 0, jsonTime = 0, cborTime = 0, decodeTime = 0;
+    unsigned long jsonBytes = 0, cborBytes = 0;
+    unsigned minMembers = ~0u, maxMembers = 0;
+
+    for (int send = 0; send < SEND_COUNT; send++) {
+        unsigned fieldCount;
+
+        sampleTime += takeSamples();
+        uint64_t start = hostNanoseconds();
+        samplerAggregate(aggregates);
+        aggregateTime += hostNanoseconds() - start;
+
+        sampleTime += takeSamples();
+        start = hostNanoseconds();
+        jsonBytes += buildTelemetryPayload(payload, sizeof(payload), MESSAGE_FORMAT_JSON, true, &fieldCount);
+        jsonTime += hostNanoseconds() - start;
+
+        sampleTime += takeSamples();
+        start = hostNanoseconds();
+        const unsigned cborLength = buildTelemetryPayload(payload, sizeof(payload), MESSAGE_FORMAT_CBOR, true, &fieldCount);
+        cborTime += hostNanoseconds() - start;
+        cborBytes += cborLength;
+
+        start = hostNanoseconds();
+        const unsigned members = decodeCbor(payload, cborLength);
+        decodeTime += hostNanoseconds() - start;
+        minMembers = members < minMembers ? members : minMembers;
+        maxMembers = members > maxMembers ? members : maxMembers;
+    }
+
+    // the payload builds aggregate as well, their serialization is what's left
+    const double aggregateNs = (double)aggregateTime / SEND_COUNT;
+    printf("trace records       %u\n", getSensorReplayRecordCount());
+    printf("sample              %8.0f ns\n", (double)sampleTime / (3 * SEND_COUNT * SAMPLES_PER_SEND));
+    printf("aggregate %2d        %8.0f ns\n", SAMPLES_PER_SEND, aggregateNs);
+    printf("json payload        %8.0f ns serialization, %lu bytes\n",
+           (double)jsonTime / SEND_COUNT - aggregateNs, jsonBytes / SEND_COUNT);
+    printf("cbor payload        %8.0f ns serialization, %lu bytes, %.0f%% of json\n",
+           (double)cborTime / SEND_COUNT - aggregateNs, cborBytes / SEND_COUNT, 100.0 * cborBytes / jsonBytes);
+    printf("cbor decode         %8.0f ns, %u to %u members with sampleCount\n",
+           (double)decodeTime / SEND_COUNT, minMembers, maxMembers);
+
+    sensorReplayClose();
+    return minMembers > 0 ? 0 : 1;
+}
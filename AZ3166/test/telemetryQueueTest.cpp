@@ -0,0 +1,322 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// TelemetryQueue on a FileFlashStore: push and replay, downsampling, erases
+// kept out of push and pop, and recovery after power is cut at every flash
+// write of a run.
+
+#include "../inc/globals.h"
+#include "../inc/telemetryQueue.h"
+#include "hostTest.h"
+
+#include <set>
+
+#define STORE_PATH "telemetryQueueTest.bin"
+#define SECTOR_SIZE 1024
+#define SECTOR_COUNT 3
+
+// counts the flash operations and can cut the power at one of them, the
+// program it stops in is torn half way
+class PowerCutStore : public FlashStore
+{
+    FlashStore &store;
+
+public:
+    unsigned long programCount;
+    unsigned long eraseCount;
+    unsigned long writeCount;
+    unsigned long cutAt; // writes done before the power goes, 0 - never
+    bool powerCut;
+
+    PowerCutStore(FlashStore &store_): store(store_), programCount(0), eraseCount(0),
+                                       writeCount(0), cutAt(0), powerCut(false) { }
+
+    bool init() { return store.init(); }
+    bool read(uint32_t address, void *buffer, uint32_t size) { return store.read(address, buffer, size); }
+
+    bool program(uint32_t address, const void *buffer, uint32_t size) {
+        if (powerCut || (cutAt > 0 && ++writeCount >= cutAt)) {
+            if (!powerCut && size > 1) {
+                store.program(address, buffer, size / 2);
+            }
+            powerCut = true;
+            return false;
+        }
+        programCount++;
+        return store.program(address, buffer, size);
+    }
+
+    bool erase(unsigned sector) {
+        if (powerCut || (cutAt > 0 && ++writeCount >= cutAt)) {
+            powerCut = true; // an interrupted erase leaves the sector as it was, or partly erased
+            return false;
+        }
+        eraseCount++;
+        return store.erase(sector);
+    }
+
+    uint32_t getSectorSize() { return store.getSectorSize(); }
+    unsigned getSectorCount() { return store.getSectorCount(); }
+};
+
+// the payload tells which message it belongs to, lengths vary with the id
+static unsigned makePayload(uint32_t id, char *payload) {
+    unsigned length = snprintf(payload, STRING_BUFFER_128, "{\"id\":%u,\"pad\":\"", (unsigned)id);
+    for (unsigned i = 0; i < id % 40; i++) {
+        payload[length++] = 'a' + i % 26;
+    }
+    length += snprintf(payload + length, 8, "\"}");
+    return length;
+}
+
+static bool payloadMatches(uint32_t id, const char *payload, unsigned length) {
+    char expected[STRING_BUFFER_128];
+    const unsigned expectedLength = makePayload(id, expected);
+    return length == expectedLength && memcmp(expected, payload, length) == 0;
+}
+
+static void freshStore() {
+    remove(STORE_PATH);
+}
+
+static bool push(TelemetryQueue &queue, uint32_t id) {
+    char payload[STRING_BUFFER_128];
+    const unsigned length = makePayload(id, payload);
+    return queue.push(payload, length, id % 3 == 0 ? MESSAGE_FORMAT_CBOR : MESSAGE_FORMAT_JSON, 1500000000 + id, id % 1000);
+}
+
+static void testPushAndReplay() {
+    freshStore();
+    FileFlashStore file(STORE_PATH, SECTOR_SIZE, SECTOR_COUNT);
+    PowerCutStore store(file);
+    TelemetryQueue queue(store);
+    CHECK(queue.init());
+    CHECK_EQUAL(0, queue.getCount());
+
+    QUEUED_MESSAGE message;
+    char payload[STRING_BUFFER_128];
+    CHECK(!queue.peek(&message, payload, sizeof(payload)));
+
+    // more than a sector
+    for (uint32_t id = 1; id <= 30; id++) {
+        CHECK(push(queue, id));
+    }
+    CHECK_EQUAL(30, queue.getCount());
+
+    for (uint32_t id = 1; id <= 30; id++) {
+        CHECK(queue.peek(&message, payload, sizeof(payload)));
+        CHECK_EQUAL(id, message.messageId);
+        CHECK_EQUAL(id % 3 == 0 ? MESSAGE_FORMAT_CBOR : MESSAGE_FORMAT_JSON, message.format);
+        CHECK_EQUAL(1500000000 + id, message.sampleTime);
+        CHECK_EQUAL(id % 1000, message.sampleMillis);
+        CHECK_EQUAL(0, message.level);
+        CHECK(payloadMatches(id, payload, message.length));
+        CHECK_EQUAL(strlen(payload), message.length);
+
+        CHECK(!queue.pop(id + 1)); // only the oldest can be confirmed
+        CHECK(queue.pop(id));
+    }
+    CHECK_EQUAL(0, queue.getCount());
+    CHECK(!queue.peek(&message, payload, sizeof(payload)));
+
+    // push and pop only program, the sectors they left behind are erased by maintain()
+    CHECK_EQUAL(0, store.eraseCount);
+    unsigned runs = 0;
+    while (queue.maintain()) {
+        runs++;
+    }
+    CHECK(runs >= 1);
+    CHECK_EQUAL(runs, store.eraseCount);
+
+    // the queue is still in order after a reset
+    for (uint32_t id = 31; id <= 40; id++) {
+        CHECK(push(queue, id));
+    }
+    CHECK(queue.pop(31));
+
+    TelemetryQueue reopened(store);
+    CHECK(reopened.init());
+    CHECK_EQUAL(9, reopened.getCount());
+    CHECK(reopened.peek(&message, payload, sizeof(payload)));
+    CHECK_EQUAL(32, message.messageId);
+    CHECK(push(reopened, 41));
+    CHECK(reopened.peek(&message, payload, sizeof(payload)));
+    CHECK_EQUAL(32, message.messageId);
+}
+
+// a payload buffer too small for the message fails rather than truncating
+static void testPeekBufferTooSmall() {
+    freshStore();
+    FileFlashStore file(STORE_PATH, SECTOR_SIZE, SECTOR_COUNT);
+    TelemetryQueue queue(file);
+    CHECK(queue.init());
+    CHECK(push(queue, 39));
+
+    QUEUED_MESSAGE message;
+    char payload[16];
+    CHECK(!queue.peek(&message, payload, sizeof(payload)));
+    CHECK(!queue.push(payload, SECTOR_SIZE, MESSAGE_FORMAT_JSON, 0, 0));
+
+    // the message is still described, so a record that will never fit can be dropped
+    CHECK_EQUAL(1, message.messageId);
+    CHECK(message.length >= sizeof(payload));
+    CHECK(queue.pop(message.messageId));
+    CHECK_EQUAL(0, queue.getCount());
+}
+
+static void testDownsample() {
+    freshStore();
+    FileFlashStore file(STORE_PATH, SECTOR_SIZE, SECTOR_COUNT);
+    PowerCutStore store(file);
+    TelemetryQueue queue(store);
+    CHECK(queue.init());
+
+    // an outage far longer than the store holds, maintained like the firmware does
+    unsigned pushed = 0;
+    for (uint32_t id = 1; id <= 2000; id++) {
+        const unsigned long erases = store.eraseCount;
+        if (push(queue, id)) {
+            pushed++;
+        }
+        CHECK_EQUAL(erases, store.eraseCount);
+        queue.maintain();
+    }
+    CHECK_EQUAL(2000, pushed);
+    CHECK(queue.getDownsampledCount() > 0);
+    CHECK_EQUAL(2000 - queue.getDownsampledCount(), queue.getCount());
+
+    // everything left comes out oldest first, older messages more sparsely
+    QUEUED_MESSAGE message;
+    char payload[STRING_BUFFER_128];
+    uint32_t previous = 0;
+    unsigned replayed = 0, maxLevel = 0, lastLevel = 0;
+    while (queue.peek(&message, payload, sizeof(payload))) {
+        CHECK(message.messageId > previous);
+        CHECK(payloadMatches(message.messageId, payload, message.length));
+        CHECK_EQUAL(1500000000 + message.messageId, message.sampleTime);
+        CHECK(queue.pop(message.messageId));
+        previous = message.messageId;
+        maxLevel = max(maxLevel, message.level);
+        lastLevel = message.level;
+        replayed++;
+    }
+    CHECK_EQUAL(2000, previous); // the newest message survives
+    CHECK_EQUAL(pushed - queue.getDownsampledCount(), replayed);
+    CHECK(maxLevel > 1);
+    CHECK(lastLevel < maxLevel);
+    CHECK_EQUAL(0, queue.getCount());
+}
+
+// without maintain() the queue runs out of erased sectors, push fails rather than erasing
+static void testFullWithoutMaintenance() {
+    freshStore();
+    FileFlashStore file(STORE_PATH, SECTOR_SIZE, SECTOR_COUNT);
+    PowerCutStore store(file);
+    TelemetryQueue queue(store);
+    CHECK(queue.init());
+
+    uint32_t id = 1;
+    while (push(queue, id)) {
+        id++;
+    }
+    CHECK(id > 10);
+    CHECK_EQUAL(0, store.eraseCount);
+    CHECK_EQUAL(id - 1, queue.getCount());
+
+    // a merge frees room once its sources are erased
+    while (queue.maintain()) { }
+    CHECK(queue.getDownsampledCount() > 0);
+    CHECK(push(queue, id));
+}
+
+// a run of pushes, replays and maintenance, stopped after cutAt flash writes
+static void runUntilPowerCut(PowerCutStore &store, std::set<uint32_t> &pushed, std::set<uint32_t> &popped) {
+    TelemetryQueue queue(store);
+    if (!queue.init()) {
+        return;
+    }
+
+    QUEUED_MESSAGE message;
+    char payload[STRING_BUFFER_128];
+    for (uint32_t id = 1; id <= 200 && !store.powerCut; id++) {
+        if (push(queue, id)) {
+            pushed.insert(id);
+        }
+        // the hub comes and goes, replaying a few messages now and then
+        if (id % 50 > 40 && queue.peek(&message, payload, sizeof(payload)) && queue.pop(message.messageId)) {
+            popped.insert(message.messageId);
+        }
+        queue.maintain();
+    }
+}
+
+static void testPowerLoss() {
+    // how many flash writes a full run takes
+    freshStore();
+    FileFlashStore counting(STORE_PATH, SECTOR_SIZE, SECTOR_COUNT);
+    PowerCutStore countingStore(counting);
+    std::set<uint32_t> pushed, popped;
+    runUntilPowerCut(countingStore, pushed, popped);
+    const unsigned long writes = countingStore.programCount + countingStore.eraseCount;
+    CHECK(writes > 100);
+    CHECK(!popped.empty());
+
+    unsigned recovered = 0;
+    for (unsigned long cut = 1; cut <= writes; cut++) {
+        freshStore();
+        std::set<uint32_t> pushedBeforeCut, poppedBeforeCut;
+        {
+            FileFlashStore file(STORE_PATH, SECTOR_SIZE, SECTOR_COUNT);
+            PowerCutStore store(file);
+            store.cutAt = cut;
+            runUntilPowerCut(store, pushedBeforeCut, poppedBeforeCut);
+        }
+
+        FileFlashStore file(STORE_PATH, SECTOR_SIZE, SECTOR_COUNT);
+        TelemetryQueue queue(file);
+        const int failures = hostFailures;
+        CHECK(queue.init());
+
+        // what comes back is in order, intact, was pushed and wasn't confirmed yet;
+        // the message being pushed or popped when the power went may go either way
+        QUEUED_MESSAGE message;
+        char payload[STRING_BUFFER_128];
+        uint32_t previous = 0;
+        unsigned count = 0;
+        const uint32_t inProgress = pushedBeforeCut.empty() ? 1 : *pushedBeforeCut.rbegin() + 1;
+        while (queue.peek(&message, payload, sizeof(payload))) {
+            CHECK(message.messageId > previous);
+            CHECK(payloadMatches(message.messageId, payload, message.length));
+            CHECK(pushedBeforeCut.count(message.messageId) == 1 || message.messageId == inProgress);
+            CHECK(poppedBeforeCut.count(message.messageId) == 0 ||
+                  message.messageId == *poppedBeforeCut.rbegin());
+            CHECK(queue.pop(message.messageId));
+            previous = message.messageId;
+            count++;
+        }
+        CHECK_EQUAL(0, queue.getCount());
+
+        // and the queue carries on with newer ids
+        while (queue.maintain()) { }
+        CHECK(push(queue, 1000));
+        CHECK(queue.peek(&message, payload, sizeof(payload)));
+        CHECK(message.messageId > previous);
+
+        if (hostFailures > failures) {
+            printf("  power cut at flash write %lu\n", cut);
+            break;
+        }
+        recovered++;
+    }
+    CHECK_EQUAL(writes, recovered);
+}
+
+int main() {
+    testPushAndReplay();
+    testPeekBufferTooSmall();
+    testDownsample();
+    testFullWithoutMaintenance();
+    testPowerLoss();
+    remove(STORE_PATH);
+    return hostTestResult("telemetryQueueTest");
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Host time of the message timestamps against the C library formatting
+// the sketch used before: ctime() and gmtime() with strftime().
+
+#include "../inc/globals.h"
+#include "../inc/timestamp.h"
+#include "hostTest.h"
+
+#define CALLS 1000000
+#define CALL_INTERVAL 5 // ms of virtual time between two timestamps
+
+static volatile unsigned sink;
+
+static void report(const char *name, uint64_t elapsed) {
+    printf("%-28s %8.1f ns\n", name, (double)elapsed / CALLS);
+}
+
+int main() {
+    char buffer[STRING_BUFFER_32];
+    hostSetTime(0);
+    set_time(1506881916);
+    anchorCurrentTime();
+
+    uint64_t start = hostNanoseconds();
+    for (int i = 0; i < CALLS; i++) {
+        sink += formatIsoTimestamp(buffer, sizeof(buffer));
+        hostAdvanceTime(CALL_INTERVAL);
+    }
+    report("formatIsoTimestamp", hostNanoseconds() - start);
+
+    start = hostNanoseconds();
+    for (int i = 0; i < CALLS; i++) {
+        time_t seconds;
+        unsigned milliseconds;
+        getCurrentTime(&seconds, &milliseconds);
+        sink += formatIsoTimestampAt(seconds, milliseconds, buffer, sizeof(buffer));
+        hostAdvanceTime(CALL_INTERVAL);
+    }
+    report("formatIsoTimestampAt", hostNanoseconds() - start);
+
+    start = hostNanoseconds();
+    for (int i = 0; i < CALLS; i++) {
+        const time_t now = time(NULL);
+        sink += strlen(ctime(&now));
+        hostAdvanceTime(CALL_INTERVAL);
+    }
+    report("ctime", hostNanoseconds() - start);
+
+    start = hostNanoseconds();
+    for (int i = 0; i < CALLS; i++) {
+        const time_t now = time(NULL);
+        struct tm parts;
+        gmtime_r(&now, &parts);
+        const unsigned length = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &parts);
+        sink += length + snprintf(buffer + length, sizeof(buffer) - length, ".%03luZ", millis() % 1000);
+        hostAdvanceTime(CALL_INTERVAL);
+    }
+    report("gmtime + strftime", hostNanoseconds() - start);
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// Timestamps against the C library: the calendar part against gmtime and
+// strftime, the milliseconds against the virtual clock the RTC runs on.
+
+#include "../inc/globals.h"
+#include "../inc/timestamp.h"
+#include "hostTest.h"
+
+static void referenceTimestamp(time_t seconds, unsigned milliseconds, char *buffer, unsigned bufferSize) {
+    struct tm parts;
+    gmtime_r(&seconds, &parts);
+    const unsigned length = strftime(buffer, bufferSize, "%Y-%m-%dT%H:%M:%S", &parts);
+    snprintf(buffer + length, bufferSize - length, ".%03uZ", milliseconds);
+}
+
+static void testCalendar() {
+    char buffer[STRING_BUFFER_32], expected[STRING_BUFFER_32];
+
+    // leap days, year ends and the range a 32 bit sample time holds
+    const time_t dates[] = { 0, 951782400, 951868799, 1078012800, 1506881916, 1609459199, 1609459200,
+                             2147483647, 4107542399U, 4294967295U };
+    for (unsigned i = 0; i < sizeof(dates) / sizeof(dates[0]); i++) {
+        CHECK_EQUAL(ISO8601_TIMESTAMP_LENGTH, formatIsoTimestampAt(dates[i], 123, buffer, sizeof(buffer)));
+        referenceTimestamp(dates[i], 123, expected, sizeof(expected));
+        CHECK_STRING(expected, buffer);
+    }
+
+    srand(1);
+    for (int i = 0; i < 100000; i++) {
+        const time_t seconds = (time_t)(((unsigned long long)rand() << 16 ^ rand()) % 4294967296ULL);
+        const unsigned milliseconds = rand() % 1000;
+        formatIsoTimestampAt(seconds, milliseconds, buffer, sizeof(buffer));
+        referenceTimestamp(seconds, milliseconds, expected, sizeof(expected));
+        CHECK_STRING(expected, buffer);
+    }
+
+    // too small a buffer gets an empty string
+    CHECK_EQUAL(0, formatIsoTimestampAt(0, 0, buffer, ISO8601_TIMESTAMP_LENGTH));
+    CHECK_EQUAL(0, buffer[0]);
+}
+
+// the milliseconds follow the RTC second set at the anchor, however seldom
+// the time is read
+static void testMilliseconds() {
+    const time_t synced = 1506881916;
+    hostSetTime(12345);
+    set_time(synced);
+    anchorCurrentTime();
+
+    char buffer[STRING_BUFFER_32], expected[STRING_BUFFER_32];
+    time_t seconds;
+    unsigned milliseconds;
+    for (unsigned long elapsed = 0; elapsed < 10000; elapsed += 7) {
+        hostSetTime(12345 + elapsed);
+        getCurrentTime(&seconds, &milliseconds);
+        CHECK_EQUAL(synced + elapsed / 1000, seconds);
+        CHECK_EQUAL(elapsed % 1000, milliseconds);
+
+        formatIsoTimestamp(buffer, sizeof(buffer));
+        referenceTimestamp(synced + elapsed / 1000, elapsed % 1000, expected, sizeof(expected));
+        CHECK_STRING(expected, buffer);
+    }
+
+    // first read of a second well into it
+    hostSetTime(12345 + 20000 + 730);
+    getCurrentTime(&seconds, &milliseconds);
+    CHECK_EQUAL(synced + 20, seconds);
+    CHECK_EQUAL(730, milliseconds);
+}
+
+// setting the RTC again moves the anchor, no sync call needed
+static void testRtcSetAgain() {
+    hostSetTime(0);
+    set_time(1000);
+    anchorCurrentTime();
+    hostAdvanceTime(2500);
+
+    time_t seconds;
+    unsigned milliseconds;
+    getCurrentTime(&seconds, &milliseconds);
+    CHECK_EQUAL(1002, seconds);
+    CHECK_EQUAL(500, milliseconds);
+
+    set_time(1506881916);
+    hostAdvanceTime(250);
+    getCurrentTime(&seconds, &milliseconds);
+    CHECK_EQUAL(1506881916, seconds);
+    CHECK_EQUAL(750, milliseconds);
+
+    hostAdvanceTime(1000);
+    time_t later;
+    getCurrentTime(&later, &milliseconds);
+    CHECK_EQUAL(seconds + 1, later);
+}
+
+// an RTC that drifts more than a second from the count moves the seconds
+// only, the milliseconds keep counting from the anchored second
+static void testRtcDrift() {
+    const time_t synced = 1506881916;
+    hostSetTime(50000);
+    set_time(synced);
+    anchorCurrentTime();
+
+    time_t seconds;
+    unsigned milliseconds;
+    const long drifts[] = { 5, -3, 2, -2 };
+    unsigned long elapsed = 0;
+    time_t expected = synced;
+    for (unsigned i = 0; i < sizeof(drifts) / sizeof(drifts[0]); i++) {
+        // set the RTC 300 ms into a second of the count
+        elapsed += 2300 - elapsed % 1000;
+        hostSetTime(50000 + elapsed);
+        expected += drifts[i];
+        set_time(expected + (time_t)(elapsed / 1000));
+
+        for (unsigned step = 0; step < 2000; step += 7) {
+            hostSetTime(50000 + elapsed + step);
+            getCurrentTime(&seconds, &milliseconds);
+            CHECK_EQUAL(expected + (time_t)((elapsed + step) / 1000), seconds);
+            CHECK_EQUAL((elapsed + step) % 1000, milliseconds);
+        }
+    }
+
+    // a drift of a second is left alone
+    elapsed += 2000;
+    hostSetTime(50000 + elapsed);
+    set_time(expected + (time_t)(elapsed / 1000) + 1);
+    getCurrentTime(&seconds, &milliseconds);
+    CHECK_EQUAL(expected + (time_t)(elapsed / 1000), seconds);
+    CHECK_EQUAL(elapsed % 1000, milliseconds);
+}
+
+// what the formatter writes parses back, with the hub's seven fraction digits as well
+static void testParse() {
+    char buffer[STRING_BUFFER_32];
+    time_t seconds;
+    unsigned milliseconds;
+    for (time_t date = 0; date < 4102444800; date += 86400 * 13 + 3607) {
+        const unsigned millis = (unsigned)(date % 1000);
+        const unsigned length = formatIsoTimestampAt(date, millis, buffer, sizeof(buffer));
+        CHECK(parseIsoTimestamp(buffer, length, &seconds, &milliseconds));
+        CHECK_EQUAL(date, seconds);
+        CHECK_EQUAL(millis, milliseconds);
+    }
+
+    const char *hub = "2017-10-01T18:02:16.4801234Z";
+    CHECK(parseIsoTimestamp(hub, strlen(hub), &seconds, &milliseconds));
+    CHECK_EQUAL(1506880936, seconds);
+    CHECK_EQUAL(480, milliseconds);
+    CHECK(parseIsoTimestamp(hub, 19, &seconds, &milliseconds) == false);
+    CHECK(parseIsoTimestamp("2017-10-01T18:02:16Z", 20, &seconds, &milliseconds));
+    CHECK_EQUAL(0, milliseconds);
+    CHECK(parseIsoTimestamp("2017-10-01T18:02:16.5Z", 22, &seconds, &milliseconds));
+    CHECK_EQUAL(500, milliseconds);
+
+    const char *bad[] = { "", "2017-10-01", "2017-10-01 18:02:16Z", "2017-13-01T18:02:16Z",
+                          "2017-10-01T18:02:16.48+01:00", "2017-10-01T18:02:16.48Zx", "20a7-10-01T18:02:16Z" };
+    for (unsigned i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        CHECK(!parseIsoTimestamp(bad[i], strlen(bad[i]), &seconds, &milliseconds));
+    }
+}
+
+int main() {
+    CHECK(!isTimeSynced());
+    testCalendar();
+    testParse();
+    testMilliseconds();
+    testRtcSetAgain();
+    testRtcDrift();
+    return hostTestResult("timestampTest");
+}
@@ -0,0 +1,167 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The twin parser on full twins of 1 to 8 KB laid out like the hub sends
+// them, with $metadata for every property in both sections, and on partial
+// updates: every twin must parse to the properties it was built with, and
+// the time per twin and per KB is printed to show the cost stays linear.
+
+#include "../inc/globals.h"
+#include "../inc/twinParser.h"
+#include "hostTest.h"
+
+#define PARSE_ROUNDS 2000
+#define CORPUS_MAX_SIZE (8 * 1024)
+
+static const char *lastUpdated = "\"$lastUpdated\":\"2026-10-17T08:00:00.1234567Z\",\"$lastUpdatedVersion\":%d";
+
+// the sketch's own properties, then generic ones, every fourth with an object value
+static int appendDesired(char *buffer, int size, int i) {
+    switch (i) {
+    case 0: return snprintf(buffer, size, "\"fanSpeed\":{\"value\":%d}", 100 + i);
+    case 1: return snprintf(buffer, size, "\"setVoltage\":{\"value\":3}");
+    case 2: return snprintf(buffer, size, "\"setCurrent\":{\"value\":2}");
+    case 3: return snprintf(buffer, size, "\"telemetryDeadband\":{\"value\":{\"enabled\":true,"
+                                          "\"heartbeat\":300,\"temp\":0.5,\"humidityRel\":0.02}}");
+    default:
+        if (i % 4 == 3) {
+            return snprintf(buffer, size, "\"setting%d\":{\"value\":{\"mode\":\"auto\",\"limits\":[%d,%d]}}",
+                            i, i, 2 * i);
+        }
+        return snprintf(buffer, size, "\"setting%d\":{\"value\":%d}", i, i);
+    }
+}
+
+static int appendName(char *buffer, int size, int i) {
+    switch (i) {
+    case 0: return snprintf(buffer, size, "fanSpeed");
+    case 1: return snprintf(buffer, size, "setVoltage");
+    case 2: return snprintf(buffer, size, "setCurrent");
+    case 3: return snprintf(buffer, size, "telemetryDeadband");
+    default: return snprintf(buffer, size, "setting%d", i);
+    }
+}
+
+#define APPEND(...) length += snprintf(twin + length, size - length, __VA_ARGS__)
+
+// a full twin with count properties desired and reported
+static int buildTwin(char *twin, int size, int count) {
+    char name[STRING_BUFFER_32];
+    int length = 0;
+
+    APPEND("{\"desired\":{");
+    for (int i = 0; i < count; i++) {
+        length += appendDesired(twin + length, size - length, i);
+        APPEND(",");
+    }
+    APPEND("\"$metadata\":{");
+    APPEND(lastUpdated, count);
+    for (int i = 0; i < count; i++) {
+        appendName(name, sizeof(name), i);
+        APPEND(",\"%s\":{", name);
+        APPEND(lastUpdated, i + 1);
+        APPEND(",\"value\":{");
+        APPEND(lastUpdated, i + 1);
+        APPEND("}}");
+    }
+    APPEND("},\"$version\":%d},", count);
+
+    APPEND("\"reported\":{");
+    for (int i = 0; i < count; i++) {
+        appendName(name, sizeof(name), i);
+        APPEND("\"%s\":{\"value\":%d,\"statusCode\":200,\"status\":\"completed\",\"desiredVersion\":%d},",
+               name, i, i + 1);
+    }
+    APPEND("\"$metadata\":{");
+    APPEND(lastUpdated, count);
+    for (int i = 0; i < count; i++) {
+        appendName(name, sizeof(name), i);
+        APPEND(",\"%s\":{", name);
+        APPEND(lastUpdated, i + 1);
+        APPEND("}");
+    }
+    APPEND("},\"$version\":%d}}", 2 * count);
+    return length < size ? length : 0;
+}
+
+// the patch the hub sends when count desired properties changed at once
+static int buildPatch(char *twin, int size, int count) {
+    char name[STRING_BUFFER_32];
+    int length = 0;
+
+    APPEND("{");
+    for (int i = 0; i < count; i++) {
+        length += appendDesired(twin + length, size - length, i);
+        APPEND(",");
+    }
+    APPEND("\"$metadata\":{");
+    APPEND(lastUpdated, count);
+    for (int i = 0; i < count; i++) {
+        appendName(name, sizeof(name), i);
+        APPEND(",\"%s\":{", name);
+        APPEND(lastUpdated, count);
+        APPEND("}");
+    }
+    APPEND("},\"$version\":%d}", count);
+    return length < size ? length : 0;
+}
+
+// every property found with both sections, or the patch's, and nothing else
+static bool checkParsed(const TWIN_DOCUMENT &document, int count, bool partial) {
+    if (document.propertyCount != (unsigned)count || document.droppedCount != 0 ||
+        document.desiredVersion.length == 0 || document.desiredLastUpdated.length != 28) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        char name[STRING_BUFFER_32];
+        const int nameLength = appendName(name, sizeof(name), i);
+        const TWIN_PROPERTY &property = document.properties[i];
+        if (property.name.length != (unsigned)nameLength || memcmp(property.name.start, name, nameLength) != 0 ||
+            !property.inDesired || property.desiredValue.length == 0 ||
+            property.inReported == partial || (!partial && property.reportedDesiredVersion.length == 0)) {
+            return false;
+        }
+    }
+    return partial || document.reportedVersion.length > 0;
+}
+
+static unsigned failures = 0;
+
+static void benchTwin(const char *twin, int length, int count, bool partial) {
+    static TWIN_DOCUMENT document;
+    if (length == 0 || !twinParse(twin, length, partial, &document) || !checkParsed(document, count, partial)) {
+        printf("%s of %d properties, %d bytes not parsed\n", partial ? "patch" : "twin", count, length);
+        failures++;
+        return;
+    }
+
+    const uint64_t start = hostNanoseconds(), startCycles = hostCycles();
+    for (int round = 0; round < PARSE_ROUNDS; round++) {
+        twinParse(twin, length, partial, &document);
+    }
+    const double ns = (double)(hostNanoseconds() - start) / PARSE_ROUNDS;
+    const double cycles = (double)(hostCycles() - startCycles) / PARSE_ROUNDS;
+    printf("%-5s %2d properties %5d bytes %8.0f ns %8.0f cycles %6.0f ns/KB %5.2f cycles/byte\n",
+           partial ? "patch" : "twin", count, length, ns, cycles, ns * 1024 / length, cycles / length);
+}
+
+int main() {
+    static char twin[CORPUS_MAX_SIZE + STRING_BUFFER_1024];
+
+    // the smallest twins past 1, 2, 4 and 8 KB
+    int count = 1;
+    for (int target = 1024; target <= CORPUS_MAX_SIZE; target *= 2) {
+        int length;
+        while ((length = buildTwin(twin, sizeof(twin), count)) != 0 && length < target &&
+               count < TWIN_MAX_PROPERTIES) {
+            count++;
+        }
+        benchTwin(twin, length, count, false);
+    }
+
+    for (count = 1; count <= 16; count *= 4) {
+        benchTwin(twin, buildPatch(twin, sizeof(twin), count), count, true);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license.
+
+// The twin parser on the members the hub adds: $metadata and the other $
+// members are skipped without becoming properties, only the $version of
+// each section and the $lastUpdated of the desired one are kept, and a twin
+// with more than TWIN_MAX_PROPERTIES properties is parsed to the end.
+
+#include "../inc/globals.h"
+#include "../inc/twinParser.h"
+#include "hostTest.h"
+
+static TWIN_DOCUMENT twin;
+
+static bool parse(const char *payload, bool partial) {
+    return twinParse(payload, strlen(payload), partial, &twin);
+}
+
+static bool spanIs(const TWIN_SPAN &span, const char *text) {
+    return span.length == strlen(text) && memcmp(span.start, text, span.length) == 0;
+}
+
+static const TWIN_PROPERTY *property(const char *name) {
+    for (unsigned i = 0; i < twin.propertyCount; i++) {
+        if (spanIs(twin.properties[i].name, name)) {
+            return &twin.properties[i];
+        }
+    }
+    return NULL;
+}
+
+static void testDollarMembersSkipped() {
+    const char *payload =
+        "{\"desired\":{"
+            "\"$iotin:thermostat\":{\"value\":1},"
+            "\"fanSpeed\":{\"value\":100},"
+            "\"$metadata\":{"
+                "\"$lastUpdated\":\"2026-10-17T08:00:00.1234567Z\","
+                "\"$lastUpdatedVersion\":7,"
+                "\"fanSpeed\":{\"$lastUpdated\":\"2026-10-16T01:00:00Z\",\"$lastUpdatedVersion\":6,"
+                    "\"value\":{\"$lastUpdated\":\"2026-10-16T01:00:00Z\"}},"
+                "\"shadow\":{\"$lastUpdated\":\"2026-10-15T01:00:00Z\"}},"
+            "\"$version\":7,"
+            "\"$\":\"empty name\"},"
+        "\"reported\":{"
+            "\"fanSpeed\":{\"value\":90,\"statusCode\":200,\"desiredVersion\":6},"
+            "\"$metadata\":{\"$lastUpdated\":\"2026-10-17T09:00:00Z\","
+                "\"fanSpeed\":{\"$lastUpdated\":\"2026-10-17T09:00:00Z\"}},"
+            "\"$version\":12},"
+        "\"$etag\":\"AAAAAAAAAAE=\"}";
+
+    CHECK(parse(payload, false));
+    CHECK_EQUAL(1, twin.propertyCount);
+    CHECK_EQUAL(0, twin.droppedCount);
+    CHECK(property("shadow") == NULL);
+    CHECK(property("$iotin:thermostat") == NULL);
+
+    const TWIN_PROPERTY *fan = property("fanSpeed");
+    CHECK(fan != NULL && fan->inDesired && fan->inReported);
+    CHECK(fan != NULL && spanIs(fan->desiredValue, "100"));
+    CHECK(fan != NULL && spanIs(fan->reportedValue, "90"));
+    CHECK(fan != NULL && spanIs(fan->reportedDesiredVersion, "6"));
+
+    CHECK(spanIs(twin.desiredVersion, "7"));
+    CHECK(spanIs(twin.reportedVersion, "12"));
+    // the desired section's own, not a property's or the reported one
+    CHECK(spanIs(twin.desiredLastUpdated, "2026-10-17T08:00:00.1234567Z"));
+}
+
+// a patch is the desired section itself, $metadata last like the hub sends it
+static void testPartialDollarMembers() {
+    const char *payload =
+        "{ \"setVoltage\" : { \"value\" : 3 } ,"
+        "  \"$metadata\" : { \"setVoltage\" : { \"$lastUpdated\" : \"2026-10-16T00:00:00Z\" },"
+        "                    \"$lastUpdated\" : \"2026-10-17T10:00:00Z\" },"
+        "  \"$version\" : 21 }";
+
+    CHECK(parse(payload, true));
+    CHECK_EQUAL(1, twin.propertyCount);
+    CHECK(property("setVoltage") != NULL && spanIs(property("setVoltage")->desiredValue, "3"));
+    CHECK(spanIs(twin.desiredVersion, "21"));
+    CHECK(spanIs(twin.desiredLastUpdated, "2026-10-17T10:00:00Z"));
+    CHECK_EQUAL(0, twin.reportedVersion.length);
+
+    // no $metadata, nothing kept
+    CHECK(parse("{\"fanSpeed\":{\"value\":1},\"$version\":3}", true));
+    CHECK_EQUAL(0, twin.desiredLastUpdated.length);
+    CHECK(spanIs(twin.desiredVersion, "3"));
+
+    // $ members holding objects with braces and quotes in their strings
+    CHECK(parse("{\"$odd\":{\"a\":\"}\\\"{\",\"b\":[{\"c\":\"]\"}]},\"fanSpeed\":2,\"$version\":4}", true));
+    CHECK_EQUAL(1, twin.propertyCount);
+    CHECK(property("fanSpeed") != NULL && spanIs(property("fanSpeed")->desiredValue, "2"));
+    CHECK(spanIs(twin.desiredVersion, "4"));
+}
+
+// properties past the table are counted and skipped, the rest of the twin is still read
+static void testOverflow() {
+    static char payload[STRING_BUFFER_4096];
+    int length = snprintf(payload, sizeof(payload), "{\"desired\":{");
+    for (int i = 0; i < TWIN_MAX_PROPERTIES + 3; i++) {
+        length += snprintf(payload + length, sizeof(payload) - length,
+                           "\"property%d\":{\"value\":{\"nested\":[%d,{\"x\":\"}\"}]}},", i, i);
+    }
+    length += snprintf(payload + length, sizeof(payload) - length,
+                       "\"$version\":40},\"reported\":{"
+                       "\"property0\":{\"value\":1,\"desiredVersion\":39},"
+                       "\"property%d\":{\"value\":2,\"desiredVersion\":39},"
+                       "\"$version\":41}}", TWIN_MAX_PROPERTIES + 1);
+    CHECK(length < (int)sizeof(payload));
+
+    CHECK(parse(payload, false));
+    CHECK_EQUAL(TWIN_MAX_PROPERTIES, twin.propertyCount);
+    // three desired properties, and the reported entry of one of them again
+    CHECK_EQUAL(4, twin.droppedCount);
+    CHECK(spanIs(twin.desiredVersion, "40"));
+    CHECK(spanIs(twin.reportedVersion, "41"));
+
+    const TWIN_PROPERTY *last = property("property31");
+    CHECK(last != NULL && spanIs(last->desiredValue, "{\"nested\":[31,{\"x\":\"}\"}]}"));
+    CHECK(property("property32") == NULL);
+    CHECK(property("property0") != NULL && property("property0")->inReported);
+    CHECK(property("property0") != NULL && spanIs(property("property0")->reportedDesiredVersion, "39"));
+
+    // a reported property the desired section didn't fill the table with is dropped too
+    length = snprintf(payload, sizeof(payload), "{\"reported\":{");
+    for (int i = 0; i < TWIN_MAX_PROPERTIES + 1; i++) {
+        length += snprintf(payload + length, sizeof(payload) - length, "\"r%d\":{\"value\":%d},", i, i);
+    }
+    snprintf(payload + length, sizeof(payload) - length, "\"$version\":2}}");
+    CHECK(parse(payload, false));
+    CHECK_EQUAL(TWIN_MAX_PROPERTIES, twin.propertyCount);
+    CHECK_EQUAL(1, twin.droppedCount);
+    CHECK(spanIs(twin.reportedVersion, "2"));
+}
+
+static void testMalformed() {
+    CHECK(!parse("{\"desired\":{\"$metadata\":{\"$lastUpdated\":", false));
+    CHECK(!parse("{\"$version\":3", true));
+    CHECK(!parse("{\"$odd\":{\"a\":1}", true));
+    CHECK(!parse("", true));
+}
+
+int main() {
+    testDollarMembersSkipped();
+    testPartialDollarMembers();
+    testOverflow();
+    testMalformed();
+    return hostTestResult("twinParserTest");
+}